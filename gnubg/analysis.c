@@ -70,6 +70,21 @@ int afAnalysePlayers[2] = { TRUE, TRUE };
 
 evalcontext ecLuck = { TRUE, 0, FALSE, TRUE, 0.0 };
 
+/* A move of a game being analysed whose luck is computed in a task of
+ * its own, in parallel with the analysis of its cube action and
+ * chequer play. Whichever of the two finishes last adds the move to
+ * the statistics. */
+struct _moveluck {
+    moverecord *pmr;
+    matchstate ms;              /* as the move is analysed */
+    const listOLD *plGame;
+    statcontext *psc;
+    int cPending;               /* luck and move analysis not yet done */
+};
+
+/* all the above, freed when the analysis is over */
+static GSList *plMoveLuck = NULL;
+
 extern ratingtype
 GetRating(const float rError)
 {
@@ -581,12 +596,68 @@ updateStatcontext(statcontext * psc, const moverecord * pmr, const matchstate *
 
 }
 
-extern int
-AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
-            statcontext * psc, const evalsetup * pesChequer, evalsetup * pesCube,
-            /* const */ movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], const int analysePlayers[2],
-            float *doubleError)
+/* Called with MT_Exclusive() held, when the luck or the rest of the
+ * analysis of the move is done */
+
+static void
+MoveLuckDone(moveluck * pml)
+{
+    if (--pml->cPending == 0)
+        updateStatcontext(pml->psc, pml->pmr, &pml->ms, pml->plGame);
+}
+
+static void
+AnalyseLuckMT(moveluck * pml)
+{
+    moverecord *pmr = pml->pmr;
+    float rLuck = LuckAnalysis((ConstTanBoard) pml->ms.anBoard, pmr->anDice[0], pmr->anDice[1], &pml->ms);
+
+    MT_Exclusive();
+    pmr->rLuck = rLuck;
+    pmr->lt = Luck(rLuck);
+    MoveLuckDone(pml);
+    MT_Release();
+}
+
+/* Copy the results of analysing the move from the task's copy of it */
+
+static void
+CommitMoveAnalysis(moverecord * pmr, const moverecord * pmrAnalysed, int fLuck)
 {
+    if (pmr->ml.amMoves != pmrAnalysed->ml.amMoves)
+        g_free(pmr->ml.amMoves);
+    pmr->ml = pmrAnalysed->ml;
+    pmr->esChequer = pmrAnalysed->esChequer;
+    pmr->n.iMove = pmrAnalysed->n.iMove;
+    pmr->n.stMove = pmrAnalysed->n.stMove;
+
+    if (pmr->CubeDecPtr)
+        *pmr->CubeDecPtr = *pmrAnalysed->CubeDecPtr;
+    pmr->stCube = pmrAnalysed->stCube;
+
+    pmr->r = pmrAnalysed->r;
+
+    if (fLuck) {
+        pmr->rLuck = pmrAnalysed->rLuck;
+        pmr->lt = pmrAnalysed->lt;
+    }
+}
+
+/* The move is analysed on a copy of its record, without the lock.
+ * MT_Exclusive() is only held at the end, to store the results, add
+ * them to the statistics and update the game record: these are what
+ * the other tasks and the autosave share. */
+
+static int
+AnalyzeMoveRecord(moverecord * pmrRecord, matchstate * pms, const listOLD * plParentGame,
+                  statcontext * psc, const evalsetup * pesChequer, evalsetup * pesCube,
+                  /* const */ movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], const int analysePlayers[2],
+                  float *doubleError, moveluck * pml)
+{
+    moverecord mr;
+    moverecord *pmr = &mr;
+    cubedecisiondata cdd;
+    int fStats = FALSE;
     TanBoard anBoardMove;
     cubeinfo ci;
     float rSkill, rChequerSkill;
@@ -598,6 +669,12 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
     const xmovegameinfo *pmgi = &((moverecord *) plParentGame->plNext->p)->g;
     int is_initial_position = 1;
 
+    memcpy(&mr, pmrRecord, sizeof(mr));
+    if (pmrRecord->CubeDecPtr) {
+        cdd = *pmrRecord->CubeDecPtr;
+        mr.CubeDecPtr = &cdd;
+    }
+
     /* analyze this move */
 
     FixMatchState(pms, pmr);
@@ -610,14 +687,10 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
         is_initial_position = !memcmp(anBoardMove, pms->anBoard, 2 * 25 * sizeof(int));
     }
 
-    MT_Exclusive();
     switch (pmr->mt) {
     case MOVE_GAMEINFO:
 
-        if (psc) {
-            IniStatcontext(psc);
-            updateStatcontext(psc, pmr, pms, plParentGame);
-        }
+        fStats = TRUE;
         break;
     case MOVE_NORMAL:
         if (pmr->fPlayer != pms->fMove) {
@@ -637,11 +710,9 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
             float arDouble[NUM_CUBEFUL_OUTPUTS];
 
             if (cmp_evalsetup(pesCube, &pmr->CubeDecPtr->esDouble) > 0) {
-                MT_Release();
                 if (GeneralCubeDecision(aarOutput, aarStdDev, NULL,
                                         (ConstTanBoard) pms->anBoard, &ci, pesCube, NULL, NULL) < 0)
-                    return -1;
-                MT_Exclusive();
+                    goto failed;
 
                 pmr->CubeDecPtr->esDouble = *pesCube;
 
@@ -657,9 +728,9 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
         } else
             pmr->CubeDecPtr->esDouble.et = EVAL_NONE;
 
-        /* luck analysis */
+        /* luck analysis, unless it has a task of its own */
 
-        if (fAnalyseDice) {
+        if (fAnalyseDice && !pml) {
             pmr->rLuck = LuckAnalysis((ConstTanBoard) pms->anBoard, pmr->anDice[0], pmr->anDice[1], pms);
             pmr->lt = Luck(pmr->rLuck);
         }
@@ -677,28 +748,18 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
 
             if (cmp_evalsetup(pesChequer, &pmr->esChequer) > 0) {
 
-                if (pmr->ml.cMoves) {
-                    g_free(pmr->ml.amMoves);
-                    pmr->ml.amMoves = NULL;
-                }
+                /* find best moves; the old ones are freed when the
+                 * new ones are stored */
 
-                /* find best moves */
-
-                {
-                    movelist ml;
-                    MT_Release();
-                    if (FindnSaveBestMoves(&ml, pmr->anDice[0],
-                                           pmr->anDice[1],
-                                           (ConstTanBoard) pms->anBoard, &key,
-                                           arSkillLevel[SKILL_DOUBTFUL], &ci, &pesChequer->ec, aamf) < 0) {
-                        g_free(ml.amMoves);
-                        return -1;
-                    }
-                    MT_Exclusive();
-                    CopyMoveList(&pmr->ml, &ml);
-                    if (ml.cMoves)
-                        g_free(ml.amMoves);
+                movelist ml;
+                if (FindnSaveBestMoves(&ml, pmr->anDice[0],
+                                       pmr->anDice[1],
+                                       (ConstTanBoard) pms->anBoard, &key,
+                                       arSkillLevel[SKILL_DOUBTFUL], &ci, &pesChequer->ec, aamf) < 0) {
+                    g_free(ml.amMoves);
+                    goto failed;
                 }
+                pmr->ml = ml;
 
             }
 
@@ -713,8 +774,7 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
             pmr->esChequer = *pesChequer;
         }
 
-        if (psc)
-            updateStatcontext(psc, pmr, pms, plParentGame);
+        fStats = TRUE;
 
         break;
 
@@ -736,11 +796,9 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
                 float arDouble[NUM_CUBEFUL_OUTPUTS];
 
                 if (cmp_evalsetup(pesCube, &pmr->CubeDecPtr->esDouble) > 0) {
-                    MT_Release();
                     if (GeneralCubeDecision(aarOutput, aarStdDev,
                                             NULL, (ConstTanBoard) pms->anBoard, &ci, pesCube, NULL, NULL) < 0)
-                        return -1;
-                    MT_Exclusive();
+                        goto failed;
 
                     pmr->CubeDecPtr->esDouble = *pesCube;
                 } else {
@@ -764,8 +822,7 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
                 *doubleError = ERR_VAL;
         }
 
-        if (psc)
-            updateStatcontext(psc, pmr, pms, plParentGame);
+        fStats = TRUE;
 
         break;
 
@@ -784,8 +841,7 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
             pmr->stCube = Skill(-*doubleError);
         }
 
-        if (psc)
-            updateStatcontext(psc, pmr, pms, plParentGame);
+        fStats = TRUE;
 
         break;
 
@@ -804,8 +860,7 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
             pmr->stCube = Skill(*doubleError);
         }
 
-        if (psc)
-            updateStatcontext(psc, pmr, pms, plParentGame);
+        fStats = TRUE;
 
         break;
 
@@ -869,13 +924,12 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
 
         GetMatchStateCubeInfo(&ci, pms);
 
-        if (fAnalyseDice) {
+        if (fAnalyseDice && !pml) {
             pmr->rLuck = LuckAnalysis((ConstTanBoard) pms->anBoard, pmr->anDice[0], pmr->anDice[1], pms);
             pmr->lt = Luck(pmr->rLuck);
         }
 
-        if (psc)
-            updateStatcontext(psc, pmr, pms, plParentGame);
+        fStats = TRUE;
 
         break;
 
@@ -885,7 +939,21 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
         break;
     }
 
-    ApplyMoveRecord(pms, plParentGame, pmr);
+    MT_Exclusive();
+
+    CommitMoveAnalysis(pmrRecord, pmr, !pml);
+
+    if (fStats) {
+        if (pml)
+            MoveLuckDone(pml);
+        else if (psc) {
+            if (pmr->mt == MOVE_GAMEINFO)
+                IniStatcontext(psc);
+            updateStatcontext(psc, pmrRecord, pms, plParentGame);
+        }
+    }
+
+    ApplyMoveRecord(pms, plParentGame, pmrRecord);
 
     if (psc) {
         psc->fMoves = fAnalyseMove;
@@ -895,6 +963,23 @@ AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
     MT_Release();
 
     return fInterrupt ? -1 : 0;
+
+  failed:
+    /* the move list found for the copy isn't stored */
+    if (pmr->ml.amMoves != pmrRecord->ml.amMoves)
+        g_free(pmr->ml.amMoves);
+
+    return -1;
+}
+
+extern int
+AnalyzeMove(moverecord * pmr, matchstate * pms, const listOLD * plParentGame,
+            statcontext * psc, const evalsetup * pesChequer, evalsetup * pesCube,
+            /* const */ movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], const int analysePlayers[2],
+            float *doubleError)
+{
+    return AnalyzeMoveRecord(pmr, pms, plParentGame, psc, pesChequer, pesCube, aamf, analysePlayers,
+                             doubleError, NULL);
 }
 
 static int
@@ -911,6 +996,49 @@ NumberMovesGame(listOLD * plGame)
 
 }
 
+/* Whether AnalyzeGame() computes the luck of the move in a task of its
+ * own. The luck and the chequer analysis of a move only have the 0-ply
+ * search of the roll played in common: the luck searches the other 20
+ * rolls at 0-ply, which the chequer analysis never looks at, and the
+ * chequer analysis goes on to n plies with its own filters. The 0-ply
+ * evaluations of the roll played are found in the evaluation cache by
+ * whichever of the two tasks comes second, since 0-ply keys don't
+ * depend on pruning, so a single task for both would share nothing
+ * more and only run them one after the other. */
+
+static int
+LuckTask(const moverecord * pmr)
+{
+    return fAnalyseDice && (pmr->mt == MOVE_NORMAL || pmr->mt == MOVE_SETDICE) && afAnalysePlayers[pmr->fPlayer];
+}
+
+/* The tasks for the progress bar: the moves and their luck */
+
+static int
+NumberTasksGame(listOLD * plGame)
+{
+
+    int nTasks = 0;
+    listOLD *pl;
+
+    for (pl = plGame->plNext; pl != plGame; pl = pl->plNext)
+        nTasks += LuckTask(pl->p) ? 2 : 1;
+
+    return nTasks;
+
+}
+
+static void
+FreeMoveLuck(void)
+{
+    GSList *pl;
+
+    for (pl = plMoveLuck; pl; pl = pl->next)
+        g_free(pl->data);
+    g_slist_free(plMoveLuck);
+    plMoveLuck = NULL;
+}
+
 
 static gboolean
 UpdateProgressBar(gpointer UNUSED(unused))
@@ -927,8 +1055,9 @@ AnalyseMoveMT(Task * task)
 
   analyzeDouble:
     amt = (AnalyseMoveTask *) task;
-    if (AnalyzeMove(amt->pmr, &amt->ms, amt->plGame, amt->psc,
-                    &esAnalysisChequer, &esAnalysisCube, aamfAnalysis, afAnalysePlayers, &doubleError) < 0)
+    if (AnalyzeMoveRecord(amt->pmr, &amt->ms, amt->plGame, amt->psc,
+                          &esAnalysisChequer, &esAnalysisCube, aamfAnalysis, afAnalysePlayers, &doubleError,
+                          amt->pml) < 0)
         MT_AbortTasks();
 
     if (task->pLinkedTask) {    /* Need to analyze take/drop decision in sequence */
@@ -977,6 +1106,27 @@ AnalyzeGame(listOLD * plGame, int wait)
         pt->plGame = plGame;
         pt->psc = psc;
         memcpy(&pt->ms, &msAnalyse, sizeof(msAnalyse));
+        pt->pml = NULL;
+
+        if (LuckTask(pmr)) {
+            /* schedule the luck first, to run alongside the move */
+            moveluck *pml = g_new(moveluck, 1);
+
+            pml->pmr = pmr;
+            pml->plGame = plGame;
+            pml->psc = psc;
+            pml->cPending = 2;
+            memcpy(&pml->ms, &msAnalyse, sizeof(msAnalyse));
+            FixMatchState(&pml->ms, pmr);
+            if (pmr->fPlayer != pml->ms.fMove) {
+                SwapSides(pml->ms.anBoard);
+                pml->ms.fMove = pmr->fPlayer;
+            }
+            plMoveLuck = g_slist_prepend(plMoveLuck, pml);
+            pt->pml = pml;
+
+            mt_add_tasks(1, (AsyncFun) AnalyseLuckMT, pml, NULL);
+        }
 
         if (pmr->mt == MOVE_DOUBLE) {
             doubletype dt = DoubleType(msAnalyse.fDoubled, msAnalyse.fMove, msAnalyse.fTurn);
@@ -1010,6 +1160,7 @@ AnalyzeGame(listOLD * plGame, int wait)
 
         multi_debug("wait for all task: analysis");
         result = MT_WaitForTasks(UpdateProgressBar, 250, fAutoSaveAnalysis);
+        FreeMoveLuck();
 
         if (result == -1)
             IniStatcontext(psc);
@@ -1140,7 +1291,7 @@ NumberMovesMatch(listOLD * plMatch)
     listOLD *pl;
 
     for (pl = plMatch->plNext; pl != plMatch; pl = pl->plNext)
-        nMoves += NumberMovesGame(pl->p);
+        nMoves += NumberTasksGame(pl->p);
 
     return nMoves;
 
@@ -1159,7 +1310,7 @@ CommandAnalyseGame(char *UNUSED(sz))
         return;
 
     fStore_crawford = ms.fCrawford;
-    nMoves = NumberMovesGame(plGame);
+    nMoves = NumberTasksGame(plGame);
 
     ProgressStartValue(_("Analysing game; move:"), nMoves);
 
@@ -1214,6 +1365,7 @@ CommandAnalyseMatch(char *UNUSED(sz))
 
     multi_debug("wait for all task: analysis");
     MT_WaitForTasks(UpdateProgressBar, 250, fAutoSaveAnalysis);
+    FreeMoveLuck();
 
     ProgressEnd();
 
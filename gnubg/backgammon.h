@@ -299,6 +299,12 @@ extern listOLD *plLastMove;
  */
 extern listOLD lMatch;
 
+/* Incremented whenever move records are freed, so that holders of
+ * pointers into lMatch, such as Python match views, can tell when
+ * they have gone stale.
+ */
+extern unsigned int nMatchGeneration;
+
 extern int automaticTask;
 
 extern char *aszCopying[];
@@ -568,6 +574,7 @@ extern void CommandExportGameLaTeX(char *);
 extern void CommandExportGamePDF(char *);
 extern void CommandExportGamePS(char *);
 extern void CommandExportGameText(char *);
+extern void CommandExportDirectory(char *);
 extern void CommandExportHTMLImages(char *);
 extern void CommandExportMatchHtml(char *);
 extern void CommandExportMatchLaTeX(char *);
@@ -587,6 +594,8 @@ extern void CommandExportPositionSnowieTxt(char *);
 extern void CommandExportPositionSVG(char *);
 extern void CommandExportPositionText(char *);
 extern void CommandExternal(char *);
+extern void CommandSetExternalClients(char *);
+extern void CommandShowExternal(char *);
 extern void CommandFirstGame(char *);
 extern void CommandFirstMove(char *);
 extern void CommandHelp(char *);
@@ -604,6 +613,8 @@ extern void CommandImportSnowieTxt(char *);
 extern void CommandImportTMG(char *);
 extern void CommandListGame(char *);
 extern void CommandListMatch(char *);
+extern void CommandLoadBinaryMatch(char *);
+extern void CommandLoadBook(char *);
 extern void CommandLoadCommands(char *);
 extern void CommandLoadGame(char *);
 extern void CommandLoadMatch(char *);
@@ -621,6 +632,7 @@ extern void CommandPrevious(char *);
 extern void CommandQuit(char *);
 extern void CommandRedouble(char *);
 extern void CommandReject(char *);
+extern void CommandRelationalAddDirectory(char *);
 extern void CommandRelationalAddMatch(char *);
 extern void CommandRelationalEraseAll(char *);
 extern void CommandRelationalErase(char *);
@@ -632,10 +644,15 @@ extern void CommandRelationalTest(char *);
 extern void CommandResign(char *);
 extern void CommandRoll(char *);
 extern void CommandRollout(char *);
+extern void CommandSaveBinaryMatch(char *);
+extern void CommandSaveBook(char *);
 extern void CommandSaveGame(char *);
 extern void CommandSaveMatch(char *);
 extern void CommandSavePosition(char *);
 extern void CommandSaveSettings(char *);
+extern void CommandSetAdaptiveFiltersConfidence(char *);
+extern void CommandSetAdaptiveFiltersEnable(char *);
+extern void CommandSetAdaptiveFiltersSigma(char *);
 extern void CommandSetAnalysisChequerplay(char *);
 extern void CommandSetAnalysisCube(char *);
 extern void CommandSetAnalysisCubedecision(char *);
@@ -808,6 +825,7 @@ extern void CommandSetPlayerGNU(char *);
 extern void CommandSetPlayerHuman(char *);
 extern void CommandSetPlayerMoveFilter(char *);
 extern void CommandSetPlayerName(char *);
+extern void CommandSetPonder(char *);
 extern void CommandSetPostCrawford(char *);
 extern void CommandSetPriorityAboveNormal(char *);
 extern void CommandSetPriorityBelowNormal(char *);
@@ -914,6 +932,7 @@ extern void CommandSetVariationStandard(char *);
 extern void CommandSetVsync3d(char *);
 extern void CommandSetWarning(char *);
 extern void CommandShow8912(char *);
+extern void CommandShowAdaptiveFilters(char *);
 extern void CommandShowAliases(char *);
 extern void CommandShowAnalysis(char *);
 extern void CommandShowAutoSave(char *);
@@ -921,6 +940,7 @@ extern void CommandShowAutomatic(char *);
 extern void CommandShowBearoff(char *);
 extern void CommandShowBeavers(char *);
 extern void CommandShowBoard(char *);
+extern void CommandShowBook(char *);
 extern void CommandShowBrowser(char *);
 extern void CommandShowBuildInfo(char *);
 extern void CommandShowCache(char *);
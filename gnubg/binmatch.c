@@ -0,0 +1,781 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "backgammon.h"
+#include "analysis.h"
+#include "binmatch.h"
+#if USE_GTK
+#include "gtkgame.h"
+#endif
+
+#define BINMATCH_MAGIC "GNUBGBM\n"
+#define BINMATCH_BYTEORDER 0x01020304u
+
+#define PAD8(cb) (((cb) + 7) & ~(gsize) 7)
+
+typedef struct {
+    char achMagic[8];
+    guint32 nVersion;
+    guint32 nByteOrder;         /* BINMATCH_BYTEORDER as written */
+    guint32 acbLayout[4];       /* sizes of the structures stored as they are */
+    guint32 cGames;
+    guint32 cbInfo;             /* size of the match strings */
+    guint32 nYear, nMonth, nDay;
+    guint32 nReserved;
+} binheader;
+
+typedef struct {
+    guint64 iOffset;
+    guint32 cb;
+    guint32 cRecords;
+} binindex;
+
+typedef struct {
+    guint32 cb;                 /* size of the whole record, padding included */
+    guint32 fFlags;
+} binrecord;
+
+#define BR_MOVES 1              /* followed by ml.cMoves moves */
+#define BR_MONEYCUBE 2          /* followed by the money cube analysis */
+#define BR_TEXT 4               /* followed by the annotation */
+#define BR_LINKED 8             /* shares the cube analysis of the preceding double */
+
+#define CB_RECORD_HEAD (sizeof(binrecord) + PAD8(sizeof(moverecord)))
+
+struct _binmatch {
+    GMappedFile *pmf;
+    const char *pch;
+    gsize cb;
+    binheader bh;
+    const char *pchInfo;
+    binindex *abi;
+};
+
+static void
+SetLayout(guint32 acb[4])
+{
+    acb[0] = sizeof(moverecord);
+    acb[1] = sizeof(move);
+    acb[2] = sizeof(cubedecisiondata);
+    acb[3] = sizeof(void *);
+}
+
+static void
+WritePadding(FILE * pf, gsize cb)
+{
+    static const char achZero[8] = { 0 };
+
+    if (cb & 7)
+        fwrite(achZero, 1, 8 - (cb & 7), pf);
+}
+
+/* Copies of the stored structures made member by member into zeroed
+ * memory, so that their padding doesn't carry whatever was in memory
+ * into the file */
+
+static void
+CopyEvalContext(evalcontext * pec, const evalcontext * pecSrc)
+{
+    memset(pec, 0, sizeof(*pec));
+    pec->fCubeful = pecSrc->fCubeful;
+    pec->nPlies = pecSrc->nPlies;
+    pec->fUsePrune = pecSrc->fUsePrune;
+    pec->fDeterministic = pecSrc->fDeterministic;
+    pec->rNoise = pecSrc->rNoise;
+}
+
+static void
+CopyRolloutContext(rolloutcontext * prc, const rolloutcontext * prcSrc)
+{
+    int i;
+
+    memset(prc, 0, sizeof(*prc));
+    for (i = 0; i < 2; i++) {
+        CopyEvalContext(&prc->aecCube[i], &prcSrc->aecCube[i]);
+        CopyEvalContext(&prc->aecChequer[i], &prcSrc->aecChequer[i]);
+        CopyEvalContext(&prc->aecCubeLate[i], &prcSrc->aecCubeLate[i]);
+        CopyEvalContext(&prc->aecChequerLate[i], &prcSrc->aecChequerLate[i]);
+    }
+    CopyEvalContext(&prc->aecCubeTrunc, &prcSrc->aecCubeTrunc);
+    CopyEvalContext(&prc->aecChequerTrunc, &prcSrc->aecChequerTrunc);
+    memcpy(prc->aaamfChequer, prcSrc->aaamfChequer, sizeof(prc->aaamfChequer));
+    memcpy(prc->aaamfLate, prcSrc->aaamfLate, sizeof(prc->aaamfLate));
+    prc->fCubeful = prcSrc->fCubeful;
+    prc->fVarRedn = prcSrc->fVarRedn;
+    prc->fInitial = prcSrc->fInitial;
+    prc->fRotate = prcSrc->fRotate;
+    prc->fTruncBearoff2 = prcSrc->fTruncBearoff2;
+    prc->fTruncBearoffOS = prcSrc->fTruncBearoffOS;
+    prc->fLateEvals = prcSrc->fLateEvals;
+    prc->fDoTruncate = prcSrc->fDoTruncate;
+    prc->fStopOnSTD = prcSrc->fStopOnSTD;
+    prc->fStopOnJsd = prcSrc->fStopOnJsd;
+    prc->fStopMoveOnJsd = prcSrc->fStopMoveOnJsd;
+    prc->nTruncate = prcSrc->nTruncate;
+    prc->nTrials = prcSrc->nTrials;
+    prc->nLate = prcSrc->nLate;
+    prc->rngRollout = prcSrc->rngRollout;
+    prc->nSeed = prcSrc->nSeed;
+    prc->nMinimumGames = prcSrc->nMinimumGames;
+    prc->rStdLimit = prcSrc->rStdLimit;
+    prc->nMinimumJsdGames = prcSrc->nMinimumJsdGames;
+    prc->rJsdLimit = prcSrc->rJsdLimit;
+    prc->nGamesDone = prcSrc->nGamesDone;
+    prc->rStoppedOnJSD = prcSrc->rStoppedOnJSD;
+    prc->nSkip = prcSrc->nSkip;
+}
+
+static void
+CopyEvalSetup(evalsetup * pes, const evalsetup * pesSrc)
+{
+    memset(pes, 0, sizeof(*pes));
+    pes->et = pesSrc->et;
+    CopyEvalContext(&pes->ec, &pesSrc->ec);
+    CopyRolloutContext(&pes->rc, &pesSrc->rc);
+}
+
+static void
+CopyMove(move * pm, const move * pmSrc)
+{
+    memset(pm, 0, sizeof(*pm));
+    memcpy(pm->anMove, pmSrc->anMove, sizeof(pm->anMove));
+    pm->key = pmSrc->key;
+    pm->cMoves = pmSrc->cMoves;
+    pm->cPips = pmSrc->cPips;
+    pm->rScore = pmSrc->rScore;
+    pm->rScore2 = pmSrc->rScore2;
+    memcpy(pm->arEvalMove, pmSrc->arEvalMove, sizeof(pm->arEvalMove));
+    memcpy(pm->arEvalStdDev, pmSrc->arEvalStdDev, sizeof(pm->arEvalStdDev));
+    CopyEvalSetup(&pm->esMove, &pmSrc->esMove);
+    pm->cmark = pmSrc->cmark;
+}
+
+static void
+CopyCubeDecision(cubedecisiondata * pcd, const cubedecisiondata * pcdSrc)
+{
+    memset(pcd, 0, sizeof(*pcd));
+    memcpy(pcd->aarOutput, pcdSrc->aarOutput, sizeof(pcd->aarOutput));
+    memcpy(pcd->aarStdDev, pcdSrc->aarStdDev, sizeof(pcd->aarStdDev));
+    CopyEvalSetup(&pcd->esDouble, &pcdSrc->esDouble);
+    pcd->cmark = pcdSrc->cmark;
+}
+
+/* The pointers are left NULL; they are rebuilt on loading */
+static void
+CopyMoveRecord(moverecord * pmr, const moverecord * pmrSrc)
+{
+    memset(pmr, 0, sizeof(*pmr));
+    pmr->mt = pmrSrc->mt;
+    pmr->fPlayer = pmrSrc->fPlayer;
+    pmr->anDice[0] = pmrSrc->anDice[0];
+    pmr->anDice[1] = pmrSrc->anDice[1];
+    pmr->lt = pmrSrc->lt;
+    pmr->rLuck = pmrSrc->rLuck;
+    CopyEvalSetup(&pmr->esChequer, &pmrSrc->esChequer);
+    pmr->ml.cMoves = pmrSrc->ml.cMoves;
+    pmr->ml.cMaxMoves = pmrSrc->ml.cMaxMoves;
+    pmr->ml.cMaxPips = pmrSrc->ml.cMaxPips;
+    pmr->ml.iMoveBest = pmrSrc->ml.iMoveBest;
+    pmr->ml.rBestScore = pmrSrc->ml.rBestScore;
+    pmr->nAnimals = pmrSrc->nAnimals;
+    if (pmrSrc->CubeDecPtr == &pmrSrc->CubeDec)
+        CopyCubeDecision(&pmr->CubeDec, &pmrSrc->CubeDec);
+    pmr->stCube = pmrSrc->stCube;
+
+    pmr->g.i = pmrSrc->g.i;
+    pmr->g.nMatch = pmrSrc->g.nMatch;
+    pmr->g.anScore[0] = pmrSrc->g.anScore[0];
+    pmr->g.anScore[1] = pmrSrc->g.anScore[1];
+    pmr->g.fCrawford = pmrSrc->g.fCrawford;
+    pmr->g.fCrawfordGame = pmrSrc->g.fCrawfordGame;
+    pmr->g.fJacoby = pmrSrc->g.fJacoby;
+    pmr->g.fWinner = pmrSrc->g.fWinner;
+    pmr->g.nPoints = pmrSrc->g.nPoints;
+    pmr->g.fResigned = pmrSrc->g.fResigned;
+    pmr->g.nAutoDoubles = pmrSrc->g.nAutoDoubles;
+    pmr->g.bgv = pmrSrc->g.bgv;
+    pmr->g.fCubeUse = pmrSrc->g.fCubeUse;
+    pmr->g.sc = pmrSrc->g.sc;
+
+    memcpy(pmr->n.anMove, pmrSrc->n.anMove, sizeof(pmr->n.anMove));
+    pmr->n.iMove = pmrSrc->n.iMove;
+    pmr->n.stMove = pmrSrc->n.stMove;
+
+    pmr->r.nResigned = pmrSrc->r.nResigned;
+    CopyEvalSetup(&pmr->r.esResign, &pmrSrc->r.esResign);
+    memcpy(pmr->r.arResign, pmrSrc->r.arResign, sizeof(pmr->r.arResign));
+    pmr->r.stResign = pmrSrc->r.stResign;
+    pmr->r.stAccept = pmrSrc->r.stAccept;
+
+    pmr->sb.key = pmrSrc->sb.key;
+    pmr->scv.nCube = pmrSrc->scv.nCube;
+    pmr->scp.fCubeOwner = pmrSrc->scp.fCubeOwner;
+}
+
+static guint32
+WriteRecord(FILE * pf, const moverecord * pmr)
+{
+    moverecord mr;
+    binrecord br;
+    gsize cbText = pmr->sz ? strlen(pmr->sz) + 1 : 0;
+
+    br.fFlags = 0;
+    br.cb = (guint32) CB_RECORD_HEAD;
+    CopyMoveRecord(&mr, pmr);
+
+    if (pmr->ml.cMoves && pmr->ml.amMoves) {
+        br.fFlags |= BR_MOVES;
+        br.cb += (guint32) PAD8(pmr->ml.cMoves * sizeof(move));
+    } else
+        mr.ml.cMoves = 0;
+    if (pmr->MoneyCubeDecPtr) {
+        br.fFlags |= BR_MONEYCUBE;
+        br.cb += (guint32) PAD8(sizeof(cubedecisiondata));
+    }
+    if (cbText) {
+        br.fFlags |= BR_TEXT;
+        br.cb += (guint32) PAD8(cbText);
+    }
+    if (pmr->CubeDecPtr != &pmr->CubeDec)
+        br.fFlags |= BR_LINKED;
+
+    /* sanitise the move if from a hint record, as SaveGame() does */
+    if (mr.mt == MOVE_NORMAL && mr.ml.cMoves && mr.n.iMove >= mr.ml.cMoves) {
+        memcpy(mr.n.anMove, pmr->ml.amMoves[0].anMove, sizeof(mr.n.anMove));
+        mr.n.iMove = 0;
+    }
+
+    fwrite(&br, sizeof(br), 1, pf);
+    fwrite(&mr, sizeof(mr), 1, pf);
+    WritePadding(pf, sizeof(mr));
+    if (br.fFlags & BR_MOVES) {
+        unsigned int i;
+
+        for (i = 0; i < pmr->ml.cMoves; i++) {
+            move m;
+
+            CopyMove(&m, &pmr->ml.amMoves[i]);
+            fwrite(&m, sizeof(m), 1, pf);
+        }
+        WritePadding(pf, pmr->ml.cMoves * sizeof(move));
+    }
+    if (br.fFlags & BR_MONEYCUBE) {
+        cubedecisiondata cd;
+
+        CopyCubeDecision(&cd, pmr->MoneyCubeDecPtr);
+        fwrite(&cd, sizeof(cd), 1, pf);
+        WritePadding(pf, sizeof(cd));
+    }
+    if (cbText) {
+        fwrite(pmr->sz, 1, cbText, pf);
+        WritePadding(pf, cbText);
+    }
+
+    return br.cb;
+}
+
+static void
+AppendString(GString * gs, const char *sz)
+{
+    g_string_append_c(gs, sz ? 1 : 0);
+    if (sz)
+        g_string_append_len(gs, sz, (gssize) strlen(sz) + 1);
+}
+
+extern int
+BinMatchSave(const char *szFile)
+{
+    FILE *pf;
+    binheader bh;
+    binindex *abi;
+    GString *gs;
+    listOLD *pl, *plg;
+    guint64 iOffset;
+    unsigned int i;
+    int ret;
+
+    memset(&bh, 0, sizeof(bh));
+    memcpy(bh.achMagic, BINMATCH_MAGIC, sizeof(bh.achMagic));
+    bh.nVersion = BINMATCH_VERSION;
+    bh.nByteOrder = BINMATCH_BYTEORDER;
+    SetLayout(bh.acbLayout);
+    for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext)
+        bh.cGames++;
+    bh.nYear = mi.nYear;
+    bh.nMonth = mi.nMonth;
+    bh.nDay = mi.nDay;
+
+    gs = g_string_new(NULL);
+    AppendString(gs, ap[0].szName);
+    AppendString(gs, ap[1].szName);
+    AppendString(gs, mi.pchRating[0]);
+    AppendString(gs, mi.pchRating[1]);
+    AppendString(gs, mi.pchEvent);
+    AppendString(gs, mi.pchRound);
+    AppendString(gs, mi.pchPlace);
+    AppendString(gs, mi.pchAnnotator);
+    AppendString(gs, mi.pchComment);
+    bh.cbInfo = (guint32) PAD8(gs->len);
+
+    if (!(pf = g_fopen(szFile, "wb"))) {
+        outputerr(szFile);
+        g_string_free(gs, TRUE);
+        return -1;
+    }
+
+    abi = g_new0(binindex, bh.cGames);
+
+    /* the index is written again once the offsets are known */
+    fwrite(&bh, sizeof(bh), 1, pf);
+    fwrite(abi, sizeof(binindex), bh.cGames, pf);
+    fwrite(gs->str, 1, gs->len, pf);
+    WritePadding(pf, gs->len);
+    g_string_free(gs, TRUE);
+
+    iOffset = sizeof(bh) + bh.cGames * sizeof(binindex) + bh.cbInfo;
+    for (i = 0, plg = lMatch.plNext; plg != &lMatch; i++, plg = plg->plNext) {
+        listOLD *plGameSave = plg->p;
+        int fMoveNormalSeen = FALSE;
+
+        updateStatisticsGame(plGameSave);
+
+        abi[i].iOffset = iOffset;
+        for (pl = plGameSave->plNext; pl != plGameSave; pl = pl->plNext) {
+            moverecord *pmr = pl->p;
+
+            if (pmr->mt == MOVE_NORMAL)
+                fMoveNormalSeen = TRUE;
+            /* skip the placeholder for hint data that SaveGame() skips */
+            else if (pmr->mt == MOVE_DOUBLE && pl->plNext == plGameSave &&
+                     !(fMoveNormalSeen == FALSE && pmr->CubeDecPtr->esDouble.et != EVAL_NONE))
+                continue;
+
+            abi[i].cb += WriteRecord(pf, pmr);
+            abi[i].cRecords++;
+        }
+        iOffset += abi[i].cb;
+    }
+
+    fseek(pf, (long) sizeof(bh), SEEK_SET);
+    fwrite(abi, sizeof(binindex), bh.cGames, pf);
+    g_free(abi);
+
+    ret = ferror(pf) ? -1 : 0;
+    if (fclose(pf) || ret) {
+        outputerr(szFile);
+        ret = -1;
+    }
+
+    return ret;
+}
+
+static int
+CheckSkill(skilltype st)
+{
+    return (unsigned int) st <= SKILL_NONE;
+}
+
+/* From a point to a lower one, or off the board */
+static int
+CheckMove(const int anMove[8])
+{
+    int i;
+
+    for (i = 0; i < 8 && anMove[i] >= 0; i += 2)
+        if (anMove[i] > 24 || anMove[i + 1] < -1 || anMove[i + 1] >= anMove[i])
+            return FALSE;
+
+    return TRUE;
+}
+
+/* Check the values of a record that restoring it uses as indices or
+ * counts, as RestoreNode() in sgf.c does for SGF */
+static int
+CheckRecord(const moverecord * pmr)
+{
+    if (pmr->fPlayer < -1 || pmr->fPlayer > 1 || pmr->anDice[0] > 6 || pmr->anDice[1] > 6
+        || (unsigned int) pmr->lt > LUCK_VERYGOOD || !CheckSkill(pmr->stCube))
+        return FALSE;
+
+    switch (pmr->mt) {
+    case MOVE_GAMEINFO:
+        return pmr->g.nMatch >= 0 && pmr->g.anScore[0] >= 0 && pmr->g.anScore[1] >= 0
+            && pmr->g.fWinner >= -1 && pmr->g.fWinner <= 1
+            && pmr->g.nAutoDoubles >= 0 && pmr->g.nAutoDoubles < 31 && (1 << pmr->g.nAutoDoubles) <= MAX_CUBE
+            && (unsigned int) pmr->g.bgv < NUM_VARIATIONS;
+
+    case MOVE_NORMAL:
+        return pmr->fPlayer >= 0 && pmr->anDice[0] >= 1 && pmr->anDice[1] >= 1
+            && CheckSkill(pmr->n.stMove) && CheckMove(pmr->n.anMove);
+
+    case MOVE_DOUBLE:
+    case MOVE_TAKE:
+    case MOVE_DROP:
+        return pmr->fPlayer >= 0;
+
+    case MOVE_RESIGN:
+        return pmr->fPlayer >= 0 && pmr->r.nResigned >= 1 && pmr->r.nResigned <= 3
+            && CheckSkill(pmr->r.stResign) && CheckSkill(pmr->r.stAccept);
+
+    case MOVE_SETDICE:
+        return pmr->anDice[0] >= 1 && pmr->anDice[1] >= 1;
+
+    case MOVE_SETCUBEVAL:
+        return pmr->scv.nCube >= 1 && pmr->scv.nCube <= MAX_CUBE;
+
+    case MOVE_SETCUBEPOS:
+        return pmr->scp.fCubeOwner >= -1 && pmr->scp.fCubeOwner <= 1;
+
+    default:
+        return TRUE;
+    }
+}
+
+/* Check every record of a game, so that restoring it can trust them */
+static int
+CheckGame(const binmatch * pbm, const binindex * pbi)
+{
+    const char *pch, *pchEnd;
+    moverecord mr;
+    unsigned int i, j;
+
+    if ((pbi->iOffset & 7) || pbi->iOffset > pbm->cb || pbi->cb > pbm->cb - pbi->iOffset || !pbi->cRecords)
+        return FALSE;
+
+    pch = pbm->pch + pbi->iOffset;
+    pchEnd = pch + pbi->cb;
+
+    for (i = 0; i < pbi->cRecords; i++) {
+        binrecord br;
+        gsize cb = CB_RECORD_HEAD;
+
+        if ((gsize) (pchEnd - pch) < CB_RECORD_HEAD)
+            return FALSE;
+
+        memcpy(&br, pch, sizeof(br));
+        memcpy(&mr, pch + sizeof(br), sizeof(mr));
+
+        if ((br.cb & 7) || br.cb < CB_RECORD_HEAD || br.cb > (gsize) (pchEnd - pch))
+            return FALSE;
+        if ((unsigned int) mr.mt > MOVE_SETCUBEPOS || (i == 0) != (mr.mt == MOVE_GAMEINFO) || !CheckRecord(&mr))
+            return FALSE;
+        if (br.fFlags & BR_MOVES) {
+            if (!mr.ml.cMoves || mr.ml.cMoves > br.cb / sizeof(move))
+                return FALSE;
+            /* WriteRecord() leaves no move outside the list */
+            if (mr.mt == MOVE_NORMAL && mr.n.iMove >= mr.ml.cMoves)
+                return FALSE;
+            cb += PAD8(mr.ml.cMoves * sizeof(move));
+            if (cb > br.cb)
+                return FALSE;
+            for (j = 0; j < mr.ml.cMoves; j++) {
+                int anMove[8];
+
+                memcpy(anMove, pch + CB_RECORD_HEAD + j * sizeof(move) + G_STRUCT_OFFSET(move, anMove),
+                       sizeof(anMove));
+                if (!CheckMove(anMove))
+                    return FALSE;
+            }
+        } else if (mr.ml.cMoves)
+            return FALSE;
+        if (br.fFlags & BR_MONEYCUBE)
+            cb += PAD8(sizeof(cubedecisiondata));
+        if (cb > br.cb || ((br.fFlags & BR_TEXT) && !memchr(pch + cb, 0, br.cb - cb)))
+            return FALSE;
+
+        pch += br.cb;
+    }
+
+    return pch == pchEnd;
+}
+
+extern binmatch *
+BinMatchOpen(const char *szFile)
+{
+    binmatch *pbm;
+    GMappedFile *pmf;
+    GError *error = NULL;
+    guint32 acbLayout[4];
+    gsize cbHead;
+    unsigned int i;
+
+    if (!(pmf = g_mapped_file_new(szFile, FALSE, &error))) {
+        outputerrf("%s: %s", szFile, error->message);
+        g_error_free(error);
+        return NULL;
+    }
+
+    pbm = g_new0(binmatch, 1);
+    pbm->pmf = pmf;
+    pbm->pch = g_mapped_file_get_contents(pmf);
+    pbm->cb = g_mapped_file_get_length(pmf);
+
+    if (pbm->cb < sizeof(binheader) || memcmp(pbm->pch, BINMATCH_MAGIC, 8)) {
+        outputerrf(_("%s: not a binary match file"), szFile);
+        BinMatchClose(pbm);
+        return NULL;
+    }
+
+    memcpy(&pbm->bh, pbm->pch, sizeof(binheader));
+    SetLayout(acbLayout);
+    if (pbm->bh.nVersion != BINMATCH_VERSION || pbm->bh.nByteOrder != BINMATCH_BYTEORDER
+        || memcmp(acbLayout, pbm->bh.acbLayout, sizeof(acbLayout))) {
+        outputerrf(_("%s: this binary match file was written by a different "
+                     "version of GNU Backgammon or on a different kind of computer; "
+                     "convert it through SGF"), szFile);
+        BinMatchClose(pbm);
+        return NULL;
+    }
+
+    cbHead = sizeof(binheader) + (gsize) pbm->bh.cGames * sizeof(binindex) + pbm->bh.cbInfo;
+    if (pbm->bh.cGames > pbm->cb / sizeof(binindex) || cbHead > pbm->cb) {
+        outputerrf(_("%s: corrupt binary match file"), szFile);
+        BinMatchClose(pbm);
+        return NULL;
+    }
+
+    pbm->abi = g_new(binindex, pbm->bh.cGames);
+    memcpy(pbm->abi, pbm->pch + sizeof(binheader), pbm->bh.cGames * sizeof(binindex));
+    pbm->pchInfo = pbm->pch + sizeof(binheader) + pbm->bh.cGames * sizeof(binindex);
+
+    for (i = 0; i < pbm->bh.cGames; i++)
+        if (!CheckGame(pbm, &pbm->abi[i])) {
+            outputerrf(_("%s: corrupt binary match file"), szFile);
+            BinMatchClose(pbm);
+            return NULL;
+        }
+
+    return pbm;
+}
+
+extern void
+BinMatchClose(binmatch * pbm)
+{
+#if GLIB_CHECK_VERSION(2,22,0)
+    g_mapped_file_unref(pbm->pmf);
+#else
+    g_mapped_file_free(pbm->pmf);
+#endif
+    g_free(pbm->abi);
+    g_free(pbm);
+}
+
+extern unsigned int
+BinMatchGameCount(const binmatch * pbm)
+{
+    return pbm->bh.cGames;
+}
+
+static char *
+ReadString(const char **ppch, const char *pchEnd)
+{
+    const char *pch = *ppch, *pchNul;
+
+    if (pch >= pchEnd)
+        return NULL;
+
+    if (!*pch++ || !(pchNul = memchr(pch, 0, (gsize) (pchEnd - pch)))) {
+        *ppch = pch;
+        return NULL;
+    }
+
+    *ppch = pchNul + 1;
+    return g_strdup(pch);
+}
+
+extern void
+BinMatchRestoreInfo(const binmatch * pbm)
+{
+    const char *pch = pbm->pchInfo, *pchEnd = pch + pbm->bh.cbInfo;
+    char *asz[2];
+    int i;
+
+    for (i = 0; i < 2; i++)
+        if ((asz[i] = ReadString(&pch, pchEnd))) {
+            g_strlcpy(ap[i].szName, asz[i], sizeof(ap[i].szName));
+            g_free(asz[i]);
+        }
+
+    g_free(mi.pchRating[0]);
+    mi.pchRating[0] = ReadString(&pch, pchEnd);
+    g_free(mi.pchRating[1]);
+    mi.pchRating[1] = ReadString(&pch, pchEnd);
+    g_free(mi.pchEvent);
+    mi.pchEvent = ReadString(&pch, pchEnd);
+    g_free(mi.pchRound);
+    mi.pchRound = ReadString(&pch, pchEnd);
+    g_free(mi.pchPlace);
+    mi.pchPlace = ReadString(&pch, pchEnd);
+    g_free(mi.pchAnnotator);
+    mi.pchAnnotator = ReadString(&pch, pchEnd);
+    g_free(mi.pchComment);
+    mi.pchComment = ReadString(&pch, pchEnd);
+
+    mi.nYear = pbm->bh.nYear;
+    mi.nMonth = pbm->bh.nMonth;
+    mi.nDay = pbm->bh.nDay;
+}
+
+extern int
+BinMatchRestoreGame(const binmatch * pbm, unsigned int iGame)
+{
+    const binindex *pbi;
+    const char *pch;
+    moverecord *pmrGameInfo = NULL;
+    unsigned int i;
+
+    if (iGame >= pbm->bh.cGames)
+        return -1;
+
+    pbi = &pbm->abi[iGame];
+    pch = pbm->pch + pbi->iOffset;
+
+    /* as RestoreGame() in sgf.c */
+    InitBoard(ms.anBoard, ms.bgv);
+
+    ClearMoveRecord();
+
+    ListInsert(&lMatch, plGame);
+
+    ms.anDice[0] = ms.anDice[1] = 0;
+    ms.fResigned = ms.fDoubled = FALSE;
+    ms.nCube = 1;
+    ms.fTurn = ms.fMove = ms.fCubeOwner = -1;
+    ms.gs = GAME_NONE;
+
+    for (i = 0; i < pbi->cRecords; i++) {
+        binrecord br;
+        moverecord *pmr = g_new(moverecord, 1);
+        const char *pchData = pch + CB_RECORD_HEAD;
+
+        memcpy(&br, pch, sizeof(br));
+        memcpy(pmr, pch + sizeof(br), sizeof(moverecord));
+
+        /* the pointers of the file are meaningless */
+        pmr->sz = NULL;
+        pmr->ml.amMoves = NULL;
+        pmr->MoneyCubeDecPtr = NULL;
+        pmr->CubeDecPtr = &pmr->CubeDec;
+        if (br.fFlags & BR_MOVES) {
+            pmr->ml.amMoves = g_new(move, pmr->ml.cMoves);
+            memcpy(pmr->ml.amMoves, pchData, pmr->ml.cMoves * sizeof(move));
+            pchData += PAD8(pmr->ml.cMoves * sizeof(move));
+        }
+        if (br.fFlags & BR_MONEYCUBE) {
+            pmr->MoneyCubeDecPtr = g_new(cubedecisiondata, 1);
+            memcpy(pmr->MoneyCubeDecPtr, pchData, sizeof(cubedecisiondata));
+            pchData += PAD8(sizeof(cubedecisiondata));
+        }
+        if (br.fFlags & BR_TEXT)
+            pmr->sz = g_strdup(pchData);
+        if (br.fFlags & BR_LINKED)
+            LinkToDouble(pmr);
+
+        AddMoveRecord(pmr);
+
+        if (!i)
+            pmrGameInfo = pmr;
+        pch += br.cb;
+    }
+
+    if (pmrGameInfo)
+        AddGame(pmrGameInfo);
+
+    return 0;
+}
+
+extern void
+CommandLoadBinaryMatch(char *sz)
+{
+    binmatch *pbm;
+    unsigned int i;
+
+    sz = NextToken(&sz);
+
+    if (!sz || !*sz) {
+        outputl(_("You must specify a file to load from (see `help load " "binarymatch')."));
+        return;
+    }
+
+    if (!(pbm = BinMatchOpen(sz)))
+        return;
+
+    if (!get_input_discard()) {
+        BinMatchClose(pbm);
+        return;
+    }
+#if USE_GTK
+    if (fX) {                   /* Clear record to avoid ugly updates */
+        GTKClearMoveRecord();
+        GTKFreeze();
+    }
+#endif
+
+    FreeMatch();
+    ClearMatch();
+
+    BinMatchRestoreInfo(pbm);
+    for (i = 0; i < BinMatchGameCount(pbm); i++)
+        BinMatchRestoreGame(pbm, i);
+
+    BinMatchClose(pbm);
+
+    UpdateSettings();
+
+#if USE_GTK
+    if (fX) {
+        GTKThaw();
+        GTKSet(ap);
+    }
+#endif
+
+    setDefaultFileName(sz);
+
+    if (fGotoFirstGame)
+        CommandFirstGame(NULL);
+}
+
+extern void
+CommandSaveBinaryMatch(char *sz)
+{
+    sz = NextToken(&sz);
+
+    if (!plGame) {
+        outputl(_("No game in progress (type `new game' to start one)."));
+        return;
+    }
+
+    if (!sz || !*sz) {
+        outputl(_("You must specify a file to save to (see `help save " "binarymatch')."));
+        return;
+    }
+
+    if (!confirmOverwrite(sz, fConfirmSave))
+        return;
+
+    if (!BinMatchSave(sz))
+        setDefaultFileName(sz);
+}
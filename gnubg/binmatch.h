@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef BINMATCH_H
+#define BINMATCH_H
+
+/* Binary match files hold the move records of a match, with all their
+ * analysis, exactly as they are in memory.  They load much faster than
+ * SGF but are only readable by a gnubg built for the same kind of
+ * computer; SGF remains the format to exchange matches in.
+ *
+ * Layout (all offsets are from the start of the file and multiples
+ * of 8):
+ *
+ *   binheader
+ *   binindex[cGames]          offset and size of each game
+ *   match strings             player names and match information
+ *   games                     each a sequence of records: a binrecord
+ *                             header, the moverecord, then its move
+ *                             list, money cube analysis and annotation
+ *                             as the flags say
+ */
+
+#define BINMATCH_VERSION 1
+
+typedef struct _binmatch binmatch;
+
+/* Map a binary match file; NULL (with an error shown) if it can't be
+ * read or was written by an incompatible gnubg. */
+extern binmatch *BinMatchOpen(const char *szFile);
+extern void BinMatchClose(binmatch * pbm);
+extern unsigned int BinMatchGameCount(const binmatch * pbm);
+/* Set the player names and match information */
+extern void BinMatchRestoreInfo(const binmatch * pbm);
+/* Append game iGame to the current match */
+extern int BinMatchRestoreGame(const binmatch * pbm, unsigned int iGame);
+
+/* Write the current match; returns 0 on success */
+extern int BinMatchSave(const char *szFile);
+
+#endif                          /* BINMATCH_H */
@@ -0,0 +1,827 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "backgammon.h"
+#include "book.h"
+#include "matchequity.h"
+#include "md5.h"
+#include "multithread.h"
+#include "positionid.h"
+
+#define BOOK_MAGIC "GNUBGOB\n"
+#define BOOK_BYTEORDER 0x01020304u
+
+#define BOOK_MOVES 1
+#define BOOK_CUBE 2
+
+/* the depth of the books "save book" makes */
+#define BOOK_PLIES_DEFAULT 2
+#define BOOK_PLIES_MAX 4
+
+typedef struct {
+    char achMagic[8];
+    guint32 nVersion;
+    guint32 nByteOrder;         /* BOOK_BYTEORDER as written */
+    guint32 acbLayout[3];       /* sizes of the structures stored as they are */
+    guint32 cEntries;
+    unsigned char auchWeights[16];      /* EvalWeightsDigest() */
+    unsigned char auchMET[16];  /* METDigest() */
+    guint32 nPlies;             /* as made, for "show book" */
+    guint32 nMatchTo;
+} bookheader;
+
+typedef struct {
+    unsigned char auchKey[16];  /* BookKey() */
+    guint32 nType;
+    guint32 cMoves;             /* BOOK_MOVES: the length of the move list */
+    guint32 nMaxPly;            /* and how deep FindnSaveBestMoves() went */
+    guint32 cOldMoves;
+} bookentry;
+
+typedef struct {
+    positionkey key;
+    float rScore, rScore2;
+    float arEvalMove[NUM_ROLLOUT_OUTPUTS];
+    evalcontext ec;
+    guint32 et;
+} bookmove;
+
+typedef struct {
+    float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
+} bookcube;
+
+/* What the key digests; all fields are four bytes so there is no
+ * padding to clear */
+typedef struct {
+    guint32 nType;
+    positionkey key;
+    guint32 anDice[2];
+    gint32 anCube[10];
+    guint32 anEval[4];
+    gint32 aanFilter[MAX_FILTER_PLIES][2];
+    float arThreshold[MAX_FILTER_PLIES];
+    guint32 fAdaptive;
+    float rConfidence;
+    float aarSigma[MAX_FILTER_PLIES][MAX_FILTER_PLIES + 1];
+} bookkey;
+
+typedef struct {
+    GMappedFile *pmf;
+    char *szFile;
+    bookheader bh;
+    GHashTable *ph;             /* key -> bookentry in the file */
+    int fMET;                   /* made with the current MET */
+    unsigned int cMETChanges;
+    int cLookups, cHits;
+} book;
+
+/* the book in use, and the entries of one being made */
+static book *pbkLoaded = NULL;
+static GHashTable *phMaking = NULL;
+
+static void
+SetLayout(guint32 acb[3])
+{
+    acb[0] = sizeof(bookentry);
+    acb[1] = sizeof(bookmove);
+    acb[2] = sizeof(bookcube);
+}
+
+static void
+METDigest(unsigned char auchDigest[16])
+{
+    struct md5_ctx ctx;
+
+    md5_init_ctx(&ctx);
+    md5_process_bytes(aafMET, sizeof(aafMET), &ctx);
+    md5_process_bytes(aafMETPostCrawford, sizeof(aafMETPostCrawford), &ctx);
+    md5_finish_ctx(&ctx, auchDigest);
+}
+
+static guint
+BookHash(gconstpointer p)
+{
+    guint n;
+
+    memcpy(&n, p, sizeof(n));
+    return n;
+}
+
+static gboolean
+BookEqual(gconstpointer p0, gconstpointer p1)
+{
+    return !memcmp(p0, p1, 16);
+}
+
+static gsize
+EntrySize(const bookentry * pbe)
+{
+    return sizeof(bookentry) + (pbe->nType == BOOK_MOVES ? pbe->cMoves * sizeof(bookmove) : sizeof(bookcube));
+}
+
+/* Books only have searches without noise beyond 0-ply */
+static int
+BookUsable(const evalcontext * pec)
+{
+    return pec->nPlies && pec->rNoise == 0.0f;
+}
+
+/* and match play only with the MET they were made with */
+static int
+BookMETValid(const book * pbk)
+{
+    return pbk->fMET && pbk->cMETChanges == cMETChanges;
+}
+
+static void
+BookKey(unsigned char auchKey[16], guint32 nType, const TanBoard anBoard, int nDice0, int nDice1,
+        const cubeinfo * pci, const evalcontext * pec, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES])
+{
+    bookkey bk;
+    unsigned int i;
+
+    memset(&bk, 0, sizeof(bk));
+
+    bk.nType = nType;
+    PositionKey(anBoard, &bk.key);
+    bk.anDice[0] = (guint32) MAX(nDice0, nDice1);
+    bk.anDice[1] = (guint32) MIN(nDice0, nDice1);
+
+    bk.anCube[0] = pci->nCube;
+    bk.anCube[1] = pci->fCubeOwner;
+    bk.anCube[2] = pci->fMove;
+    bk.anCube[3] = pci->nMatchTo;
+    bk.anCube[4] = pci->anScore[0];
+    bk.anCube[5] = pci->anScore[1];
+    bk.anCube[6] = pci->fCrawford;
+    bk.anCube[7] = pci->fJacoby;
+    bk.anCube[8] = pci->fBeavers;
+    bk.anCube[9] = pci->bgv;
+
+    if (pec) {
+        bk.anEval[0] = pec->fCubeful;
+        bk.anEval[1] = pec->nPlies;
+        bk.anEval[2] = pec->fUsePrune;
+        bk.anEval[3] = pec->fDeterministic;
+    }
+
+    /* the filters FindnSaveBestMoves() uses */
+    if (pec && aamf && pec->nPlies) {
+        const movefilter *amf = aamf[MIN(pec->nPlies, MAX_FILTER_PLIES) - 1];
+
+        for (i = 0; i < MIN(pec->nPlies, MAX_FILTER_PLIES); i++) {
+            bk.aanFilter[i][0] = amf[i].Accept;
+            bk.aanFilter[i][1] = amf[i].Extra;
+            bk.arThreshold[i] = amf[i].Threshold;
+        }
+
+        /* which replace the thresholds when adaptive */
+        if (fAdaptiveFilters) {
+            bk.fAdaptive = TRUE;
+            bk.rConfidence = rFilterConfidence;
+            memcpy(bk.aarSigma, aarFilterSigma, sizeof(bk.aarSigma));
+        }
+    }
+
+    md5_buffer((const char *) &bk, sizeof(bk), auchKey);
+}
+
+static int
+BookMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoard,
+          const cubeinfo * pci, const evalcontext * pec,
+          movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], unsigned int *pnMaxPly, unsigned int *pcOldMoves)
+{
+    unsigned char auchKey[16];
+    const char *pch;
+    bookentry be;
+    move *pm;
+    unsigned int i, j;
+
+    if (!pbkLoaded || !BookUsable(pec) || (pci->nMatchTo && !BookMETValid(pbkLoaded)))
+        return FALSE;
+
+    MT_SafeInc(&pbkLoaded->cLookups);
+
+    BookKey(auchKey, BOOK_MOVES, anBoard, nDice0, nDice1, pci, pec, aamf);
+    if (!(pch = g_hash_table_lookup(pbkLoaded->ph, auchKey)))
+        return FALSE;
+
+    memcpy(&be, pch, sizeof(be));
+    pch += sizeof(be);
+
+    GenerateMoves(pml, anBoard, nDice0, nDice1, FALSE);
+    if (pml->cMoves != be.cMoves)
+        return FALSE;
+
+    /* the moves in the order the search left them, with its results */
+    pm = g_new(move, be.cMoves);
+    for (i = 0; i < be.cMoves; i++, pch += sizeof(bookmove)) {
+        bookmove bm;
+
+        memcpy(&bm, pch, sizeof(bm));
+        for (j = 0; j < pml->cMoves; j++)
+            if (EqualKeys(bm.key, pml->amMoves[j].key))
+                break;
+        if (j == pml->cMoves) {
+            g_free(pm);
+            return FALSE;
+        }
+
+        pm[i] = pml->amMoves[j];
+        pm[i].rScore = bm.rScore;
+        pm[i].rScore2 = bm.rScore2;
+        memcpy(pm[i].arEvalMove, bm.arEvalMove, sizeof(bm.arEvalMove));
+        memset(pm[i].arEvalStdDev, 0, sizeof(pm[i].arEvalStdDev));
+        memset(&pm[i].esMove, 0, sizeof(pm[i].esMove));
+        pm[i].esMove.et = (evaltype) bm.et;
+        pm[i].esMove.ec = bm.ec;
+        pm[i].cmark = CMARK_NONE;
+    }
+
+    pml->amMoves = pm;
+    pml->iMoveBest = 0;
+    pml->rBestScore = pm[0].rScore;
+    *pnMaxPly = be.nMaxPly;
+    *pcOldMoves = be.cOldMoves;
+
+    MT_SafeInc(&pbkLoaded->cHits);
+
+    return TRUE;
+}
+
+static void
+BookAdd(bookentry * pbe)
+{
+    MT_Exclusive();
+    if (g_hash_table_lookup(phMaking, pbe->auchKey))
+        g_free(pbe);
+    else
+        g_hash_table_insert(phMaking, pbe->auchKey, pbe);
+    MT_Release();
+}
+
+static void
+BookAddMoves(const movelist * pml, int nDice0, int nDice1, const TanBoard anBoard,
+             const cubeinfo * pci, const evalcontext * pec,
+             movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], unsigned int nMaxPly, unsigned int cOldMoves)
+{
+    bookentry *pbe;
+    bookmove *abm;
+    unsigned int i;
+
+    if (!phMaking || !BookUsable(pec))
+        return;
+
+    pbe = g_malloc0(sizeof(bookentry) + pml->cMoves * sizeof(bookmove));
+    BookKey(pbe->auchKey, BOOK_MOVES, anBoard, nDice0, nDice1, pci, pec, aamf);
+    pbe->nType = BOOK_MOVES;
+    pbe->cMoves = pml->cMoves;
+    pbe->nMaxPly = nMaxPly;
+    pbe->cOldMoves = cOldMoves;
+
+    abm = (bookmove *) (pbe + 1);
+    for (i = 0; i < pml->cMoves; i++) {
+        const move *pm = &pml->amMoves[i];
+
+        CopyKey(pm->key, abm[i].key);
+        abm[i].rScore = pm->rScore;
+        abm[i].rScore2 = pm->rScore2;
+        memcpy(abm[i].arEvalMove, pm->arEvalMove, sizeof(abm[i].arEvalMove));
+        abm[i].ec = pm->esMove.ec;
+        abm[i].et = pm->esMove.et;
+    }
+
+    BookAdd(pbe);
+}
+
+static int
+BookCube(float aarOutput[2][NUM_ROLLOUT_OUTPUTS], const TanBoard anBoard,
+         const cubeinfo * pci, const evalcontext * pec)
+{
+    unsigned char auchKey[16];
+    const char *pch;
+
+    if (!pbkLoaded || !BookUsable(pec) || (pci->nMatchTo && !BookMETValid(pbkLoaded)))
+        return FALSE;
+
+    MT_SafeInc(&pbkLoaded->cLookups);
+
+    BookKey(auchKey, BOOK_CUBE, anBoard, 0, 0, pci, pec, NULL);
+    if (!(pch = g_hash_table_lookup(pbkLoaded->ph, auchKey)))
+        return FALSE;
+
+    memcpy(aarOutput, pch + sizeof(bookentry), sizeof(bookcube));
+
+    MT_SafeInc(&pbkLoaded->cHits);
+
+    return TRUE;
+}
+
+static void
+BookAddCube(float aarOutput[2][NUM_ROLLOUT_OUTPUTS], const TanBoard anBoard,
+            const cubeinfo * pci, const evalcontext * pec)
+{
+    bookentry *pbe;
+
+    if (!phMaking || !BookUsable(pec))
+        return;
+
+    pbe = g_malloc0(sizeof(bookentry) + sizeof(bookcube));
+    BookKey(pbe->auchKey, BOOK_CUBE, anBoard, 0, 0, pci, pec, NULL);
+    pbe->nType = BOOK_CUBE;
+    memcpy(pbe + 1, aarOutput, sizeof(bookcube));
+
+    BookAdd(pbe);
+}
+
+static const evalbook ebBook = { BookMoves, BookAddMoves, BookCube, BookAddCube };
+
+static void
+UpdateHooks(void)
+{
+    pevalbook = (pbkLoaded || phMaking) ? &ebBook : NULL;
+}
+
+static void
+BookFree(book * pbk)
+{
+    if (pbk->ph)
+        g_hash_table_destroy(pbk->ph);
+#if GLIB_CHECK_VERSION(2,22,0)
+    g_mapped_file_unref(pbk->pmf);
+#else
+    g_mapped_file_free(pbk->pmf);
+#endif
+    g_free(pbk->szFile);
+    g_free(pbk);
+}
+
+/* The book is freed and replaced without a lock, which is safe because
+ * that only happens in commands. The calculation threads look it up
+ * while a command runs or while they ponder between commands, and
+ * Python threads while they evaluate without the GIL. HandleCommand()
+ * stops the pondering and waits for those evaluations before running
+ * any command (see PythonCommandBegin()), so nothing but the command
+ * itself can be using the book here. */
+
+extern void
+BookUnload(void)
+{
+    if (pbkLoaded) {
+        BookFree(pbkLoaded);
+        pbkLoaded = NULL;
+    }
+    UpdateHooks();
+}
+
+extern int
+BookLoad(const char *szFile)
+{
+    book *pbk;
+    GMappedFile *pmf;
+    GError *error = NULL;
+    guint32 acbLayout[3];
+    unsigned char auch[16];
+    const char *pch, *pchEnd;
+    unsigned int i;
+
+    if (!(pmf = g_mapped_file_new(szFile, FALSE, &error))) {
+        outputerrf("%s: %s", szFile, error->message);
+        g_error_free(error);
+        return -1;
+    }
+
+    pbk = g_new0(book, 1);
+    pbk->pmf = pmf;
+    pbk->szFile = g_strdup(szFile);
+    pch = g_mapped_file_get_contents(pmf);
+    pchEnd = pch + g_mapped_file_get_length(pmf);
+
+    if ((gsize) (pchEnd - pch) < sizeof(bookheader) || memcmp(pch, BOOK_MAGIC, 8)) {
+        outputerrf(_("%s: not an opening book"), szFile);
+        BookFree(pbk);
+        return -1;
+    }
+
+    memcpy(&pbk->bh, pch, sizeof(bookheader));
+    SetLayout(acbLayout);
+    if (pbk->bh.nVersion != BOOK_VERSION || pbk->bh.nByteOrder != BOOK_BYTEORDER
+        || memcmp(acbLayout, pbk->bh.acbLayout, sizeof(acbLayout))) {
+        outputerrf(_("%s: this opening book was made by a different "
+                     "version of GNU Backgammon or on a different kind of computer; "
+                     "make it again with `save book'"), szFile);
+        BookFree(pbk);
+        return -1;
+    }
+
+    EvalWeightsDigest(auch);
+    if (memcmp(auch, pbk->bh.auchWeights, sizeof(auch))) {
+        outputerrf(_("%s: this opening book was made with other neural net weights; "
+                     "make it again with `save book'"), szFile);
+        BookFree(pbk);
+        return -1;
+    }
+
+    METDigest(auch);
+    pbk->fMET = !memcmp(auch, pbk->bh.auchMET, sizeof(auch));
+    pbk->cMETChanges = cMETChanges;
+
+    /* index the entries, checking them so that lookups can trust them */
+    pbk->ph = g_hash_table_new(BookHash, BookEqual);
+    pch += sizeof(bookheader);
+    for (i = 0; i < pbk->bh.cEntries; i++) {
+        bookentry be;
+
+        if ((gsize) (pchEnd - pch) < sizeof(be))
+            break;
+        memcpy(&be, pch, sizeof(be));
+        if ((be.nType != BOOK_MOVES && be.nType != BOOK_CUBE)
+            || (be.nType == BOOK_MOVES
+                && (!be.cMoves || be.cMoves > (gsize) (pchEnd - pch) / sizeof(bookmove)
+                    || be.cOldMoves > be.cMoves))
+            || EntrySize(&be) > (gsize) (pchEnd - pch))
+            break;
+
+        g_hash_table_insert(pbk->ph, (gpointer) pch, (gpointer) pch);
+        pch += EntrySize(&be);
+    }
+
+    if (i < pbk->bh.cEntries || pch != pchEnd) {
+        outputerrf(_("%s: corrupt opening book"), szFile);
+        BookFree(pbk);
+        return -1;
+    }
+
+    /* unlocked, see BookUnload() */
+    BookUnload();
+    pbkLoaded = pbk;
+    UpdateHooks();
+
+    if (!pbk->fMET && pbk->bh.nMatchTo)
+        outputf(_("%s was made with a different match equity table; "
+                  "only its money play entries will be used.\n"), szFile);
+
+    return 0;
+}
+
+/* Making a book: the positions of each depth are found from the best
+ * moves at the one before, and all the rolls and cube decisions of a
+ * depth are searched in tasks of their own. The results are collected
+ * by the hooks as the searches find them. */
+
+typedef struct {
+    int nMatchTo;
+    int anScore[2];
+    int fCrawford;
+} bookscore;
+
+typedef struct {
+    unsigned char auchKey[16];
+    TanBoard anBoard;
+    unsigned int iScore;
+    int fMove;
+} booknode;
+
+typedef struct {
+    const booknode *pbn;
+    int anDice[2];              /* 0, 0 for the cube decision */
+    movelist ml;
+} bookitem;
+
+typedef struct {
+    const bookscore *abs;
+    bookitem *abi;
+    int iNext;
+    int cDone;
+} bookcalc;
+
+/* for BookProgress() */
+static bookcalc *pbcProgress;
+
+static void
+NodeCubeInfo(cubeinfo * pci, const bookscore * pbs, int fMove)
+{
+    SetCubeInfo(pci, 1, -1, fMove, pbs->nMatchTo, pbs->anScore, pbs->fCrawford, fJacoby, nBeavers, bgvDefault);
+}
+
+static void
+BookTask(void *p)
+{
+    bookcalc *pbc = (bookcalc *) p;
+    bookitem *pbi = &pbc->abi[MT_SafeIncCheck(&pbc->iNext)];
+    cubeinfo ci;
+
+    if (fInterrupt)
+        return;
+
+    NodeCubeInfo(&ci, &pbc->abs[pbi->pbn->iScore], pbi->pbn->fMove);
+
+    if (pbi->anDice[0]) {
+        if (FindnSaveBestMoves(&pbi->ml, pbi->anDice[0], pbi->anDice[1], (ConstTanBoard) pbi->pbn->anBoard,
+                               NULL, 0.0f, &ci, &esAnalysisChequer.ec, aamfAnalysis) < 0) {
+            MT_SetResultFailed();
+            return;
+        }
+    } else {
+        float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
+
+        if (GeneralCubeDecisionE(aarOutput, (ConstTanBoard) pbi->pbn->anBoard, &ci, &esAnalysisCube.ec,
+                                 &esAnalysisCube) < 0) {
+            MT_SetResultFailed();
+            return;
+        }
+    }
+
+    MT_SafeInc(&pbc->cDone);
+}
+
+static gboolean
+BookProgress(gpointer UNUSED(p))
+{
+    ProgressValue(MT_SafeGet(&pbcProgress->cDone));
+    return TRUE;
+}
+
+/* Add the position to the next depth unless it is already there */
+static void
+AddNode(GPtrArray * pa, GHashTable * ph, const TanBoard anBoard, unsigned int iScore, int fMove,
+        const bookscore abs[])
+{
+    booknode *pbn = g_new(booknode, 1);
+    cubeinfo ci;
+
+    memcpy(pbn->anBoard, anBoard, sizeof(pbn->anBoard));
+    pbn->iScore = iScore;
+    pbn->fMove = fMove;
+    NodeCubeInfo(&ci, &abs[iScore], fMove);
+    BookKey(pbn->auchKey, 0, (ConstTanBoard) pbn->anBoard, 0, 0, &ci, NULL, NULL);
+
+    if (g_hash_table_lookup(ph, pbn->auchKey))
+        g_free(pbn);
+    else {
+        g_hash_table_insert(ph, pbn->auchKey, pbn);
+        g_ptr_array_add(pa, pbn);
+    }
+}
+
+static void
+WriteEntry(gpointer UNUSED(key), gpointer p, gpointer pf)
+{
+    fwrite(p, EntrySize(p), 1, pf);
+}
+
+static int
+BookWrite(const char *szFile, unsigned int nPlies, int nMatchTo)
+{
+    FILE *pf;
+    bookheader bh;
+    int ret;
+
+    memset(&bh, 0, sizeof(bh));
+    memcpy(bh.achMagic, BOOK_MAGIC, sizeof(bh.achMagic));
+    bh.nVersion = BOOK_VERSION;
+    bh.nByteOrder = BOOK_BYTEORDER;
+    SetLayout(bh.acbLayout);
+    bh.cEntries = g_hash_table_size(phMaking);
+    EvalWeightsDigest(bh.auchWeights);
+    METDigest(bh.auchMET);
+    bh.nPlies = nPlies;
+    bh.nMatchTo = (guint32) nMatchTo;
+
+    if (!(pf = g_fopen(szFile, "wb"))) {
+        outputerr(szFile);
+        return -1;
+    }
+
+    fwrite(&bh, sizeof(bh), 1, pf);
+    g_hash_table_foreach(phMaking, WriteEntry, pf);
+
+    ret = ferror(pf) ? -1 : 0;
+    if (fclose(pf) || ret) {
+        outputerr(szFile);
+        ret = -1;
+    }
+
+    return ret;
+}
+
+static int
+BookMake(const char *szFile, unsigned int nPlies, int nMatchTo)
+{
+    GArray *pabs = g_array_new(FALSE, FALSE, sizeof(bookscore));
+    GPtrArray *pa = g_ptr_array_new(), *paNext;
+    GHashTable *phNodes = g_hash_table_new_full(BookHash, BookEqual, NULL, g_free);
+    bookcalc bc;
+    bookscore bs;
+    TanBoard anBoard;
+    int fCube = esAnalysisCube.et == EVAL_EVAL && esAnalysisCube.ec.nPlies && esAnalysisCube.ec.rNoise == 0.0f;
+    unsigned int iPly, i, j, k, cItems;
+    int ret = 0;
+
+    /* the scores: money, or all those of the match */
+    memset(&bs, 0, sizeof(bs));
+    bs.nMatchTo = nMatchTo;
+    if (!nMatchTo)
+        g_array_append_val(pabs, bs);
+    for (i = 0; (int) i < nMatchTo; i++)
+        for (j = 0; (int) j < nMatchTo; j++) {
+            bs.anScore[0] = (int) i;
+            bs.anScore[1] = (int) j;
+            bs.fCrawford = FALSE;
+            g_array_append_val(pabs, bs);
+            if (((int) i == nMatchTo - 1) != ((int) j == nMatchTo - 1)) {
+                bs.fCrawford = TRUE;
+                g_array_append_val(pabs, bs);
+            }
+        }
+
+    InitBoard(anBoard, bgvDefault);
+    for (i = 0; i < pabs->len; i++)
+        for (j = 0; j < 2; j++)
+            AddNode(pa, phNodes, (ConstTanBoard) anBoard, i, (int) j, (bookscore *) pabs->data);
+
+    phMaking = g_hash_table_new_full(BookHash, BookEqual, NULL, g_free);
+    UpdateHooks();
+
+    bc.abs = (bookscore *) pabs->data;
+    pbcProgress = &bc;
+
+    for (iPly = 0; iPly < nPlies && pa->len && !ret; iPly++) {
+        /* the 15 opening rolls, then all 21 rolls and the cube */
+        unsigned int cRolls = iPly ? 21 : 15;
+
+        cItems = pa->len * cRolls;
+        if (iPly && fCube)
+            cItems += pa->len;
+        bc.abi = g_new0(bookitem, cItems);
+        bc.iNext = 0;
+        bc.cDone = 0;
+
+        for (i = 0, k = 0; i < pa->len; i++) {
+            const booknode *pbn = g_ptr_array_index(pa, i);
+            cubeinfo ci;
+            int d0, d1;
+
+            for (d0 = 1; d0 <= 6; d0++)
+                for (d1 = iPly ? d0 : d0 + 1; d1 <= 6; d1++, k++) {
+                    bc.abi[k].pbn = pbn;
+                    bc.abi[k].anDice[0] = d1;
+                    bc.abi[k].anDice[1] = d0;
+                }
+
+            NodeCubeInfo(&ci, &bc.abs[pbn->iScore], pbn->fMove);
+            if (iPly && fCube && GetDPEq(NULL, NULL, &ci))
+                bc.abi[k++].pbn = pbn;
+        }
+        cItems = k;
+
+        ProgressStartValue(_("Making the opening book"), (int) cItems);
+        mt_add_tasks(cItems, BookTask, &bc, NULL);
+        ret = MT_WaitForTasks(BookProgress, UI_UPDATETIME, FALSE);
+        ProgressEnd();
+
+        if (ret < 0 || fInterrupt)
+            ret = -1;
+
+        /* the positions after the best moves and those close to them */
+        paNext = g_ptr_array_new();
+        for (k = 0; k < cItems; k++) {
+            const bookitem *pbi = &bc.abi[k];
+            const movelist *pml = &pbi->ml;
+
+            if (!ret && iPly + 1 < nPlies)
+                for (j = 0; j < pml->cMoves; j++) {
+                    const move *pm = &pml->amMoves[j];
+
+                    if (pm->esMove.ec.nPlies != pml->amMoves[0].esMove.ec.nPlies
+                        || pm->rScore < pml->amMoves[0].rScore - arSkillLevel[SKILL_DOUBTFUL])
+                        continue;
+
+                    PositionFromKey(anBoard, &pm->key);
+                    if (GameStatus((ConstTanBoard) anBoard, bgvDefault))
+                        continue;
+                    SwapSides(anBoard);
+                    AddNode(paNext, phNodes, (ConstTanBoard) anBoard, pbi->pbn->iScore, !pbi->pbn->fMove, bc.abs);
+                }
+            g_free(pml->amMoves);
+        }
+        g_free(bc.abi);
+
+        g_ptr_array_free(pa, TRUE);
+        pa = paNext;
+    }
+
+    /* phNodes owns the nodes */
+    g_hash_table_destroy(phNodes);
+    g_ptr_array_free(pa, TRUE);
+    g_array_free(pabs, TRUE);
+
+    if (!ret) {
+        ret = BookWrite(szFile, nPlies, nMatchTo);
+        if (!ret)
+            outputf(_("%u positions and rolls written to %s.\n"), g_hash_table_size(phMaking), szFile);
+    }
+
+    g_hash_table_destroy(phMaking);
+    phMaking = NULL;
+    UpdateHooks();
+
+    return ret;
+}
+
+extern void
+CommandLoadBook(char *sz)
+{
+    sz = NextToken(&sz);
+
+    if (!sz || !*sz) {
+        outputl(_("You must specify a file to load from (see `help load " "book')."));
+        return;
+    }
+
+    if (!BookLoad(sz))
+        outputf(_("Opening book %s loaded (%u entries).\n"), sz, pbkLoaded->bh.cEntries);
+}
+
+extern void
+CommandSaveBook(char *sz)
+{
+    char *szFile = NextToken(&sz);
+    int nPlies, nMatchTo;
+
+    if (!szFile || !*szFile) {
+        outputl(_("You must specify a file to save to (see `help save " "book')."));
+        return;
+    }
+
+    if ((nPlies = ParseNumber(&sz)) == INT_MIN)
+        nPlies = BOOK_PLIES_DEFAULT;
+    if ((nMatchTo = ParseNumber(&sz)) == INT_MIN)
+        nMatchTo = 0;
+
+    if (nPlies < 1 || nPlies > BOOK_PLIES_MAX) {
+        outputf(_("The book must cover from 1 to %d moves.\n"), BOOK_PLIES_MAX);
+        return;
+    }
+
+    if (nMatchTo < 0 || nMatchTo > MAXSCORE) {
+        outputf(_("The match length must be from 0 (money play) to %d.\n"), MAXSCORE);
+        return;
+    }
+
+    if (esAnalysisChequer.et != EVAL_EVAL || !esAnalysisChequer.ec.nPlies || esAnalysisChequer.ec.rNoise != 0.0f) {
+        outputl(_("Opening books are made with the chequer play analysis settings, which must be "
+                  "a neural net evaluation of at least 1 ply without noise (see `set analysis chequerplay')."));
+        return;
+    }
+
+    if (!confirmOverwrite(szFile, fConfirmSave))
+        return;
+
+    if (!BookMake(szFile, (unsigned int) nPlies, nMatchTo))
+        BookLoad(szFile);
+}
+
+extern void
+CommandShowBook(char *UNUSED(sz))
+{
+    if (!pbkLoaded) {
+        outputl(_("No opening book is loaded (see `help load book')."));
+        return;
+    }
+
+    outputf(_("Opening book %s:\n"), pbkLoaded->szFile);
+    outputf(_("  %u entries, %u moves deep, "), pbkLoaded->bh.cEntries, pbkLoaded->bh.nPlies);
+    if (pbkLoaded->bh.nMatchTo)
+        outputf(_("for %u point matches"), pbkLoaded->bh.nMatchTo);
+    else
+        output(_("for money play"));
+    if (pbkLoaded->bh.nMatchTo && !BookMETValid(pbkLoaded))
+        output(_(" (not used: made with a different match equity table)"));
+    outputc('\n');
+    outputf(_("  %d lookups, %d found\n"), MT_SafeGet(&pbkLoaded->cLookups), MT_SafeGet(&pbkLoaded->cHits));
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef BOOK_H
+#define BOOK_H
+
+/* Opening books hold the analysis of the first moves of a game: the
+ * move lists FindnSaveBestMoves() finds and the cube decisions
+ * GeneralCubeDecisionE() finds, keyed by a digest of the position, the
+ * dice, the cube and score, the evaluation context and the move
+ * filters. While a book is loaded those functions return the stored
+ * result instead of searching whenever the key matches, so the result
+ * is exactly what the search would have found.
+ *
+ * A book is made with "save book" from the analysis settings, and is
+ * only good for the neural net weights it was made with; match play
+ * entries are only used with the MET it was made with.
+ *
+ * Layout:
+ *
+ *   bookheader
+ *   entries                   each a bookentry, then cMoves bookmoves
+ *                             or one bookcube
+ */
+
+#define BOOK_VERSION 2
+
+/* Map a book and use it; returns 0 on success, and -1 with an error
+ * shown if it can't be read or was made with other weights. */
+extern int BookLoad(const char *szFile);
+extern void BookUnload(void);
+
+#endif                          /* BOOK_H */
@@ -57,6 +57,8 @@ static void SQLiteDisconnect(void);
 static RowSet *SQLiteSelect(const char *str);
 static int SQLiteUpdateCommand(const char *str);
 static void SQLiteCommit(void);
+static void SQLiteBegin(void);
+static int SQLiteInsert(const char *table, const DBRow * prow);
 #endif
 
 #if NUM_PROVIDERS
@@ -65,27 +67,29 @@ static GList *SQLiteGetDatabaseList(const char *user, const char *password, cons
 static DBProvider providers[NUM_PROVIDERS] = {
 #if defined(USE_SQLITE)
     {SQLiteConnect, SQLiteDisconnect, SQLiteSelect, SQLiteUpdateCommand, SQLiteCommit, SQLiteGetDatabaseList,
-     SQLiteDeleteDatabase,
+     SQLiteDeleteDatabase, SQLiteBegin, SQLiteInsert,
      "SQLite", "SQLite", N_("Direct SQLite3 connection"), FALSE, TRUE, "gnubg", "", "", ""},
 #endif
 #if defined(USE_PYTHON)
 #if !defined(USE_SQLITE)
     {PySQLiteConnect, PyDisconnect, PySelect, PyUpdateCommand, PyCommit, SQLiteGetDatabaseList, SQLiteDeleteDatabase,
+     NULL, NULL,
      "SQLite (Python)", "PythonSQLite", N_("SQLite3 connection via Python"), FALSE, TRUE, "gnubg",
      "", "", ""},
 #endif
     {PyMySQLConnect, PyDisconnect, PySelect, PyUpdateCommand, PyCommit, PyMySQLGetDatabaseList, PyMySQLDeleteDatabase,
+     NULL, NULL,
      "MySQL (Python)", "PythonMySQL", N_("MySQL/MariaDB connection via MySQLdb Python module"), TRUE, TRUE, "gnubg", "", "",
      "localhost:3306"},
     {PyPostgreConnect, PyDisconnect, PySelect, PyUpdateCommand, PyCommit, PyPostgreGetDatabaseList,
-     PyPostgreDeleteDatabase,
+     PyPostgreDeleteDatabase, NULL, NULL,
      "PostgreSQL (Python)", "PythonPostgre", N_("PostgreSQL connection via PyGreSQL Python module"), TRUE, TRUE, "gnubg", "",
      "", "localhost:5432"},
 #endif
 };
 
 #else
-DBProvider providers[1] = { {0, 0, 0, 0, 0, 0, 0, "No Providers", "No Providers", N_("No database providers"), 0, 0, 0, 0, 0, 0} };
+DBProvider providers[1] = { {0, 0, 0, 0, 0, 0, 0, 0, 0, "No Providers", "No Providers", N_("No database providers"), 0, 0, 0, 0, 0, 0} };
 #endif
 
 #if defined(USE_PYTHON) || defined(USE_SQLITE)
@@ -565,6 +569,7 @@ PyPostgreDeleteDatabase(const char *dbfilename, const char *user, const char *pa
 #include <sqlite3.h>
 
 static sqlite3 *connection;
+static GHashTable *phtStatements;       /* prepared INSERT statements by SQL text */
 
 int
 SQLiteConnect(const char *dbfilename, const char *UNUSED(user), const char *UNUSED(password),
@@ -591,6 +596,11 @@ SQLiteConnect(const char *dbfilename, const char *UNUSED(user), const char *UNUS
 static void
 SQLiteDisconnect(void)
 {
+    if (phtStatements) {
+        g_hash_table_destroy(phtStatements);
+        phtStatements = NULL;
+    }
+
     if (sqlite3_close(connection) != SQLITE_OK)
         outputerrf("SQL error: %s in sqlite3_close()", sqlite3_errmsg(connection));
 }
@@ -658,9 +668,88 @@ SQLiteUpdateCommand(const char *str)
     return (ret == SQLITE_OK);
 }
 
+static void
+SQLiteBegin(void)
+{
+    if (sqlite3_get_autocommit(connection))
+        SQLiteUpdateCommand("BEGIN");
+}
+
 static void
 SQLiteCommit(void)
-{                               /* No transaction in sqlite by default */
+{                               /* No transaction in sqlite unless SQLiteBegin() started one */
+    if (!sqlite3_get_autocommit(connection))
+        SQLiteUpdateCommand("COMMIT");
+}
+
+static void
+FinalizeStatement(gpointer p)
+{
+    sqlite3_finalize((sqlite3_stmt *) p);
+}
+
+static int
+SQLiteInsert(const char *table, const DBRow * prow)
+{
+    GString *gsSQL = g_string_new(NULL);
+    sqlite3_stmt *pStmt;
+    unsigned int i;
+    int iParam, ret;
+
+    g_string_append_printf(gsSQL, "INSERT INTO %s (", table);
+    for (i = 0; i < prow->cValues; i++)
+        g_string_append_printf(gsSQL, "%s%s", i ? ", " : "", prow->aValues[i].szColumn);
+    g_string_append(gsSQL, ") VALUES (");
+    for (i = 0; i < prow->cValues; i++)
+        g_string_append_printf(gsSQL, "%s%s", i ? ", " : "", prow->aValues[i].t == DB_NOW ? "CURRENT_TIMESTAMP" : "?");
+    g_string_append(gsSQL, ")");
+
+    if (!phtStatements)
+        phtStatements = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, FinalizeStatement);
+
+    if (!(pStmt = g_hash_table_lookup(phtStatements, gsSQL->str))) {
+#if SQLITE_VERSION_NUMBER >= 3003011
+        ret = sqlite3_prepare_v2(connection, gsSQL->str, -1, &pStmt, NULL);
+#else
+        ret = sqlite3_prepare(connection, gsSQL->str, -1, &pStmt, NULL);
+#endif
+        if (ret != SQLITE_OK) {
+            outputerrf("SQL error: %s\nfrom '%s'", sqlite3_errmsg(connection), gsSQL->str);
+            g_string_free(gsSQL, TRUE);
+            return FALSE;
+        }
+        g_hash_table_insert(phtStatements, g_strdup(gsSQL->str), pStmt);
+    }
+
+    for (i = 0, iParam = 1, ret = SQLITE_OK; i < prow->cValues && ret == SQLITE_OK; i++) {
+        const DBValue *pv = &prow->aValues[i];
+
+        switch (pv->t) {
+        case DB_INT:
+            ret = sqlite3_bind_int(pStmt, iParam++, pv->n);
+            break;
+        case DB_FLOAT:
+            ret = sqlite3_bind_double(pStmt, iParam++, pv->r);
+            break;
+        case DB_TEXT:
+            ret = sqlite3_bind_text(pStmt, iParam++, pv->sz, -1, SQLITE_TRANSIENT);
+            break;
+        case DB_NOW:
+            break;
+        }
+    }
+
+    if (ret == SQLITE_OK && (ret = sqlite3_step(pStmt)) == SQLITE_DONE)
+        ret = SQLITE_OK;
+
+    if (ret != SQLITE_OK)
+        outputerrf("SQL error: %s\nfrom '%s'", sqlite3_errmsg(connection), gsSQL->str);
+
+    sqlite3_reset(pStmt);
+    sqlite3_clear_bindings(pStmt);
+    g_string_free(gsSQL, TRUE);
+
+    return (ret == SQLITE_OK);
 }
 #endif
 
@@ -31,6 +31,32 @@ typedef struct {
     size_t *widths;
 } RowSet;
 
+/* A row to insert; values are bound to prepared statements by
+ * providers that support them, otherwise they are written into the
+ * INSERT statement */
+
+#define DB_MAX_COLUMNS 96
+
+typedef enum {
+    DB_INT,
+    DB_FLOAT,
+    DB_TEXT,
+    DB_NOW
+} DBValueType;
+
+typedef struct {
+    const char *szColumn;
+    DBValueType t;
+    int n;
+    double r;
+    const char *sz;
+} DBValue;
+
+typedef struct {
+    unsigned int cValues;
+    DBValue aValues[DB_MAX_COLUMNS];
+} DBRow;
+
 typedef struct {
     int (*Connect) (const char *database, const char *user, const char *password, const char *hostname);
     void (*Disconnect) (void);
@@ -39,6 +65,8 @@ typedef struct {
     void (*Commit) (void);
     GList *(*GetDatabaseList) (const char *user, const char *password, const char *hostname);
     int (*DeleteDatabase) (const char *database, const char *user, const char *password, const char *hostname);
+    void (*Begin) (void);       /* may be NULL if transactions start implicitly */
+    int (*Insert) (const char *table, const DBRow * prow);      /* may be NULL */
 
     const char *name;
     const char *shortname;
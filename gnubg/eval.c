@@ -29,6 +29,7 @@
 #include "isaac.h"
 #include "md5.h"
 #include "bearoffgammon.h"
+#include "osr.h"
 #include "positionid.h"
 #include "matchid.h"
 #include "matchequity.h"
@@ -203,6 +204,7 @@ f_FindBestMove FindBestMove = FindBestMoveNoLocking;
 f_EvaluatePosition EvaluatePosition = EvaluatePositionNoLocking;
 f_ScoreMove ScoreMove = ScoreMoveNoLocking;
 f_GeneralCubeDecisionE GeneralCubeDecisionE = GeneralCubeDecisionENoLocking;
+f_GeneralCubeDecisionsE GeneralCubeDecisionsE = GeneralCubeDecisionsENoLocking;
 f_GeneralEvaluationE GeneralEvaluationE = GeneralEvaluationENoLocking;
 
 #define FindnSaveBestMoves FindnSaveBestMovesNoLocking
@@ -210,6 +212,7 @@ f_GeneralEvaluationE GeneralEvaluationE = GeneralEvaluationENoLocking;
 #define EvaluatePosition EvaluatePositionNoLocking
 #define ScoreMove ScoreMoveNoLocking
 #define GeneralCubeDecisionE GeneralCubeDecisionENoLocking
+#define GeneralCubeDecisionsE GeneralCubeDecisionsENoLocking
 #define GeneralEvaluationE GeneralEvaluationENoLocking
 #define EvaluatePositionCache EvaluatePositionCacheNoLocking
 #define FindBestMovePlied FindBestMovePliedNoLocking
@@ -243,7 +246,13 @@ bearoffcontext *pbcOS = NULL;
 bearoffcontext *pbcTS = NULL;
 bearoffcontext *pbc1 = NULL;
 bearoffcontext *pbc2 = NULL;
-bearoffcontext *apbcHyper[3] = { NULL, NULL, NULL };
+static bearoffcontext *apbcHyper[3] = { NULL, NULL, NULL };
+static int afHyperOpened[3] = { FALSE, FALSE, FALSE };
+#if defined(USE_MULTITHREAD)
+static Mutex mutexHyper;
+#endif
+
+evalinitprofile eipInit;
 
 evalCache cEval;
 evalCache cpEval;
@@ -255,6 +264,12 @@ int fMatchCancelled = FALSE;
 
 bgvariation bgvDefault = VARIATION_STANDARD;
 
+const evalbook *pevalbook = NULL;
+
+/* replies FindnSaveBestMoves() looked up and found, see ReplyMemoStart() */
+int cReplyLookups = 0;
+int cReplyHits = 0;
+
 /* the number of chequers for the variations */
 
 int anChequers[NUM_VARIATIONS] = { 15, 15, 1, 2, 3 };
@@ -293,6 +308,10 @@ evalcontext ecBasic = { FALSE, 0, FALSE, TRUE, 0.0 };
 
 movefilter defaultFilters[MAX_FILTER_PLIES][MAX_FILTER_PLIES] = MOVEFILTER_NORMAL;
 
+int fAdaptiveFilters = FALSE;
+float rFilterConfidence = 2.0f;
+float aarFilterSigma[MAX_FILTER_PLIES][MAX_FILTER_PLIES + 1] = FILTER_SIGMA_DEFAULT;
+
 
 /* Random context, for generating non-deterministic noisy evaluations. */
 static randctx rc;
@@ -477,6 +496,9 @@ ComputeTable(void)
     ComputeTable1();
 }
 
+/* weights file the nets point into, if it could be mapped */
+static GMappedFile *pmfWeights = NULL;
+
 static void
 DestroyWeights(void)
 {
@@ -487,6 +509,44 @@ DestroyWeights(void)
     NeuralNetDestroy(&nnpContact);
     NeuralNetDestroy(&nnpCrashed);
     NeuralNetDestroy(&nnpRace);
+
+    if (pmfWeights) {
+#if GLIB_CHECK_VERSION(2,22,0)
+        g_mapped_file_unref(pmfWeights);
+#else
+        g_mapped_file_free(pmfWeights);
+#endif
+        pmfWeights = NULL;
+    }
+}
+
+static void
+DigestNet(struct md5_ctx *pctx, const neuralnet * pnn)
+{
+    md5_process_bytes(&pnn->cInput, sizeof(pnn->cInput), pctx);
+    md5_process_bytes(&pnn->cHidden, sizeof(pnn->cHidden), pctx);
+    md5_process_bytes(&pnn->cOutput, sizeof(pnn->cOutput), pctx);
+    md5_process_bytes(&pnn->rBetaHidden, sizeof(pnn->rBetaHidden), pctx);
+    md5_process_bytes(&pnn->rBetaOutput, sizeof(pnn->rBetaOutput), pctx);
+    md5_process_bytes(pnn->arHiddenWeight, pnn->cHidden * pnn->cInput * sizeof(float), pctx);
+    md5_process_bytes(pnn->arOutputWeight, pnn->cOutput * pnn->cHidden * sizeof(float), pctx);
+    md5_process_bytes(pnn->arHiddenThreshold, pnn->cHidden * sizeof(float), pctx);
+    md5_process_bytes(pnn->arOutputThreshold, pnn->cOutput * sizeof(float), pctx);
+}
+
+extern void
+EvalWeightsDigest(unsigned char auchDigest[16])
+{
+    struct md5_ctx ctx;
+
+    md5_init_ctx(&ctx);
+    DigestNet(&ctx, &nnContact);
+    DigestNet(&ctx, &nnRace);
+    DigestNet(&ctx, &nnCrashed);
+    DigestNet(&ctx, &nnpContact);
+    DigestNet(&ctx, &nnpRace);
+    DigestNet(&ctx, &nnpCrashed);
+    md5_finish_ctx(&ctx, auchDigest);
 }
 
 extern int
@@ -517,6 +577,58 @@ EvalShutdown(void)
 
 }
 
+/*
+ * Use the nets in a weights file written by "makeweights -m" in place,
+ * without reading them. The pages are shared with any other process
+ * mapping the same file. Returns -1 if the file isn't in that format,
+ * so that the caller can read it as an ordinary binary weights file.
+ */
+
+static int
+MapWeights(const char *szFilename)
+{
+    GMappedFile *pmf;
+    const char *pch;
+    size_t cb, off;
+    float ar[2];
+
+    if (!(pmf = g_mapped_file_new(szFilename, FALSE, NULL)))
+        return -1;
+
+    pch = g_mapped_file_get_contents(pmf);
+    cb = g_mapped_file_get_length(pmf);
+
+    if (cb < NN_MAPPED_ALIGN || ((gsize) pch & (NN_MAPPED_ALIGN - 1)))
+        goto failed;
+
+    memcpy(ar, pch, sizeof(ar));
+    if (ar[0] != WEIGHTS_MAGIC_MAPPED || ar[1] != WEIGHTS_VERSION_BINARY)
+        goto failed;
+
+    off = NN_MAPPED_ALIGN;
+    if (NeuralNetMap(&nnContact, pch, cb, &off) ||
+        NeuralNetMap(&nnRace, pch, cb, &off) ||
+        NeuralNetMap(&nnCrashed, pch, cb, &off) ||
+        NeuralNetMap(&nnpContact, pch, cb, &off) ||
+        NeuralNetMap(&nnpCrashed, pch, cb, &off) || NeuralNetMap(&nnpRace, pch, cb, &off)) {
+        perror(szFilename);
+        nnContact.fMapped = nnRace.fMapped = nnCrashed.fMapped = FALSE;
+        nnpContact.fMapped = nnpCrashed.fMapped = nnpRace.fMapped = FALSE;
+        goto failed;
+    }
+
+    pmfWeights = pmf;
+    return 0;
+
+  failed:
+#if GLIB_CHECK_VERSION(2,22,0)
+    g_mapped_file_unref(pmf);
+#else
+    g_mapped_file_free(pmf);
+#endif
+    return -1;
+}
+
 static int
 binary_weights_failed(char *filename, FILE * weights)
 {
@@ -577,6 +689,105 @@ weights_failed(char *filename, FILE * weights)
     return 0;
 }
 
+/*
+ * The hypergammon databases are only needed for hypergammon games, so
+ * they are opened the first time they are asked for rather than at
+ * start-up.
+ */
+
+extern bearoffcontext *
+GetHyperBearoff(const int i)
+{
+    g_assert(i >= 0 && i < 3);
+
+    if (!MT_SafeGet(&afHyperOpened[i])) {
+#if defined(USE_MULTITHREAD)
+        Mutex_Lock(&mutexHyper);
+#endif
+        if (!afHyperOpened[i]) {
+            char *fn;
+            char sz[10];
+
+            sprintf(sz, "hyper%1d.bd", i + 1);
+            fn = BuildFilename(sz);
+            apbcHyper[i] = BearoffInit(fn, BO_IN_MEMORY, NULL);
+            g_free(fn);
+
+            MT_SafeSet(&afHyperOpened[i], TRUE);
+        }
+#if defined(USE_MULTITHREAD)
+        Mutex_Release(&mutexHyper);
+#endif
+    }
+
+    return apbcHyper[i];
+}
+
+/* Whether GetHyperBearoff(i) will succeed, without reading the database */
+
+extern int
+HyperBearoffAvailable(const int i)
+{
+    char *fn;
+    char sz[10];
+    int f;
+
+    if (MT_SafeGet(&afHyperOpened[i]))
+        return apbcHyper[i] != NULL;
+
+    sprintf(sz, "hyper%1d.bd", i + 1);
+    fn = BuildFilename(sz);
+    f = g_file_test(fn, G_FILE_TEST_IS_REGULAR);
+    g_free(fn);
+
+    return f;
+}
+
+/* May run on a thread of its own: the heuristic one-sided database,
+ * whose progress is shown by the GUI, is left to EvalInitialise() */
+
+static gpointer
+LoadBearoffDatabases(gpointer UNUSED(unused))
+{
+    char *gnubg_bearoff;
+    char *gnubg_bearoff_os;
+    GTimer *timer = g_timer_new();
+
+    gnubg_bearoff_os = BuildFilename("gnubg_os0.bd");
+    if (!pbc1)
+        pbc1 = BearoffInit(gnubg_bearoff_os, BO_IN_MEMORY | BO_MUST_BE_ONE_SIDED, NULL);
+    g_free(gnubg_bearoff_os);
+
+    /* read two-sided db from gnubg.bd */
+    gnubg_bearoff = BuildFilename("gnubg_ts0.bd");
+    pbc2 = BearoffInit(gnubg_bearoff, BO_IN_MEMORY | BO_MUST_BE_TWO_SIDED, NULL);
+    g_free(gnubg_bearoff);
+
+    if (!pbc2)
+        g_printerr(
+              _("\n***WARNING***\n\n"
+                "GNU Backgammon will not use the two-sided bearoff\n"
+                "database since the gnubg_ts0.bd could not be found.\n"
+                "You should obtain this file or generate it yourself\n"
+                "with the command: makebearoff -t 6x6 -f gnubg_ts0.bd\n"
+                "You can also generate other bearoff databases; see\n" "README for more details\n\n"));
+
+    gnubg_bearoff_os = BuildFilename("gnubg_os.bd");
+    /* init one-sided db */
+    pbcOS = BearoffInit(gnubg_bearoff_os, BO_IN_MEMORY | BO_MUST_BE_ONE_SIDED, NULL);
+    g_free(gnubg_bearoff_os);
+
+    gnubg_bearoff = BuildFilename("gnubg_ts.bd");
+    /* init two-sided db */
+    pbcTS = BearoffInit(gnubg_bearoff, BO_IN_MEMORY | BO_MUST_BE_TWO_SIDED, NULL);
+    g_free(gnubg_bearoff);
+
+    eipInit.rBearoff = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+
+    return NULL;
+}
+
 extern void
 EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff, void (*pfProgress) (unsigned int))
 {
@@ -586,6 +797,10 @@ EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff, void (*pf
 #if defined(USE_SIMD_INSTRUCTIONS)
     int simderror = TRUE;
 #endif
+#if defined(USE_MULTITHREAD)
+    GThread *threadBearoff = NULL;
+#endif
+    GTimer *timer = g_timer_new();
 
     if (!fInitialised) {
 #if defined(USE_SIMD_INSTRUCTIONS)
@@ -637,59 +852,39 @@ EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff, void (*pf
             rc.randrsl[i] = rc.randrsl[0];
         irandinit(&rc, TRUE);
 
+#if defined(USE_MULTITHREAD)
+        InitMutex(&mutexHyper);
+#endif
+
         fInitialised = TRUE;
     }
 
-    if (!fNoBearoff) {
-        char *gnubg_bearoff;
-        char *gnubg_bearoff_os;
-
-        gnubg_bearoff_os = BuildFilename("gnubg_os0.bd");
-        if (!pbc1)
-            pbc1 = BearoffInit(gnubg_bearoff_os, BO_IN_MEMORY | BO_MUST_BE_ONE_SIDED, NULL);
-        g_free(gnubg_bearoff_os);
-
-        if (!pbc1)
-            pbc1 = BearoffInit(NULL, BO_HEURISTIC, pfProgress);
-
-        /* read two-sided db from gnubg.bd */
-        gnubg_bearoff = BuildFilename("gnubg_ts0.bd");
-        pbc2 = BearoffInit(gnubg_bearoff, BO_IN_MEMORY | BO_MUST_BE_TWO_SIDED, NULL);
-        g_free(gnubg_bearoff);
-
-        if (!pbc2)
-            g_printerr(
-                  _("\n***WARNING***\n\n"
-                    "GNU Backgammon will not use the two-sided bearoff\n"
-                    "database since the gnubg_ts0.bd could not be found.\n"
-                    "You should obtain this file or generate it yourself\n"
-                    "with the command: makebearoff -t 6x6 -f gnubg_ts0.bd\n"
-                    "You can also generate other bearoff databases; see\n" "README for more details\n\n"));
-
-        gnubg_bearoff_os = BuildFilename("gnubg_os.bd");
-        /* init one-sided db */
-        pbcOS = BearoffInit(gnubg_bearoff_os, BO_IN_MEMORY | BO_MUST_BE_ONE_SIDED, NULL);
-        g_free(gnubg_bearoff_os);
-
-        gnubg_bearoff = BuildFilename("gnubg_ts.bd");
-        /* init two-sided db */
-        pbcTS = BearoffInit(gnubg_bearoff, BO_IN_MEMORY | BO_MUST_BE_TWO_SIDED, NULL);
-        g_free(gnubg_bearoff);
-
-        /* hyper-gammon databases */
-
-        for (i = 0; i < 3; ++i) {
-            char *fn;
-            char sz[10];
-            sprintf(sz, "hyper%1d.bd", i + 1);
-            fn = BuildFilename(sz);
-            apbcHyper[i] = BearoffInit(fn, BO_IN_MEMORY, NULL);
-            g_free(fn);
-        }
+    eipInit.rTables = g_timer_elapsed(timer, NULL);
 
+    if (!fNoBearoff) {
+        /* the bearoff databases and the weights are independent of each
+         * other, so read them in parallel */
+#if defined(USE_MULTITHREAD)
+#if GLIB_CHECK_VERSION (2,32,0)
+        threadBearoff = g_thread_try_new(NULL, LoadBearoffDatabases, NULL, NULL);
+#else
+        threadBearoff = g_thread_create(LoadBearoffDatabases, NULL, TRUE, NULL);
+#endif
+        if (!threadBearoff)
+#endif
+            LoadBearoffDatabases(NULL);
+    } else {
+        /* don't open the hypergammon databases later either */
+        for (i = 0; i < 3; ++i)
+            afHyperOpened[i] = TRUE;
     }
 
-    if (szWeightsBinary) {
+    g_timer_start(timer);
+
+    if (szWeightsBinary)
+        fReadWeights = !MapWeights(szWeightsBinary);
+
+    if (!fReadWeights && szWeightsBinary) {
         pfWeights = g_fopen(szWeightsBinary, "rb");
         if (!binary_weights_failed(szWeightsBinary, pfWeights)) {
             if (!fReadWeights && !(fReadWeights =
@@ -726,6 +921,21 @@ EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff, void (*pf
         pfWeights = NULL;
     }
 
+    eipInit.rWeights = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+
+#if defined(USE_MULTITHREAD)
+    if (threadBearoff)
+        g_thread_join(threadBearoff);
+#endif
+
+    if (!fNoBearoff && !pbc1) {
+        timer = g_timer_new();
+        pbc1 = BearoffInit(NULL, BO_HEURISTIC, pfProgress);
+        eipInit.rBearoff += g_timer_elapsed(timer, NULL);
+        g_timer_destroy(timer);
+    }
+
     g_assert(fReadWeights);
 
     g_assert(nnContact.cInput == NUM_INPUTS && nnContact.cOutput == NUM_OUTPUTS);
@@ -1902,7 +2112,7 @@ static int
 EvalHypergammon1(const TanBoard anBoard, float arOutput[], const bgvariation UNUSED(bgv), NNState * UNUSED(nnStates))
 {
 
-    return BearoffEval(apbcHyper[0], anBoard, arOutput);
+    return BearoffEval(GetHyperBearoff(0), anBoard, arOutput);
 
 }
 
@@ -1910,7 +2120,7 @@ static int
 EvalHypergammon2(const TanBoard anBoard, float arOutput[], const bgvariation UNUSED(bgv), NNState * UNUSED(nnStates))
 {
 
-    return BearoffEval(apbcHyper[1], anBoard, arOutput);
+    return BearoffEval(GetHyperBearoff(1), anBoard, arOutput);
 
 }
 
@@ -1918,7 +2128,7 @@ static int
 EvalHypergammon3(const TanBoard anBoard, float arOutput[], const bgvariation UNUSED(bgv), NNState * UNUSED(nnStates))
 {
 
-    return BearoffEval(apbcHyper[2], anBoard, arOutput);
+    return BearoffEval(GetHyperBearoff(2), anBoard, arOutput);
 
 }
 
@@ -3021,7 +3231,7 @@ static void
 StatusHypergammon1(char *sz)
 {
 
-    BearoffStatus(apbcHyper[0], sz);
+    BearoffStatus(GetHyperBearoff(0), sz);
 
 }
 
@@ -3029,7 +3239,7 @@ static void
 StatusHypergammon2(char *sz)
 {
 
-    BearoffStatus(apbcHyper[1], sz);
+    BearoffStatus(GetHyperBearoff(1), sz);
 
 }
 
@@ -3037,7 +3247,7 @@ static void
 StatusHypergammon3(char *sz)
 {
 
-    BearoffStatus(apbcHyper[2], sz);
+    BearoffStatus(GetHyperBearoff(2), sz);
 
 }
 
@@ -3121,6 +3331,9 @@ EvalStatus(char *szOutput)
             acsf[i] (strchr(szOutput, 0));
 
     sprintf(strchr(szOutput, 0), _(" * " "Weights file and databases installed in" ":\n   - %s\n"), getPkgDataDir());
+
+    sprintf(strchr(szOutput, 0), _(" * Replies reused by deeper move searches: %u of %u\n"),
+            (unsigned int) MT_SafeGet(&cReplyHits), (unsigned int) MT_SafeGet(&cReplyLookups));
 }
 
 
@@ -3185,6 +3398,7 @@ void
 CommandClearCache(char *UNUSED(sz))
 {
     EvalCacheFlush();
+    OSRCacheFlush();
 }
 
 extern double
@@ -3704,7 +3918,8 @@ Cl2CfMatchCentered(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 
     float rMWCDead, rMWCLive;
     float rMWCOppCash, rMWCCash, rOppTG, rTG;
-    float aarMETResult[2][DTLBP1 + 1];
+    metresults mr;
+    const float (*aarMETResult)[DTLBP1 + 1];
 
     /* Centered cube */
 
@@ -3734,8 +3949,7 @@ Cl2CfMatchCentered(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 
     GetPoints(arOutput, pci, arCP);
 
-    getMEMultiple(pci->anScore[0], pci->anScore[1], pci->nMatchTo,
-                  pci->nCube, -1, -1, pci->fCrawford, aafMET, aafMETPostCrawford, aarMETResult[0], aarMETResult[1]);
+    aarMETResult = getMEMemo(pci->anScore[0], pci->anScore[1], pci->nMatchTo, pci->nCube, pci->fCrawford, &mr)->aar;
 
     rMWCCash = aarMETResult[pci->fMove][NDW];
 
@@ -3809,7 +4023,8 @@ Cl2CfMatchOwned(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 
     float rMWCDead, rMWCLive;
     float rMWCCash, rTG;
-    float aarMETResult[2][DTLBP1 + 1];
+    metresults mr;
+    const float (*aarMETResult)[DTLBP1 + 1];
 
     /* I own cube */
 
@@ -3839,8 +4054,7 @@ Cl2CfMatchOwned(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 
     GetPoints(arOutput, pci, arCP);
 
-    getMEMultiple(pci->anScore[0], pci->anScore[1], pci->nMatchTo,
-                  pci->nCube, -1, -1, pci->fCrawford, aafMET, aafMETPostCrawford, aarMETResult[0], aarMETResult[1]);
+    aarMETResult = getMEMemo(pci->anScore[0], pci->anScore[1], pci->nMatchTo, pci->nCube, pci->fCrawford, &mr)->aar;
 
     rMWCCash = aarMETResult[pci->fMove][NDW];
 
@@ -3910,7 +4124,8 @@ Cl2CfMatchUnavailable(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 
     float rMWCDead, rMWCLive;
     float rMWCOppCash, rOppTG;
-    float aarMETResult[2][DTLBP1 + 1];
+    metresults mr;
+    const float (*aarMETResult)[DTLBP1 + 1];
 
     /* I own cube */
 
@@ -3940,8 +4155,7 @@ Cl2CfMatchUnavailable(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 
     GetPoints(arOutput, pci, arCP);
 
-    getMEMultiple(pci->anScore[0], pci->anScore[1], pci->nMatchTo,
-                  pci->nCube, -1, -1, pci->fCrawford, aafMET, aafMETPostCrawford, aarMETResult[0], aarMETResult[1]);
+    aarMETResult = getMEMemo(pci->anScore[0], pci->anScore[1], pci->nMatchTo, pci->nCube, pci->fCrawford, &mr)->aar;
 
     rMWCOppCash = aarMETResult[pci->fMove][NDL];
 
@@ -4026,6 +4240,232 @@ Cl2CfMatch(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX)
 }
 
 
+/*
+ * Cl2CfMoney() or Cl2CfMatch() for all the cube positions of aci[] with
+ * nCube > 0 at once, with the same cube efficiency rCubeX. Cl2CfManyOf()
+ * does either the money or the match positions.
+ *
+ * In every case the live cube equity (or MWC) is a linear interpolation
+ * of p = arOutput[ OUTPUT_WIN ] between the nodes
+ *
+ *   (0, y0), (x1, y1), (x2, y2), (1, y3)
+ *
+ * with x1 = x2 when the middle segment doesn't exist (owned or
+ * unavailable cube). The nodes are worked out position by position
+ * (for match play that means GetPoints() and the MET) into one array
+ * per quantity; the interpolation and the mix with the dead cube then
+ * run as branch free loops over the arrays, which the compiler
+ * vectorises with the SIMD instructions of the build. The arithmetic is
+ * that of the scalar functions.
+ */
+
+static void
+Cl2CfManyOf(float arOutput[NUM_OUTPUTS], cubeinfo aci[], int n, float rCubeX, float arCf[], int fMatch)
+{
+    const float p = arOutput[OUTPUT_WIN];
+    int *ai = (int *) g_alloca(n * sizeof(int));
+    float *arDead = (float *) g_alloca(n * sizeof(float));
+    float *arX = (float *) g_alloca(n * sizeof(float));
+    float *arX1 = (float *) g_alloca(n * sizeof(float));
+    float *arX2 = (float *) g_alloca(n * sizeof(float));
+    float *arY0 = (float *) g_alloca(n * sizeof(float));
+    float *arY1 = (float *) g_alloca(n * sizeof(float));
+    float *arY2 = (float *) g_alloca(n * sizeof(float));
+    float *arY3 = (float *) g_alloca(n * sizeof(float));
+    float *arY2Last = (float *) g_alloca(n * sizeof(float));
+    float *arD1 = (float *) g_alloca(n * sizeof(float));
+    float *arD2 = (float *) g_alloca(n * sizeof(float));
+    float *arD3 = (float *) g_alloca(n * sizeof(float));
+    float *arR1 = (float *) g_alloca(n * sizeof(float));
+    float *arR2 = (float *) g_alloca(n * sizeof(float));
+    float *arR3 = (float *) g_alloca(n * sizeof(float));
+    float *arResult = (float *) g_alloca(n * sizeof(float));
+    int i, c;
+
+    for (i = 0, c = 0; i < n; i++)
+        if (aci[i].nCube > 0 && !aci[i].nMatchTo == !fMatch)
+            ai[c++] = i;
+
+    if (!c)
+        return;
+
+    if (!fMatch) {
+
+        const float epsilon = 0.0000001f;
+        const float omepsilon = 0.9999999f;
+        float rW, rL, rTP, rCP;
+
+        if (p <= epsilon || p >= omepsilon) {
+            /* basically a dead cube */
+            for (i = 0; i < c; i++)
+                arCf[ai[i]] = Utility(arOutput, &aci[ai[i]]);
+            return;
+        }
+
+        /* Janowski's average win and loss and the take and cash points
+         * are the same for every cube position */
+
+        rW = 1.0f + (arOutput[OUTPUT_WINGAMMON] + arOutput[OUTPUT_WINBACKGAMMON]) / p;
+        rL = 1.0f + (arOutput[OUTPUT_LOSEGAMMON] + arOutput[OUTPUT_LOSEBACKGAMMON]) / (1.0f - p);
+        rTP = (rL - 0.5f) / (rW + rL + 0.5f);
+        rCP = (rL + 1.0f) / (rW + rL + 0.5f);
+
+        for (i = 0; i < c; i++) {
+            const cubeinfo *pci = &aci[ai[i]];
+
+            arDead[i] = Utility(arOutput, pci);
+            arX[i] = rCubeX;
+            arY0[i] = -rL;
+            arY3[i] = rW;
+
+            if (pci->fCubeOwner == -1) {
+                arX1[i] = rTP;
+                arX2[i] = rCP;
+                arY1[i] = -1.0f;
+                arY2[i] = 1.0f;
+                if (pci->fJacoby) {
+                    /* flat beyond the take and cash points */
+                    arY0[i] = -1.0f;
+                    arY3[i] = 1.0f;
+                }
+            } else if (pci->fCubeOwner == pci->fMove) {
+                arX1[i] = arX2[i] = rCP;
+                arY1[i] = arY2[i] = 1.0f;
+            } else {
+                arX1[i] = arX2[i] = rTP;
+                arY1[i] = arY2[i] = -1.0f;
+            }
+        }
+
+    } else {
+
+        float rG0, rBG0, rG1, rBG1;
+
+        /* normal, gammon, and backgammon ratios */
+
+        if (p > 0.0f) {
+            rG0 = (arOutput[OUTPUT_WINGAMMON] - arOutput[OUTPUT_WINBACKGAMMON]) / p;
+            rBG0 = arOutput[OUTPUT_WINBACKGAMMON] / p;
+        } else {
+            rG0 = 0.0f;
+            rBG0 = 0.0f;
+        }
+
+        if (p < 1.0f) {
+            rG1 = (arOutput[OUTPUT_LOSEGAMMON] - arOutput[OUTPUT_LOSEBACKGAMMON]) / (1.0f - p);
+            rBG1 = arOutput[OUTPUT_LOSEBACKGAMMON] / (1.0f - p);
+        } else {
+            rG1 = 0.0f;
+            rBG1 = 0.0f;
+        }
+
+        for (i = 0; i < c; i++) {
+            cubeinfo *pci = &aci[ai[i]];
+            metresults mr;
+            const float (*aarMETResult)[DTLBP1 + 1];
+            float arCP[2];
+            float rMWCCash, rMWCOppCash, rTG, rOppTG;
+
+            /* MWC(dead cube) = cubeless equity */
+
+            arDead[i] = eq2mwc(Utility(arOutput, pci), pci);
+
+            if (!fDoCubeful(pci)) {
+                /* no live cube: all nodes 0, weight 0 */
+                arX[i] = 0.0f;
+                arX1[i] = arX2[i] = 0.0f;
+                arY0[i] = arY1[i] = arY2[i] = arY3[i] = 0.0f;
+                continue;
+            }
+
+            GetPoints(arOutput, pci, arCP);
+
+            aarMETResult = getMEMemo(pci->anScore[0], pci->anScore[1], pci->nMatchTo, pci->nCube, pci->fCrawford, &mr)->aar;
+
+            rMWCCash = aarMETResult[pci->fMove][NDW];
+            rMWCOppCash = aarMETResult[pci->fMove][NDL];
+
+            rOppTG = 1.0f - arCP[!pci->fMove];
+            rTG = arCP[pci->fMove];
+
+            arX[i] = rCubeX;
+            arY0[i] = (1.0f - rG1 - rBG1) * aarMETResult[pci->fMove][NDL]
+                + rG1 * aarMETResult[pci->fMove][NDLG]
+                + rBG1 * aarMETResult[pci->fMove][NDLB];
+            arY3[i] = (1.0f - rG0 - rBG0) * aarMETResult[pci->fMove][NDW]
+                + rG0 * aarMETResult[pci->fMove][NDWG]
+                + rBG0 * aarMETResult[pci->fMove][NDWB];
+
+            if (pci->fCubeOwner == -1) {
+                arX1[i] = rOppTG;
+                arX2[i] = rTG;
+                arY1[i] = rMWCOppCash;
+                arY2[i] = rMWCCash;
+            } else if (pci->fCubeOwner == pci->fMove) {
+                arX1[i] = arX2[i] = rTG;
+                arY1[i] = arY2[i] = rMWCCash;
+            } else {
+                arX1[i] = arX2[i] = rOppTG;
+                arY1[i] = arY2[i] = rMWCOppCash;
+            }
+        }
+
+    }
+
+    /* Where a segment can't be chosen its denominator is replaced by
+     * 1, so that every lane stays finite and the loops below need no
+     * branches. The first segment with x1 <= 0 is only chosen at p = 0
+     * and still gives y0; the last with x2 >= 1 only at p = 1, where
+     * the scalar code returns y3. */
+
+    for (i = 0; i < c; i++) {
+        const float x1 = arX1[i];
+        const float x2 = arX2[i];
+        const float y2 = arY2[i];
+        const float y3 = arY3[i];
+
+        arD1[i] = (x1 > 0.0f) ? x1 : 1.0f;
+        arD2[i] = (x2 > x1) ? x2 - x1 : 1.0f;
+        arD3[i] = (x2 < 1.0f) ? 1.0f - x2 : 1.0f;
+        arY2Last[i] = (x2 < 1.0f) ? y2 : y3;
+    }
+
+    /* the three segments at p */
+
+    for (i = 0; i < c; i++) {
+        arR1[i] = arY0[i] + (arY1[i] - arY0[i]) * p / arD1[i];
+        arR2[i] = arY1[i] + (arY2[i] - arY1[i]) * (p - arX1[i]) / arD2[i];
+        arR3[i] = arY2Last[i] + (arY3[i] - arY2Last[i]) * (p - arX2[i]) / arD3[i];
+    }
+
+    /* Pick the segment (match play includes x1 in the first, money
+     * play doesn't) and mix: (1-x) MWC(dead) + x MWC(live) */
+
+    for (i = 0; i < c; i++) {
+        const float x1 = arX1[i];
+        const float x2 = arX2[i];
+        const float r1 = arR1[i];
+        const float r2 = arR2[i];
+        const float r3 = arR3[i];
+        const float rLive = (p < x1 || (fMatch && p == x1)) ? r1 : ((p < x2) ? r2 : r3);
+
+        arResult[i] = arDead[i] * (1.0f - arX[i]) + rLive * arX[i];
+    }
+
+    for (i = 0; i < c; i++)
+        arCf[ai[i]] = arResult[i];
+
+}
+
+extern void
+Cl2CfMany(float arOutput[NUM_OUTPUTS], cubeinfo aci[], int n, float rCubeX, float arCf[])
+{
+    /* the money positions (such as those ScoreMapCubeStatic() mixes in
+     * with match positions) and the match positions separately */
+    Cl2CfManyOf(arOutput, aci, n, rCubeX, arCf, FALSE);
+    Cl2CfManyOf(arOutput, aci, n, rCubeX, arCf, TRUE);
+}
+
 
 extern float
 EvalEfficiency(const TanBoard anBoard, positionclass pc)
@@ -5247,6 +5687,7 @@ DoubleType(const int fDoubled, const int fMove, const int fTurn)
 #define EvaluatePosition EvaluatePositionWithLocking
 #define ScoreMove ScoreMoveWithLocking
 #define GeneralCubeDecisionE GeneralCubeDecisionEWithLocking
+#define GeneralCubeDecisionsE GeneralCubeDecisionsEWithLocking
 #define GeneralEvaluationE GeneralEvaluationEWithLocking
 #define EvaluatePositionCache EvaluatePositionCacheWithLocking
 #define FindBestMovePlied FindBestMovePliedWithLocking
@@ -5291,6 +5732,119 @@ static int ScoreMovesPruned(movelist * pml, const cubeinfo * pci, const evalcont
 #define MIN_PRUNE_MOVES 5
 #define MAX_PRUNE_MOVES (MIN_PRUNE_MOVES + 11)
 
+/*
+ * The replies FindBestMoveInEval() chooses only depend on the position,
+ * the roll and 0-ply evaluations, so when FindnSaveBestMoves() searches
+ * its candidates at n plies it chooses the same replies at the first
+ * n - 1 levels as it did at all the levels of the search at n - 1
+ * plies. Each thread keeps the replies of the shallower searches in a
+ * table of its own, so that the deepest one only has to choose the
+ * replies at its last level. The entries are stamped with the
+ * FindnSaveBestMoves() call that made them and are only used by that
+ * call, so they never outlive the weights they were made with.
+ */
+
+#define REPLYMEMO_SIZE (1 << 15)
+
+/* defined in the first pass, counted in both */
+extern int cReplyLookups;
+extern int cReplyHits;
+
+typedef struct {
+    positionkey key;
+    unsigned int nContext;      /* EvalKey() at 0-ply */
+    unsigned int nStamp;        /* the search, and the roll in the low 6 bits */
+    positionkey keyReply;
+} replyentry;
+
+typedef struct _replymemo {
+    unsigned int nStamp;
+    int fUse;
+    int fStore;                 /* the search will go deeper */
+    int cLookups, cHits;
+    replyentry are[REPLYMEMO_SIZE];
+} replymemo;
+
+static replymemo *
+ReplyMemoStart(const cubeinfo * pci, const evalcontext * pec)
+{
+    ThreadLocalData *ptld = MT_GetTLD();
+    replymemo *prm;
+
+    /* only searches deeper than one ply choose replies twice */
+    if (pec->nPlies < 2 || !pec->fUsePrune || pec->rNoise != 0.0f || pci->bgv != VARIATION_STANDARD)
+        return NULL;
+
+    if (!(prm = ptld->prm))
+        prm = ptld->prm = g_new0(replymemo, 1);
+
+    if (++prm->nStamp == 1u << 26) {
+        memset(prm->are, 0, sizeof(prm->are));
+        prm->nStamp = 1;
+    }
+    prm->fUse = TRUE;
+
+    return prm;
+}
+
+static void
+ReplyMemoEnd(replymemo * prm)
+{
+    if (!prm)
+        return;
+
+    prm->fUse = prm->fStore = FALSE;
+    MT_SafeAdd(&cReplyLookups, prm->cLookups);
+    MT_SafeAdd(&cReplyHits, prm->cHits);
+    prm->cLookups = prm->cHits = 0;
+}
+
+/* The entry for the reply to nDice0-nDice1 in anBoard, with *pre set up
+ * to be stored in it; NULL if the table isn't in use. Sets *pfFound if
+ * the entry holds the reply. */
+static replyentry *
+ReplyMemoFind(replyentry * pre, int *pfFound, int nDice0, int nDice1, const TanBoard anBoard,
+              const cubeinfo * pci, const evalcontext * pec)
+{
+    replymemo *prm = MT_GetTLD()->prm;
+    replyentry *preFound;
+    unsigned int h;
+    int i;
+
+    *pfFound = FALSE;
+
+    if (!prm || !prm->fUse)
+        return NULL;
+
+    PositionKey(anBoard, &pre->key);
+    pre->nContext = EvalKey(pec, 0, pci, TRUE);
+    pre->nStamp = (prm->nStamp << 6) | (unsigned int) (nDice0 * 7 + nDice1);
+
+    /* FNV-1a over the key */
+    h = 2166136261u ^ pre->nContext ^ (pre->nStamp & 63);
+    for (i = 0; i < 7; i++)
+        h = (h ^ pre->key.data[i]) * 16777619u;
+    preFound = &prm->are[(h ^ (h >> 15)) & (REPLYMEMO_SIZE - 1)];
+
+    prm->cLookups++;
+    if (preFound->nStamp == pre->nStamp && preFound->nContext == pre->nContext && EqualKeys(preFound->key, pre->key)) {
+        prm->cHits++;
+        *pfFound = TRUE;
+        return preFound;
+    }
+
+    return prm->fStore ? preFound : NULL;
+}
+
+static void
+ReplyMemoStore(replyentry * preFound, replyentry * pre, const positionkey * pkeyReply)
+{
+    if (preFound) {
+        CopyKey((*pkeyReply), pre->keyReply);
+        *preFound = *pre;
+    }
+}
+
 static SIMD_AVX_STACKALIGN void
 FindBestMoveInEval(NNState * nnStates, int const nDice0, int const nDice1, const TanBoard anBoardIn,
                    TanBoard anBoardOut, cubeinfo * const pci, const evalcontext * pec)
@@ -5300,6 +5854,14 @@ FindBestMoveInEval(NNState * nnStates, int const nDice0, int const nDice1, const
     positionclass evalClass = CLASS_OVER;
     unsigned int bmovesi[MAX_PRUNE_MOVES];
     unsigned int prune_moves;
+    replyentry re, *pre;
+    int fFound;
+
+    /* chosen before by a shallower search? */
+    if ((pre = ReplyMemoFind(&re, &fFound, nDice0, nDice1, anBoardIn, pci, pec)) && fFound) {
+        PositionFromKey(anBoardOut, &pre->keyReply);
+        return;
+    }
 
     GenerateMoves(&ml, anBoardIn, nDice0, nDice1, FALSE);
 
@@ -5321,6 +5883,7 @@ FindBestMoveInEval(NNState * nnStates, int const nDice0, int const nDice1, const
     if (ml.cMoves <= prune_moves) {
         ScoreMoves(&ml, pci, pec, 0);
         PositionFromKey(anBoardOut, &ml.amMoves[ml.iMoveBest].key);
+        ReplyMemoStore(pre, &re, &ml.amMoves[ml.iMoveBest].key);
         return;
     }
 
@@ -5401,6 +5964,7 @@ FindBestMoveInEval(NNState * nnStates, int const nDice0, int const nDice1, const
         ScoreMoves(&ml, pci, pec, 0);
 
     PositionFromKey(anBoardOut, &ml.amMoves[ml.iMoveBest].key);
+    ReplyMemoStore(pre, &re, &ml.amMoves[ml.iMoveBest].key);
 }
 
 static int
@@ -5655,6 +6219,18 @@ ScoreMovesPruned(movelist * pml, const cubeinfo * pci, const evalcontext * pec,
 
 static movefilter NullFilter = { -1, 0, 0.0 };
 
+/* The margin of the adaptive filter at iPly, from the error of iPly
+ * relative to the next ply the moves kept are scored at */
+static float
+AdaptiveThreshold(const movefilter amf[MAX_FILTER_PLIES], unsigned int iPly, unsigned int nPlies)
+{
+    unsigned int j;
+
+    for (j = iPly + 1; j < nPlies && j < MAX_FILTER_PLIES && amf[j].Accept < 0; j++);
+
+    return rFilterConfidence * aarFilterSigma[iPly][MIN(j, MAX_FILTER_PLIES)];
+}
+
 static int
 FindBestMovePlied(int anMove[8], int nDice0, int nDice1,
                   TanBoard anBoard,
@@ -5717,6 +6293,10 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
     movefilter *mFilters;
     unsigned int nMaxPly = 0;
     unsigned int cOldMoves;
+    replymemo *prm = NULL;
+
+    if (pevalbook && pevalbook->pfMoves(pml, nDice0, nDice1, anBoard, pci, pec, aamf, &nMaxPly, &cOldMoves))
+        goto found;
 
     /* Find all moves -- note that pml contains internal pointers to static
      * data, so we can't call GenerateMoves again (or anything that calls
@@ -5739,6 +6319,10 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
     mFilters = (pec->nPlies > 0 && pec->nPlies <= MAX_FILTER_PLIES) ?
         aamf[pec->nPlies - 1] : aamf[MAX_FILTER_PLIES - 1];
 
+    /* keep the replies of the shallower plies for the deeper ones */
+    if ((prm = ReplyMemoStart(pci, pec)))
+        prm->fStore = TRUE;
+
     for (iPly = 0; iPly < pec->nPlies; iPly++) {
 
         movefilter *mFilter = (iPly < MAX_FILTER_PLIES) ? &mFilters[iPly] : &NullFilter;
@@ -5750,6 +6334,7 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
         }
 
         if (ScoreMoves(pml, pci, pec, iPly) < 0) {
+            ReplyMemoEnd(prm);
             g_free(pm);
             pml->cMoves = 0;
             pml->amMoves = NULL;
@@ -5765,9 +6350,13 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
 
         {
             unsigned int limit = MIN(k, pml->cMoves + mFilter->Extra);
+            /* beyond the Accept best, adaptive filters keep the moves
+             * the next ply might well find better than the best one,
+             * however close or far the decision is */
+            float rThreshold = fAdaptiveFilters ? AdaptiveThreshold(mFilters, iPly, pec->nPlies) : mFilter->Threshold;
 
             for ( /**/; pml->cMoves < limit; ++pml->cMoves) {
-                if (pml->amMoves[pml->cMoves].rScore < pml->amMoves[0].rScore - mFilter->Threshold) {
+                if (pml->amMoves[pml->cMoves].rScore < pml->amMoves[0].rScore - rThreshold) {
                     break;
                 }
             }
@@ -5784,7 +6373,11 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
 
     /* evaluate moves on top ply */
 
+    if (prm)
+        prm->fStore = FALSE;
+
     if (ScoreMoves(pml, pci, pec, pec->nPlies) < 0) {
+        ReplyMemoEnd(prm);
         g_free(pm);
         pml->cMoves = 0;
         pml->amMoves = NULL;
@@ -5804,6 +6397,14 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
     cOldMoves = pml->cMoves;
     pml->cMoves = nMoves;
 
+    if (prm)
+        prm->fStore = FALSE;
+
+  found:
+
+    if (pevalbook)
+        pevalbook->pfAddMoves(pml, nDice0, nDice1, anBoard, pci, pec, aamf, nMaxPly, cOldMoves);
+
     /* Make sure that keyMove and top move are both  
      * evaluated at the deepest ply. */
     if (keyMove) {
@@ -5853,6 +6454,8 @@ FindnSaveBestMoves(movelist * pml, int nDice0, int nDice1, const TanBoard anBoar
             }
     }
 
+    ReplyMemoEnd(prm);
+
     return 0;
 
 }
@@ -5868,6 +6471,8 @@ GeneralCubeDecisionE(float aarOutput[2][NUM_ROLLOUT_OUTPUTS],
     float arCubeful[2];
     int i, j;
 
+    if (pevalbook && pevalbook->pfCube(aarOutput, anBoard, pci, pec))
+        goto found;
 
     /* Setup cube for "no double" and "double, take" */
 
@@ -5898,6 +6503,49 @@ GeneralCubeDecisionE(float aarOutput[2][NUM_ROLLOUT_OUTPUTS],
 
     }
 
+  found:
+
+    if (pevalbook)
+        pevalbook->pfAddCube(aarOutput, anBoard, pci, pec);
+
+    return 0;
+
+}
+
+extern int
+GeneralCubeDecisionsE(float aarCubeful[][2], const TanBoard anBoard, const cubeinfo aci[], int cci,
+                      const evalcontext * pec)
+{
+
+    SSE_ALIGN(float arOutput[NUM_OUTPUTS]);
+    cubeinfo *aciCubePos = g_new(cubeinfo, 2 * cci);
+    float *arCubeful = g_new(float, 2 * cci);
+    cubeinfo ciMove = aci[0];
+    int i;
+
+    /* Setup cube for "no double" and "double, take" at each score */
+
+    for (i = 0; i < cci; i++) {
+        aciCubePos[2 * i] = aciCubePos[2 * i + 1] = aci[i];
+        aciCubePos[2 * i + 1].fCubeOwner = !aciCubePos[2 * i + 1].fMove;
+        aciCubePos[2 * i + 1].nCube *= 2;
+    }
+
+    if (EvaluatePositionCubeful3(NULL, anBoard, arOutput, arCubeful, aciCubePos, 2 * cci, &ciMove, pec, pec->nPlies, TRUE)) {
+        g_free(aciCubePos);
+        g_free(arCubeful);
+        return -1;
+    }
+
+    for (i = 0; i < cci; i++) {
+        aarCubeful[i][0] = arCubeful[2 * i];
+        /* Scale double-take equity */
+        aarCubeful[i][1] = aci[i].nMatchTo ? arCubeful[2 * i + 1] : 2.0f * arCubeful[2 * i + 1];
+    }
+
+    g_free(aciCubePos);
+    g_free(arCubeful);
+
     return 0;
 
 }
@@ -6078,7 +6726,7 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
 
         if (pc == CLASS_HYPERGAMMON1 || pc == CLASS_HYPERGAMMON2 || pc == CLASS_HYPERGAMMON3) {
 
-            bearoffcontext *pbc = apbcHyper[pc - CLASS_HYPERGAMMON1];
+            bearoffcontext *pbc = GetHyperBearoff(pc - CLASS_HYPERGAMMON1);
             unsigned int nUs, nThem, iPos;
             unsigned int n;
 
@@ -6090,7 +6738,7 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
             n = Combination(pbc->nPoints + pbc->nChequers, pbc->nPoints);
             iPos = nUs * n + nThem;
 
-            if (BearoffHyper(apbcHyper[pc - CLASS_HYPERGAMMON1], iPos, arOutput, arEquity))
+            if (BearoffHyper(pbc, iPos, arOutput, arEquity))
                 return -1;
 
         } else if (pc > CLASS_OVER && pc <= CLASS_PERFECT /* && ! pciMove->nMatchTo */ ) {
@@ -6134,56 +6782,40 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
 
         /* Calculate cubeful equity for each possible cube position */
 
-        for (ici = 0; ici < 2 * cci; ici++)
-            if (aci[ici].nCube > 0) {
-                /* cube available */
+        switch (pc) {
+        case CLASS_OVER:
+        case CLASS_RACE:
+        case CLASS_CRASHED:
+        case CLASS_CONTACT:
+        case CLASS_BEAROFF1:
+        case CLASS_BEAROFF_OS:
+            /* approximate using Janowski's formulae (money) or Joern's
+             * generalisation of them (match), for all the cube
+             * positions together */
+
+            Cl2CfMany(arOutput, aci, 2 * cci, rCubeX, arCf);
+            break;
 
-                if (!aci[ici].nMatchTo) {
+        case CLASS_HYPERGAMMON1:
+        case CLASS_HYPERGAMMON2:
+        case CLASS_HYPERGAMMON3:
+            for (ici = 0; ici < 2 * cci; ici++)
+                if (aci[ici].nCube > 0) {
+                    /* cube available */
 
-                    /* money play */
+                    if (!aci[ici].nMatchTo) {
 
-                    switch (pc) {
-                    case CLASS_HYPERGAMMON1:
-                    case CLASS_HYPERGAMMON2:
-                    case CLASS_HYPERGAMMON3:
-                        /* exact bearoff equities & contact */
+                        /* money play: exact bearoff equities & contact */
 
                         arCf[ici] = CFHYPER(arEquity, &aci[ici]);
-                        break;
-
-                    case CLASS_BEAROFF2:
-                    case CLASS_BEAROFF_TS:
-                        /* exact bearoff equities */
-
-                        arCf[ici] = CFMONEY(arEquity, &aci[ici]);
-                        break;
-
-                    case CLASS_OVER:
-                    case CLASS_RACE:
-                    case CLASS_CRASHED:
-                    case CLASS_CONTACT:
-                    case CLASS_BEAROFF1:
-                    case CLASS_BEAROFF_OS:
-                        /* approximate using Janowski's formulae */
-
-                        arCf[ici] = Cl2CfMoney(arOutput, &aci[ici], rCubeX);
-                        break;
 
-                    }
-
-                } else {
-
-                    float rCl, rCf, rCfMoney;
-                    float X = rCubeX;
-                    cubeinfo ciMoney;
+                    } else {
 
-                    /* match play */
+                        float rCl, rCf, rCfMoney;
+                        float X = rCubeX;
+                        cubeinfo ciMoney;
 
-                    switch (pc) {
-                    case CLASS_HYPERGAMMON1:
-                    case CLASS_HYPERGAMMON2:
-                    case CLASS_HYPERGAMMON3:
-                        /* use exact money equities to guess cube efficiency */
+                        /* match play: use exact money equities to guess cube efficiency */
 
                         SetCubeInfoMoney(&ciMoney, 1, aci[ici].fCubeOwner, aci[ici].fMove, FALSE, FALSE, aci[ici].bgv);
 
@@ -6199,11 +6831,30 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
 
                         rCubeX = X;
 
-                        break;
+                    }
+
+                }
+            break;
+
+        case CLASS_BEAROFF2:
+        case CLASS_BEAROFF_TS:
+            for (ici = 0; ici < 2 * cci; ici++)
+                if (aci[ici].nCube > 0) {
+                    /* cube available */
+
+                    if (!aci[ici].nMatchTo) {
+
+                        /* money play: exact bearoff equities */
+
+                        arCf[ici] = CFMONEY(arEquity, &aci[ici]);
+
+                    } else {
+
+                        float rCl, rCf, rCfMoney;
+                        float X = rCubeX;
+                        cubeinfo ciMoney;
 
-                    case CLASS_BEAROFF2:
-                    case CLASS_BEAROFF_TS:
-                        /* use exact money equities to guess cube efficiency */
+                        /* match play: use exact money equities to guess cube efficiency */
 
                         SetCubeInfoMoney(&ciMoney, 1, aci[ici].fCubeOwner, aci[ici].fMove, FALSE, FALSE, aci[ici].bgv);
 
@@ -6229,25 +6880,11 @@ EvaluatePositionCubeful4(NNState * nnStates, const TanBoard anBoard,
 
                         rCubeX = X;
 
-                        break;
-
-                    case CLASS_OVER:
-                    case CLASS_RACE:
-                    case CLASS_CRASHED:
-                    case CLASS_CONTACT:
-                    case CLASS_BEAROFF1:
-                    case CLASS_BEAROFF_OS:
-                        /* approximate using Joern's generalisation of 
-                         * Janowski's formulae */
-
-                        arCf[ici] = Cl2CfMatch(arOutput, &aci[ici], rCubeX);
-                        break;
-
                     }
 
                 }
-
-            }
+            break;
+        }
 
 
         /* find optimal of "no double" and "double" */
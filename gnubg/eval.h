@@ -35,6 +35,7 @@
 #define WEIGHTS_VERSION "1.00"
 #define WEIGHTS_VERSION_BINARY 1.00f
 #define WEIGHTS_MAGIC_BINARY 472.3782f
+#define WEIGHTS_MAGIC_MAPPED 472.3783f
 
 #define NUM_OUTPUTS 5
 #define NUM_CUBEFUL_OUTPUTS 4
@@ -84,6 +85,16 @@ typedef struct movefilter_s {
 #define MAX_FILTER_PLIES	4
 extern movefilter defaultFilters[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
 
+/* Adaptive move filters: instead of Threshold, keep the moves within
+ * rFilterConfidence standard deviations of the best one, where
+ * aarFilterSigma[k][j] is the standard deviation of the change in a
+ * move's equity relative to the best move between ply k and ply j.
+ * The Accept best moves are still always kept, and at most Accept +
+ * Extra. */
+extern int fAdaptiveFilters;
+extern float rFilterConfidence;
+extern float aarFilterSigma[MAX_FILTER_PLIES][MAX_FILTER_PLIES + 1];
+
 typedef struct {
     /* FIXME expand this... e.g. different settings for different position
      * classes */
@@ -285,7 +296,10 @@ extern bearoffcontext *pbc1;
 extern bearoffcontext *pbc2;
 extern bearoffcontext *pbcOS;
 extern bearoffcontext *pbcTS;
-extern bearoffcontext *apbcHyper[3];
+
+/* the hypergammon databases are opened on first use */
+extern bearoffcontext *GetHyperBearoff(const int i);
+extern int HyperBearoffAvailable(const int i);
 
 typedef struct {
     unsigned int cMoves;        /* and current move when building list */
@@ -345,6 +359,15 @@ extern classevalfunc acef[N_CLASSES];
 
 extern void EvalInitialise(char *szWeights, char *szWeightsBinary, int fNoBearoff, void (*pfProgress) (unsigned int));
 
+/* time in seconds spent in the steps of EvalInitialise() */
+typedef struct {
+    double rTables;
+    double rBearoff;
+    double rWeights;
+} evalinitprofile;
+
+extern evalinitprofile eipInit;
+
 extern int EvalShutdown(void);
 
 extern void EvalStatus(char *szOutput);
@@ -471,9 +494,41 @@ extern cubedecision FindCubeDecision(float arDouble[], float aarOutput[][NUM_ROL
 EXP_LOCK_FUN(int, GeneralCubeDecisionE, float aarOutput[2][NUM_ROLLOUT_OUTPUTS],
              const TanBoard anBoard, cubeinfo * const pci, const evalcontext * pec, const evalsetup * pes);
 
+/* The cubeful equities after no double and double, take at each of cci
+ * cubes and scores, from one search. The moves in the search are chosen
+ * at the score of aci[0], so beyond 0-ply this is only exact if all the
+ * scores are the same. */
+EXP_LOCK_FUN(int, GeneralCubeDecisionsE, float aarCubeful[][2],
+             const TanBoard anBoard, const cubeinfo aci[], int cci, const evalcontext * pec);
+
 EXP_LOCK_FUN(int, GeneralEvaluationE, float arOutput[NUM_ROLLOUT_OUTPUTS],
              const TanBoard anBoard, cubeinfo * const pci, const evalcontext * pec);
 
+/* An opening book (book.c) hooks into FindnSaveBestMoves() and
+ * GeneralCubeDecisionE() through these, as the utilities built from
+ * eval.c don't have one. pfMoves and pfCube return TRUE with the stored
+ * result if the book has it; pfAddMoves and pfAddCube see every result
+ * found, for making a book. pevalbook is NULL when there is no book. */
+typedef struct {
+    int (*pfMoves) (movelist * pml, int nDice0, int nDice1, const TanBoard anBoard,
+                    const cubeinfo * pci, const evalcontext * pec,
+                    movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], unsigned int *pnMaxPly,
+                    unsigned int *pcOldMoves);
+    void (*pfAddMoves) (const movelist * pml, int nDice0, int nDice1, const TanBoard anBoard,
+                        const cubeinfo * pci, const evalcontext * pec,
+                        movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], unsigned int nMaxPly,
+                        unsigned int cOldMoves);
+    int (*pfCube) (float aarOutput[2][NUM_ROLLOUT_OUTPUTS], const TanBoard anBoard,
+                   const cubeinfo * pci, const evalcontext * pec);
+    void (*pfAddCube) (float aarOutput[2][NUM_ROLLOUT_OUTPUTS], const TanBoard anBoard,
+                       const cubeinfo * pci, const evalcontext * pec);
+} evalbook;
+
+extern const evalbook *pevalbook;
+
+/* MD5 digest of the neural net weights in use */
+extern void EvalWeightsDigest(unsigned char auchDigest[16]);
+
 extern int
  cmp_evalsetup(const evalsetup * pes1, const evalsetup * pes2);
 
@@ -540,6 +595,7 @@ extern int CompareMoves(const move * pm0, const move * pm1);
 extern float EvalEfficiency(const TanBoard anBoard, positionclass pc);
 extern float Cl2CfMoney(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX);
 extern float Cl2CfMatch(float arOutput[NUM_OUTPUTS], cubeinfo * pci, float rCubeX);
+extern void Cl2CfMany(float arOutput[NUM_OUTPUTS], cubeinfo aci[], int n, float rCubeX, float arCf[]);
 extern float Noise(const evalcontext * pec, const TanBoard anBoard, int iOutput);
 extern int EvalKey(const evalcontext * pec, const int nPlies, const cubeinfo * pci, int fCubefulEquity);
 extern void MakeCubePos(const cubeinfo aciCubePos[], const int cci, const int fTop, cubeinfo aci[], const int fInvert);
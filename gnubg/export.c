@@ -34,6 +34,7 @@
 #include "analysis.h"
 #include "drawboard.h"
 #include "export.h"
+#include "file.h"
 #include "eval.h"
 #include "positionid.h"
 #include "renderprefs.h"
@@ -49,6 +50,14 @@
 #include "simpleboard.h"
 #endif
 
+#if !GLIB_CHECK_VERSION (2,26,0)
+#ifdef WIN32
+#define GStatBuf struct _g_stat_struct
+#else
+typedef struct stat GStatBuf;
+#endif
+#endif
+
 /*
  * Get filename from base file and game number:
  *
@@ -1389,3 +1398,157 @@ CommandExportMatchSnowieTxt(char *sz)
 {
     ExportMatchMat(sz, TRUE);
 }
+
+/* Bulk export of a directory of matches. The reader thread of
+ * MatchDirOpen() detects the format of the files while the main thread
+ * loads each match and writes it with the usual "export match" command,
+ * so the files are the same as exporting the matches one by one. The
+ * exporters work on the current match, which is why only one match is
+ * rendered at a time. */
+
+/* The name of the exported file: the match file name with the extension
+ * of the export format added, in szOutDir. Keeping the extension of the
+ * match file gives a.sgf and a.mat different names. */
+static gchar *
+ExportDirFileName(const gchar * szFile, const gchar * szOutDir, ExportType type)
+{
+    gchar *szBase = g_path_get_basename(szFile);
+    gchar *szName, *szOut;
+
+    szName = g_strconcat(szBase, export_format[type].extension, NULL);
+    szOut = g_build_filename(szOutDir, szName, NULL);
+    g_free(szName);
+    g_free(szBase);
+
+    return szOut;
+}
+
+static int
+SameDirectory(const char *szDir0, const char *szDir1)
+{
+#ifndef WIN32
+    GStatBuf st0, st1;
+
+    if (!g_stat(szDir0, &st0) && !g_stat(szDir1, &st1))
+        return st0.st_dev == st1.st_dev && st0.st_ino == st1.st_ino;
+#endif
+
+    return !strcmp(szDir0, szDir1);
+}
+
+extern void
+CommandExportDirectory(char *sz)
+{
+    matchdir *pmd;
+    ImportType typeIn;
+    char *szDir, *szFormat, *szOutDir, *szFile;
+    GTimer *timer;
+    GHashTable *phtInputs = NULL;
+    ExportType type;
+    int fConfirmNewOld = fConfirmNew, fAutoSaveConfirmDeleteOld = fAutoSaveConfirmDelete;
+    int fConfirmSaveOld = fConfirmSave;
+    int nExported = 0, nSkipped = 0, nDone = 0;
+    double rElapsed;
+
+    szDir = NextToken(&sz);
+    szFormat = NextToken(&sz);
+    if (!szDir || !*szDir || !szFormat || !*szFormat) {
+        outputl(_("You must specify a directory and a format (see `help export directory')."));
+        return;
+    }
+    if (!(szOutDir = NextToken(&sz)) || !*szOutDir)
+        szOutDir = szDir;
+
+    /* any format "export match" or "save match" knows */
+    for (type = 0; type < N_EXPORT_TYPES; type++)
+        if (export_format[type].exports[0] && !StrCaseCmp(szFormat, export_format[type].clname))
+            break;
+    if (type == N_EXPORT_TYPES) {
+        outputf(_("Unknown match export format `%s'.\n"), szFormat);
+        return;
+    }
+
+    if (!g_file_test(szOutDir, G_FILE_TEST_IS_DIR)) {
+        outputf(_("`%s' is not a directory.\n"), szOutDir);
+        return;
+    }
+
+    if (!(pmd = MatchDirOpen(szDir)))
+        return;
+
+    if (!get_input_discard()) {
+        MatchDirClose(pmd);
+        return;
+    }
+
+    /* all the HTML files share one set of board images; make it now
+     * rather than in the middle of the first match */
+    if (type == EXPORT_HTML && exsExport.het == HTML_EXPORT_TYPE_GNU) {
+        gchar *szFirst = ExportDirFileName(MatchDirName(pmd, 0), szOutDir, type);
+        check_for_html_images(szFirst);
+        g_free(szFirst);
+    }
+
+    /* the match files must not be overwritten by what is made of the
+     * others */
+    if (SameDirectory(szDir, szOutDir)) {
+        unsigned int i;
+
+        phtInputs = g_hash_table_new(g_str_hash, g_str_equal);
+        for (i = 0; i < MatchDirSize(pmd); i++)
+            g_hash_table_insert(phtInputs, (gpointer) MatchDirName(pmd, i), (gpointer) MatchDirName(pmd, i));
+    }
+
+    /* the current match is discarded and the loaded ones replace each
+     * other without asking; overwriting files is confirmed below, before
+     * "export match" is run */
+    fConfirmNew = FALSE;
+    fAutoSaveConfirmDelete = FALSE;
+    fConfirmSave = FALSE;
+
+    timer = g_timer_new();
+    ProgressStartValue(_("Exporting matches; file:"), (int) MatchDirSize(pmd));
+
+    while ((szFile = MatchDirNext(pmd, &typeIn))) {
+        gchar *szOut = ExportDirFileName(szFile, szOutDir, type);
+        gchar *szOutName = g_path_get_basename(szOut);
+
+        ProgressValue(++nDone);
+
+        if (phtInputs && g_hash_table_lookup(phtInputs, szOutName)) {
+            outputf(_("Skipping `%s': `%s' is one of the files being exported.\n"), szFile, szOut);
+            nSkipped++;
+        } else if (!confirmOverwrite(szOut, fConfirmSaveOld) || !MatchDirLoad(szFile, typeIn))
+            nSkipped++;
+        else {
+            char *cmd;
+
+            if (type == EXPORT_SGF)
+                cmd = g_strdup_printf("save match \"%s\"", szOut);
+            else
+                cmd = g_strdup_printf("export match %s \"%s\"", export_format[type].clname, szOut);
+            HandleCommand(cmd, acTop);
+            g_free(cmd);
+            nExported++;
+        }
+
+        g_free(szOutName);
+        g_free(szOut);
+        g_free(szFile);
+    }
+
+    ProgressEnd();
+    rElapsed = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+
+    fConfirmNew = fConfirmNewOld;
+    fAutoSaveConfirmDelete = fAutoSaveConfirmDeleteOld;
+    fConfirmSave = fConfirmSaveOld;
+
+    if (phtInputs)
+        g_hash_table_destroy(phtInputs);
+    MatchDirClose(pmd);
+
+    outputf(_("%d matches exported to `%s', %d files skipped, in %.1f seconds (%.1f matches/s)\n"),
+            nExported, szOutDir, nSkipped, rElapsed, rElapsed > 0.0 ? nExported / rElapsed : 0.0);
+}
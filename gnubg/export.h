@@ -92,6 +92,8 @@ typedef struct {
 extern exportsetup exsExport;
 
 extern char *filename_from_iGame(const char *szBase, const int iGame);
+/* Generate the HTML images for an export to path unless they exist */
+extern void check_for_html_images(const gchar * path);
 extern int WritePNG(const char *sz, unsigned char *puch,
                     unsigned int nStride, unsigned int nSizeX, unsigned int nSizeY);
 
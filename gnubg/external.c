@@ -49,6 +49,10 @@
 #include <sys/un.h>
 #endif                          /* #if HAVE_SYS_SOCKET_H */
 
+#if HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif                          /* #if HAVE_SYS_TIME_H */
+
 #else                           /* #ifndef WIN32 */
 
 #include <winsock2.h>
@@ -109,6 +113,8 @@
 #include "rollout.h"
 #include "eval.h"
 #include "matchid.h"
+#include "multithread.h"
+#include "ponder.h"
 #include "lib/gnubg-types.h"
 
 #if HAVE_SOCKETS
@@ -230,11 +236,12 @@ ExternalUnbind(char *sz)
 #endif                          /* HAVE_SOCKETS */
 
 #if HAVE_SOCKETS
-extern int
-ExternalRead(int h, char *pch, size_t cch)
-{
+/* Read what is available, up to cch bytes. Returns the number of bytes
+ * read, -1 if the connection was closed or failed and -2 if interrupted. */
 
-    char *p = pch, *pEnd;
+static int
+ExternalReceive(int h, char *p, size_t cch)
+{
 #ifndef WIN32
     ssize_t n;
     psighandler sh;
@@ -242,7 +249,7 @@ ExternalRead(int h, char *pch, size_t cch)
     int n;
 #endif
 
-    while (cch) {
+    for (;;) {
         ProcessEvents();
 
         if (fInterrupt)
@@ -275,6 +282,21 @@ ExternalRead(int h, char *pch, size_t cch)
             return -1;
         }
 
+        return (int) n;
+    }
+}
+
+extern int
+ExternalRead(int h, char *pch, size_t cch)
+{
+
+    char *p = pch, *pEnd;
+    int n;
+
+    while (cch) {
+        if ((n = ExternalReceive(h, p, cch)) < 0)
+            return n;
+
         if ((pEnd = memchr(p, '\n', n))) {
             *pEnd = 0;
             return 0;
@@ -288,6 +310,42 @@ ExternalRead(int h, char *pch, size_t cch)
     p[cch - 1] = 0;
     return 0;
 }
+
+/*
+ * Like ExternalRead(), but what follows the newline is kept in gsPending
+ * for the next call instead of being lost, so that a controller can send
+ * several commands without waiting for the answers.
+ */
+
+static int
+ExternalReadBuffered(int h, GString * gsPending, char *pch, size_t cch)
+{
+    char ach[1024];
+    char *pEnd;
+    int n;
+
+    for (;;) {
+        if ((pEnd = memchr(gsPending->str, '\n', gsPending->len))) {
+            size_t cb = MIN((size_t) (pEnd - gsPending->str), cch - 1);
+
+            memcpy(pch, gsPending->str, cb);
+            pch[cb] = 0;
+            g_string_erase(gsPending, 0, (gssize) (pEnd - gsPending->str) + 1);
+            return 0;
+        } else if (gsPending->len >= cch - 1) {
+            /* too long; the rest is read as the next command */
+            memcpy(pch, gsPending->str, cch - 1);
+            pch[cch - 1] = 0;
+            g_string_erase(gsPending, 0, (gssize) cch - 1);
+            return 0;
+        }
+
+        if ((n = ExternalReceive(h, ach, sizeof(ach))) < 0)
+            return n;
+
+        g_string_append_len(gsPending, ach, n);
+    }
+}
 #endif                          /* HAVE_SOCKETS */
 
 #if HAVE_SOCKETS
@@ -438,8 +496,16 @@ ExtEvaluation(scancontext * pec)
     return szResponse;
 }
 
+/* The position the opponent is on roll in after a move was sent */
+
+typedef struct {
+    int fValid;
+    TanBoard anBoard;
+    cubeinfo ci;
+} extponder;
+
 static char *
-ExtFIBSBoard(scancontext * pec)
+ExtFIBSBoard(scancontext * pec, extponder * pep)
 {
     ProcessedFIBSBoard processedBoard;
     TanBoard anBoardOrig;
@@ -546,6 +612,14 @@ ExtFIBSBoard(scancontext * pec)
 
         FormatMovePlain(szMove, (ConstTanBoard)anBoardOrig, anMove);
         szResponse = g_strconcat(szMove, "\n", NULL);
+
+        if (pep) {
+            memcpy(pep->anBoard, processedBoard.anBoard, sizeof(TanBoard));
+            SwapSides(pep->anBoard);
+            pep->ci = ci;
+            pep->ci.fMove = !ci.fMove;
+            pep->fValid = TRUE;
+        }
     } else {
         /* double decision */
         if (GeneralCubeDecision(aarOutput, aarStdDev,
@@ -595,8 +669,912 @@ ExtFIBSBoard(scancontext * pec)
 
     return szResponse;
 }
+
+/*
+ * Statistics of the evaluation and fibsboard requests answered since the
+ * external command was last started. They are shown by "show external"
+ * and returned to the controllers by the "statistics" command.
+ */
+
+typedef struct {
+    unsigned int nConnections;
+    unsigned int nRequests;
+    double rLatency;            /* total, in ms */
+    double rLatencyMax;
+    double rStart;
+    double rStop;
+} externalstats;
+
+static externalstats exs;
+
+#if defined(USE_MULTITHREAD)
+static Mutex mutexStats;
+#endif
+
+static void
+ExtStatsReset(void)
+{
+#if defined(USE_MULTITHREAD)
+    static int fInit = FALSE;
+
+    if (!fInit) {
+        InitMutex(&mutexStats);
+        fInit = TRUE;
+    }
+    Mutex_Lock(&mutexStats);
+#endif
+    memset(&exs, 0, sizeof(exs));
+    exs.rStart = get_time();
+#if defined(USE_MULTITHREAD)
+    Mutex_Release(&mutexStats);
+#endif
+}
+
+static void
+ExtStatsAdd(unsigned int nConnections, unsigned int nRequests, double rLatency)
+{
+#if defined(USE_MULTITHREAD)
+    Mutex_Lock(&mutexStats);
+#endif
+    exs.nConnections += nConnections;
+    exs.nRequests += nRequests;
+    exs.rLatency += rLatency;
+    if (rLatency > exs.rLatencyMax)
+        exs.rLatencyMax = rLatency;
+#if defined(USE_MULTITHREAD)
+    Mutex_Release(&mutexStats);
+#endif
+}
+
+static void
+ExtStatsStop(void)
+{
+#if defined(USE_MULTITHREAD)
+    Mutex_Lock(&mutexStats);
+#endif
+    exs.rStop = get_time();
+#if defined(USE_MULTITHREAD)
+    Mutex_Release(&mutexStats);
+#endif
+}
+
+static char *
+ExtStatistics(void)
+{
+    externalstats es;
+    double rElapsed;
+
+#if defined(USE_MULTITHREAD)
+    Mutex_Lock(&mutexStats);
+#endif
+    es = exs;
+#if defined(USE_MULTITHREAD)
+    Mutex_Release(&mutexStats);
 #endif
 
+    rElapsed = ((es.rStop > 0.0) ? es.rStop : get_time()) - es.rStart;
+
+    return g_strdup_printf("Connections: %u\n"
+                           "Requests: %u\n"
+                           "Mean latency: %.3f ms\n"
+                           "Max latency: %.3f ms\n"
+                           "Throughput: %.1f requests/s\n",
+                           es.nConnections, es.nRequests,
+                           es.nRequests ? es.rLatency / es.nRequests : 0.0,
+                           es.rLatencyMax, rElapsed > 0.0 ? 1000.0 * es.nRequests / rElapsed : 0.0);
+}
+
+/* Answer the commands that don't need an evaluation */
+
+static char *
+ExtAnswer(scancontext * pec)
+{
+    char *szResponse;
+    gchar *szOptStr;
+
+    switch (pec->ct) {
+    case COMMAND_HELP:
+        szResponse = g_strdup("\tNo help information available\n");
+        break;
+
+    case COMMAND_SET:
+        szOptStr = g_value_get_gstring_gchar(g_list_nth_data(pec->pCmdData, 0));
+        if (g_ascii_strcasecmp(szOptStr, KEY_STR_DEBUG) == 0) {
+            pec->fDebug = g_value_get_int(g_list_nth_data(pec->pCmdData, 1));
+            szResponse = g_strdup_printf("Debug output %s\n", pec->fDebug ? "ON" : "OFF");
+        } else if (g_ascii_strcasecmp(szOptStr, KEY_STR_NEWINTERFACE) == 0) {
+            pec->fNewInterface = g_value_get_int(g_list_nth_data(pec->pCmdData, 1));
+            szResponse = g_strdup_printf("New interface %s\n", pec->fNewInterface ? "ON" : "OFF");
+        } else {
+            szResponse = g_strdup_printf("Error: set option '%s' not supported\n", szOptStr);
+        }
+        g_list_gv_boxed_free(pec->pCmdData);
+
+        break;
+
+    case COMMAND_VERSION:
+        szResponse = g_strdup("Interface: " EXTERNAL_INTERFACE_VERSION "\n"
+                              "RFBF: " RFBF_VERSION_SUPPORTED "\n"
+                              "Engine: " WEIGHTS_VERSION "\n" "Software: " VERSION "\n");
+
+        break;
+
+    case COMMAND_STATISTICS:
+        szResponse = ExtStatistics();
+        break;
+
+    case COMMAND_NONE:
+        szResponse = g_strdup("Error: no command given\n");
+        break;
+
+    default:
+        szResponse = g_strdup("Unsupported Command\n");
+    }
+
+    return szResponse;
+}
+
+/* The board and settings of an evaluation or fibsboard command, for "set debug on" */
+
+static void
+ExtDebugBoard(scancontext * pec, GString * dbgStr)
+{
+    ProcessedFIBSBoard processedBoard;
+    GValue *optionsmapgv;
+    GValue *boarddatagv;
+    int anScore[2];
+    int fcrawford, fjacoby;
+    char *asz[7] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+    char szBoard[10000];
+    char **aszLines, **aszLinesOrig;
+    char *szMatchID;
+
+    optionsmapgv = (GValue *) g_list_nth_data(g_value_get_boxed(pec->pCmdData), 1);
+    boarddatagv = (GValue *) g_list_nth_data(g_value_get_boxed(pec->pCmdData), 0);
+    g_string_append(dbgStr, DEBUG_PREFIX);
+    g_value_tostring(dbgStr, optionsmapgv, 0);
+    g_string_append(dbgStr, "\n" DEBUG_PREFIX);
+    g_value_tostring(dbgStr, boarddatagv, 0);
+    g_string_append(dbgStr, "\n" DEBUG_PREFIX "\n");
+    ProcessFIBSBoardInfo(&pec->bi, &processedBoard);
+
+    anScore[0] = processedBoard.nScoreOpp;
+    anScore[1] = processedBoard.nScore;
+    /* If the session isn't using Crawford rule, set Crawford flag to false */
+    fcrawford = pec->fCrawfordRule ? processedBoard.fCrawford : FALSE;
+    /* Set the Jacoby flag appropriately from the external interface settings */
+    fjacoby = pec->fJacobyRule;
+
+    szMatchID = MatchID((unsigned int *) processedBoard.anDice, 1, processedBoard.nResignation,
+                        processedBoard.fDoubled, 1, processedBoard.fCubeOwner, fcrawford,
+                        processedBoard.nMatchTo, anScore, processedBoard.nCube, fjacoby, GAME_PLAYING);
+
+    DrawBoard(szBoard, (ConstTanBoard) & processedBoard.anBoard, 1, asz, szMatchID, 15);
+
+    aszLines = g_strsplit(&szBoard[0], "\n", 32);
+    aszLinesOrig = aszLines;
+    while (*aszLines) {
+        g_string_append(dbgStr, DEBUG_PREFIX);
+        g_string_append(dbgStr, *aszLines);
+        g_string_append(dbgStr, "\n");
+        aszLines++;
+    }
+
+    g_string_append_printf(dbgStr, DEBUG_PREFIX "X is %s, O is %s\n", processedBoard.szPlayer, processedBoard.szOpp);
+    if (processedBoard.nMatchTo) {
+        g_string_append_printf(dbgStr, DEBUG_PREFIX "Match Play %s Crawford Rule\n",
+                               pec->fCrawfordRule ? "with" : "without");
+        g_string_append_printf(dbgStr, DEBUG_PREFIX "Score: %d-%d/%d%s, ", processedBoard.nScore,
+                               processedBoard.nScoreOpp, processedBoard.nMatchTo, fcrawford ? "*" : "");
+    } else {
+        g_string_append_printf(dbgStr, DEBUG_PREFIX "Money Session %s Jacoby Rule, %s Beavers\n",
+                               pec->fJacobyRule ? "with" : "without", pec->fBeavers ? "with" : "without");
+        g_string_append_printf(dbgStr, DEBUG_PREFIX "Score: %d-%d, ", processedBoard.nScore,
+                               processedBoard.nScoreOpp);
+    }
+    g_string_append_printf(dbgStr, "Roll: %d%d\n", processedBoard.anDice[0], processedBoard.anDice[1]);
+    g_string_append_printf(dbgStr,
+                           DEBUG_PREFIX
+                           "CubeOwner: %d, Cube: %d, Turn: %c, Doubled: %d, Resignation: %d\n",
+                           processedBoard.fCubeOwner, processedBoard.nCube, 'X',
+                           processedBoard.fDoubled, processedBoard.nResignation);
+    g_string_append(dbgStr, DEBUG_PREFIX "\n");
+
+    g_strfreev(aszLinesOrig);
+}
+
+static char *
+ExtEvaluate(scancontext * pec)
+{
+    return pec->ct == COMMAND_EVALUATION ? ExtEvaluation(pec) : ExtFIBSBoard(pec, NULL);
+}
+
+/* Move a parsed evaluation or fibsboard command from pec to psc, leaving
+ * pec ready for the next command */
+
+static void
+ExtTakeCommand(scancontext * pec, scancontext * psc)
+{
+    g_value_unsetfree(pec->pCmdData);
+    pec->pCmdData = NULL;
+
+    *psc = *pec;
+    psc->scanner = NULL;
+    psc->szError = NULL;
+
+    pec->bi.gsName = NULL;
+    pec->bi.gsOpp = NULL;
+}
+
+/*
+ * "batch <n>": the n following lines are evaluation or fibsboard commands,
+ * answered with one line each once all of them have been read. The
+ * commands are evaluated in parallel, and a command identical to an
+ * earlier one in the batch is answered from the earlier evaluation.
+ * Positions that only differ in the cube share their cubeless
+ * evaluations through the evaluation cache.
+ */
+
+#define MAX_BATCH 1024
+
+typedef struct {
+    scancontext sc;
+    char *szResponse;
+    int iSame;                  /* identical earlier command, or -1 */
+} extbatchitem;
+
+static const char szBatchOnly[] = "Error: only evaluation and fibsboard commands can be batched\n";
+
+static int
+ExtBatchSize(const scancontext * pec, char **pszError)
+{
+    if (pec->nBatch < 1 || pec->nBatch > MAX_BATCH) {
+        *pszError = g_strdup_printf("Error: batch size must be between 1 and %d\n", MAX_BATCH);
+        return 0;
+    }
+
+    *pszError = NULL;
+    return pec->nBatch;
+}
+
+static int
+ExtSameCommand(const scancontext * pec0, const scancontext * pec1)
+{
+    if (pec0->rNoise != 0.0f && !pec0->fDeterministic)
+        return FALSE;
+
+    return pec0->ct == pec1->ct && pec0->nPlies == pec1->nPlies && pec0->rNoise == pec1->rNoise
+        && pec0->fDeterministic == pec1->fDeterministic && pec0->fCubeful == pec1->fCubeful
+        && pec0->fUsePrune == pec1->fUsePrune && pec0->fJacobyRule == pec1->fJacobyRule
+        && pec0->fCrawfordRule == pec1->fCrawfordRule && pec0->nResignation == pec1->nResignation
+        && pec0->fBeavers == pec1->fBeavers
+        && !memcmp(&pec0->bi, &pec1->bi, G_STRUCT_OFFSET(FIBSBoardInfo, gsName));
+}
+
+static void
+ExtBatchEvaluate(void *p)
+{
+    extbatchitem *pbi = (extbatchitem *) p;
+
+    if (!(pbi->szResponse = ExtEvaluate(&pbi->sc)))
+        pbi->szResponse = g_strdup("Error: evaluation failed\n");
+}
+
+/* Evaluate the items without an answer and return all the answers */
+
+static char *
+ExtBatch(extbatchitem * abi, int n)
+{
+    GString *gs = g_string_new(NULL);
+    unsigned int cTasks = 0;
+    int i, j;
+
+    for (i = 0; i < n; i++) {
+        abi[i].iSame = -1;
+
+        if (abi[i].szResponse)
+            continue;
+
+        for (j = 0; j < i && abi[i].iSame < 0; j++)
+            if (!abi[j].szResponse && abi[j].iSame < 0 && ExtSameCommand(&abi[j].sc, &abi[i].sc))
+                abi[i].iSame = j;
+
+        if (abi[i].iSame >= 0)
+            continue;
+
+        if (abi[i].sc.ct == COMMAND_FIBSBOARD && esEvalCube.et == EVAL_ROLLOUT)
+            /* rollouts use the calculation threads themselves */
+            continue;
+
+        mt_add_tasks(1, ExtBatchEvaluate, &abi[i], NULL);
+        cTasks++;
+    }
+
+    if (cTasks)
+        MT_WaitForTasks(NULL, 10, FALSE);
+
+    for (i = 0; i < n; i++) {
+        if (abi[i].iSame >= 0)
+            abi[i].szResponse = g_strdup(abi[abi[i].iSame].szResponse);
+        else if (!abi[i].szResponse)
+            ExtBatchEvaluate(&abi[i]);
+    }
+
+    for (i = 0; i < n; i++) {
+        g_string_append(gs, abi[i].szResponse);
+        unset_scan_context(&abi[i].sc, FALSE);
+        g_free(abi[i].szResponse);
+    }
+
+    return g_string_free(gs, FALSE);
+}
+
+/* Read and answer the commands of a batch from a single controller */
+
+static char *
+ExtReadBatch(int hPeer, GString * gsPending, scancontext * pec, int *pretval)
+{
+    extbatchitem *abi;
+    char szCommand[256];
+    char *szResponse;
+    int i, n;
+
+    if (!(n = ExtBatchSize(pec, &szResponse)))
+        return szResponse;
+
+    abi = g_new0(extbatchitem, n);
+
+    for (i = 0; i < n; i++) {
+        if ((*pretval = ExternalReadBuffered(hPeer, gsPending, szCommand, sizeof(szCommand) - 1))) {
+            while (i--) {
+                unset_scan_context(&abi[i].sc, FALSE);
+                g_free(abi[i].szResponse);
+            }
+            g_free(abi);
+            return NULL;
+        }
+        strcat(szCommand, "\n");
+
+        if (!ExtParse(pec, szCommand)) {
+            abi[i].szResponse = pec->szError;
+            pec->szError = NULL;
+        } else if (pec->ct == COMMAND_FIBSBOARD || pec->ct == COMMAND_EVALUATION)
+            ExtTakeCommand(pec, &abi[i].sc);
+        else {
+            if (pec->ct == COMMAND_SET)
+                g_list_gv_boxed_free(pec->pCmdData);
+            abi[i].szResponse = g_strdup(szBatchOnly);
+        }
+        unset_scan_context(pec, FALSE);
+    }
+
+    szResponse = ExtBatch(abi, n);
+    g_free(abi);
+
+    return szResponse;
+}
+
+#if defined(USE_MULTITHREAD)
+
+/*
+ * Server for several simultaneous controllers ("set external clients").
+ *
+ * A listener thread accepts the connections and starts an I/O thread
+ * for each of them. The I/O threads read and parse the requests with
+ * their own scanner, answer the simple commands themselves and queue
+ * evaluation and fibsboard requests for the thread running the external
+ * command. That thread hands whatever has been queued to the calculation
+ * threads as one round of tasks. Every connection keeps its requests in
+ * the order they were received and only writes an answer once all the
+ * earlier ones have been written.
+ *
+ * The calculation threads only store the answers. They are written by
+ * the thread running the command once the round is over, or by the I/O
+ * thread for the answers it makes itself. The sockets have a send
+ * timeout, and a connection that can't be written to is shut down, so a
+ * controller that stops reading can't hold up the others.
+ */
+
+typedef struct _extserver extserver;
+
+typedef struct {
+    extserver *pes;
+    int h;
+    scancontext *psc;
+    Mutex lock;                 /* protects pqPending, the requests' fDone and fWriting */
+    GQueue *pqPending;          /* extrequest, in the order received */
+    int fWriting;               /* a thread is writing answers */
+    int fWriteFailed;           /* only used by the thread writing */
+    int nBatch;                 /* commands left in the current batch */
+    int nRefs;                  /* the I/O thread and each pending request */
+} extconnection;
+
+typedef struct {
+    extconnection *pConn;
+    scancontext sc;             /* copy of the parsed command */
+    GString *gsDebug;
+    char *szResponse;
+    double rStart;
+    int fEvaluate;
+    int fDone;
+} extrequest;
+
+struct _extserver {
+    int h;
+    GAsyncQueue *paq;           /* extrequest to evaluate */
+    int fStop;
+    Mutex lock;                 /* protects plConnections and plClosed */
+    GList *plConnections;
+    GList *plClosed;            /* connections to free on the main thread */
+};
+
+#ifndef SHUT_RDWR
+#define SHUT_RDWR SD_BOTH
+#endif
+
+#define EXT_SEND_TIMEOUT 2      /* seconds */
+
+static void
+ExtServerSetTimeout(int h)
+{
+#ifdef WIN32
+    DWORD ms = EXT_SEND_TIMEOUT * 1000;
+
+    setsockopt((SOCKET) h, SOL_SOCKET, SO_SNDTIMEO, (const char *) &ms, sizeof(ms));
+#else
+    struct timeval tv;
+
+    tv.tv_sec = EXT_SEND_TIMEOUT;
+    tv.tv_usec = 0;
+    setsockopt(h, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+#endif
+}
+
+static int
+ExtServerWrite(int h, const char *pch, size_t cch)
+{
+    int n;
+
+    while (cch) {
+#ifdef WIN32
+        n = send((SOCKET) h, pch, (int) cch, 0);
+#else
+        n = (int) send(h, pch, cch, 0);
+#endif
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        } else if (!n)
+            return -1;
+
+        cch -= (size_t) n;
+        pch += n;
+    }
+
+    return 0;
+}
+
+static void
+ExtConnectionUnref(extconnection * pConn)
+{
+    extserver *pes = pConn->pes;
+
+    if (!MT_SafeDecCheck(&pConn->nRefs))
+        return;
+
+    closesocket(pConn->h);
+    unset_scan_context(pConn->psc, TRUE);
+    g_free(pConn->psc);
+    g_queue_free(pConn->pqPending);
+
+    /* the last reference may be dropped by any thread, but only the
+     * main thread may free the mutex */
+    Mutex_Lock(&pes->lock);
+    pes->plConnections = g_list_remove(pes->plConnections, pConn);
+    pes->plClosed = g_list_prepend(pes->plClosed, pConn);
+    Mutex_Release(&pes->lock);
+}
+
+static void
+ExtServerFreeClosed(extserver * pes)
+{
+    GList *pl, *plClosed;
+
+    Mutex_Lock(&pes->lock);
+    plClosed = pes->plClosed;
+    pes->plClosed = NULL;
+    Mutex_Release(&pes->lock);
+
+    for (pl = plClosed; pl; pl = pl->next) {
+        extconnection *pConn = (extconnection *) pl->data;
+
+        FreeMutex(&pConn->lock);
+        g_free(pConn);
+    }
+    g_list_free(plClosed);
+}
+
+/* Mark preq as answered and write the answers that are now in order.
+ * One thread at a time writes, without holding the lock; the others
+ * leave their answers to it. Not for the calculation threads. */
+
+static void
+ExtRequestDone(extconnection * pConn, extrequest * preq)
+{
+    extrequest *preqHead;
+    unsigned int nDone = 0;
+
+    Mutex_Lock(&pConn->lock);
+
+    preq->fDone = TRUE;
+
+    if (pConn->fWriting) {
+        Mutex_Release(&pConn->lock);
+        return;
+    }
+    pConn->fWriting = TRUE;
+
+    for (;;) {
+        GQueue *pqDone = g_queue_new();
+        GList *pl;
+
+        while ((preqHead = g_queue_peek_head(pConn->pqPending)) && preqHead->fDone)
+            g_queue_push_tail(pqDone, g_queue_pop_head(pConn->pqPending));
+
+        if (g_queue_is_empty(pqDone)) {
+            pConn->fWriting = FALSE;
+            g_queue_free(pqDone);
+            break;
+        }
+
+        Mutex_Release(&pConn->lock);
+
+        for (pl = pqDone->head; pl; pl = pl->next) {
+            preqHead = (extrequest *) pl->data;
+
+            if (preqHead->szResponse && !pConn->fWriteFailed
+                && (pConn->fWriteFailed = ExtServerWrite(pConn->h, preqHead->szResponse,
+                                                         strlen(preqHead->szResponse))))
+                /* the controller is gone or doesn't read; end the I/O thread */
+                shutdown(pConn->h, SHUT_RDWR);
+
+            if (preqHead->fEvaluate)
+                ExtStatsAdd(0, 1, get_time() - preqHead->rStart);
+
+            unset_scan_context(&preqHead->sc, FALSE);
+            g_free(preqHead->szResponse);
+            g_free(preqHead);
+            nDone++;
+        }
+        g_queue_free(pqDone);
+
+        Mutex_Lock(&pConn->lock);
+    }
+
+    Mutex_Release(&pConn->lock);
+
+    while (nDone--)
+        ExtConnectionUnref(pConn);
+}
+
+static void
+ExtServerEvaluate(void *p)
+{
+    extrequest *preq = (extrequest *) p;
+    char *sz = ExtEvaluate(&preq->sc);
+
+    if (!sz)
+        sz = g_strdup("Error: evaluation failed\n");
+
+    if (preq->gsDebug) {
+        g_string_append(preq->gsDebug, sz);
+        g_free(sz);
+        sz = g_string_free(preq->gsDebug, FALSE);
+        preq->gsDebug = NULL;
+    }
+
+    /* written by ExternalServer() after the round */
+    preq->szResponse = sz;
+}
+
+static void
+ExtServerQueue(extconnection * pConn, extrequest * preq)
+{
+    preq->pConn = pConn;
+
+    MT_SafeInc(&pConn->nRefs);
+    Mutex_Lock(&pConn->lock);
+    g_queue_push_tail(pConn->pqPending, preq);
+    Mutex_Release(&pConn->lock);
+
+    if (preq->fEvaluate)
+        g_async_queue_push(pConn->pes->paq, preq);
+    else
+        ExtRequestDone(pConn, preq);
+}
+
+/* Parse one line from a controller. Returns TRUE when it asks to exit. */
+
+static int
+ExtServerRequest(extconnection * pConn, const char *szCommand)
+{
+    scancontext *psc = pConn->psc;
+    extrequest *preq = g_new0(extrequest, 1);
+    int fInBatch = pConn->nBatch > 0;
+    int fExit = FALSE;
+
+    preq->rStart = get_time();
+
+    if (fInBatch)
+        pConn->nBatch--;
+
+    if (!ExtParse(psc, szCommand)) {
+        /* parse error */
+        preq->szResponse = psc->szError;
+        psc->szError = NULL;
+    } else if (psc->ct == COMMAND_FIBSBOARD || psc->ct == COMMAND_EVALUATION) {
+        if (psc->fDebug && !fInBatch) {
+            preq->gsDebug = g_string_new(NULL);
+            ExtDebugBoard(psc, preq->gsDebug);
+        }
+        ExtTakeCommand(psc, &preq->sc);
+        preq->fEvaluate = TRUE;
+    } else if (fInBatch) {
+        if (psc->ct == COMMAND_SET)
+            g_list_gv_boxed_free(psc->pCmdData);
+        preq->szResponse = g_strdup(szBatchOnly);
+    } else if (psc->ct == COMMAND_EXIT)
+        fExit = TRUE;
+    else if (psc->ct == COMMAND_BATCH)
+        /* the commands of a batch are queued like any others */
+        pConn->nBatch = ExtBatchSize(psc, &preq->szResponse);
+    else
+        preq->szResponse = ExtAnswer(psc);
+
+    unset_scan_context(psc, FALSE);
+
+    ExtServerQueue(pConn, preq);
+
+    return fExit;
+}
+
+static gpointer
+ExtServerConnection(gpointer p)
+{
+    extconnection *pConn = (extconnection *) p;
+    GString *gsLine = g_string_new(NULL);
+    char ach[1024];
+    int n, fExit = FALSE;
+
+    while (!fExit) {
+        char *pch;
+        gsize i;
+
+#ifdef WIN32
+        n = recv((SOCKET) pConn->h, ach, sizeof(ach), 0);
+#else
+        n = (int) recv(pConn->h, ach, sizeof(ach), 0);
+#endif
+        if (n < 0 && errno == EINTR)
+            continue;
+        else if (n <= 0)
+            break;
+
+        g_string_append_len(gsLine, ach, n);
+
+        i = 0;
+        while (!fExit && (pch = memchr(gsLine->str + i, '\n', gsLine->len - i))) {
+            /* the lexer wants each command terminated with \n */
+            char *szCommand = g_strndup(gsLine->str + i, (gsize) (pch - gsLine->str) - i + 1);
+
+            fExit = ExtServerRequest(pConn, szCommand);
+            g_free(szCommand);
+            i = (gsize) (pch - gsLine->str) + 1;
+        }
+        g_string_erase(gsLine, 0, (gssize) i);
+
+        if (gsLine->len > 16384) {
+            extrequest *preq = g_new0(extrequest, 1);
+            preq->szResponse = g_strdup("Error: line too long\n");
+            ExtServerQueue(pConn, preq);
+            break;
+        }
+    }
+
+    g_string_free(gsLine, TRUE);
+    /* the socket is closed once all pending answers are written */
+    ExtConnectionUnref(pConn);
+
+    return NULL;
+}
+
+static gpointer
+ExtServerListen(gpointer p)
+{
+    extserver *pes = (extserver *) p;
+
+    while (!MT_SafeGet(&pes->fStop)) {
+        struct sockaddr_in saRemote;
+        socklen_t saLen = sizeof(saRemote);
+        struct timeval tv;
+        fd_set fds;
+        extconnection *pConn;
+        GThread *pt;
+        int hPeer;
+
+        /* wake up regularly to see if the server is stopping */
+        FD_ZERO(&fds);
+        FD_SET(pes->h, &fds);
+        tv.tv_sec = 0;
+        tv.tv_usec = 100000;
+        if (select(pes->h + 1, &fds, NULL, NULL, &tv) <= 0)
+            continue;
+
+        if ((hPeer = accept(pes->h, (struct sockaddr *) &saRemote, &saLen)) < 0)
+            continue;
+        ExtServerSetTimeout(hPeer);
+
+        Mutex_Lock(&pes->lock);
+        if (g_list_length(pes->plConnections) >= nExternalClients) {
+            static const char szBusy[] = "Error: too many connections\n";
+
+            Mutex_Release(&pes->lock);
+            ExtServerWrite(hPeer, szBusy, strlen(szBusy));
+            closesocket(hPeer);
+            continue;
+        }
+
+        pConn = g_new0(extconnection, 1);
+        pConn->pes = pes;
+        pConn->h = hPeer;
+        pConn->psc = g_new0(scancontext, 1);
+        ExtInitParse(&pConn->psc->scanner);
+        InitMutex(&pConn->lock);
+        pConn->pqPending = g_queue_new();
+        pConn->nRefs = 1;
+
+        pes->plConnections = g_list_prepend(pes->plConnections, pConn);
+        Mutex_Release(&pes->lock);
+        ExtStatsAdd(1, 0, 0.0);
+
+#if GLIB_CHECK_VERSION (2,32,0)
+        if ((pt = g_thread_try_new(NULL, ExtServerConnection, pConn, NULL)))
+            g_thread_unref(pt);
+#else
+        pt = g_thread_create(ExtServerConnection, pConn, FALSE, NULL);
+#endif
+        if (!pt)
+            ExtConnectionUnref(pConn);
+    }
+
+    return NULL;
+}
+
+static void
+ExternalServer(int h)
+{
+    extserver es;
+    GThread *ptListen;
+    GList *plRound = NULL, *pl;
+    extrequest *preq;
+#ifndef WIN32
+    psighandler sh;
+#endif
+
+#ifndef WIN32
+    if (h >= FD_SETSIZE) {
+        /* select() can't wait for it */
+        outputl(_("Too many open files to wait for connections"));
+        return;
+    }
+#endif
+
+    es.h = h;
+    es.paq = g_async_queue_new();
+    es.fStop = FALSE;
+    InitMutex(&es.lock);
+    es.plConnections = NULL;
+    es.plClosed = NULL;
+
+#ifndef WIN32
+    PortableSignal(SIGPIPE, SIG_IGN, &sh, FALSE);
+#endif
+
+#if GLIB_CHECK_VERSION (2,32,0)
+    ptListen = g_thread_try_new(NULL, ExtServerListen, &es, NULL);
+#else
+    ptListen = g_thread_create(ExtServerListen, &es, TRUE, NULL);
+#endif
+    if (!ptListen) {
+        outputl(_("Failed to create thread"));
+        g_async_queue_unref(es.paq);
+        FreeMutex(&es.lock);
+#ifndef WIN32
+        PortableSignalRestore(SIGPIPE, &sh);
+#endif
+        return;
+    }
+
+    while (!fInterrupt) {
+        unsigned int cTasks = 0;
+
+#if GLIB_CHECK_VERSION (2,32,0)
+        preq = g_async_queue_timeout_pop(es.paq, 100000);
+#else
+        {
+            GTimeVal tv;
+            g_get_current_time(&tv);
+            g_time_val_add(&tv, 100000);
+            preq = g_async_queue_timed_pop(es.paq, &tv);
+        }
+#endif
+        ProcessEvents();
+
+        /* everything queued so far goes to the calculation threads as one round */
+        for (; preq; preq = g_async_queue_try_pop(es.paq)) {
+            plRound = g_list_append(plRound, preq);
+            /* rollouts use the calculation threads themselves */
+            if (preq->sc.ct != COMMAND_FIBSBOARD || esEvalCube.et != EVAL_ROLLOUT) {
+                mt_add_tasks(1, ExtServerEvaluate, preq, NULL);
+                cTasks++;
+            }
+        }
+
+        if (cTasks)
+            MT_WaitForTasks(NULL, 10, FALSE);
+
+        for (pl = plRound; pl; pl = pl->next) {
+            preq = (extrequest *) pl->data;
+            if (!preq->szResponse)
+                ExtServerEvaluate(preq);
+        }
+
+        for (pl = plRound; pl; pl = pl->next) {
+            preq = (extrequest *) pl->data;
+            ExtRequestDone(preq->pConn, preq);
+        }
+        g_list_free(plRound);
+        plRound = NULL;
+
+        ExtServerFreeClosed(&es);
+    }
+
+    /* stop accepting, then wake up the I/O threads and answer what is left */
+    MT_SafeSet(&es.fStop, TRUE);
+    g_thread_join(ptListen);
+
+    for (;;) {
+        Mutex_Lock(&es.lock);
+        for (pl = es.plConnections; pl; pl = pl->next)
+            shutdown(((extconnection *) pl->data)->h, SHUT_RDWR);
+        pl = es.plConnections;
+        Mutex_Release(&es.lock);
+
+        if (!pl)
+            break;
+
+        while ((preq = g_async_queue_try_pop(es.paq))) {
+            preq->szResponse = g_strdup("Error: server stopped\n");
+            if (preq->gsDebug)
+                g_string_free(preq->gsDebug, TRUE);
+            preq->gsDebug = NULL;
+            ExtRequestDone(preq->pConn, preq);
+        }
+
+        g_usleep(10000);
+    }
+
+    ExtServerFreeClosed(&es);
+    g_async_queue_unref(es.paq);
+    FreeMutex(&es.lock);
+#ifndef WIN32
+    PortableSignalRestore(SIGPIPE, &sh);
+#endif
+}
+#endif                          /* USE_MULTITHREAD */
+#endif                          /* HAVE_SOCKETS */
+
 extern void
 CommandExternal(char *sz)
 {
@@ -616,6 +1594,8 @@ CommandExternal(char *sz)
     int fExit;
     int fRestart = TRUE;
     int retval = 0;
+    GString *gsPending;
+    extponder ep;
 
     sz = NextToken(&sz);
 
@@ -627,6 +1607,8 @@ CommandExternal(char *sz)
     memset(&scanctx, 0, sizeof(scanctx));
     ExtInitParse(&scanctx.scanner);
 
+    ExtStatsReset();
+
   listenloop:
     {
         fExit = FALSE;
@@ -649,13 +1631,34 @@ CommandExternal(char *sz)
 
         g_free(psa);
 
-        if (listen(h, 1) < 0) {
+        if (listen(h, (int) nExternalClients) < 0) {
             SockErr("listen");
             closesocket(h);
             ExternalUnbind(sz);
             ExtDestroyParse(scanctx.scanner);
             return;
         }
+
+#if defined(USE_MULTITHREAD)
+        if (nExternalClients > 1) {
+            outputf(_("Waiting for up to %u simultaneous connections from %s...\n"), nExternalClients, sz);
+            outputx();
+            ProcessEvents();
+
+            ExternalServer(h);
+
+            closesocket(h);
+            ExternalUnbind(sz);
+            ExtDestroyParse(scanctx.scanner);
+            ExtStatsStop();
+
+            szResponse = ExtStatistics();
+            outputf("%s", szResponse);
+            g_free(szResponse);
+            return;
+        }
+#endif
+
         outputf(_("Waiting for a connection from %s...\n"), sz);
         outputx();
         ProcessEvents();
@@ -685,6 +1688,7 @@ CommandExternal(char *sz)
 
         closesocket(h);
         ExternalUnbind(sz);
+        ExtStatsAdd(1, 0, 0.0);
 
         /* print info about remove client */
 
@@ -692,7 +1696,15 @@ CommandExternal(char *sz)
         outputx();
         ProcessEvents();
 
-        while (!fExit && !(retval = ExternalRead(hPeer, szCommand, sizeof(szCommand)))) {
+        gsPending = g_string_new(NULL);
+
+        while (!fExit && !(retval = ExternalReadBuffered(hPeer, gsPending, szCommand, sizeof(szCommand) - 1))) {
+            double rStart = get_time();
+            int nEvaluated = 0;
+
+            PonderStop();
+            ep.fValid = FALSE;
+
             /* To keep lexer happy terminate each line with \n */
             if (szCommand[strlen(szCommand) - 1] != '\n')
                 strcat(szCommand, "\n");
@@ -701,122 +1713,29 @@ CommandExternal(char *sz)
                 /* parse error */
                 szResponse = scanctx.szError;
             } else {
-                ProcessedFIBSBoard processedBoard;
-                gchar *szOptStr;
-
                 switch (scanctx.ct) {
-                case COMMAND_HELP:
-                    szResponse = g_strdup("\tNo help information available\n");
-                    break;
-
-                case COMMAND_SET:
-                    szOptStr = g_value_get_gstring_gchar(g_list_nth_data(scanctx.pCmdData, 0));
-                    if (g_ascii_strcasecmp(szOptStr, KEY_STR_DEBUG) == 0) {
-                        scanctx.fDebug = g_value_get_int(g_list_nth_data(scanctx.pCmdData, 1));
-                        szResponse = g_strdup_printf("Debug output %s\n", scanctx.fDebug ? "ON" : "OFF");
-                    } else if (g_ascii_strcasecmp(szOptStr, KEY_STR_NEWINTERFACE) == 0) {
-                        scanctx.fNewInterface = g_value_get_int(g_list_nth_data(scanctx.pCmdData, 1));
-                        szResponse = g_strdup_printf("New interface %s\n", scanctx.fNewInterface ? "ON" : "OFF");
-                    } else {
-                        szResponse = g_strdup_printf("Error: set option '%s' not supported\n", szOptStr);
-                    }
-                    g_list_gv_boxed_free(scanctx.pCmdData);
-
-                    break;
-
-                case COMMAND_VERSION:
-                    szResponse = g_strdup("Interface: " EXTERNAL_INTERFACE_VERSION "\n"
-                                          "RFBF: " RFBF_VERSION_SUPPORTED "\n"
-                                          "Engine: " WEIGHTS_VERSION "\n" "Software: " VERSION "\n");
-
-                    break;
-
-                case COMMAND_NONE:
-                    szResponse = g_strdup("Error: no command given\n");
-                    break;
-
                 case COMMAND_FIBSBOARD:
                 case COMMAND_EVALUATION:
                     if (scanctx.fDebug) {
-                        GValue *optionsmapgv;
-                        GValue *boarddatagv;
-                        GString *dbgStr;
-                        int anScore[2];
-                        int fcrawford, fjacoby;
-                        char *asz[7] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL };
-                        char szBoard[10000];
-                        char **aszLines, **aszLinesOrig;
-                        char *szMatchID;
-
-                        optionsmapgv = (GValue *) g_list_nth_data(g_value_get_boxed(scanctx.pCmdData), 1);
-                        boarddatagv = (GValue *) g_list_nth_data(g_value_get_boxed(scanctx.pCmdData), 0);
-                        dbgStr = g_string_new(DEBUG_PREFIX);
-                        g_value_tostring(dbgStr, optionsmapgv, 0);
-                        g_string_append(dbgStr, "\n" DEBUG_PREFIX);
-                        g_value_tostring(dbgStr, boarddatagv, 0);
-                        g_string_append(dbgStr, "\n" DEBUG_PREFIX "\n");
-                        ExternalWrite(hPeer, dbgStr->str, strlen(dbgStr->str));
-                        ProcessFIBSBoardInfo(&scanctx.bi, &processedBoard);
-
-                        anScore[0] = processedBoard.nScoreOpp;
-                        anScore[1] = processedBoard.nScore;
-                        /* If the session isn't using Crawford rule, set Crawford flag to false */
-                        fcrawford = scanctx.fCrawfordRule ? processedBoard.fCrawford : FALSE;
-                        /* Set the Jacoby flag appropriately from the external interface settings */
-                        fjacoby = scanctx.fJacobyRule;
-
-                        szMatchID = MatchID((unsigned int *) processedBoard.anDice, 1, processedBoard.nResignation,
-                                            processedBoard.fDoubled, 1, processedBoard.fCubeOwner, fcrawford,
-                                            processedBoard.nMatchTo, anScore, processedBoard.nCube, fjacoby,
-                                            GAME_PLAYING);
-
-                        DrawBoard(szBoard, (ConstTanBoard) & processedBoard.anBoard, 1, asz, szMatchID, 15);
-
-                        aszLines = g_strsplit(&szBoard[0], "\n", 32);
-                        aszLinesOrig = aszLines;
-                        while (*aszLines) {
-                            ExternalWrite(hPeer, DEBUG_PREFIX, strlen(DEBUG_PREFIX));
-                            ExternalWrite(hPeer, *aszLines, strlen(*aszLines));
-                            ExternalWrite(hPeer, "\n", 1);
-                            aszLines++;
-                        }
-
-                        dbgStr = g_string_assign(dbgStr, "");
-                        g_string_append_printf(dbgStr, DEBUG_PREFIX "X is %s, O is %s\n", processedBoard.szPlayer,
-                                               processedBoard.szOpp);
-                        if (processedBoard.nMatchTo) {
-                            g_string_append_printf(dbgStr, DEBUG_PREFIX "Match Play %s Crawford Rule\n",
-                                                   scanctx.fCrawfordRule ? "with" : "without");
-                            g_string_append_printf(dbgStr, DEBUG_PREFIX "Score: %d-%d/%d%s, ", processedBoard.nScore,
-                                                   processedBoard.nScoreOpp, processedBoard.nMatchTo,
-                                                   fcrawford ? "*" : "");
-                        } else {
-                            g_string_append_printf(dbgStr, DEBUG_PREFIX "Money Session %s Jacoby Rule, %s Beavers\n",
-                                                   scanctx.fJacobyRule ? "with" : "without",
-                                                   scanctx.fBeavers ? "with" : "without");
-                            g_string_append_printf(dbgStr, DEBUG_PREFIX "Score: %d-%d, ", processedBoard.nScore,
-                                                   processedBoard.nScoreOpp);
-                        }
-                        g_string_append_printf(dbgStr, "Roll: %d%d\n",
-                                               processedBoard.anDice[0], processedBoard.anDice[1]);
-                        g_string_append_printf(dbgStr,
-                                               DEBUG_PREFIX
-                                               "CubeOwner: %d, Cube: %d, Turn: %c, Doubled: %d, Resignation: %d\n",
-                                               processedBoard.fCubeOwner, processedBoard.nCube, 'X',
-                                               processedBoard.fDoubled, processedBoard.nResignation);
-                        g_string_append(dbgStr, DEBUG_PREFIX "\n");
-                        ExternalWrite(hPeer, dbgStr->str, strlen(dbgStr->str));
+                        GString *dbgStr = g_string_new(NULL);
 
+                        ExtDebugBoard(&scanctx, dbgStr);
+                        ExternalWrite(hPeer, dbgStr->str, strlen(dbgStr->str));
                         g_string_free(dbgStr, TRUE);
-                        g_strfreev(aszLinesOrig);
                     }
                     g_value_unsetfree(scanctx.pCmdData);
 
-                    if (scanctx.ct == COMMAND_EVALUATION)
-                        szResponse = ExtEvaluation(&scanctx);
+                    if (scanctx.ct == COMMAND_FIBSBOARD)
+                        szResponse = ExtFIBSBoard(&scanctx, &ep);
                     else
-                        szResponse = ExtFIBSBoard(&scanctx);
+                        szResponse = ExtEvaluation(&scanctx);
+                    nEvaluated = 1;
+
+                    break;
 
+                case COMMAND_BATCH:
+                    szResponse = ExtReadBatch(hPeer, gsPending, &scanctx, &retval);
+                    nEvaluated = szResponse ? scanctx.nBatch : 0;
                     break;
 
                 case COMMAND_EXIT:
@@ -825,11 +1744,14 @@ CommandExternal(char *sz)
                     break;
 
                 default:
-                    szResponse = g_strdup("Unsupported Command\n");
+                    szResponse = ExtAnswer(&scanctx);
                 }
                 unset_scan_context(&scanctx, FALSE);
             }
 
+            if (retval)
+                break;
+
             if (szResponse) {
                 /* outputf("%s", szResponse); */
                 if (ExternalWrite(hPeer, szResponse, strlen(szResponse)))
@@ -837,9 +1759,26 @@ CommandExternal(char *sz)
 
                 g_free(szResponse);
                 szResponse = NULL;
+
+                rStart = get_time() - rStart;
+                while (nEvaluated-- > 0)
+                    ExtStatsAdd(0, 1, rStart);
             }
+#if defined(USE_MULTITHREAD)
+            /* think about our next move until the controller sends
+             * the next board */
+            if (ep.fValid) {
+                const evalsetup *pesCube = GetEvalCube();
+                unsigned int anDice[2] = { 0, 0 };
+
+                PonderPosition((ConstTanBoard) ep.anBoard, anDice, &ep.ci, &GetEvalChequer()->ec,
+                               *GetEvalMoveFilter(), pesCube->et == EVAL_EVAL ? &pesCube->ec : NULL);
+            }
+#endif
 
         }
+        PonderStop();
+
         /* Interrupted : get out of listen loop */
         if (retval == -2) {
             ProcessEvents();
@@ -847,6 +1786,7 @@ CommandExternal(char *sz)
         }
 
         closesocket(hPeer);
+        g_string_free(gsPending, TRUE);
         if (szResponse)
             g_free(szResponse);
 
@@ -856,6 +1796,50 @@ CommandExternal(char *sz)
     if (fRestart)
         goto listenloop;
 
+    ExtStatsStop();
     unset_scan_context(&scanctx, TRUE);
 #endif
 }
+
+unsigned int nExternalClients = 1;
+
+extern void
+CommandSetExternalClients(char *sz)
+{
+    int n;
+
+    if ((n = ParseNumber(&sz)) <= 0) {
+        outputl(_("You must specify how many external controllers may connect at the same time."));
+        return;
+    }
+
+    nExternalClients = (unsigned int) n;
+
+#if !defined(USE_MULTITHREAD)
+    if (nExternalClients > 1)
+        outputl(_("This installation of GNU Backgammon was compiled without\n"
+                  "thread support, and serves one external controller at a time."));
+#endif
+
+    outputf(ngettext("Up to %u external controller may connect at the same time.\n",
+                     "Up to %u external controllers may connect at the same time.\n",
+                     nExternalClients), nExternalClients);
+}
+
+extern void
+CommandShowExternal(char *UNUSED(sz))
+{
+    outputf(ngettext("Up to %u external controller may connect at the same time.\n",
+                     "Up to %u external controllers may connect at the same time.\n",
+                     nExternalClients), nExternalClients);
+
+#if HAVE_SOCKETS
+    if (exs.rStart > 0.0) {
+        char *szStats = ExtStatistics();
+
+        outputl(_("Requests answered by the external command:"));
+        outputf("%s", szStats);
+        g_free(szStats);
+    }
+#endif
+}
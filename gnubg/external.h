@@ -32,6 +32,9 @@ extern void ExtDestroyParse(void *scancontext);
 
 #define MAX_RFBF_ELEMENTS 53
 
+/* how many controllers the external command serves at the same time */
+extern unsigned int nExternalClients;
+
 #define KEY_STR_BEAVERS "beavers"
 #define KEY_STR_RESIGNATION "resignation"
 #define KEY_STR_DETERMINISTIC "deterministic"
@@ -53,7 +56,9 @@ typedef enum {
     COMMAND_VERSION = 4,
     COMMAND_SET = 5,
     COMMAND_HELP = 6,
-    COMMAND_LIST = 7
+    COMMAND_LIST = 7,
+    COMMAND_STATISTICS = 8,
+    COMMAND_BATCH = 9
 } cmdtype;
 
 typedef struct {
@@ -164,6 +169,7 @@ typedef struct scancontext {
     /* command type */
     cmdtype ct;
     void *pCmdData;
+    int nBatch;                 /* commands following "batch" */
 
     /* evalcontext */
     int nPlies;
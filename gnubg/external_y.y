@@ -125,7 +125,7 @@ void yyerror(scancontext *scanner, const char *str)
 %{
 %}
 
-%token EOL EXIT DISABLED INTERFACEVERSION 
+%token EOL EXIT DISABLED INTERFACEVERSION STATISTICS BATCH
 %token DEBUG SET NEW OLD OUTPUT E_INTERFACE HELP PROMPT
 %token E_STRING E_CHARACTER E_INTEGER E_FLOAT E_BOOLEAN
 %token FIBSBOARD FIBSBOARDEND EVALUATION
@@ -195,6 +195,19 @@ commands:
             YYACCEPT;
         }
     |
+    STATISTICS EOL
+        {
+            extcmd->ct = COMMAND_STATISTICS;
+            YYACCEPT;
+        }
+    |
+    BATCH E_INTEGER EOL
+        {
+            extcmd->nBatch = $2;
+            extcmd->ct = COMMAND_BATCH;
+            YYACCEPT;
+        }
+    |
     EXIT EOL
         {
             extcmd->ct = COMMAND_EXIT;
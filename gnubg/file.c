@@ -22,6 +22,7 @@
 #include "backgammon.h"
 #include <glib/gstdio.h>
 #include "file.h"
+#include "multithread.h"
 #include <stdlib.h>
 
 ExportFormat export_format[] = {
@@ -488,3 +489,170 @@ GetFilename(int CheckForCurrent, ExportType type)
 
     return sz;
 }
+
+/* A directory of matches. Its files are listed when it is opened, and a
+ * reader thread detects their format ahead of the caller. */
+
+struct _matchdir {
+    gchar *szDir;
+    GPtrArray *pafiles;         /* names in szDir */
+    GAsyncQueue *paqFiles;      /* reader -> caller: matchfile */
+    GThread *ptReader;
+    int fStop;                  /* set by the caller, read by the reader */
+    int fEnd;
+};
+
+typedef struct {
+    gchar *szFile;              /* NULL for the end of the queue */
+    ImportType type;
+} matchfile;
+
+static gpointer
+MatchDirReader(gpointer p)
+{
+    matchdir *pmd = p;
+    matchfile *pmf;
+    guint i;
+
+    for (i = 0; i < pmd->pafiles->len && !MT_SafeGet(&pmd->fStop); i++) {
+        gchar *szFile = g_build_filename(pmd->szDir, g_ptr_array_index(pmd->pafiles, i), NULL);
+        FilePreviewData *fpd = ReadFilePreview(szFile);
+
+        pmf = g_new(matchfile, 1);
+        pmf->szFile = szFile;
+        pmf->type = fpd ? fpd->type : N_IMPORT_TYPES;
+        g_free(fpd);
+        g_async_queue_push(pmd->paqFiles, pmf);
+    }
+
+    pmf = g_new0(matchfile, 1);
+    g_async_queue_push(pmd->paqFiles, pmf);
+
+    return NULL;
+}
+
+extern matchdir *
+MatchDirOpen(const char *szDir)
+{
+    matchdir *pmd;
+    GDir *dir;
+    const gchar *szName;
+
+    if (!(dir = g_dir_open(szDir, 0, NULL))) {
+        outputerr(szDir);
+        return NULL;
+    }
+
+    pmd = g_new0(matchdir, 1);
+    pmd->szDir = g_strdup(szDir);
+    pmd->pafiles = g_ptr_array_new();
+    while ((szName = g_dir_read_name(dir)) != NULL) {
+        gchar *szFile = g_build_filename(szDir, szName, NULL);
+        if (g_file_test(szFile, G_FILE_TEST_IS_REGULAR))
+            g_ptr_array_add(pmd->pafiles, g_strdup(szName));
+        g_free(szFile);
+    }
+    g_dir_close(dir);
+
+    if (!pmd->pafiles->len) {
+        outputf(_("No files found in `%s'\n"), szDir);
+        pmd->fEnd = TRUE;
+        MatchDirClose(pmd);
+        return NULL;
+    }
+
+    pmd->paqFiles = g_async_queue_new();
+
+#if defined(USE_MULTITHREAD)
+#if GLIB_CHECK_VERSION (2,32,0)
+    pmd->ptReader = g_thread_try_new(NULL, MatchDirReader, pmd, NULL);
+#else
+    pmd->ptReader = g_thread_create(MatchDirReader, pmd, TRUE, NULL);
+#endif
+#endif
+    if (!pmd->ptReader)
+        MatchDirReader(pmd);
+
+    return pmd;
+}
+
+extern unsigned int
+MatchDirSize(const matchdir * pmd)
+{
+    return pmd->pafiles->len;
+}
+
+extern const char *
+MatchDirName(const matchdir * pmd, unsigned int i)
+{
+    return g_ptr_array_index(pmd->pafiles, i);
+}
+
+extern char *
+MatchDirNext(matchdir * pmd, ImportType * ptype)
+{
+    matchfile *pmf;
+    char *szFile;
+
+    if (pmd->fEnd)
+        return NULL;
+
+    pmf = g_async_queue_pop(pmd->paqFiles);
+    szFile = pmf->szFile;
+    *ptype = pmf->type;
+    g_free(pmf);
+
+    if (!szFile)
+        pmd->fEnd = TRUE;
+    else if (fInterrupt) {
+        /* the files read already are skipped */
+        MT_SafeSet(&pmd->fStop, TRUE);
+        *ptype = N_IMPORT_TYPES;
+    }
+
+    return szFile;
+}
+
+extern int
+MatchDirLoad(const char *szFile, ImportType type)
+{
+    char *cmd;
+
+    if (type == N_IMPORT_TYPES || type == IMPORT_POS)
+        return FALSE;
+
+    if (type == IMPORT_SGF)
+        cmd = g_strdup_printf("load match \"%s\"", szFile);
+    else
+        cmd = g_strdup_printf("import %s \"%s\"", import_format[type].clname, szFile);
+    FreeMatch();
+    ClearMatch();
+    HandleCommand(cmd, acTop);
+    g_free(cmd);
+
+    return !ListEmpty(&lMatch);
+}
+
+extern void
+MatchDirClose(matchdir * pmd)
+{
+    guint i;
+
+    if (pmd->paqFiles) {
+        ImportType type;
+        char *szFile;
+
+        MT_SafeSet(&pmd->fStop, TRUE);
+        while ((szFile = MatchDirNext(pmd, &type)))
+            g_free(szFile);
+        if (pmd->ptReader)
+            g_thread_join(pmd->ptReader);
+        g_async_queue_unref(pmd->paqFiles);
+    }
+
+    for (i = 0; i < pmd->pafiles->len; i++)
+        g_free(g_ptr_array_index(pmd->pafiles, i));
+    g_ptr_array_free(pmd->pafiles, TRUE);
+    g_free(pmd->szDir);
+    g_free(pmd);
+}
@@ -76,4 +76,20 @@ typedef struct {
 extern char *GetFilename(int CheckForCurrent, ExportType type);
 extern FilePreviewData *ReadFilePreview(const char *filename);
 
+/* The match files of a directory, for the bulk commands */
+typedef struct _matchdir matchdir;
+
+/* List the files of szDir; NULL, with an error, if there are none */
+extern matchdir *MatchDirOpen(const char *szDir);
+extern unsigned int MatchDirSize(const matchdir * pmd);
+/* The name of file i, without the directory */
+extern const char *MatchDirName(const matchdir * pmd, unsigned int i);
+/* The path of the next file and its format (N_IMPORT_TYPES if not a
+ * match file, or after an interrupt), NULL after the last; g_free() it */
+extern char *MatchDirNext(matchdir * pmd, ImportType * ptype);
+/* Load the file found by MatchDirNext() as the current match, without
+ * confirmation if fConfirmNew is unset; FALSE if it isn't a match */
+extern int MatchDirLoad(const char *szFile, ImportType type);
+extern void MatchDirClose(matchdir * pmd);
+
 #endif
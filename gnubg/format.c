@@ -1103,8 +1103,8 @@ static int
 DumpHypergammon1(const TanBoard anBoard, char *szOutput, const bgvariation UNUSED(bgv))
 {
 
-    g_assert(apbcHyper[0]);
-    return BearoffDump(apbcHyper[0], anBoard, szOutput);
+    g_assert(GetHyperBearoff(0));
+    return BearoffDump(GetHyperBearoff(0), anBoard, szOutput);
 
 }
 
@@ -1112,8 +1112,8 @@ static int
 DumpHypergammon2(const TanBoard anBoard, char *szOutput, const bgvariation UNUSED(bgv))
 {
 
-    g_assert(apbcHyper[1]);
-    return BearoffDump(apbcHyper[1], anBoard, szOutput);
+    g_assert(GetHyperBearoff(1));
+    return BearoffDump(GetHyperBearoff(1), anBoard, szOutput);
 
 }
 
@@ -1121,8 +1121,8 @@ static int
 DumpHypergammon3(const TanBoard anBoard, char *szOutput, const bgvariation UNUSED(bgv))
 {
 
-    g_assert(apbcHyper[2]);
-    return BearoffDump(apbcHyper[2], anBoard, szOutput);
+    g_assert(GetHyperBearoff(2));
+    return BearoffDump(GetHyperBearoff(2), anBoard, szOutput);
 
 }
 
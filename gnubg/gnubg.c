@@ -69,6 +69,7 @@ static char szCommandSeparators[] = " \t\n\r\v\f";
 #include "credits.h"
 #include "external.h"
 #include "neuralnet.h"
+#include "ponder.h"
 #include "util.h"
 
 #if defined(LIBCURL_PROTOCOL_HTTPS)
@@ -482,8 +483,11 @@ char player1aliases[256] = "";
 static char szDICE[] = N_("<die> <die>"),
     szCOMMAND[] = N_("<command>"),
     szCOMMENT[] = N_("<comment>"),
+    szDIRFORMAT[] = N_("<directory> <format> [<output directory>]"),
+    szDIROPTANALYSE[] = N_("<directory> [analyse]"),
     szER[] = "evaluation|rollout",
     szFILENAME[] = N_("<filename>"),
+    szFILEPLIESLENGTH[] = N_("<filename> [<moves> [<length>]]"),
     szKEYVALUE[] = N_("[<key>=<value> ...]"),
     szLENGTH[] = N_("<length>"),
     szLIMIT[] = N_("<limit>"),
@@ -496,12 +500,14 @@ static char szDICE[] = N_("<die> <die>"),
     szLANG[] = N_("system|<language code>"),
     szONOFF[] = "on|off",
     szOPTCOMMAND[] = N_("[command]"),
+    szOPTCUBEPLIES[] = N_("[=cube] [plies]"),
     szOPTDATE[] = N_("[yyyy-mm-dd]"),
     szOPTDEPTH[] = N_("[depth]"),
     szOPTFILENAME[] = N_("[filename]"),
     szOPTLENGTH[] = N_("[length]"),
     szOPTMODULUSOPTSEED[] = N_("[modulus <modulus>|factors <factor> <factor>] "
                                "[seed]"),
+    szOPTMOVELENGTH[] = N_("[=move] [length]"),
     szOPTNAME[] = N_("[name]"),
     szOPTPOSITION[] = N_("[position]"),
     szOPTSEED[] = N_("[seed]"),
@@ -513,6 +519,7 @@ static char szDICE[] = N_("<die> <die>"),
     szPRIORITY[] = N_("<priority>"),
     szPROMPT[] = N_("<prompt>"),
     szSCORE[] = N_("<score> [length]"),
+    szSIGMA[] = N_("<ply> <next ply> <value>"),
     szSIZE[] = N_("<size>"),
     szSTEP[] = N_("[game|roll|rolled|marked] <count>"),
     szTRIALS[] = N_("<trials>"),
@@ -1166,8 +1173,8 @@ ResetInterrupt(void)
 }
 
 
-extern void
-HandleCommand(char *sz, command * ac)
+static void
+DispatchCommand(char *sz, command * ac)
 {
 
     command *pc;
@@ -1237,7 +1244,25 @@ HandleCommand(char *sz, command * ac)
 
         outputx();
     } else
-        HandleCommand(sz, pc->pc);
+        DispatchCommand(sz, pc->pc);
+}
+
+/* Nothing else evaluates while a command runs: neither the pondering
+ * (see ponder.h) nor Python threads (see PythonCommandBegin()), so the
+ * commands may free and replace what the evaluations use */
+
+extern void
+HandleCommand(char *sz, command * ac)
+{
+    if (ac != acTop) {
+        DispatchCommand(sz, ac);
+        return;
+    }
+
+    PonderStop();
+    PythonCommandBegin();
+    DispatchCommand(sz, ac);
+    PythonCommandEnd();
 }
 
 extern void
@@ -2866,6 +2891,23 @@ SaveMoveFilterSettings(FILE * pf, const char *sz, movefilter aamf[MAX_FILTER_PLI
         }
 }
 
+static void
+SaveAdaptiveFilterSettings(FILE * pf)
+{
+
+    int i, j;
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+    fprintf(pf, "set adaptivefilters enable %s\n", fAdaptiveFilters ? "on" : "off");
+    fprintf(pf, "set adaptivefilters confidence %s\n",
+            g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%0.3g", rFilterConfidence));
+
+    for (i = 0; i < MAX_FILTER_PLIES; ++i)
+        for (j = i + 1; j <= MAX_FILTER_PLIES; ++j)
+            fprintf(pf, "set adaptivefilters sigma %d %d %s\n", i, j,
+                    g_ascii_formatd(buf, G_ASCII_DTOSTR_BUF_SIZE, "%0.4g", aarFilterSigma[i][j]));
+}
+
 
 
 
@@ -3202,6 +3244,7 @@ SavePlayingSettings(FILE * pf)
     fprintf(pf, "set automatic game %s\n", fAutoGame ? "on" : "off");
     fprintf(pf, "set automatic move %s\n", fAutoMove ? "on" : "off");
     fprintf(pf, "set automatic roll %s\n", fAutoRoll ? "on" : "off");
+    fprintf(pf, "set ponder %s\n", fPonder ? "on" : "off");
 }
 
 static void
@@ -3221,6 +3264,7 @@ SaveEvaluationSettings(FILE * pf)
     SaveEvalSetupSettings(pf, "set evaluation chequerplay", &esEvalChequer);
     SaveEvalSetupSettings(pf, "set evaluation cubedecision", &esEvalCube);
     SaveMoveFilterSettings(pf, "set evaluation movefilter", aamfEval);
+    SaveAdaptiveFilterSettings(pf);
     fprintf(pf, "set cache %u\n", GetEvalCacheEntries());
     fprintf(pf, "set matchequitytable \"%s\"\n", miCurrent.szFileName);
     fprintf(pf, "set invert matchequitytable %s\n", fInvertMET ? "on" : "off");
@@ -3258,6 +3302,7 @@ SaveMiscSettings(FILE * pf)
     fprintf(pf, "set confirm save %s\n", fConfirmSave ? "on" : "off");
     fprintf(pf, "set cube use %s\n", fCubeUse ? "on" : "off");
     fprintf(pf, "set display %s\n", fDisplay ? "on" : "off");
+    fprintf(pf, "set external clients %u\n", nExternalClients);
 
     fprintf(pf, "set confirm default ");
     if (nConfirmDefault == 1)
@@ -3685,6 +3730,7 @@ ProcessInput(char *sz)
         rl_callback_handler_install(szp, ProcessInput);
         g_free(szp);
         fReadingCommand = TRUE;
+        PonderSchedule();
     }
 }
 
@@ -3709,6 +3755,7 @@ UserCommand(const char *szCommand)
         HandleCommand(sz, acTop);
         g_free(sz);
         ResetInterrupt();
+        PonderSchedule();
         return;
     }
 
@@ -3729,6 +3776,7 @@ UserCommand(const char *szCommand)
     HandleCommand(sz, acTop);
     g_free(sz);
     ResetInterrupt();
+    PonderSchedule();
     if (nNextTurn)
         Prompt();
     else
@@ -4252,6 +4300,10 @@ run_cl(void)
 {
     char *line;
     for (;;) {
+        /* think ahead while the user is typing; a script has no one
+         * to wait for */
+        if (fInteractive)
+            PonderStart();
 #if defined(HAVE_LIB_READLINE)
         if (fInteractive) {
             line = get_readline();
@@ -4334,6 +4386,39 @@ PushSplash(char *UNUSED(unused), char *UNUSED(heading), char *UNUSED(message))
 }
 #endif
 
+/* --startup-profile: time spent in each initialisation step */
+
+static int fStartupProfile = FALSE;
+
+typedef struct {
+    const char *szStep;
+    double rTime;               /* ms */
+} startupstep;
+
+static startupstep aStartupSteps[16];
+static unsigned int cStartupSteps = 0;
+
+static void
+StartupProfileAdd(const char *szStep, const double rTime)
+{
+    if (cStartupSteps < G_N_ELEMENTS(aStartupSteps)) {
+        aStartupSteps[cStartupSteps].szStep = szStep;
+        aStartupSteps[cStartupSteps].rTime = rTime;
+        ++cStartupSteps;
+    }
+}
+
+static void
+StartupProfileShow(const double rTotal)
+{
+    unsigned int i;
+
+    outputf("%s\n", _("Start-up profile (ms):"));
+    for (i = 0; i < cStartupSteps; ++i)
+        outputf("  %-40s %9.1f\n", gettext(aStartupSteps[i].szStep), aStartupSteps[i].rTime);
+    outputf("  %-40s %9.1f\n", _("Total (wall clock)"), rTotal);
+}
+
 static void
 init_nets(int fNoBearoff)
 {
@@ -4344,6 +4429,22 @@ init_nets(int fNoBearoff)
     g_free(gnubg_weights_binary);
 }
 
+static double rMETTime;
+
+static gpointer
+init_met(gpointer UNUSED(unused))
+{
+    double rStart = get_time();
+    char *met = BuildFilename2("met", "Kazaross-XG2.xml");
+
+    InitMatchEquity(met);
+    g_free(met);
+
+    rMETTime = get_time() - rStart;
+
+    return NULL;
+}
+
 extern int
 GetManualDice(unsigned int anDice[2])
 {
@@ -4515,7 +4616,10 @@ main(int argc, char *argv[])
     char *pwSplash = NULL;
 #endif
     char *pchMatch = NULL;
-    char *met = NULL;
+    double rStart = get_time(), rStep;
+#if defined(USE_MULTITHREAD)
+    GThread *threadMET = NULL;
+#endif
 
     static char *pchCommands = NULL, *lang = NULL;
     static int fNoBearoff = FALSE, fNoX = FALSE, fSplash = FALSE, fNoTTY = FALSE, show_version = FALSE, debug = FALSE;
@@ -4551,6 +4655,8 @@ main(int argc, char *argv[])
          N_("Specify location of program documentation"), NULL},
         {"prefsdir", 's', 0, G_OPTION_ARG_STRING, &prefsdir,
          N_("Specify location of user's preferences directory"), NULL},
+        {"startup-profile", 0, 0, G_OPTION_ARG_NONE, &fStartupProfile,
+         N_("Show the time spent in each start-up step"), NULL},
         {NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL}
     };
     GError *error = NULL;
@@ -4656,19 +4762,44 @@ main(int argc, char *argv[])
     }
 
     PushSplash(pwSplash, _("Initialising"), _("Random number generator"));
+    rStep = get_time();
     init_rng();
+    StartupProfileAdd(N_("Random number generator"), get_time() - rStep);
+
+    glib_ext_init();
+
+    /* the match equity table and the neural nets are independent of
+     * each other, so initialise them in parallel */
 
     PushSplash(pwSplash, _("Initialising"), _("match equity table"));
-    met = BuildFilename2("met", "Kazaross-XG2.xml");
-    InitMatchEquity(met);
-    g_free(met);
+#if defined(USE_MULTITHREAD)
+#if GLIB_CHECK_VERSION (2,32,0)
+    threadMET = g_thread_try_new(NULL, init_met, NULL, NULL);
+#else
+    threadMET = g_thread_create(init_met, NULL, TRUE, NULL);
+#endif
+    if (!threadMET)
+#endif
+        init_met(NULL);
 
     PushSplash(pwSplash, _("Initialising"), _("neural nets"));
+    rStep = get_time();
     init_nets(fNoBearoff);
+    StartupProfileAdd(N_("Neural nets and bearoff databases"), get_time() - rStep);
+    StartupProfileAdd(N_("  escape tables and caches"), 1000.0 * eipInit.rTables);
+    StartupProfileAdd(N_("  weights"), 1000.0 * eipInit.rWeights);
+    StartupProfileAdd(N_("  bearoff databases (in parallel)"), 1000.0 * eipInit.rBearoff);
+
+#if defined(USE_MULTITHREAD)
+    if (threadMET)
+        g_thread_join(threadMET);
+#endif
+    StartupProfileAdd(N_("Match equity table (in parallel)"), rMETTime);
 
     PushSplash(pwSplash, _("Initialising"), _("initialising thread data"));
-    glib_ext_init();
+    rStep = get_time();
     MT_InitThreads();
+    StartupProfileAdd(N_("Thread data"), get_time() - rStep);
 
 #if defined(WIN32) && defined(HAVE_SOCKETS)
     PushSplash(pwSplash, _("Initialising"), _("Windows sockets"));
@@ -4677,7 +4808,9 @@ main(int argc, char *argv[])
 
 #if defined(USE_PYTHON)
     PushSplash(pwSplash, _("Initialising"), "Python");
+    rStep = get_time();
     PythonInitialise(argv[0]);
+    StartupProfileAdd(N_("Python"), get_time() - rStep);
 #endif
 
     SetExitSoundOff();
@@ -4685,7 +4818,9 @@ main(int argc, char *argv[])
     /* -r option given */
     if (!fNoRC) {
         PushSplash(pwSplash, _("Loading"), _("User Settings"));
+        rStep = get_time();
         LoadRCFiles();
+        StartupProfileAdd(N_("User settings"), get_time() - rStep);
     }
 
     strcpy(ap[0].szName, default_names[0]);
@@ -4696,9 +4831,14 @@ main(int argc, char *argv[])
 
 #if defined(USE_MULTITHREAD)
     /* Make sure threads started */
+    rStep = get_time();
     MT_StartThreads();
+    StartupProfileAdd(N_("Evaluation threads"), get_time() - rStep);
 #endif
 
+    if (fStartupProfile)
+        StartupProfileShow(get_time() - rStart);
+
     /* start-up sound */
     playSound(SOUND_START);
 
@@ -5222,7 +5362,7 @@ EPC(const TanBoard anBoard, float *arEPC, float *arMu, float *arSigma, int *pfSo
         float ar[5];
         int i;
 
-        raceProbs(anBoard, nTrials, ar, arMux);
+        raceProbsMT(anBoard, nTrials, MT_GetNumThreads(), ar, arMux);
 
         for (i = 0; i < 2; ++i) {
             if (arEPC)
@@ -5367,7 +5507,10 @@ RunAsyncProcess(AsyncFun fun, void *data, const char *msg)
 {
     int ret;
 #if defined(USE_MULTITHREAD)
-    Task *pt = (Task *) g_malloc(sizeof(Task));
+    Task *pt;
+
+    PonderStop();
+    pt = (Task *) g_malloc(sizeof(Task));
 
     pt->pLinkedTask = NULL;
     pt->fun = fun;
@@ -34,7 +34,9 @@
 #include "matchequity.h"
 #include "positionid.h"
 #include "matchid.h"
+#include "multithread.h"
 #include "util.h"
+#include "scoremap.h"
 #include "lib/gnubg-types.h"
 #include "lib/simd.h"
 
@@ -910,6 +912,189 @@ PythonHint(PyObject * UNUSED(self), PyObject * args)
     return retval;
 }
 
+static PyObject *
+ScoreMapCellToPy(const scoremapcell * psmc, const scoremaptable * pst)
+{
+    char sz[FORMATEDMOVESIZE];
+
+    if (!psmc)
+        Py_RETURN_NONE;
+
+    if (pst->fCubeMap)
+        return Py_BuildValue("(ffs)", psmc->rNoDouble, psmc->rDoubleTake,
+                             ScoreMapCubeAction(psmc->rNoDouble, psmc->rDoubleTake));
+
+    if (!psmc->ml.cMoves)
+        Py_RETURN_NONE;
+
+    FormatMove(sz, (ConstTanBoard) ms.anBoard, psmc->ml.amMoves[0].anMove);
+    return Py_BuildValue("(sf)", sz, psmc->ml.amMoves[0].rScore);
+}
+
+/* Commands may free what the evaluations running without the GIL
+ * read, such as the opening book or the match equity memo, so the two
+ * exclude each other: a command waits for the evaluations running, and
+ * evaluations wait for the commands running. Python run by a command
+ * evaluates straight away, on the command's own thread. */
+
+#if defined(USE_MULTITHREAD)
+static struct {
+    Mutex lock;                 /* protects the counts */
+    ManualEvent meIdle;         /* no evaluations */
+    ManualEvent meNoCommands;   /* no commands */
+    int cEvaluations;
+    int cCommands;
+} pyguard;
+
+static void
+PyGuardInit(void)
+{
+    InitMutex(&pyguard.lock);
+    InitManualEvent(&pyguard.meIdle);
+    InitManualEvent(&pyguard.meNoCommands);
+    SetManualEvent(pyguard.meIdle);
+    SetManualEvent(pyguard.meNoCommands);
+}
+
+extern void
+PythonCommandBegin(void)
+{
+    if (!pyguard.meIdle)
+        /* Python isn't initialised */
+        return;
+
+    MT_AttachThread();
+    if (MT_GetTLD()->cCommands++)
+        return;
+
+    Mutex_Lock(&pyguard.lock);
+    if (!pyguard.cCommands++)
+        ResetManualEvent(pyguard.meNoCommands);
+    while (pyguard.cEvaluations) {
+        Mutex_Release(&pyguard.lock);
+        WaitForManualEvent(pyguard.meIdle);
+        Mutex_Lock(&pyguard.lock);
+    }
+    Mutex_Release(&pyguard.lock);
+}
+
+extern void
+PythonCommandEnd(void)
+{
+    if (!pyguard.meIdle || --MT_GetTLD()->cCommands)
+        return;
+
+    Mutex_Lock(&pyguard.lock);
+    if (!--pyguard.cCommands)
+        SetManualEvent(pyguard.meNoCommands);
+    Mutex_Release(&pyguard.lock);
+}
+
+/* Called with the GIL released, after MT_AttachThread() */
+static void
+PyEvaluationBegin(void)
+{
+    if (MT_GetTLD()->cCommands)
+        return;
+
+    Mutex_Lock(&pyguard.lock);
+    while (pyguard.cCommands) {
+        Mutex_Release(&pyguard.lock);
+        WaitForManualEvent(pyguard.meNoCommands);
+        Mutex_Lock(&pyguard.lock);
+    }
+    if (!pyguard.cEvaluations++)
+        ResetManualEvent(pyguard.meIdle);
+    Mutex_Release(&pyguard.lock);
+}
+
+static void
+PyEvaluationEnd(void)
+{
+    if (MT_GetTLD()->cCommands)
+        return;
+
+    Mutex_Lock(&pyguard.lock);
+    if (!--pyguard.cEvaluations)
+        SetManualEvent(pyguard.meIdle);
+    Mutex_Release(&pyguard.lock);
+}
+#else
+#define PyEvaluationBegin()
+#define PyEvaluationEnd()
+#endif
+
+/* The score map of the current position, evaluated on the calculation
+ * threads like "show scoremap" */
+
+static PyObject *
+PythonScoreMap(PyObject * UNUSED(self), PyObject * args)
+{
+    int nMatchTo = 0, fMove = 0, fMain = TRUE, ret;
+    scoremaptable st;
+    cubeinfo ci;
+    PyObject *pyScores, *pyRow, *pyMoney;
+    unsigned int i, j;
+
+    if (!PyArg_ParseTuple(args, "|ii:scoremap", &nMatchTo, &fMove))
+        return NULL;
+
+    if (ms.gs != GAME_PLAYING) {
+        PyErr_SetString(PyExc_StandardError, _("You must set up a board first."));
+        return NULL;
+    }
+    if (!nMatchTo)
+        nMatchTo = ms.nMatchTo < 3 ? 3 : MIN(ms.nMatchTo, 9);
+    if (nMatchTo < 2 || nMatchTo > MAXSCORE) {
+        PyErr_SetString(PyExc_ValueError, _("invalid match length"));
+        return NULL;
+    }
+    if (fMove && !ms.anDice[0]) {
+        PyErr_SetString(PyExc_StandardError, _("You must roll the dice first."));
+        return NULL;
+    }
+    GetMatchStateCubeInfo(&ci, &ms);
+    if (!fMove && !GetDPEq(NULL, NULL, &ci)) {
+        PyErr_SetString(PyExc_StandardError, _("Cube is not available."));
+        return NULL;
+    }
+#if defined(USE_MULTITHREAD)
+    MT_AttachThread();
+    fMain = MT_GetThreadID() == -1;
+#endif
+    if (!fMain) {
+        PyErr_SetString(PyExc_StandardError, _("scoremap() must be called from the main thread"));
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS;
+    PyEvaluationBegin();
+    ret = ScoreMapTableCalc(&st, &ms, !fMove, nMatchTo);
+    PyEvaluationEnd();
+    Py_END_ALLOW_THREADS;
+
+    if (ret < 0) {
+        ScoreMapTableFree(&st);
+        ResetInterrupt();
+        PyErr_SetString(PyExc_StandardError, _("interrupted/errno in scoremap"));
+        return NULL;
+    }
+
+    pyScores = PyList_New(st.cSize);
+    for (i = 0; i < st.cSize; i++) {
+        pyRow = PyList_New(st.cSize);
+        for (j = 0; j < st.cSize; j++)
+            PyList_SET_ITEM(pyRow, j, ScoreMapCellToPy(st.apsmc[i * st.cSize + j], &st));
+        PyList_SET_ITEM(pyScores, i, pyRow);
+    }
+    pyMoney = ScoreMapCellToPy(st.apsmc[st.cSize * st.cSize], &st);
+
+    ScoreMapTableFree(&st);
+
+    return Py_BuildValue("{s:s,s:i,s:i,s:N,s:N}", "type", fMove ? "move" : "cube",
+                         "matchlength", nMatchTo, "plies", (int) st.nPlies, "scores", pyScores, "money", pyMoney);
+}
+
 static PyObject *
 PythonUpdateUI(PyObject * UNUSED(self), PyObject * UNUSED(args))
 {
@@ -1202,6 +1387,95 @@ PythonCalculateGammonPrice(PyObject * UNUSED(self), PyObject * pyCubeInfo)
     return (pyCubeInfo);
 }
 
+/* In multithreaded builds the evaluation functions run on the calling
+ * thread with the GIL released, so that several Python threads can
+ * evaluate at the same time. Each thread has its own evaluation state
+ * and uses the locking versions of the evaluation functions, whatever
+ * the number of calculation threads. The arguments, and the defaults
+ * taken from the current match, are copied before the GIL is released.
+ */
+
+#if defined(USE_MULTITHREAD)
+#define PyGeneralEvaluationE GeneralEvaluationEWithLocking
+#define PyGeneralCubeDecisionE GeneralCubeDecisionEWithLocking
+#define PyFindnSaveBestMoves FindnSaveBestMovesWithLocking
+#else
+#define PyGeneralEvaluationE GeneralEvaluationE
+#define PyGeneralCubeDecisionE GeneralCubeDecisionE
+#define PyFindnSaveBestMoves FindnSaveBestMoves
+#endif
+
+static int
+PyMoveDecisionE(void *p)
+{
+    decisionData *pdd = (decisionData *) p;
+
+    return PyGeneralEvaluationE(pdd->aarOutput[0], pdd->pboard, pdd->pci, pdd->pec);
+}
+
+static int
+PyCubeDecisionE(void *p)
+{
+    decisionData *pdd = (decisionData *) p;
+
+    return PyGeneralCubeDecisionE(pdd->aarOutput, pdd->pboard, pdd->pci, pdd->pec, pdd->pes);
+}
+
+static int
+PyFindBestMoves(void *p)
+{
+    findData *pfd = (findData *) p;
+
+    if (PyFindnSaveBestMoves(pfd->pml, pfd->anDice[0], pfd->anDice[1], pfd->pboard,
+                             pfd->keyMove, pfd->rThr, pfd->pci, pfd->pec, pfd->aamf) < 0)
+        return -1;
+
+    RefreshMoveList(pfd->pml, NULL);
+    return 0;
+}
+
+static int
+PyRunEvaluation(int (*fun) (void *), AsyncFun funAsync, void *data, const char *szMessage)
+{
+    int ret;
+#if defined(USE_MULTITHREAD)
+    int fMain;
+
+    (void) funAsync;
+    (void) szMessage;
+
+    MT_AttachThread();
+    fMain = MT_GetThreadID() == -1;
+
+    Py_BEGIN_ALLOW_THREADS;
+    PyEvaluationBegin();
+    ret = fun(data);
+    PyEvaluationEnd();
+    Py_END_ALLOW_THREADS;
+
+    if (ret < 0 || fInterrupt) {
+        if (fMain)
+            ResetInterrupt();
+        return -1;
+    }
+#else
+    int fSaveShowProg = fShowProgress;
+
+    (void) fun;
+
+    fShowProgress = FALSE;
+    ret = RunAsyncProcess(funAsync, data, szMessage);
+    fShowProgress = fSaveShowProg;
+
+    if (ret != 0 || fInterrupt) {
+        ResetInterrupt();
+        return -1;
+    }
+#endif
+
+    return 0;
+}
+
 SIMD_STACKALIGN static PyObject *
 PythonEvaluate(PyObject * UNUSED(self), PyObject * args)
 {
@@ -1210,7 +1484,6 @@ PythonEvaluate(PyObject * UNUSED(self), PyObject * args)
     PyObject *pyCubeInfo = NULL;
     PyObject *pyEvalContext = NULL;
 
-    int fSaveShowProg;
     decisionData dd;
     TanBoard anBoard;
     cubeinfo ci;
@@ -1236,15 +1509,10 @@ PythonEvaluate(PyObject * UNUSED(self), PyObject * args)
     dd.pci = &ci;
     dd.pec = &ec;
 
-    fSaveShowProg = fShowProgress;
-    fShowProgress = FALSE;
-    if ((RunAsyncProcess((AsyncFun) asyncMoveDecisionE, &dd, _("Considering move...")) != 0) || fInterrupt) {
-        fShowProgress = fSaveShowProg;
-        ResetInterrupt();
+    if (PyRunEvaluation(PyMoveDecisionE, (AsyncFun) asyncMoveDecisionE, &dd, _("Considering move...")) < 0) {
         PyErr_SetString(PyExc_StandardError, _("interrupted/errno in asyncMoveDecisionE"));
         return NULL;
     }
-    fShowProgress = fSaveShowProg;
 
     {
         PyObject *p = PyTuple_New(6);
@@ -1264,7 +1532,6 @@ PythonEvaluateCubeful(PyObject * UNUSED(self), PyObject * args)
     PyObject *pyCubeInfo = NULL;
     PyObject *pyEvalContext = NULL;
 
-    int fSaveShowProg;
     decisionData dd;
     TanBoard anBoard;
     float arCube[NUM_CUBEFUL_OUTPUTS];
@@ -1293,15 +1560,10 @@ PythonEvaluateCubeful(PyObject * UNUSED(self), PyObject * args)
     dd.pec = &ec;
     dd.pes = NULL;
 
-    fSaveShowProg = fShowProgress;
-    fShowProgress = FALSE;
-    if ((RunAsyncProcess((AsyncFun) asyncCubeDecisionE, &dd, _("Considering cube decision...")) != 0) || fInterrupt) {
-        fShowProgress = fSaveShowProg;
-        ResetInterrupt();
+    if (PyRunEvaluation(PyCubeDecisionE, (AsyncFun) asyncCubeDecisionE, &dd, _("Considering cube decision...")) < 0) {
         PyErr_SetString(PyExc_StandardError, _("interrupted/errno in asyncCubeDecisionE"));
         return NULL;
     }
-    fShowProgress = fSaveShowProg;
 
     cp = FindCubeDecision(arCube, dd.aarOutput, &ci);
 
@@ -1333,12 +1595,13 @@ PythonFindBestMove(PyObject * UNUSED(self), PyObject * args)
     evalcontext ec;
     movelist ml;
     findData fd;
-    int fSaveShowProg;
+    TmoveFilter aamf;
 
     memcpy(&ec, &GetEvalChequer()->ec, sizeof(evalcontext));
     memcpy(anBoard, msBoard(), sizeof(TanBoard));
     memcpy(&fd.anDice, ms.anDice, sizeof(ms.anDice));
-    fd.aamf = *GetEvalMoveFilter();
+    memcpy(aamf, *GetEvalMoveFilter(), sizeof(TmoveFilter));
+    fd.aamf = aamf;
 
     GetMatchStateCubeInfo(&ci, &ms);
     if (!PyArg_ParseTuple(args, "|OOOOO", &pyBoard, &pyCubeInfo, &pyEvalContext, &pyDice, &pyMoveFilters))
@@ -1371,15 +1634,10 @@ PythonFindBestMove(PyObject * UNUSED(self), PyObject * args)
     fd.pci = &ci;
     fd.pec = &ec;
 
-    fSaveShowProg = fShowProgress;
-    fShowProgress = FALSE;
-    if ((RunAsyncProcess((AsyncFun) asyncFindBestMoves, &fd, _("Considering move...")) != 0) || fInterrupt) {
-        fShowProgress = fSaveShowProg;
-        ResetInterrupt();
+    if (PyRunEvaluation(PyFindBestMoves, (AsyncFun) asyncFindBestMoves, &fd, _("Considering move...")) < 0) {
         PyErr_SetString(PyExc_StandardError, _("interrupted/errno in asyncFindBestMoves"));
         return NULL;
     }
-    fShowProgress = fSaveShowProg;
 
     {
         PyObject *p;
@@ -1405,132 +1663,585 @@ PythonFindBestMove(PyObject * UNUSED(self), PyObject * args)
     }
 }
 
-static PyObject *
-METRow(float ar[MAXSCORE], const int n)
-{
+/* Batch evaluation of positions passed as integer arrays */
 
-    int i;
-    PyObject *pyList;
+typedef struct {
+    Py_ssize_t n;
+    const TanBoard *aanBoard;
+    const int (*aanDice)[2];    /* NULL for evaluate_batch */
+    float (*aarOutput)[NUM_OUTPUTS + 1];
+    int (*aanMove)[8];
+    cubeinfo *pci;
+    const evalcontext *pec;
+    movefilter(*aamf)[MAX_FILTER_PLIES];
+    int iNext;
+    int fFailed;
+} pybatch;
+
+/* An integer in the standard size and byte order of a struct module
+ * format starting with '<', '>', '!' or '=' */
 
-    if (!(pyList = PyList_New(n)))
-        return NULL;
+static int
+BufferItemStandard(const unsigned char *puch, Py_ssize_t cb, char chOrder, char chType, long *pl)
+{
+    static const char szTypes[] = "bBhHiIlLqQ";
+    static const Py_ssize_t acb[] = { 1, 1, 2, 2, 4, 4, 4, 4, 8, 8 };
+    const char *pchType = chType ? strchr(szTypes, chType) : NULL;
+    int fBig = chOrder == '>' || chOrder == '!' || (chOrder == '=' && G_BYTE_ORDER == G_BIG_ENDIAN);
+    guint64 u = 0;
+    Py_ssize_t k;
+
+    if (!pchType || cb != acb[pchType - szTypes])
+        return FALSE;
 
-    for (i = 0; i < n; ++i) {
-        PyObject *pyf;
+    for (k = 0; k < cb; ++k)
+        u = (u << 8) | puch[fBig ? k : cb - 1 - k];
 
-        if (!(pyf = PyFloat_FromDouble(ar[i])))
-            return NULL;
+    /* sign extend the signed types */
+    if (g_ascii_islower(chType) && cb < 8 && (u >> (8 * cb - 1)) & 1)
+        u |= ~(guint64) 0 << (8 * cb);
 
-        if (PyList_SetItem(pyList, i, pyf) < 0)
-            return NULL;
+    *pl = (long) (gint64) u;
+    return TRUE;
+}
 
+static int
+BufferItem(const Py_buffer * pb, Py_ssize_t i, long *pl)
+{
+    const char *pch = (const char *) pb->buf + i * pb->itemsize;
+    const char *szFormat = pb->format ? pb->format : "B";
+
+    if (*szFormat == '<' || *szFormat == '>' || *szFormat == '!' || *szFormat == '=')
+        return BufferItemStandard((const unsigned char *) pch, pb->itemsize, szFormat[0], szFormat[1], pl);
+
+    if (*szFormat == '@')
+        szFormat++;
+
+    switch (*szFormat) {
+    case 'b':
+        *pl = *(const signed char *) pch;
+        return TRUE;
+    case 'B':
+        *pl = *(const unsigned char *) pch;
+        return TRUE;
+    case 'h':
+        *pl = *(const short *) pch;
+        return TRUE;
+    case 'H':
+        *pl = *(const unsigned short *) pch;
+        return TRUE;
+    case 'i':
+        *pl = *(const int *) pch;
+        return TRUE;
+    case 'I':
+        *pl = (long) *(const unsigned int *) pch;
+        return TRUE;
+    case 'l':
+        *pl = *(const long *) pch;
+        return TRUE;
+    case 'L':
+        *pl = (long) *(const unsigned long *) pch;
+        return TRUE;
+    case 'q':
+        *pl = (long) *(const long long *) pch;
+        return TRUE;
+    case 'Q':
+        *pl = (long) *(const unsigned long long *) pch;
+        return TRUE;
+    default:
+        return FALSE;
     }
-
-    return pyList;
-
 }
 
-static PyObject *
-METPre(float aar[MAXSCORE][MAXSCORE], const int n)
+/* Read a C contiguous integer array of cItem values per row, such as
+ * an N x 2 x 25 numpy array of boards; returns the number of rows or
+ * -1 with a Python exception set */
+
+static Py_ssize_t
+PyToIntArray(PyObject * p, int cItem, int **ppn)
 {
-    int i;
-    PyObject *pyList;
+    Py_buffer b;
+    Py_ssize_t i, cRows;
 
-    if (!(pyList = PyList_New(n)))
-        return NULL;
+    if (PyObject_GetBuffer(p, &b, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0)
+        return -1;
 
-    for (i = 0; i < n; ++i) {
-        PyObject *pyRow;
+    cRows = b.len / b.itemsize / cItem;
 
-        if (!(pyRow = METRow(aar[i], n)))
-            return NULL;
+    if (b.len != cRows * cItem * b.itemsize || (b.ndim > 1 && b.shape[0] != cRows)) {
+        PyErr_Format(PyExc_ValueError, _("array must have %d values per row"), cItem);
+        PyBuffer_Release(&b);
+        return -1;
+    }
 
-        if (PyList_SetItem(pyList, i, pyRow) < 0)
-            return NULL;
+    *ppn = g_new(int, cRows * cItem + 1);
+
+    for (i = 0; i < cRows * cItem; ++i) {
+        long l;
 
+        if (!BufferItem(&b, i, &l)) {
+            PyErr_SetString(PyExc_TypeError, _("array must contain integers"));
+            g_free(*ppn);
+            PyBuffer_Release(&b);
+            return -1;
+        }
+        (*ppn)[i] = (l < INT_MIN || l > INT_MAX) ? -1 : (int) l;
     }
 
-    return pyList;
+    PyBuffer_Release(&b);
+    return cRows;
 }
 
-
-static PyObject *
-PythonDiceRolls(PyObject * UNUSED(self), PyObject * args)
+static Py_ssize_t
+PyToBoards(PyObject * p, TanBoard ** paanBoard)
 {
-    PyObject *pyDiceRolls;
-    long n;
-    unsigned int anDice[2];
-    int rollsidx;
+    int *an;
+    Py_ssize_t i, n;
 
-    if (!PyArg_ParseTuple(args, "l:dicerolls", &n))
-        return NULL;
+    if ((n = PyToIntArray(p, 2 * 25, &an)) < 0)
+        return -1;
 
-    if (n <= 0) {
-        PyErr_SetString(PyExc_ValueError, _("number of rolls must be greater than 0"));
-        return NULL;
-    }
+    *paanBoard = g_new(TanBoard, n + 1);
 
-    if (!(pyDiceRolls = PyTuple_New(n)))
-        return NULL;
+    for (i = 0; i < n; ++i) {
+        int j, k;
 
-    rollsidx = 0;
-    while (n-- > 0) {
-        PyObject *pyDiceRoll;
-        PyObject *pyDie1;
-        PyObject *pyDie2;
-        int dieidx;
+        for (j = 0; j < 2; ++j) {
+            int c = 0;
 
-        RollDice(anDice, &rngCurrent, rngctxCurrent);
+            for (k = 0; k < 25; ++k) {
+                int nChequers = an[(i * 2 + j) * 25 + k];
 
-        pyDie1 = PyInt_FromLong(anDice[0]);
-        pyDie2 = PyInt_FromLong(anDice[1]);
+                if (nChequers < 0 || nChequers > 15) {
+                    c = -1;
+                    break;
+                }
+                c += nChequers;
+                (*paanBoard)[i][j][k] = (unsigned int) nChequers;
+            }
+            if (c < 0 || c > 15) {
+                PyErr_Format(PyExc_ValueError, _("board %ld is not a legal position"), (long) i);
+                g_free(an);
+                g_free(*paanBoard);
+                return -1;
+            }
+        }
+    }
 
-        if (!(pyDiceRoll = PyTuple_New(2)))
-            return NULL;
+    g_free(an);
+    return n;
+}
 
-        dieidx = 0;
-        if (PyTuple_SetItem(pyDiceRoll, dieidx, pyDie1) < 0)
-            return NULL;
-        if (PyTuple_SetItem(pyDiceRoll, dieidx + 1, pyDie2) < 0)
-            return NULL;
+static void
+BatchEvaluate(void *p)
+{
+    pybatch *pbat = (pybatch *) p;
+    Py_ssize_t i;
 
-        if (PyTuple_SetItem(pyDiceRolls, rollsidx++, pyDiceRoll) < 0)
-            return NULL;
+    while (!fInterrupt && (i = MT_SafeIncCheck(&pbat->iNext)) < pbat->n) {
+        float arOutput[NUM_ROLLOUT_OUTPUTS];
+
+        if (PyGeneralEvaluationE(arOutput, (ConstTanBoard) pbat->aanBoard[i], pbat->pci, pbat->pec) < 0) {
+            pbat->fFailed = TRUE;
+            return;
+        }
+        memcpy(pbat->aarOutput[i], arOutput, sizeof(pbat->aarOutput[i]));
     }
-    return pyDiceRolls;
 }
 
-static PyObject *
-PythonMET(PyObject * UNUSED(self), PyObject * args)
+static void
+BatchFindBestMove(void *p)
 {
+    pybatch *pbat = (pybatch *) p;
+    Py_ssize_t i;
 
-    int n = ms.nMatchTo ? ms.nMatchTo : MAXSCORE;
-    int i;
-    PyObject *pyMET;
-    PyObject *pyList;
+    while (!fInterrupt && (i = MT_SafeIncCheck(&pbat->iNext)) < pbat->n) {
+        const int *anDice = pbat->aanDice[i];
+        movelist ml;
+        int k;
 
-    if (!PyArg_ParseTuple(args, "|i:matchequiytable", &n))
-        return NULL;
+        for (k = 0; k < 8; ++k)
+            pbat->aanMove[i][k] = 0;
 
-    if (n < 0 || n > MAXSCORE) {
-        PyErr_SetString(PyExc_ValueError, _("invalid matchlength"));
-        return NULL;
+        if (PyFindnSaveBestMoves(&ml, anDice[0], anDice[1], (ConstTanBoard) pbat->aanBoard[i],
+                               NULL, 0.0f, pbat->pci, pbat->pec, pbat->aamf) < 0) {
+            pbat->fFailed = TRUE;
+            return;
+        }
+
+        if (ml.cMoves) {
+            for (k = 0; k < 8 && ml.amMoves[0].anMove[k] >= 0; ++k)
+                pbat->aanMove[i][k] = ml.amMoves[0].anMove[k] + 1;
+            g_free(ml.amMoves);
+        }
     }
+}
 
-    if (!(pyMET = PyList_New(3)))
-        return NULL;
+/* Spread the batch over the calculation threads. The GIL is released
+ * meanwhile; user input is suspended while waiting for the tasks, so
+ * no Python code runs on this thread until we are done. Other Python
+ * threads can't use the calculation threads and evaluate the batch
+ * themselves. */
 
-    /* pre-Crawford scores */
+static int
+RunBatch(AsyncFun fun, pybatch * pbat)
+{
+    int fMain = TRUE;
 
-    if (!(pyList = METPre(aafMET, n)))
-        return NULL;
+    pbat->iNext = 0;
+    pbat->fFailed = FALSE;
 
-    if (PyList_SetItem(pyMET, 0, pyList) < 0)
-        return NULL;
+#if defined(USE_MULTITHREAD)
+    MT_AttachThread();
+    fMain = MT_GetThreadID() == -1;
+#endif
 
-    /* post-Crawford scores */
+    Py_BEGIN_ALLOW_THREADS;
+    PyEvaluationBegin();
+    if (fMain) {
+        mt_add_tasks(MT_GetNumThreads(), fun, pbat, NULL);
+        MT_WaitForTasks(NULL, 0, FALSE);
+    } else
+        fun(pbat);
+    PyEvaluationEnd();
+    Py_END_ALLOW_THREADS;
 
-    for (i = 0; i < 2; ++i) {
+    if (pbat->fFailed || fInterrupt) {
+        if (fMain)
+            ResetInterrupt();
+        PyErr_SetString(PyExc_StandardError, _("interrupted/errno in batch evaluation"));
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Wrap the n x c result rows in an object supporting the buffer
+ * protocol: a memoryview of a bytearray, which numpy.asarray() turns
+ * into an array without copying. Python 2 gets a list of tuples. */
+
+static PyObject *
+BatchResultToPy(PyObject * pyBytes, Py_ssize_t n, int c, const char *szFormat)
+{
+#if PY_MAJOR_VERSION >= 3
+    PyObject *pyView, *p;
+
+    if (!(pyView = PyMemoryView_FromObject(pyBytes))) {
+        Py_DECREF(pyBytes);
+        return NULL;
+    }
+    Py_DECREF(pyBytes);
+
+    p = PyObject_CallMethod(pyView, "cast", "s(ni)", szFormat, n, c);
+    Py_DECREF(pyView);
+
+    return p;
+#else
+    const char *pch = PyByteArray_AS_STRING(pyBytes);
+    PyObject *pyList;
+    Py_ssize_t i;
+
+    if (!(pyList = PyList_New(n))) {
+        Py_DECREF(pyBytes);
+        return NULL;
+    }
+
+    for (i = 0; i < n; ++i) {
+        PyObject *p = PyTuple_New(c);
+        int k;
+
+        for (k = 0; k < c; ++k)
+            PyTuple_SET_ITEM(p, k, *szFormat == 'f' ?
+                             PyFloat_FromDouble(((const float *) pch)[i * c + k]) :
+                             PyInt_FromLong(((const int *) pch)[i * c + k]));
+        PyList_SET_ITEM(pyList, i, p);
+    }
+
+    Py_DECREF(pyBytes);
+    return pyList;
+#endif
+}
+
+SIMD_STACKALIGN static PyObject *
+PythonEvaluateBatch(PyObject * UNUSED(self), PyObject * args)
+{
+
+    PyObject *pyBoards = NULL;
+    PyObject *pyCubeInfo = NULL;
+    PyObject *pyEvalContext = NULL;
+    PyObject *pyBytes;
+
+    TanBoard *aanBoard;
+    cubeinfo ci;
+    evalcontext ec;
+    pybatch bat;
+
+    memcpy(&ec, &GetEvalChequer()->ec, sizeof(evalcontext));
+    GetMatchStateCubeInfo(&ci, &ms);
+
+    if (!PyArg_ParseTuple(args, "O|OO", &pyBoards, &pyCubeInfo, &pyEvalContext))
+        return NULL;
+
+    if (pyCubeInfo && PyToCubeInfo(pyCubeInfo, &ci))
+        return NULL;
+
+    if (pyEvalContext && PyToEvalContext(pyEvalContext, &ec))
+        return NULL;
+
+    if ((bat.n = PyToBoards(pyBoards, &aanBoard)) < 0)
+        return NULL;
+
+    if (!(pyBytes = PyByteArray_FromStringAndSize(NULL, bat.n * (NUM_OUTPUTS + 1) * sizeof(float)))) {
+        g_free(aanBoard);
+        return NULL;
+    }
+
+    bat.aanBoard = (const TanBoard *) aanBoard;
+    bat.aanDice = NULL;
+    bat.aarOutput = (float (*)[NUM_OUTPUTS + 1]) PyByteArray_AS_STRING(pyBytes);
+    bat.aanMove = NULL;
+    bat.pci = &ci;
+    bat.pec = &ec;
+    bat.aamf = NULL;
+
+    if (RunBatch(BatchEvaluate, &bat) < 0) {
+        g_free(aanBoard);
+        Py_DECREF(pyBytes);
+        return NULL;
+    }
+
+    g_free(aanBoard);
+    return BatchResultToPy(pyBytes, bat.n, NUM_OUTPUTS + 1, "f");
+}
+
+SIMD_STACKALIGN static PyObject *
+PythonFindBestMoveBatch(PyObject * UNUSED(self), PyObject * args)
+{
+
+    PyObject *pyBoards = NULL;
+    PyObject *pyDice = NULL;
+    PyObject *pyCubeInfo = NULL;
+    PyObject *pyEvalContext = NULL;
+    PyObject *pyMoveFilters = NULL;
+    PyObject *pyBytes;
+
+    TanBoard *aanBoard;
+    int (*aanDice)[2];
+    Py_ssize_t i;
+    cubeinfo ci;
+    evalcontext ec;
+    TmoveFilter aamf;
+    pybatch bat;
+
+    memcpy(&ec, &GetEvalChequer()->ec, sizeof(evalcontext));
+    memcpy(aamf, *GetEvalMoveFilter(), sizeof(TmoveFilter));
+    GetMatchStateCubeInfo(&ci, &ms);
+
+    if (!PyArg_ParseTuple(args, "OO|OOO", &pyBoards, &pyDice, &pyCubeInfo, &pyEvalContext, &pyMoveFilters))
+        return NULL;
+
+    if (pyCubeInfo && PyToCubeInfo(pyCubeInfo, &ci))
+        return NULL;
+
+    if (pyEvalContext && PyToEvalContext(pyEvalContext, &ec))
+        return NULL;
+
+    if (pyMoveFilters && PyToMoveFilters(pyMoveFilters, aamf))
+        return NULL;
+
+    if ((bat.n = PyToBoards(pyBoards, &aanBoard)) < 0)
+        return NULL;
+
+    /* either one roll for all boards or an N x 2 array */
+
+    if (PyObject_CheckBuffer(pyDice)) {
+        int *an;
+
+        if ((i = PyToIntArray(pyDice, 2, &an)) < 0) {
+            g_free(aanBoard);
+            return NULL;
+        }
+        if (i != bat.n) {
+            PyErr_SetString(PyExc_ValueError, _("need one roll per board"));
+            g_free(an);
+            g_free(aanBoard);
+            return NULL;
+        }
+        for (i = 0; i < bat.n; ++i)
+            if (an[2 * i] < 1 || an[2 * i] > 6 || an[2 * i + 1] < 1 || an[2 * i + 1] > 6) {
+                PyErr_Format(PyExc_ValueError, _("roll %ld is not legal"), (long) i);
+                g_free(an);
+                g_free(aanBoard);
+                return NULL;
+            }
+        aanDice = (int (*)[2]) an;
+    } else {
+        int anDice[2];
+
+        if (!PyToDice(pyDice, anDice) || anDice[0] < 1 || anDice[0] > 6 || anDice[1] < 1 || anDice[1] > 6) {
+            PyErr_SetString(PyExc_ValueError, _("the roll must be two dice from 1 to 6"));
+            g_free(aanBoard);
+            return NULL;
+        }
+        aanDice = (int (*)[2]) g_new(int, 2 * bat.n + 2);
+        for (i = 0; i < bat.n; ++i) {
+            aanDice[i][0] = anDice[0];
+            aanDice[i][1] = anDice[1];
+        }
+    }
+
+    if (!(pyBytes = PyByteArray_FromStringAndSize(NULL, bat.n * 8 * sizeof(int)))) {
+        g_free(aanDice);
+        g_free(aanBoard);
+        return NULL;
+    }
+
+    bat.aanBoard = (const TanBoard *) aanBoard;
+    bat.aanDice = (const int (*)[2]) aanDice;
+    bat.aarOutput = NULL;
+    bat.aanMove = (int (*)[8]) PyByteArray_AS_STRING(pyBytes);
+    bat.pci = &ci;
+    bat.pec = &ec;
+    bat.aamf = aamf;
+
+    if (RunBatch(BatchFindBestMove, &bat) < 0) {
+        g_free(aanDice);
+        g_free(aanBoard);
+        Py_DECREF(pyBytes);
+        return NULL;
+    }
+
+    g_free(aanDice);
+    g_free(aanBoard);
+    return BatchResultToPy(pyBytes, bat.n, 8, "i");
+}
+
+static PyObject *
+METRow(float ar[MAXSCORE], const int n)
+{
+
+    int i;
+    PyObject *pyList;
+
+    if (!(pyList = PyList_New(n)))
+        return NULL;
+
+    for (i = 0; i < n; ++i) {
+        PyObject *pyf;
+
+        if (!(pyf = PyFloat_FromDouble(ar[i])))
+            return NULL;
+
+        if (PyList_SetItem(pyList, i, pyf) < 0)
+            return NULL;
+
+    }
+
+    return pyList;
+
+}
+
+static PyObject *
+METPre(float aar[MAXSCORE][MAXSCORE], const int n)
+{
+    int i;
+    PyObject *pyList;
+
+    if (!(pyList = PyList_New(n)))
+        return NULL;
+
+    for (i = 0; i < n; ++i) {
+        PyObject *pyRow;
+
+        if (!(pyRow = METRow(aar[i], n)))
+            return NULL;
+
+        if (PyList_SetItem(pyList, i, pyRow) < 0)
+            return NULL;
+
+    }
+
+    return pyList;
+}
+
+
+static PyObject *
+PythonDiceRolls(PyObject * UNUSED(self), PyObject * args)
+{
+    PyObject *pyDiceRolls;
+    long n;
+    unsigned int anDice[2];
+    int rollsidx;
+
+    if (!PyArg_ParseTuple(args, "l:dicerolls", &n))
+        return NULL;
+
+    if (n <= 0) {
+        PyErr_SetString(PyExc_ValueError, _("number of rolls must be greater than 0"));
+        return NULL;
+    }
+
+    if (!(pyDiceRolls = PyTuple_New(n)))
+        return NULL;
+
+    rollsidx = 0;
+    while (n-- > 0) {
+        PyObject *pyDiceRoll;
+        PyObject *pyDie1;
+        PyObject *pyDie2;
+        int dieidx;
+
+        RollDice(anDice, &rngCurrent, rngctxCurrent);
+
+        pyDie1 = PyInt_FromLong(anDice[0]);
+        pyDie2 = PyInt_FromLong(anDice[1]);
+
+        if (!(pyDiceRoll = PyTuple_New(2)))
+            return NULL;
+
+        dieidx = 0;
+        if (PyTuple_SetItem(pyDiceRoll, dieidx, pyDie1) < 0)
+            return NULL;
+        if (PyTuple_SetItem(pyDiceRoll, dieidx + 1, pyDie2) < 0)
+            return NULL;
+
+        if (PyTuple_SetItem(pyDiceRolls, rollsidx++, pyDiceRoll) < 0)
+            return NULL;
+    }
+    return pyDiceRolls;
+}
+
+static PyObject *
+PythonMET(PyObject * UNUSED(self), PyObject * args)
+{
+
+    int n = ms.nMatchTo ? ms.nMatchTo : MAXSCORE;
+    int i;
+    PyObject *pyMET;
+    PyObject *pyList;
+
+    if (!PyArg_ParseTuple(args, "|i:matchequiytable", &n))
+        return NULL;
+
+    if (n < 0 || n > MAXSCORE) {
+        PyErr_SetString(PyExc_ValueError, _("invalid matchlength"));
+        return NULL;
+    }
+
+    if (!(pyMET = PyList_New(3)))
+        return NULL;
+
+    /* pre-Crawford scores */
+
+    if (!(pyList = METPre(aafMET, n)))
+        return NULL;
+
+    if (PyList_SetItem(pyMET, 0, pyList) < 0)
+        return NULL;
+
+    /* post-Crawford scores */
+
+    for (i = 0; i < 2; ++i) {
 
         if (!(pyList = METRow(aafMETPostCrawford[i], n)))
             return NULL;
@@ -2562,26 +3273,12 @@ PyGameStats(const statcontext * sc, const int fIsMatch, const int nMatchTo)
     }
 }
 
-/* plGame: Game as a list of records.
- * doAnalysis: if true, add analysis info.
- * verbose: if true, add derived analysis data.
- * scMatch: if non-0, add game & match statistics.
- */
-
 static PyObject *
-PythonGame(const listOLD * plGame,
-           int const doAnalysis, int const verbose, statcontext * scMatch, int const includeBoards, PyMatchState * ms)
+PyGameInfo(const xmovegameinfo * g)
 {
-    const listOLD *pl = plGame->plNext;
-    const moverecord *pmr = pl->p;
-    const xmovegameinfo *g = &pmr->g;
-
-    PyObject *gameDict = PyDict_New();
     PyObject *gameInfoDict = PyDict_New();
 
-    g_assert(pmr->mt == MOVE_GAMEINFO);
-
-    if (!(gameDict && gameInfoDict)) {
+    if (!gameInfoDict) {
         PyErr_SetString(PyExc_MemoryError, "");
         return NULL;
     }
@@ -2611,9 +3308,290 @@ PythonGame(const listOLD * plGame,
         DictSetItemSteal(gameInfoDict, "initial-cube", PyInt_FromLong(1 << g->nAutoDoubles));
     }
 
-    DictSetItemSteal(gameDict, "info", gameInfoDict);
+    return gameInfoDict;
+}
 
-    if (scMatch) {
+/* The record without its analysis. szBoard is the position before
+ * the record, or 0 if boards aren't wanted. */
+
+static PyObject *
+PyMoveRecord(const moverecord * pmr, const char *szBoard)
+{
+    const char *action = 0;
+    int player = -1;
+    long points = -1;
+    PyObject *recordDict = PyDict_New();
+
+    if (!recordDict) {
+        PyErr_SetString(PyExc_MemoryError, "");
+        return NULL;
+    }
+
+    switch (pmr->mt) {
+    case MOVE_NORMAL:
+        {
+            action = "move";
+            player = pmr->fPlayer;
+
+            {
+                PyObject *dice = Py_BuildValue("(ii)",
+                                               pmr->anDice[0], pmr->anDice[1]);
+
+
+                DictSetItemSteal(recordDict, "dice", dice);
+            }
+
+            DictSetItemSteal(recordDict, "move", PyMove(pmr->n.anMove));
+
+            if (szBoard) {
+                DictSetItemSteal(recordDict, "board", PyUnicode_FromString(szBoard));
+            }
+
+            break;
+        }
+    case MOVE_DOUBLE:
+        {
+            action = "double";
+            player = pmr->fPlayer;
+
+            if (szBoard) {
+                DictSetItemSteal(recordDict, "board", PyUnicode_FromString(szBoard));
+            }
+
+            break;
+        }
+    case MOVE_TAKE:
+        {
+            action = "take";
+            player = pmr->fPlayer;
+
+            break;
+        }
+    case MOVE_DROP:
+        {
+            action = "drop";
+            player = pmr->fPlayer;
+
+            break;
+        }
+    case MOVE_RESIGN:
+        {
+            action = "resign";
+            player = pmr->fPlayer;
+            points = pmr->r.nResigned;
+            if (points < 1)
+                points = 1;
+            else if (points > 3)
+                points = 3;
+            break;
+        }
+
+    case MOVE_SETBOARD:
+        {
+            PyObject *id = PyUnicode_FromString(PositionIDFromKey(&pmr->sb.key));
+
+            action = "set";
+
+            DictSetItemSteal(recordDict, "board", id);
+
+            break;
+        }
+
+    case MOVE_SETDICE:
+        {
+            PyObject *dice;
+
+            player = pmr->fPlayer;
+            action = "set";
+
+            dice = Py_BuildValue("(ii)", pmr->anDice[0], pmr->anDice[1]);
+
+            DictSetItemSteal(recordDict, "dice", dice);
+
+            break;
+        }
+
+    case MOVE_SETCUBEVAL:
+        {
+            action = "set";
+            DictSetItemSteal(recordDict, "cube", PyInt_FromLong(pmr->scv.nCube));
+            break;
+        }
+
+    case MOVE_SETCUBEPOS:
+        {
+            const char *s[] = { "centered", "X", "O" };
+            const char *o = s[pmr->scp.fCubeOwner + 1];
+
+            action = "set";
+            DictSetItemSteal(recordDict, "cube-owner", PyUnicode_FromString(o));
+            break;
+        }
+
+    default:
+        {
+            g_assert_not_reached();
+        }
+    }
+
+    if (action) {
+        DictSetItemSteal(recordDict, "action", PyUnicode_FromString(action));
+    }
+
+    if (player != -1) {
+        DictSetItemSteal(recordDict, "player", PyUnicode_FromString(player ? "O" : "X"));
+    }
+
+    if (points != -1) {
+        DictSetItemSteal(recordDict, "points", PyInt_FromLong(points));
+    }
+
+    if (pmr->sz) {
+        DictSetItemSteal(recordDict, "comment", PyUnicode_FromString(pmr->sz));
+    }
+
+    return recordDict;
+}
+
+/* The analysis of a record, or 0 if it has none */
+
+static PyObject *
+PyMoveRecordAnalysis(const moverecord * pmr, int const verbose, PyMatchState * ms)
+{
+    PyObject *analysis = PyDict_New();
+
+    if (!analysis) {
+        PyErr_SetString(PyExc_MemoryError, "");
+        return NULL;
+    }
+
+    switch (pmr->mt) {
+    case MOVE_NORMAL:
+        {
+            if (pmr->CubeDecPtr->esDouble.et != EVAL_NONE) {
+                PyObject *d = PyDoubleAnalysis(&pmr->CubeDecPtr->esDouble,
+                                               pmr->CubeDecPtr->aarOutput,
+                                               pmr->CubeDecPtr->aarStdDev,
+                                               ms, verbose);
+                {
+                    int s = PyDict_Merge(analysis, d, 1);
+                    g_assert(s != -1);
+                    (void) s;
+                }
+                Py_DECREF(d);
+            }
+
+
+            if (pmr->ml.cMoves) {
+                PyObject *a = PyMoveAnalysis(&pmr->ml, ms);
+
+                if (a) {
+                    DictSetItemSteal(analysis, "moves", a);
+
+                    DictSetItemSteal(analysis, "imove", PyInt_FromLong(pmr->n.iMove));
+                }
+            }
+
+            addLuck(analysis, pmr->rLuck, pmr->lt);
+            addSkill(analysis, pmr->n.stMove, 0);
+            addSkill(analysis, pmr->stCube, "cube-skill");
+
+            break;
+        }
+    case MOVE_DOUBLE:
+        {
+            cubedecisiondata *c = pmr->CubeDecPtr;
+            if (c->esDouble.et != EVAL_NONE) {
+                PyObject *d = PyDoubleAnalysis(&c->esDouble, c->aarOutput,
+                                               c->aarStdDev, ms, verbose);
+                {
+                    int s = PyDict_Merge(analysis, d, 1);
+                    g_assert(s != -1);
+                    (void) s;
+                }
+                Py_DECREF(d);
+            }
+
+            addSkill(analysis, pmr->stCube, 0);
+
+            break;
+        }
+    case MOVE_TAKE:
+    case MOVE_DROP:
+        {
+            /* use nAnimals to point to double analysis ? */
+
+            addSkill(analysis, pmr->stCube, 0);
+
+            break;
+        }
+    case MOVE_SETDICE:
+        {
+            addLuck(analysis, pmr->rLuck, pmr->lt);
+
+            break;
+        }
+    default:
+        break;
+    }
+
+    if (PyDict_Size(analysis) == 0) {
+        Py_DECREF(analysis);
+        return NULL;
+    }
+
+    return analysis;
+}
+
+/* Update anBoard to the position after the record */
+
+static void
+PyMoveRecordBoard(const moverecord * pmr, TanBoard anBoard)
+{
+    switch (pmr->mt) {
+    case MOVE_NORMAL:
+        ApplyMove(anBoard, pmr->n.anMove, 0);
+        SwapSides(anBoard);
+        break;
+
+    case MOVE_SETBOARD:
+        /* (FIXME) what about side? */
+        /* JTH: the board is always stored as if player 0 was on roll */
+        PositionFromKey(anBoard, &pmr->sb.key);
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* plGame: Game as a list of records.
+ * doAnalysis: if true, add analysis info.
+ * verbose: if true, add derived analysis data.
+ * scMatch: if non-0, add game & match statistics.
+ */
+
+static PyObject *
+PythonGame(const listOLD * plGame,
+           int const doAnalysis, int const verbose, statcontext * scMatch, int const includeBoards, PyMatchState * ms)
+{
+    const listOLD *pl = plGame->plNext;
+    const moverecord *pmr = pl->p;
+    const xmovegameinfo *g = &pmr->g;
+
+    PyObject *gameDict = PyDict_New();
+    PyObject *gameInfoDict = PyGameInfo(g);
+
+    g_assert(pmr->mt == MOVE_GAMEINFO);
+
+    if (!(gameDict && gameInfoDict)) {
+        PyErr_SetString(PyExc_MemoryError, "");
+        return NULL;
+    }
+
+    DictSetItemSteal(gameDict, "info", gameInfoDict);
+
+    if (scMatch) {
         updateStatisticsGame(plGame);
 
         AddStatcontext(&g->sc, scMatch);
@@ -2648,403 +3626,895 @@ PythonGame(const listOLD * plGame,
         }
 
         for (pl = pl->plNext; pl != plGame; pl = pl->plNext) {
-            const char *action = 0;
-            int player = -1;
-            long points = -1;
-            PyObject *recordDict = PyDict_New();
-            PyObject *analysis = doAnalysis ? PyDict_New() : 0;
+            PyObject *recordDict;
 
             pmr = pl->p;
 
-            switch (pmr->mt) {
-            case MOVE_NORMAL:
-                {
-                    action = "move";
-                    player = pmr->fPlayer;
+            recordDict = PyMoveRecord(pmr, includeBoards ? PositionID((ConstTanBoard) anBoard) : 0);
 
-                    {
-                        PyObject *dice = Py_BuildValue("(ii)",
-                                                       pmr->anDice[0], pmr->anDice[1]);
+            if (!recordDict) {
+                Py_DECREF(gameTuple);
+                Py_DECREF(gameDict);
+                return NULL;
+            }
 
+            if (includeBoards) {
+                PyMoveRecordBoard(pmr, anBoard);
+            }
 
-                        DictSetItemSteal(recordDict, "dice", dice);
-                    }
+            if (doAnalysis) {
+                PyObject *analysis = PyMoveRecordAnalysis(pmr, verbose, ms);
+
+                if (analysis) {
+                    DictSetItemSteal(recordDict, "analysis", analysis);
+                }
+            }
 
-                    DictSetItemSteal(recordDict, "move", PyMove(pmr->n.anMove));
+            PyTuple_SET_ITEM(gameTuple, nRecords, recordDict);
+            ++nRecords;
+        }
 
-                    if (includeBoards) {
-                        DictSetItemSteal(recordDict, "board",
-                                         PyUnicode_FromString(PositionID((ConstTanBoard) anBoard)));
+        DictSetItemSteal(gameDict, "game", gameTuple);
+    }
 
-                        ApplyMove(anBoard, pmr->n.anMove, 0);
-                        SwapSides(anBoard);
-                    }
+    return gameDict;
+}
 
-                    if (analysis) {
-                        if (pmr->CubeDecPtr->esDouble.et != EVAL_NONE) {
-                            PyObject *d = PyDoubleAnalysis(&pmr->CubeDecPtr->esDouble,
-                                                           pmr->CubeDecPtr->aarOutput,
-                                                           pmr->CubeDecPtr->aarStdDev,
-                                                           ms, verbose);
-                            {
-                                int s = PyDict_Merge(analysis, d, 1);
-                                g_assert(s != -1);
-                                (void) s;
-                            }
-                            Py_DECREF(d);
-                        }
+static void
+addProperty(PyObject * dict, const char *name, const char *val)
+{
+    if (!val) {
+        return;
+    }
+
+    DictSetItemSteal(dict, name, PyUnicode_FromString(val));
+}
 
+/* The match information, taken from the first game */
 
-                        if (pmr->ml.cMoves) {
-                            PyObject *a = PyMoveAnalysis(&pmr->ml, ms);
+static PyObject *
+PyMatchInfo(const xmovegameinfo * g)
+{
+    PyObject *matchInfoDict = PyDict_New();
 
-                            if (a) {
-                                DictSetItemSteal(analysis, "moves", a);
+    if (!matchInfoDict) {
+        PyErr_SetString(PyExc_MemoryError, "");
+        return NULL;
+    }
 
-                                DictSetItemSteal(analysis, "imove", PyInt_FromLong(pmr->n.iMove));
-                            }
-                        }
+    /* W,X,0
+     * B,O,1 */
+    {
+        int side;
+        for (side = 0; side < 2; ++side) {
+            PyObject *d = PyDict_New();
+            addProperty(d, "rating", mi.pchRating[side]);
+            addProperty(d, "name", ap[side].szName);
 
-                        addLuck(analysis, pmr->rLuck, pmr->lt);
-                        addSkill(analysis, pmr->n.stMove, 0);
-                        addSkill(analysis, pmr->stCube, "cube-skill");
-                    }
+            DictSetItemSteal(matchInfoDict, side == 0 ? "X" : "O", d);
+        }
+    }
 
-                    break;
-                }
-            case MOVE_DOUBLE:
-                {
-                    action = "double";
-                    player = pmr->fPlayer;
+    DictSetItemSteal(matchInfoDict, "match-length", PyInt_FromLong(g->nMatch));
 
-                    if (includeBoards) {
-                        DictSetItemSteal(recordDict, "board",
-                                         PyUnicode_FromString(PositionID((ConstTanBoard) anBoard)));
-                    }
+    if (mi.nYear) {
+        PyObject *date = Py_BuildValue("(iii)", mi.nDay, mi.nMonth, mi.nYear);
 
-                    if (analysis) {
-                        cubedecisiondata *c = pmr->CubeDecPtr;
-                        if (c->esDouble.et != EVAL_NONE) {
-                            PyObject *d = PyDoubleAnalysis(&c->esDouble, c->aarOutput,
-                                                           c->aarStdDev, ms, verbose);
-                            {
-                                int s = PyDict_Merge(analysis, d, 1);
-                                g_assert(s != -1);
-                                (void) s;
-                            }
-                            Py_DECREF(d);
-                        }
+        DictSetItemSteal(matchInfoDict, "date", date);
+    }
 
-                        addSkill(analysis, pmr->stCube, 0);
-                    }
+    addProperty(matchInfoDict, "event", mi.pchEvent);
+    addProperty(matchInfoDict, "round", mi.pchRound);
+    addProperty(matchInfoDict, "place", mi.pchPlace);
+    addProperty(matchInfoDict, "annotator", mi.pchAnnotator);
+    addProperty(matchInfoDict, "comment", mi.pchComment);
 
-                    break;
-                }
-            case MOVE_TAKE:
-                {
-                    action = "take";
-                    player = pmr->fPlayer;
+    {                           /* Work out the result (-1,0,1) - (p0 win, unfinished, p1 win) */
+        int result = 0;
+        int anFinalScore[2];
+        if (getFinalScore(anFinalScore)) {
+            if (anFinalScore[0] > g->nMatch)
+                result = -1;
+            else if (anFinalScore[1] > g->nMatch)
+                result = 1;
+        }
+        DictSetItemSteal(matchInfoDict, "result", PyInt_FromLong(result));
+    }
+
+    {
+        const char *v[] = { "Standard", "Nackgammon", "Hypergammon1", "Hypergammon2",
+            "Hypergammon3"
+        };
 
-                    /* use nAnimals to point to double analysis ? */
+        addProperty(matchInfoDict, "variation", v[g->bgv]);
+    }
+
+    {
+        unsigned int n = !g->fCubeUse + !!g->fCrawford + !!g->fJacoby;
+        if (n) {
+            PyObject *rules = PyTuple_New(n);
 
-                    addSkill(analysis, pmr->stCube, 0);
+            n = 0;
+            if (!g->fCubeUse) {
+                PyTuple_SET_ITEM(rules, n++, PyUnicode_FromString("NoCube"));
+            }
+            if (g->fCrawford) {
+                PyTuple_SET_ITEM(rules, n++, PyUnicode_FromString("Crawford"));
+            }
+            if (g->fJacoby) {
+                PyTuple_SET_ITEM(rules, n, PyUnicode_FromString("Jacoby"));
+            }
+
+            DictSetItemSteal(matchInfoDict, "rules", rules);
+        }
+    }
+
+    return matchInfoDict;
+}
+
+static PyObject *
+PythonMatch(PyObject * UNUSED(self), PyObject * args, PyObject * keywds)
+{
+    /* take match info from first game */
+    const listOLD *firstGame = lMatch.plNext->p;
+    const moverecord *pmr;
+    const xmovegameinfo *g;
+    int includeAnalysis = 1;
+    int verboseAnalysis = 0;
+    int statistics = 0;
+    int boards = 1;
+    PyObject *matchDict;
+    PyObject *matchInfoDict;
+    PyMatchState s;
+
+    static char *kwlist[] = { "analysis", "boards", "statistics", "verbose", 0 };
+
+    if (!firstGame) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+
+    pmr = firstGame->plNext->p;
+    g_assert(pmr->mt == MOVE_GAMEINFO);
+    g = &pmr->g;
+
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "|iiii", kwlist,
+                                     &includeAnalysis, &boards, &statistics, &verboseAnalysis))
+        return NULL;
+
+
+    if (g->i != 0) {
+        PyErr_SetString(PyExc_StandardError, _("First game missing from match"));
+        return NULL;
+    }
+
+    matchDict = PyDict_New();
+    matchInfoDict = PyMatchInfo(g);
+
+    if (!matchDict || !matchInfoDict) {
+        PyErr_SetString(PyExc_MemoryError, "");
+        return NULL;
+    }
+
+    DictSetItemSteal(matchDict, "match-info", matchInfoDict);
+
+    s.ec = 0;
+    s.rc = 0;
+
+    {
+        int nGames = 0;
+        const listOLD *pl;
+        PyObject *matchTuple;
+        statcontext scm;
+
+        for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext) {
+            ++nGames;
+        }
+
+        if (statistics) {
+            IniStatcontext(&scm);
+        }
+
+        matchTuple = PyTuple_New(nGames);
+
+        nGames = 0;
+        for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext) {
+            PyObject *pg = PythonGame(pl->p, includeAnalysis, verboseAnalysis,
+                                      statistics ? &scm : 0, boards, &s);
+
+            if (!pg) {
+                /* Memory leaked. out of memory anyway */
+                return NULL;
+            }
+
+            PyTuple_SET_ITEM(matchTuple, nGames, pg);
+            ++nGames;
+        }
+
+        DictSetItemSteal(matchDict, "games", matchTuple);
+
+        if (statistics) {
+            PyObject *pgs = PyGameStats(&scm, TRUE, g->nMatch);
+
+            if (pgs) {
+                DictSetItemSteal(matchDict, "stats", pgs);
+            }
+        }
+    }
+
+    if (s.ec) {
+        PyObject *e = EvalContextToPy(s.ec);
+        DictSetItemSteal(matchInfoDict, "default-eval-context", e);
+    }
+
+    if (s.rc) {
+        PyObject *e = RolloutContextToPy(s.rc);
+        DictSetItemSteal(matchInfoDict, "default-rollout-context", e);
+
+        /* No need for that, I think */
+        /*     DictSetItemSteal(matchInfoDict, "sgf-rollout-version", */
+        /*                   PyInt_FromLong(SGF_ROLLOUT_VER)); */
+    }
+
+    return matchDict;
+}
+
+
+/* Lazy views of the match.
+ *
+ * gnubg.matchview() gives the same information as gnubg.match(), but
+ * reads it from the move records only when it is asked for. A match
+ * view is a sequence of game views, a game view a sequence of record
+ * views, and a record view a read only mapping with the keys of the
+ * record dictionaries of gnubg.match(). A view raises RuntimeError
+ * once move records have been freed, e.g. by loading another match. */
+
+typedef struct {
+    PyObject_HEAD
+    unsigned int nGeneration;
+    int fAnalysis;
+    int fBoards;
+    int fVerbose;
+    int fScanned;
+    PyMatchState s;
+} PyMatchView;
+
+typedef struct {
+    PyObject_HEAD
+    PyMatchView *pmv;
+    const listOLD *plGame;
+    Py_ssize_t iCursor;         /* last record looked up */
+    const listOLD *plCursor;
+    positionkey *akey;          /* positions before each record */
+    Py_ssize_t cKeys;
+} PyGameView;
+
+typedef struct {
+    PyObject_HEAD
+    PyGameView *pgv;
+    const moverecord *pmr;
+    Py_ssize_t iRecord;
+    PyObject *pyRecord;         /* the record without its analysis */
+    PyObject *pyAnalysis;
+} PyRecordView;
+
+static PyTypeObject PyMatchViewType;
+static PyTypeObject PyGameViewType;
+static PyTypeObject PyRecordViewType;
+
+static int
+MatchViewStale(const PyMatchView * pmv)
+{
+    if (pmv->nGeneration == nMatchGeneration)
+        return FALSE;
+
+    PyErr_SetString(PyExc_RuntimeError, _("the match has changed since the view was made"));
+    return TRUE;
+}
+
+static int
+PyKeyIs(PyObject * pyKey, const char *sz)
+{
+#if PY_MAJOR_VERSION >= 3
+    return PyUnicode_Check(pyKey) && !PyUnicode_CompareWithASCIIString(pyKey, sz);
+#else
+    return PyString_Check(pyKey) && !strcmp(PyString_AsString(pyKey), sz);
+#endif
+}
+
+/* A key of the same type as those of the record dictionaries */
+static PyObject *
+PyKeyFromString(const char *sz)
+{
+#if PY_MAJOR_VERSION >= 3
+    return PyUnicode_FromString(sz);
+#else
+    return PyString_FromString(sz);
+#endif
+}
+
+static void
+ScanEvalSetup(const evalsetup * pes, PyMatchState * ps)
+{
+    if (pes->et == EVAL_EVAL && !ps->ec)
+        ps->ec = &pes->ec;
+    else if (pes->et == EVAL_ROLLOUT && !ps->rc)
+        ps->rc = &pes->rc;
+}
+
+/* Find the default contexts gnubg.match() would report, i.e. the
+ * first ones met when walking the whole match, so that the analysis
+ * of a record doesn't depend on the order records are looked at */
+
+static void
+ScanMatchState(PyMatchState * ps)
+{
+    const listOLD *plg, *pl;
+
+    ps->ec = 0;
+    ps->rc = 0;
+
+    for (plg = lMatch.plNext; plg != &lMatch; plg = plg->plNext) {
+        const listOLD *plGameScan = plg->p;
+
+        for (pl = plGameScan->plNext; pl != plGameScan; pl = pl->plNext) {
+            const moverecord *pmr = pl->p;
+            unsigned int i;
+
+            switch (pmr->mt) {
+            case MOVE_NORMAL:
+                if (pmr->CubeDecPtr->esDouble.et != EVAL_NONE)
+                    ScanEvalSetup(&pmr->CubeDecPtr->esDouble, ps);
+                for (i = 0; i < pmr->ml.cMoves; i++)
+                    ScanEvalSetup(&pmr->ml.amMoves[i].esMove, ps);
+                break;
+            case MOVE_DOUBLE:
+                if (pmr->CubeDecPtr->esDouble.et != EVAL_NONE)
+                    ScanEvalSetup(&pmr->CubeDecPtr->esDouble, ps);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+static const listOLD *
+MatchViewGame(Py_ssize_t i)
+{
+    const listOLD *pl;
+
+    for (pl = lMatch.plNext; pl != &lMatch && i > 0; pl = pl->plNext)
+        --i;
+
+    return pl != &lMatch ? pl->p : NULL;
+}
+
+static void
+MatchViewDealloc(PyObject * p)
+{
+    PyObject_Del(p);
+}
+
+static Py_ssize_t
+MatchViewLength(PyObject * p)
+{
+    const listOLD *pl;
+    Py_ssize_t n = 0;
+
+    if (MatchViewStale((PyMatchView *) p))
+        return -1;
+
+    for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext)
+        ++n;
+
+    return n;
+}
+
+static PyObject *
+MatchViewItem(PyObject * p, Py_ssize_t i)
+{
+    PyGameView *pgv;
+    const listOLD *plGameView;
+
+    if (MatchViewStale((PyMatchView *) p))
+        return NULL;
+
+    if (i < 0 || !(plGameView = MatchViewGame(i))) {
+        PyErr_SetString(PyExc_IndexError, _("game index out of range"));
+        return NULL;
+    }
+
+    if (!(pgv = PyObject_New(PyGameView, &PyGameViewType)))
+        return NULL;
+
+    Py_INCREF(p);
+    pgv->pmv = (PyMatchView *) p;
+    pgv->plGame = plGameView;
+    pgv->iCursor = 0;
+    pgv->plCursor = plGameView->plNext->plNext;
+    pgv->akey = NULL;
+    pgv->cKeys = 0;
+
+    return (PyObject *) pgv;
+}
+
+/* The game info record of the first game, NULL if there is none */
+static const moverecord *
+MatchViewGameInfo(void)
+{
+    const listOLD *plGame = MatchViewGame(0);
+
+    return plGame ? plGame->plNext->p : NULL;
+}
+
+static PyObject *
+MatchViewInfo(PyObject * p, void *UNUSED(closure))
+{
+    PyMatchView *pmv = (PyMatchView *) p;
+    const moverecord *pmr;
+    PyObject *matchInfoDict;
+
+    if (MatchViewStale(pmv))
+        return NULL;
+
+    if (!(pmr = MatchViewGameInfo()))
+        Py_RETURN_NONE;
+
+    if (!(matchInfoDict = PyMatchInfo(&pmr->g)))
+        return NULL;
+
+    if (pmv->fAnalysis) {
+        if (!pmv->fScanned) {
+            ScanMatchState(&pmv->s);
+            pmv->fScanned = TRUE;
+        }
+        if (pmv->s.ec)
+            DictSetItemSteal(matchInfoDict, "default-eval-context", EvalContextToPy(pmv->s.ec));
+        if (pmv->s.rc)
+            DictSetItemSteal(matchInfoDict, "default-rollout-context", RolloutContextToPy(pmv->s.rc));
+    }
+
+    return matchInfoDict;
+}
+
+static PyObject *
+MatchViewStats(PyObject * p, void *UNUSED(closure))
+{
+    const listOLD *pl;
+    const moverecord *pmr;
+    statcontext scm;
+
+    if (MatchViewStale((PyMatchView *) p))
+        return NULL;
+
+    if (!(pmr = MatchViewGameInfo()))
+        Py_RETURN_NONE;
+
+    IniStatcontext(&scm);
+
+    for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext) {
+        const listOLD *plGameStats = pl->p;
+        const moverecord *pmrGame = plGameStats->plNext->p;
+
+        if (!pmrGame)
+            continue;
+        updateStatisticsGame(plGameStats);
+        AddStatcontext(&pmrGame->g.sc, &scm);
+    }
+
+    return PyGameStats(&scm, TRUE, pmr->g.nMatch);
+}
+
+static PyGetSetDef MatchViewGetSet[] = {
+    {"info", MatchViewInfo, NULL, "match information, see 'match'", NULL},
+    {"stats", MatchViewStats, NULL, "match statistics, see 'match'", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PySequenceMethods MatchViewSequence = {
+    .sq_length = MatchViewLength,
+    .sq_item = MatchViewItem,
+};
+
+static void
+GameViewDealloc(PyObject * p)
+{
+    PyGameView *pgv = (PyGameView *) p;
+
+    Py_DECREF(pgv->pmv);
+    g_free(pgv->akey);
+    PyObject_Del(p);
+}
+
+static Py_ssize_t
+GameViewLength(PyObject * p)
+{
+    PyGameView *pgv = (PyGameView *) p;
+    const listOLD *pl;
+    Py_ssize_t n = 0;
+
+    if (MatchViewStale(pgv->pmv))
+        return -1;
+
+    for (pl = pgv->plGame->plNext->plNext; pl != pgv->plGame; pl = pl->plNext)
+        ++n;
+
+    return n;
+}
+
+/* Records are usually looked at in order, so start from the last one */
+
+static const listOLD *
+GameViewRecord(PyGameView * pgv, Py_ssize_t i)
+{
+    const listOLD *pl = pgv->plCursor;
+    Py_ssize_t j = pgv->iCursor;
+
+    if (i < j) {
+        pl = pgv->plGame->plNext->plNext;
+        j = 0;
+    }
+
+    for (; pl != pgv->plGame && j < i; pl = pl->plNext)
+        ++j;
+
+    if (pl == pgv->plGame)
+        return NULL;
+
+    pgv->iCursor = j;
+    pgv->plCursor = pl;
+
+    return pl;
+}
+
+static const char *
+GameViewBoard(PyGameView * pgv, Py_ssize_t i)
+{
+    if (i >= pgv->cKeys) {
+        const listOLD *pl;
+        const moverecord *pmr = pgv->plGame->plNext->p;
+        TanBoard anBoard;
+        Py_ssize_t n = GameViewLength((PyObject *) pgv);
+
+        g_free(pgv->akey);
+        pgv->akey = g_new(positionkey, n);
+        pgv->cKeys = n;
+
+        InitBoard(anBoard, pmr->g.bgv);
+        for (n = 0, pl = pgv->plGame->plNext->plNext; pl != pgv->plGame; pl = pl->plNext, ++n) {
+            PositionKey((ConstTanBoard) anBoard, &pgv->akey[n]);
+            PyMoveRecordBoard(pl->p, anBoard);
+        }
+    }
+
+    return PositionIDFromKey(&pgv->akey[i]);
+}
+
+static PyObject *
+GameViewItem(PyObject * p, Py_ssize_t i)
+{
+    PyGameView *pgv = (PyGameView *) p;
+    PyRecordView *prv;
+    const listOLD *pl;
+
+    if (MatchViewStale(pgv->pmv))
+        return NULL;
+
+    if (i < 0 || !(pl = GameViewRecord(pgv, i))) {
+        PyErr_SetString(PyExc_IndexError, _("record index out of range"));
+        return NULL;
+    }
 
-                    break;
-                }
-            case MOVE_DROP:
-                {
-                    action = "drop";
-                    player = pmr->fPlayer;
+    if (!(prv = PyObject_New(PyRecordView, &PyRecordViewType)))
+        return NULL;
 
-                    addSkill(analysis, pmr->stCube, 0);
+    Py_INCREF(p);
+    prv->pgv = pgv;
+    prv->pmr = pl->p;
+    prv->iRecord = i;
+    prv->pyRecord = NULL;
+    prv->pyAnalysis = NULL;
 
-                    break;
-                }
-            case MOVE_RESIGN:
-                {
-                    action = "resign";
-                    player = pmr->fPlayer;
-                    points = pmr->r.nResigned;
-                    if (points < 1)
-                        points = 1;
-                    else if (points > 3)
-                        points = 3;
-                    break;
-                }
+    return (PyObject *) prv;
+}
 
-            case MOVE_SETBOARD:
-                {
-                    PyObject *id = PyUnicode_FromString(PositionIDFromKey(&pmr->sb.key));
+static PyObject *
+GameViewInfo(PyObject * p, void *UNUSED(closure))
+{
+    PyGameView *pgv = (PyGameView *) p;
+    const moverecord *pmr;
 
-                    action = "set";
+    if (MatchViewStale(pgv->pmv))
+        return NULL;
 
-                    DictSetItemSteal(recordDict, "board", id);
+    if (!(pmr = pgv->plGame->plNext->p))
+        Py_RETURN_NONE;
 
-                    if (includeBoards) {
-                        /* (FIXME) what about side? */
-                        /* JTH: the board is always stored as if player 0 was on roll */
-                        PositionFromKey(anBoard, &pmr->sb.key);
-                    }
+    return PyGameInfo(&pmr->g);
+}
 
-                    break;
-                }
+static PyObject *
+GameViewStats(PyObject * p, void *UNUSED(closure))
+{
+    PyGameView *pgv = (PyGameView *) p;
+    const moverecord *pmr;
 
-            case MOVE_SETDICE:
-                {
-                    PyObject *dice;
+    if (MatchViewStale(pgv->pmv))
+        return NULL;
 
-                    player = pmr->fPlayer;
-                    action = "set";
+    if (!(pmr = pgv->plGame->plNext->p))
+        Py_RETURN_NONE;
+    updateStatisticsGame(pgv->plGame);
 
-                    dice = Py_BuildValue("(ii)", pmr->anDice[0], pmr->anDice[1]);
+    return PyGameStats(&pmr->g.sc, FALSE, pmr->g.nMatch);
+}
 
-                    DictSetItemSteal(recordDict, "dice", dice);
+static PyGetSetDef GameViewGetSet[] = {
+    {"info", GameViewInfo, NULL, "game information, see 'match'", NULL},
+    {"stats", GameViewStats, NULL, "game statistics, see 'match'", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
 
-                    addLuck(analysis, pmr->rLuck, pmr->lt);
+static PySequenceMethods GameViewSequence = {
+    .sq_length = GameViewLength,
+    .sq_item = GameViewItem,
+};
 
-                    break;
-                }
+static void
+RecordViewDealloc(PyObject * p)
+{
+    PyRecordView *prv = (PyRecordView *) p;
 
-            case MOVE_SETCUBEVAL:
-                {
-                    action = "set";
-                    DictSetItemSteal(recordDict, "cube", PyInt_FromLong(pmr->scv.nCube));
-                    break;
-                }
+    Py_XDECREF(prv->pyRecord);
+    Py_XDECREF(prv->pyAnalysis);
+    Py_DECREF(prv->pgv);
+    PyObject_Del(p);
+}
 
-            case MOVE_SETCUBEPOS:
-                {
-                    const char *s[] = { "centered", "X", "O" };
-                    const char *o = s[pmr->scp.fCubeOwner + 1];
+static PyObject *
+RecordViewRecord(PyRecordView * prv)
+{
+    PyGameView *pgv = prv->pgv;
 
-                    action = "set";
-                    DictSetItemSteal(recordDict, "cube-owner", PyUnicode_FromString(o));
-                    break;
-                }
+    if (MatchViewStale(pgv->pmv))
+        return NULL;
 
-            default:
-                {
-                    g_assert_not_reached();
-                }
-            }
+    if (!prv->pyRecord)
+        prv->pyRecord = PyMoveRecord(prv->pmr, pgv->pmv->fBoards ? GameViewBoard(pgv, prv->iRecord) : 0);
 
-            if (action) {
-                DictSetItemSteal(recordDict, "action", PyUnicode_FromString(action));
-            }
+    return prv->pyRecord;
+}
 
-            if (player != -1) {
-                DictSetItemSteal(recordDict, "player", PyUnicode_FromString(player ? "O" : "X"));
-            }
+/* The analysis of the record, or Py_None if it has none */
 
-            if (points != -1) {
-                DictSetItemSteal(recordDict, "points", PyInt_FromLong(points));
-            }
+static PyObject *
+RecordViewAnalysis(PyRecordView * prv)
+{
+    PyMatchView *pmv = prv->pgv->pmv;
 
-            if (analysis) {
-                if (PyDict_Size(analysis) > 0) {
-                    DictSetItemSteal(recordDict, "analysis", analysis);
-                } else {
-                    Py_DECREF(analysis);
-                    analysis = 0;
-                }
-            }
+    if (MatchViewStale(pmv))
+        return NULL;
 
-            if (pmr->sz) {
-                DictSetItemSteal(recordDict, "comment", PyUnicode_FromString(pmr->sz));
-            }
+    if (!pmv->fAnalysis)
+        return Py_None;
 
-            PyTuple_SET_ITEM(gameTuple, nRecords, recordDict);
-            ++nRecords;
+    if (!prv->pyAnalysis) {
+        if (!pmv->fScanned) {
+            ScanMatchState(&pmv->s);
+            pmv->fScanned = TRUE;
+        }
+        if (!(prv->pyAnalysis = PyMoveRecordAnalysis(prv->pmr, pmv->fVerbose, &pmv->s))) {
+            if (PyErr_Occurred())
+                return NULL;
+            Py_INCREF(Py_None);
+            prv->pyAnalysis = Py_None;
         }
-
-        DictSetItemSteal(gameDict, "game", gameTuple);
     }
 
-    return gameDict;
+    return prv->pyAnalysis;
 }
 
-static void
-addProperty(PyObject * dict, const char *name, const char *val)
+static PyObject *
+RecordViewKeys(PyObject * p, PyObject * UNUSED(args))
 {
-    if (!val) {
-        return;
+    PyRecordView *prv = (PyRecordView *) p;
+    PyObject *pyRecord, *pyAnalysis, *pyKeys;
+
+    if (!(pyRecord = RecordViewRecord(prv)) || !(pyAnalysis = RecordViewAnalysis(prv)))
+        return NULL;
+
+    if (!(pyKeys = PyDict_Keys(pyRecord)))
+        return NULL;
+
+    if (pyAnalysis != Py_None) {
+        PyObject *pyKey = PyKeyFromString("analysis");
+
+        PyList_Append(pyKeys, pyKey);
+        Py_DECREF(pyKey);
     }
 
-    DictSetItemSteal(dict, name, PyUnicode_FromString(val));
+    return pyKeys;
 }
 
+/* Look up a key; returns a borrowed reference, or NULL without an
+ * exception set if the record has no such key */
+
 static PyObject *
-PythonMatch(PyObject * UNUSED(self), PyObject * args, PyObject * keywds)
+RecordViewLookup(PyRecordView * prv, PyObject * pyKey)
 {
-    /* take match info from first game */
-    const listOLD *firstGame = lMatch.plNext->p;
-    const moverecord *pmr;
-    const xmovegameinfo *g;
-    int includeAnalysis = 1;
-    int verboseAnalysis = 0;
-    int statistics = 0;
-    int boards = 1;
-    PyObject *matchDict;
-    PyObject *matchInfoDict;
-    PyMatchState s;
-
-    static char *kwlist[] = { "analysis", "boards", "statistics", "verbose", 0 };
+    PyObject *pyRecord, *pyValue;
 
-    if (!firstGame) {
-        Py_INCREF(Py_None);
-        return Py_None;
+    if (PyKeyIs(pyKey, "analysis")) {
+        if (!(pyValue = RecordViewAnalysis(prv)))
+            return NULL;
+        return pyValue != Py_None ? pyValue : NULL;
     }
 
-    pmr = firstGame->plNext->p;
-    g_assert(pmr->mt == MOVE_GAMEINFO);
-    g = &pmr->g;
-
-    if (!PyArg_ParseTupleAndKeywords(args, keywds, "|iiii", kwlist,
-                                     &includeAnalysis, &boards, &statistics, &verboseAnalysis))
+    if (!(pyRecord = RecordViewRecord(prv)))
         return NULL;
 
+    return PyDict_GetItem(pyRecord, pyKey);
+}
 
-    matchDict = PyDict_New();
-    matchInfoDict = PyDict_New();
+static PyObject *
+RecordViewIter(PyObject * p)
+{
+    PyObject *pyKeys = RecordViewKeys(p, NULL);
+    PyObject *pyIter;
 
-    if (!matchDict && !matchInfoDict) {
-        PyErr_SetString(PyExc_MemoryError, "");
+    if (!pyKeys)
         return NULL;
-    }
 
-    if (g->i != 0) {
-        PyErr_SetString(PyExc_StandardError, _("First game missing from match"));
-        return NULL;
-    }
+    pyIter = PyObject_GetIter(pyKeys);
+    Py_DECREF(pyKeys);
 
-    /* W,X,0
-     * B,O,1 */
-    {
-        int side;
-        for (side = 0; side < 2; ++side) {
-            PyObject *d = PyDict_New();
-            addProperty(d, "rating", mi.pchRating[side]);
-            addProperty(d, "name", ap[side].szName);
+    return pyIter;
+}
 
-            DictSetItemSteal(matchInfoDict, side == 0 ? "X" : "O", d);
-        }
+static PyObject *
+RecordViewSubscript(PyObject * p, PyObject * pyKey)
+{
+    PyObject *pyValue = RecordViewLookup((PyRecordView *) p, pyKey);
+
+    if (!pyValue) {
+        if (!PyErr_Occurred())
+            PyErr_SetObject(PyExc_KeyError, pyKey);
+        return NULL;
     }
 
-    DictSetItemSteal(matchInfoDict, "match-length", PyInt_FromLong(g->nMatch));
+    Py_INCREF(pyValue);
+    return pyValue;
+}
 
-    if (mi.nYear) {
-        PyObject *date = Py_BuildValue("(iii)", mi.nDay, mi.nMonth, mi.nYear);
+static int
+RecordViewContains(PyObject * p, PyObject * pyKey)
+{
+    PyObject *pyValue = RecordViewLookup((PyRecordView *) p, pyKey);
 
-        DictSetItemSteal(matchInfoDict, "date", date);
-    }
+    if (!pyValue)
+        return PyErr_Occurred() ? -1 : 0;
 
-    addProperty(matchInfoDict, "event", mi.pchEvent);
-    addProperty(matchInfoDict, "round", mi.pchRound);
-    addProperty(matchInfoDict, "place", mi.pchPlace);
-    addProperty(matchInfoDict, "annotator", mi.pchAnnotator);
-    addProperty(matchInfoDict, "comment", mi.pchComment);
+    return 1;
+}
 
-    {                           /* Work out the result (-1,0,1) - (p0 win, unfinished, p1 win) */
-        int result = 0;
-        int anFinalScore[2];
-        if (getFinalScore(anFinalScore)) {
-            if (anFinalScore[0] > g->nMatch)
-                result = -1;
-            else if (anFinalScore[1] > g->nMatch)
-                result = 1;
-        }
-        DictSetItemSteal(matchInfoDict, "result", PyInt_FromLong(result));
-    }
+static Py_ssize_t
+RecordViewLength(PyObject * p)
+{
+    PyObject *pyKeys = RecordViewKeys(p, NULL);
+    Py_ssize_t n;
 
-    {
-        const char *v[] = { "Standard", "Nackgammon", "Hypergammon1", "Hypergammon2",
-            "Hypergammon3"
-        };
+    if (!pyKeys)
+        return -1;
 
-        addProperty(matchInfoDict, "variation", v[g->bgv]);
-    }
+    n = PyList_Size(pyKeys);
+    Py_DECREF(pyKeys);
 
-    {
-        unsigned int n = !g->fCubeUse + !!g->fCrawford + !!g->fJacoby;
-        if (n) {
-            PyObject *rules = PyTuple_New(n);
+    return n;
+}
 
-            n = 0;
-            if (!g->fCubeUse) {
-                PyTuple_SET_ITEM(rules, n++, PyUnicode_FromString("NoCube"));
-            }
-            if (g->fCrawford) {
-                PyTuple_SET_ITEM(rules, n++, PyUnicode_FromString("Crawford"));
-            }
-            if (g->fJacoby) {
-                PyTuple_SET_ITEM(rules, n, PyUnicode_FromString("Jacoby"));
-            }
+static PyObject *
+RecordViewGet(PyObject * p, PyObject * args)
+{
+    PyObject *pyKey, *pyDefault = Py_None, *pyValue;
 
-            DictSetItemSteal(matchInfoDict, "rules", rules);
-        }
-    }
+    if (!PyArg_ParseTuple(args, "O|O", &pyKey, &pyDefault))
+        return NULL;
 
-    DictSetItemSteal(matchDict, "match-info", matchInfoDict);
+    if (!(pyValue = RecordViewLookup((PyRecordView *) p, pyKey))) {
+        if (PyErr_Occurred())
+            return NULL;
+        pyValue = pyDefault;
+    }
 
-    s.ec = 0;
-    s.rc = 0;
+    Py_INCREF(pyValue);
+    return pyValue;
+}
 
-    {
-        int nGames = 0;
-        const listOLD *pl;
-        PyObject *matchTuple;
-        statcontext scm;
+static PyMethodDef RecordViewMethods[] = {
+    {"keys", RecordViewKeys, METH_NOARGS, "list of the keys of the record"},
+    {"get", RecordViewGet, METH_VARARGS, "value of a key, or the default given"},
+    {NULL, NULL, 0, NULL}
+};
 
-        for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext) {
-            ++nGames;
-        }
+static PyMappingMethods RecordViewMapping = {
+    .mp_length = RecordViewLength,
+    .mp_subscript = RecordViewSubscript,
+};
 
-        if (statistics) {
-            IniStatcontext(&scm);
-        }
+static PySequenceMethods RecordViewSequence = {
+    .sq_contains = RecordViewContains,
+};
 
-        matchTuple = PyTuple_New(nGames);
+static PyTypeObject PyMatchViewType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "gnubg.MatchView",
+    .tp_basicsize = sizeof(PyMatchView),
+    .tp_dealloc = MatchViewDealloc,
+    .tp_as_sequence = &MatchViewSequence,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "lazy view of the games of the match",
+    .tp_getset = MatchViewGetSet,
+};
 
-        nGames = 0;
-        for (pl = lMatch.plNext; pl != &lMatch; pl = pl->plNext) {
-            PyObject *pg = PythonGame(pl->p, includeAnalysis, verboseAnalysis,
-                                      statistics ? &scm : 0, boards, &s);
+static PyTypeObject PyGameViewType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "gnubg.GameView",
+    .tp_basicsize = sizeof(PyGameView),
+    .tp_dealloc = GameViewDealloc,
+    .tp_as_sequence = &GameViewSequence,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "lazy view of the records of a game",
+    .tp_getset = GameViewGetSet,
+};
 
-            if (!pg) {
-                /* Memory leaked. out of memory anyway */
-                return NULL;
-            }
+static PyTypeObject PyRecordViewType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "gnubg.RecordView",
+    .tp_basicsize = sizeof(PyRecordView),
+    .tp_dealloc = RecordViewDealloc,
+    .tp_as_sequence = &RecordViewSequence,
+    .tp_as_mapping = &RecordViewMapping,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "lazy view of a move record",
+    .tp_iter = RecordViewIter,
+    .tp_methods = RecordViewMethods,
+};
 
-            PyTuple_SET_ITEM(matchTuple, nGames, pg);
-            ++nGames;
-        }
+static PyObject *
+PythonMatchView(PyObject * UNUSED(self), PyObject * args, PyObject * keywds)
+{
+    const listOLD *firstGame = lMatch.plNext->p;
+    int includeAnalysis = 1;
+    int verboseAnalysis = 0;
+    int boards = 1;
+    PyMatchView *pmv;
 
-        DictSetItemSteal(matchDict, "games", matchTuple);
+    static char *kwlist[] = { "analysis", "boards", "verbose", 0 };
 
-        if (statistics) {
-            PyObject *pgs = PyGameStats(&scm, TRUE, g->nMatch);
+    if (!PyArg_ParseTupleAndKeywords(args, keywds, "|iii", kwlist, &includeAnalysis, &boards, &verboseAnalysis))
+        return NULL;
 
-            if (pgs) {
-                DictSetItemSteal(matchDict, "stats", pgs);
-            }
-        }
+    if (!firstGame) {
+        Py_INCREF(Py_None);
+        return Py_None;
     }
 
-    if (s.ec) {
-        PyObject *e = EvalContextToPy(s.ec);
-        DictSetItemSteal(matchInfoDict, "default-eval-context", e);
+    if (((const moverecord *) firstGame->plNext->p)->g.i != 0) {
+        PyErr_SetString(PyExc_StandardError, _("First game missing from match"));
+        return NULL;
     }
 
-    if (s.rc) {
-        PyObject *e = RolloutContextToPy(s.rc);
-        DictSetItemSteal(matchInfoDict, "default-rollout-context", e);
+    if (!(pmv = PyObject_New(PyMatchView, &PyMatchViewType)))
+        return NULL;
 
-        /* No need for that, I think */
-        /*     DictSetItemSteal(matchInfoDict, "sgf-rollout-version", */
-        /*                   PyInt_FromLong(SGF_ROLLOUT_VER)); */
-    }
+    pmv->nGeneration = nMatchGeneration;
+    pmv->fAnalysis = includeAnalysis;
+    pmv->fBoards = boards;
+    pmv->fVerbose = verboseAnalysis;
+    pmv->fScanned = FALSE;
 
-    return matchDict;
+    return (PyObject *) pmv;
 }
 
 
@@ -3192,6 +4662,14 @@ static PyMethodDef gnubgMethods[] = {
      "    returns tuple(floats P(win), P(win gammon), P(win backgammnon)\n"
      "         P(lose gammon), P(lose backgammon), cubeless equity)"}
     ,
+    {"evaluate_batch", PythonEvaluateBatch, METH_VARARGS,
+     "Cubeless evaluation of many positions on the calculation threads\n"
+     "    arguments: boards [cube-info] [eval context]\n"
+     "         boards = integer array of N x 2 x 25 values supporting the\n"
+     "             buffer protocol (e.g. a numpy array), each board as in 'board'\n"
+     "         see 'cfevaluate' for the other arguments\n"
+     "    returns N x 6 float32 memoryview, rows as returned by 'evaluate'"}
+    ,
     {"evalcontext", PythonEvalContext, METH_VARARGS,
      "make an evalcontext\n"
      "    argument: [tuple ( 5 int, float )]\n" "    returns:  eval-context ( see 'cfevaluate' )"}
@@ -3215,9 +4693,30 @@ static PyMethodDef gnubgMethods[] = {
      "        see 'cfevaluate'\n"
      "    returns: tuple( ints point from, point to, \n" "        unused moves are set to zero"}
     ,
+    {"findbestmove_batch", PythonFindBestMoveBatch, METH_VARARGS,
+     "Find the best move for many positions on the calculation threads\n"
+     "    arguments: boards dice [cube-info] [eval-context] [move filters]\n"
+     "        boards = integer array, see 'evaluate_batch'\n"
+     "        dice = tuple of two ints used for all boards, or an\n"
+     "            N x 2 integer array\n"
+     "    returns: N x 8 int32 memoryview of (point from, point to) pairs\n"
+     "        as returned by 'findbestmove', unused moves are set to zero"}
+    ,
     {"hint", PythonHint, METH_VARARGS,
      "    arguments: [max moves]\n" "    returns: hint dictionary\n"}
     ,
+    {"scoremap", PythonScoreMap, METH_VARARGS,
+     "Evaluate the current position at every score of a match\n"
+     "    arguments: [match length] [move]\n"
+     "        match length = 2 to 64, by default as the score map window\n"
+     "        move = 0 for the cube action (default), 1 for the best move\n"
+     "    returns: dictionary with 'type', 'matchlength', 'plies',\n"
+     "        'scores' and 'money'. 'scores' is a list of rows: row i is\n"
+     "        player 0 at i + 2 away (cube) or i away (move, 1 for the\n"
+     "        Crawford game and 0 post-Crawford), column j likewise for\n"
+     "        player 1. The cells are (no double, double/take, action)\n"
+     "        equities, or (move, equity); None if the score can't occur"}
+    ,
     {"mwc2eq", PythonMwc2eq, METH_VARARGS,
      "convert MWC to equity\n"
      "    argument: [float match-winning-chance], [cube-info]\n"
@@ -3368,6 +4867,17 @@ static PyMethodDef gnubgMethods[] = {
      "          'result' =>0/1\n"
      "          'rules' = 'Crawford'/whatever\n" "          'variation' => 'Standard' or whatever\n"}
     ,
+    {"matchview", (PyCFunction) (void (*)(void)) (PyCFunctionWithKeywords) PythonMatchView, METH_VARARGS | METH_KEYWORDS,
+     "Lazy view of the current match\n"
+     "    arguments: keywords analysis, boards, verbose, see 'match'\n"
+     "    returns: None if there is no match, otherwise a sequence of games.\n"
+     "        'info' and 'stats' of the view give the match-info and\n"
+     "        statistics dictionaries of 'match'. Each game is a sequence\n"
+     "        of records with 'info' and 'stats' likewise; each record is a\n"
+     "        read only mapping with the keys of the records of 'match'.\n"
+     "        Values are only worked out when they are looked up, and the\n"
+     "        views raise RuntimeError once the match has been changed."}
+    ,
     {"navigate", (PyCFunction) (void (*)(void)) (PyCFunctionWithKeywords) PythonNavigate, METH_VARARGS | METH_KEYWORDS,
      "go to a position in a match or session'n"
      "    arguments: no args = go to start of match/session\n"
@@ -3438,6 +4948,10 @@ MOD_INIT(gnubg)
 {
     PyObject *module;
 
+    if (PyType_Ready(&PyMatchViewType) < 0 || PyType_Ready(&PyGameViewType) < 0
+        || PyType_Ready(&PyRecordViewType) < 0)
+        return MOD_ERROR_VAL;
+
     MOD_DEF(module, "gnubg", NULL, gnubgMethods);
 
     if (module == NULL)
@@ -3471,6 +4985,11 @@ PythonInitialise(char *argv0)
     g_free(working_dir);
 #endif
 
+#if defined(USE_MULTITHREAD)
+    /* gnubg.py may already run commands */
+    PyGuardInit();
+#endif
+
     Py_SetProgramName(progname);
 #if PY_MAJOR_VERSION >= 3
     PyImport_AppendInittab("gnubg", &PyInit_gnubg);
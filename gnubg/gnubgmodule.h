@@ -44,6 +44,19 @@ extern int LoadPythonFile(const char *sz, int fQuiet);
 extern gint python_run_file(gpointer file);
 extern MOD_INIT(gnubg);
 
+#if defined(USE_MULTITHREAD)
+/* Called by HandleCommand() around each command: waits for the Python
+ * evaluations running without the GIL and keeps new ones from starting
+ * until the command is over */
+extern void PythonCommandBegin(void);
+extern void PythonCommandEnd(void);
+#endif
+
 #endif                          /* USE_PYTHON */
 
+#if !defined(USE_PYTHON) || !defined(USE_MULTITHREAD)
+#define PythonCommandBegin()
+#define PythonCommandEnd()
+#endif
+
 #endif                          /* GNUBGMODULE_H */
@@ -421,7 +421,7 @@ append_game_options(optionswidget * pow)
     /* disable entries if hypergammon databases are not available */
 
     for (i = 0; i < 3; ++i)
-        gtk_widget_set_sensitive(GTK_WIDGET(pow->apwVariations[i + VARIATION_HYPERGAMMON_1]), apbcHyper[i] != NULL);
+        gtk_widget_set_sensitive(GTK_WIDGET(pow->apwVariations[i + VARIATION_HYPERGAMMON_1]), HyperBearoffAvailable(i));
 }
 
 static void
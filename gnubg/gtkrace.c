@@ -31,6 +31,7 @@
 #include "osr.h"
 #include "format.h"
 #include "gtkwindows.h"
+#include "multithread.h"
 
 typedef struct {
     GtkWidget *apwEPC[2];
@@ -277,7 +278,7 @@ PerformOSR(GtkWidget * UNUSED(pw), racewidget * prw)
     GtkTreeIter iter;
     GtkTreeModel *store;
 
-    raceProbs((ConstTanBoard) prw->anBoard, nTrials, ar, arMu);
+    raceProbsMT((ConstTanBoard) prw->anBoard, nTrials, MT_GetNumThreads(), ar, arMu);
 
     PipCount((ConstTanBoard) prw->anBoard, anPips);
 
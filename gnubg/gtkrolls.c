@@ -30,6 +30,7 @@
 #include "format.h"
 #include "gtkwindows.h"
 #include "gtkrolls.h"
+#include "ponder.h"
 
 typedef struct {
 
@@ -174,6 +175,8 @@ create_model(const int n, evalcontext * pec, const matchstate * pms)
 
     ProgressStartValue(_("Calculating equities"), j);
 
+    /* the depth is changed outside any command */
+    PonderStop();
     add_level(model, NULL, n - 1, (ConstTanBoard) anBoard, pec, &ci, TRUE, arOutput);
 
     ProgressEnd();
@@ -28,7 +28,7 @@
                     It also initializes variables.
             2. It calls UpdateCubeInfoArray(), which initializes the match state in each quadrant, by filling
                     psm->aaQuadrantData[i][j].ci for each i,j
-            3. It calls CalcScoreMapEquities(), which for each score calls CalcQuadrantEquities() to find
+            3. It calls CalcScoreMapEquities(), which evaluates all the scores on the calculation threads to find
                     the equity of each decision and therefore the best decision as well,
                     and uses it to set the text for the corresponding quadrant (the best decision is stored in
                     psm->aaQuadrantData[i][j].decisionString). This text is displayed in step 5 below.
@@ -99,6 +99,8 @@ and come back, it works again. It may be a movelist construction issue.
 #include "backgammon.h"
 #include "eval.h"
 #include "gtkscoremap.h"
+#include "scoremap.h"
+#include "multithread.h"
 #include "drawboard.h"
 #include "format.h"
 #include "gtkwindows.h"
@@ -444,64 +446,19 @@ DecisionVal(float ndEq, float dtEq) {
 //     return SCOREMAP_DECISION_SHORT_STRING[i][j];
 // }
 
-static float
-mmwc2eq(const float rMwc, const cubeinfo *pci) {
-/* Converts mwc to equity, in case of a match. If a money game, no conversion takes place. */
-    if (pci->nMatchTo==0)
-        return rMwc;
-    else
-        return mwc2eq(rMwc,pci);
-}
-
-static int
-CalcQuadrantEquities(quadrantdata * pq, const scoremap * psm, int recomputeFully) {
-/* In Cube ScoreMap: Calculates the DT and ND equities for the given quadrant. Updates data in pq accordingly.
-In Move ScoreMap: Calculates the ordered best moves and their equities.
+static void
+SetQuadrantDecision(quadrantdata * pq, const scoremap * psm) {
+/* In Cube ScoreMap: Finds the correct cube decision from the ND and DT equities of the given quadrant.
+In Move ScoreMap: Describes the best move. Updates data in pq accordingly.
 */
     if (psm->cubeScoreMap) {
-        if (!GetDPEq(NULL, NULL, & pq->ci)) { // Cube not available
-                strcpy(pq->decisionString,"");
-                pq->isAllowedScore = UNALLOWED_DOUBLE;
-                strcpy(pq->unallowedExplanation, _("Unallowed double: cube not available"));
-        } else {
-            if (recomputeFully) {
-                float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
-                if (GeneralCubeDecisionE(aarOutput, psm->pms->anBoard, & pq->ci, & psm->ec, NULL)) {
-                        //GeneralCubeDecisionE is from eval.c
-                        // extern int GeneralCubeDecisionE(float aarOutput[2][NUM_ROLLOUT_OUTPUTS], const TanBoard anBoard,
-                        // cubeinfo * const pci, const evalcontext * pec, const evalsetup * UNUSED(pes))
-                    ProgressEnd();
-                    return -1;
-                }
-
-                // Convert MWC to equity, and store in the scoremap
-                pq->ndEquity= mmwc2eq(aarOutput[0][OUTPUT_CUBEFUL_EQUITY], & pq->ci);
-                pq->dtEquity= mmwc2eq(aarOutput[1][OUTPUT_CUBEFUL_EQUITY], & pq->ci);
-            }
-
-    //g_print("Score: %d-%d ",psm->aaQuadrantData[i][j].ci.anScore[0], psm->aaQuadrantData[i][j].ci.anScore[1]);
-            // Produce 2-letter string corresponding to the correct cube action (eg DT for double-take)
-            //pq->decisionString=DecisionShortString(pq->ndEquity,pq->dtEquity);
-            pq->dec=DecisionVal(pq->ndEquity,pq->dtEquity);
-            strcpy(pq->decisionString,CUBE_DECISION_TEXT[pq->dec]);
-    // g_print("ND %f; DT %f; %s\n",ndEq,dtEq,pq->decisionString);
-        }
-        return 0;
-    } else {  //move scoremap
-        if (FindnSaveBestMoves(&(pq->ml),psm->pms->anDice[0],psm->pms->anDice[1], (ConstTanBoard) psm->pms->anBoard, NULL, //or pkey
-                                        arSkillLevel[SKILL_DOUBTFUL], &(pq->ci), &psm->ec, aamfAnalysis) <0) {
-            strcpy(pq->decisionString,"");
-            ProgressEnd();
-            return -1;
-        }
-
-        g_assert(pq->ml.cMoves > 0);
-        if (pq->ml.cMoves > 0)
-            FormatMove(pq->decisionString, (ConstTanBoard) psm->pms->anBoard, pq->ml.amMoves[0].anMove);
-
-        // g_print("FindnSaveBestMoves returned %d, %d, %1.3f; decision: %s\n",pq->ml.cMoves,pq->ml.cMaxMoves, pq->ml.rBestScore,pq->decisionString);
-
-        return 0;
+        // Produce 2-letter string corresponding to the correct cube action (eg DT for double-take)
+        pq->dec=DecisionVal(pq->ndEquity,pq->dtEquity);
+        strcpy(pq->decisionString,CUBE_DECISION_TEXT[pq->dec]);
+    } else if (pq->ml.cMoves > 0) {
+        FormatMove(pq->decisionString, (ConstTanBoard) psm->pms->anBoard, pq->ml.amMoves[0].anMove);
+    } else {
+        strcpy(pq->decisionString,"");
     }
 }
 
@@ -568,38 +525,136 @@ TODO: when changing ply etc., don't change colours.
 }
 
 
+/* The quadrants being computed, so that ScoreMapProgress() can show them as they finish */
+typedef struct {
+    scoremap *psm;
+    unsigned int n;
+    unsigned int cShown;
+    scoremapcell *asmc;         // the cells handed to the calculation threads
+    quadrantdata **apq;         // where their results go
+    gtkquadrant **apgq;         // and where they are shown (cube scoremap only)
+    int *afShown;
+} scoremapprogress;
+
+static scoremapprogress smCalc;
+
+static void
+ShowFinishedQuadrants(void)
+{
+/* Copy the results of the cells that are done into their quadrants.
+In the cube scoremap, also colour the quadrants. (The colours of the move scoremap depend on all the moves,
+so they wait for the end.)
+*/
+    scoremap *psm = smCalc.psm;
+
+    for (unsigned int k = 0; k < smCalc.n; k++) {
+        quadrantdata *pq = smCalc.apq[k];
+
+        if (smCalc.afShown[k] || !MT_SafeGet(&smCalc.asmc[k].fDone))
+            continue;
+
+        if (psm->cubeScoreMap) {
+            pq->ndEquity = smCalc.asmc[k].rNoDouble;
+            pq->dtEquity = smCalc.asmc[k].rDoubleTake;
+        } else {
+            g_free(pq->ml.amMoves);
+            pq->ml = smCalc.asmc[k].ml;
+        }
+        SetQuadrantDecision(pq, psm);
+
+        if (psm->cubeScoreMap && smCalc.apgq[k]->pDrawingAreaWidget)
+            ColourQuadrant(smCalc.apgq[k], pq, psm);
+
+        smCalc.afShown[k] = TRUE;
+        smCalc.cShown++;
+    }
+    ProgressValue((int) smCalc.cShown);
+}
+
+static gboolean
+ScoreMapProgress(gpointer UNUSED(p))
+{
+    ShowFinishedQuadrants();
+    return TRUE;
+}
+
+static void
+AddCalcQuadrant(quadrantdata * pq, gtkquadrant * pgq)
+{
+    smCalc.asmc[smCalc.n].ci = pq->ci;
+    smCalc.apq[smCalc.n] = pq;
+    smCalc.apgq[smCalc.n] = pgq;
+    smCalc.n++;
+}
+
 static int
 CalcScoreMapEquities(scoremap * psm, int oldSize)
 /* Iterate through scores. Find equities at each score, and use these to set the text for the corresponding box.
-   (Does not update the gui.)
+   The scores are evaluated in parallel on the calculation threads; in the cube scoremap, the boxes are
+   coloured as they finish, the rest of the gui is updated afterwards.
    Only does entries in the table >= oldSize. (Avoid computing old values when resizing the table.)
    In the move scoremap, it also computes the most frequent best moves across the scoremap
 */
 {
-    ProgressStartValue(_("Finding correct actions"), MAX(psm->tableSize*psm->tableSize+1-oldSize*oldSize, 1));
-            // - Should actually be 1 less if oldSize>0 (because money)
-            // - If we only recompute the money equity, the formula correctly yields 1 for oldSize = psm->tableSize
-//g_print("Finding %d-ply cube equities:\n",pec->nPlies);
+    int ret;
+    unsigned int cMax = (unsigned int) (psm->tableSize * psm->tableSize + 1);
+
+    smCalc.psm = psm;
+    smCalc.n = smCalc.cShown = 0;
+    smCalc.asmc = g_new0(scoremapcell, cMax);
+    smCalc.apq = g_new(quadrantdata *, cMax);
+    smCalc.apgq = g_new(gtkquadrant *, cMax);
+    smCalc.afShown = g_new0(int, cMax);
+
     for (int i=0; i<psm->tableSize; i++) {
         // i,j correspond to the locations in the table. E.g., in cube ScoreMap, the away-scores
         //      are 2+i, 2+j (because the (0,0)-entry of the table corresponds to 2-away 2-away).
+        int i2 = (labelBasedOn == LABEL_AWAY) ? i : psm->tableSize-1-i; // position in the visual table
         for (int j=0; j<psm->tableSize; j++) {
-            if (psm->aaQuadrantData[i][j].isAllowedScore == ALLOWED) {
-                CalcQuadrantEquities(& psm->aaQuadrantData[i][j], psm, (i>=oldSize || j>=oldSize));
-                // g_print("i=%d,j=%d,FindnSaveBestMoves returned %d, %1.3f; decision: %s\n",i,j,psm->aaQuadrantData[i][j].ml.
-                //         cMoves,psm->aaQuadrantData[i][j].ml.rBestScore,psm->aaQuadrantData[i][j].decisionString);
-                if (i>=oldSize || j>=oldSize) // Only count the ones where equities are recomputed (other ones occur near-instantly)
-                    ProgressValueAdd(1);
+            int j2 = (labelBasedOn == LABEL_AWAY) ? j : psm->tableSize-1-j;
+            quadrantdata *pq = &psm->aaQuadrantData[i][j];
+
+            if (pq->isAllowedScore != ALLOWED) {
+                strcpy(pq->decisionString,"");
+            } else if (psm->cubeScoreMap && !GetDPEq(NULL, NULL, &pq->ci)) { // Cube not available
+                strcpy(pq->decisionString,"");
+                pq->isAllowedScore = UNALLOWED_DOUBLE;
+                strcpy(pq->unallowedExplanation, _("Unallowed double: cube not available"));
+            } else if (i>=oldSize || j>=oldSize) {
+                AddCalcQuadrant(pq, &psm->aagQuadrant[i2][j2]);
             } else {
-                strcpy(psm->aaQuadrantData[i][j].decisionString,"");
+                // Old values: the equities are the same, only redo the decision (occurs near-instantly)
+                SetQuadrantDecision(pq, psm);
             }
         }
     }
-    CalcQuadrantEquities(&(psm->moneyQuadrantData), psm, TRUE);
-    ProgressValueAdd(1);
+    if (psm->cubeScoreMap && !GetDPEq(NULL, NULL, &psm->moneyQuadrantData.ci)) {
+        strcpy(psm->moneyQuadrantData.decisionString,"");
+        psm->moneyQuadrantData.isAllowedScore = UNALLOWED_DOUBLE;
+        strcpy(psm->moneyQuadrantData.unallowedExplanation, _("Unallowed double: cube not available"));
+    } else
+        AddCalcQuadrant(&psm->moneyQuadrantData, &psm->moneygQuadrant);
+
+    ProgressStartValue(_("Finding correct actions"), MAX((int) smCalc.n, 1));
 
+    if (psm->cubeScoreMap)
+        ret = ScoreMapCalcCube((ConstTanBoard) psm->pms->anBoard, &psm->ec, smCalc.asmc, smCalc.n, ScoreMapProgress);
+    else
+        ret = ScoreMapCalcMove((ConstTanBoard) psm->pms->anBoard, psm->pms->anDice, &psm->ec, aamfAnalysis,
+                               smCalc.asmc, smCalc.n, ScoreMapProgress);
+
+    ShowFinishedQuadrants();
     ProgressEnd();
 
+    g_free(smCalc.asmc);
+    g_free(smCalc.apq);
+    g_free(smCalc.apgq);
+    g_free(smCalc.afShown);
+    smCalc.n = 0;
+
+    if (ret < 0)
+        return -1;
+
     if (!psm->cubeScoreMap)
         FindMostFrequentMoves(psm);
 
@@ -1507,33 +1562,9 @@ Also, in the move scoremap, both players can double, so non-1 cube values could
                         // 3 we don't allow an absurd cubing situation, eg someone leading in Crawford
                         //          with a >1 cube, or someone at matchLength-2 who would double to 4
 
-                    /* cubeinfo */
-                    /* NOTE: it is important to change the score and cube value in the match, and not in the
-                    cubeinfo, because the gammon values in cubeinfo need to be set correctly.
-                    This is taken care of in GetMatchStateCubeInfo().
-                    */
-                    if (psm->cubeScoreMap) {
-                        // Alter the match score: we want i,j to be away scores - 2 (note match length is tableSize+1)
-                        ams.anScore[0]=psm->tableSize-i-1;
-                        ams.anScore[1]=psm->tableSize-j-1;
-                    } else { //move ScoreMap
-                        // Here we found that there may be a bug with the confusion b/w fCrawford and fPostCrawford
-                        // Using fCrawford while we should use the other...
-                        // We set ams.fCrawford=1 for the Crawford games and 0 for the post-Crawford games
-                        ams.fCrawford=(i==1 || j==1); //Crawford by default, unless i==0 or j==0
-                        ams.fPostCrawford=(i==0 || j==0); //Crawford by default, unless i==0 or j==0
-                        if (i==0) { //1-away post Crawford
-                            ams.anScore[0]=MATCH_SIZE(psm)-1;
-                        } else  //i-away Crawford
-                            ams.anScore[0]=MATCH_SIZE(psm)-i;
-                        if (j==0) { //1-away post Crawford
-                            ams.anScore[1]=MATCH_SIZE(psm)-1;
-                        } else  //j-away
-                            ams.anScore[1]=MATCH_SIZE(psm)-j;
-                    }
-                    // // Create cube info using this data
-                    //     psm->aaQuadrantData[i][j] = (scoremap *) g_malloc(sizeof(scoremap));
-                    GetMatchStateCubeInfo(&(psm->aaQuadrantData[i][j].ci), & ams);
+                    /* cubeinfo: in the cube ScoreMap i,j are the away scores - 2; in the move ScoreMap
+                    i,j are the away scores, with 1 for the Crawford game and 0 for post-Crawford */
+                    ScoreMapCellCubeInfo(&(psm->aaQuadrantData[i][j].ci), &ams, psm->cubeScoreMap, MATCH_SIZE(psm), i, j);
 
                     //we also want to update the "special" quadrants, i.e. those w/ the same score as currently,
                     // or DMP etc.
@@ -2301,6 +2332,7 @@ MatchLengthToggled(GtkWidget * pw, scoremap * psm)
             moveMatchSize=newMatchSize;
         int oldTableSize=psm->tableSize;
         psm->tableSize = (psm->cubeScoreMap)? cubeMatchSize-1 : moveMatchSize+1;
+        int oldSignednCube=psm->signednCube;
         if (abs(psm->signednCube) >= 2*newMatchSize) { //i.e. we set a big cube then decrease too much the match size
             psm->signednCube=1;
         }
@@ -2314,7 +2346,8 @@ MatchLengthToggled(GtkWidget * pw, scoremap * psm)
         // psm->signednCube=signednCube;
         BuildCubeFrame(psm);
         UpdateCubeInfoArray(psm, psm->signednCube, FALSE);
-        CalcScoreMapEquities(psm, oldTableSize);
+        // if the cube changed, all the old equities are stale
+        CalcScoreMapEquities(psm, (psm->signednCube==oldSignednCube) ? oldTableSize : 0);
         UpdateScoreMapVisual(psm);
     }
     //}
@@ -2394,6 +2427,10 @@ Allows garbage collection.
         // g_free(psm->topKDecisions[i]);
         g_free(psm->topKClassifiedDecisions[i]);
     }
+    for (int i=0; i<MAX_TABLE_SIZE; i++)
+        for (int j=0; j<MAX_TABLE_SIZE; j++)
+            g_free(psm->aaQuadrantData[i][j].ml.amMoves);
+    g_free(psm->moneyQuadrantData.ml.amMoves);
 
     g_free(psm);
 }
@@ -2769,7 +2806,7 @@ Implemented as:
     MAX_TABLE_WIDTH = MIN(MAX_TABLE_WIDTH, (int)(0.3f * (float)screenWidth));
     MAX_TABLE_HEIGHT = MIN(MAX_TABLE_HEIGHT, (int)(0.6f * (float)screenHeight));
 
-    psm = (scoremap *) g_malloc(sizeof(scoremap));
+    psm = (scoremap *) g_malloc0(sizeof(scoremap));
     psm->cubeScoreMap = cube;   // throughout this file: determines whether we want a cube scoremap or a move scoremap
     //colourBasedOn=ALL;     //default gauge; see also the option to set the starting gauge at the bottom
     // psm->describeUsing=DEFAULT_DESCRIPTION; //default description mode: NUMBERS, ENGLISH, BOTH -> moved to static variable
@@ -35,6 +35,7 @@
 #include "backgammon.h"
 #include "eval.h"
 #include "gtktempmap.h"
+#include "tempmap.h"
 #include "gtkgame.h"
 #include "drawboard.h"
 #include "format.h"
@@ -88,95 +89,33 @@ static int fShowEquity = FALSE;
 static int fShowBestMove = FALSE;
 
 static int
-TempMapEquities(evalcontext * pec, matchstate * pms,
-                float aarEquity[6][6], int aaanMove[6][6][8], const gchar * szTitle, const float rFac)
+CalcTempMapEquities(evalcontext * pec, tempmapwidget * ptmw)
 {
 
+    int i;
+    matchstate *ams = g_new(matchstate, ptmw->n);
+    float *arFac = g_new(float, ptmw->n);
+    tempmapequities *atme = g_new(tempmapequities, ptmw->n);
+    int ret;
 
-    int i, j;
-    float arOutput[NUM_ROLLOUT_OUTPUTS];
-    TanBoard anBoard;
-    int aaan[6][6][8];
-    float aar[6][6];
-    cubeinfo ci;
-    cubeinfo cix;
-
-    /* calculate equities */
-
-    GetMatchStateCubeInfo(&cix, pms);
-
-    if (szTitle && *szTitle) {
-        gchar *sz = g_strdup_printf(_("Calculating equities for %s"), szTitle);
-        ProgressStartValue(sz, 21);
-        g_free(sz);
-    } else
-        ProgressStartValue(_("Calculating equities"), 21);
-
-    for (i = 0; i < 6; ++i)
-        for (j = 0; j <= i; ++j) {
-
-            memcpy(&ci, &cix, sizeof ci);
-
-            /* find best move */
-
-            memcpy(anBoard, pms->anBoard, sizeof(anBoard));
-
-            if (FindBestMove(aaan[i][j], i + 1, j + 1, anBoard, &ci, pec, defaultFilters) < 0) {
-                ProgressEnd();
-                return -1;
-            }
-
-            /* evaluate resulting position */
-
-            SwapSides(anBoard);
-            ci.fMove = !ci.fMove;
-
-            if (GeneralEvaluationE(arOutput, (ConstTanBoard) anBoard, &ci, pec) < 0) {
-                ProgressEnd();
-                return -1;
-            }
-
-            InvertEvaluationR(arOutput, &cix);
-
-            if (!cix.nMatchTo && rFac != 1.0f)
-                arOutput[OUTPUT_CUBEFUL_EQUITY] *= rFac;
-
-            aar[i][j] = arOutput[OUTPUT_CUBEFUL_EQUITY];
-            aar[j][i] = arOutput[OUTPUT_CUBEFUL_EQUITY];
-
-            if (i != j)
-                memcpy(aaan[j][i], aaan[i][j], sizeof aaan[0][0]);
+    for (i = 0; i < ptmw->n; ++i) {
+        ams[i] = *ptmw->atm[i].pms;
+        arFac[i] = (float) ptmw->atm[i].pms->nCube / (float) ptmw->atm[0].pms->nCube;
+    }
 
-            ProgressValueAdd(1);
+    /* all the positions at once, on the calculation threads */
 
+    if ((ret = TempMapCalc(ams, arFac, ptmw->n, pec, atme)) == 0)
+        for (i = 0; i < ptmw->n; ++i) {
+            memcpy(ptmw->atm[i].aarEquity, atme[i].aarEquity, sizeof atme[i].aarEquity);
+            memcpy(ptmw->atm[i].aaanMove, atme[i].aaanMove, sizeof atme[i].aaanMove);
         }
 
+    g_free(ams);
+    g_free(arFac);
+    g_free(atme);
 
-
-    ProgressEnd();
-
-    memcpy(aarEquity, aar, sizeof aar);
-    memcpy(aaanMove, aaan, sizeof aaan);
-
-    return 0;
-
-}
-
-
-static int
-CalcTempMapEquities(evalcontext * pec, tempmapwidget * ptmw)
-{
-
-    int i;
-
-    for (i = 0; i < ptmw->n; ++i)
-        if (TempMapEquities(pec, ptmw->atm[i].pms,
-                            ptmw->atm[i].aarEquity,
-                            ptmw->atm[i].aaanMove,
-                            ptmw->atm[i].szTitle, (float) (ptmw->atm[i].pms->nCube / ptmw->atm[0].pms->nCube)) < 0)
-            return -1;
-
-    return 0;
+    return ret;
 
 }
 
@@ -2904,8 +2904,8 @@ OpenCSS(const char *sz)
 }
 
 
-static void
-check_for_html_images(gchar * path)
+extern void
+check_for_html_images(const gchar * path)
 {
     char *url = exsExport.szHTMLPictureURL;
 
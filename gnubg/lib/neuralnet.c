@@ -42,6 +42,7 @@ NeuralNetCreate(neuralnet * pnn, unsigned int cInput, unsigned int cHidden,
     pnn->rBetaHidden = rBetaHidden;
     pnn->rBetaOutput = rBetaOutput;
     pnn->nTrained = 0;
+    pnn->fMapped = FALSE;
 
     if ((pnn->arHiddenWeight = sse_malloc(cHidden * cInput * sizeof(float))) == NULL)
         return -1;
@@ -70,14 +71,17 @@ NeuralNetCreate(neuralnet * pnn, unsigned int cInput, unsigned int cHidden,
 extern void
 NeuralNetDestroy(neuralnet * pnn)
 {
-    sse_free(pnn->arHiddenWeight);
+    if (!pnn->fMapped) {
+        sse_free(pnn->arHiddenWeight);
+        sse_free(pnn->arOutputWeight);
+        sse_free(pnn->arHiddenThreshold);
+        sse_free(pnn->arOutputThreshold);
+    }
     pnn->arHiddenWeight = 0;
-    sse_free(pnn->arOutputWeight);
     pnn->arOutputWeight = 0;
-    sse_free(pnn->arHiddenThreshold);
     pnn->arHiddenThreshold = 0;
-    sse_free(pnn->arOutputThreshold);
     pnn->arOutputThreshold = 0;
+    pnn->fMapped = FALSE;
 }
 
 #if !defined(USE_SIMD_INSTRUCTIONS)
@@ -359,6 +363,117 @@ NeuralNetSaveBinary(const neuralnet * pnn, FILE * pf)
     return 0;
 }
 
+/*
+ * Mapped weights: the same data as the binary format, but with every
+ * array starting at a multiple of NN_MAPPED_ALIGN bytes, so that the
+ * file can be mapped into memory and the arrays used where they are.
+ *
+ * Each net is a header of NN_MAPPED_ALIGN bytes
+ *   cInput, cHidden, cOutput, nTrained, rBetaHidden, rBetaOutput
+ * followed by the hidden weights, output weights, hidden thresholds
+ * and output thresholds, each padded to NN_MAPPED_ALIGN bytes.
+ */
+
+static size_t
+MappedSize(size_t cb)
+{
+    return (cb + NN_MAPPED_ALIGN - 1) & ~((size_t) NN_MAPPED_ALIGN - 1);
+}
+
+static int
+WritePadded(const void *p, size_t cb, FILE * pf)
+{
+    static const char achZero[NN_MAPPED_ALIGN] = { 0 };
+    size_t cbPad = MappedSize(cb) - cb;
+
+    if (fwrite(p, 1, cb, pf) < cb || fwrite(achZero, 1, cbPad, pf) < cbPad)
+        return -1;
+
+    return 0;
+}
+
+extern int
+NeuralNetSaveMapped(const neuralnet * pnn, FILE * pf)
+{
+    unsigned int anHeader[6];
+
+    anHeader[0] = pnn->cInput;
+    anHeader[1] = pnn->cHidden;
+    anHeader[2] = pnn->cOutput;
+    anHeader[3] = (unsigned int) pnn->nTrained;
+    memcpy(anHeader + 4, &pnn->rBetaHidden, sizeof(float));
+    memcpy(anHeader + 5, &pnn->rBetaOutput, sizeof(float));
+
+    if (WritePadded(anHeader, sizeof(anHeader), pf) ||
+        WritePadded(pnn->arHiddenWeight, pnn->cInput * pnn->cHidden * sizeof(float), pf) ||
+        WritePadded(pnn->arOutputWeight, pnn->cHidden * pnn->cOutput * sizeof(float), pf) ||
+        WritePadded(pnn->arHiddenThreshold, pnn->cHidden * sizeof(float), pf) ||
+        WritePadded(pnn->arOutputThreshold, pnn->cOutput * sizeof(float), pf))
+        return -1;
+
+    return 0;
+}
+
+/*
+ * Set up pnn to use the net stored at *poffset in the mapped weights
+ * pch[0..cb-1] in place. pch must be aligned to NN_MAPPED_ALIGN bytes and
+ * stay mapped while the net is used. *poffset is advanced past the net.
+ */
+
+extern int
+NeuralNetMap(neuralnet * pnn, const char *pch, size_t cb, size_t * poffset)
+{
+    unsigned int anHeader[6];
+    size_t off = *poffset;
+    size_t cbHidden, cbOutput;
+
+    if (off + sizeof(anHeader) > cb) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memcpy(anHeader, pch + off, sizeof(anHeader));
+
+    pnn->cInput = anHeader[0];
+    pnn->cHidden = anHeader[1];
+    pnn->cOutput = anHeader[2];
+    pnn->nTrained = (int) anHeader[3];
+    memcpy(&pnn->rBetaHidden, anHeader + 4, sizeof(float));
+    memcpy(&pnn->rBetaOutput, anHeader + 5, sizeof(float));
+
+    if (pnn->cInput < 1 || pnn->cHidden < 1 || pnn->cOutput < 1 || pnn->rBetaHidden <= 0.0f || pnn->rBetaOutput <= 0.0f
+        || pnn->cInput > 0xffff || pnn->cHidden > 0xffff || pnn->cOutput > 0xffff) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    cbHidden = MappedSize(pnn->cInput * pnn->cHidden * sizeof(float));
+    cbOutput = MappedSize(pnn->cHidden * pnn->cOutput * sizeof(float));
+
+    off += MappedSize(sizeof(anHeader));
+
+    if (off + cbHidden + cbOutput + MappedSize(pnn->cHidden * sizeof(float)) +
+        MappedSize(pnn->cOutput * sizeof(float)) > cb) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* the evaluation code doesn't write to the weights */
+    pnn->arHiddenWeight = (float *) (void *) (pch + off);
+    off += cbHidden;
+    pnn->arOutputWeight = (float *) (void *) (pch + off);
+    off += cbOutput;
+    pnn->arHiddenThreshold = (float *) (void *) (pch + off);
+    off += MappedSize(pnn->cHidden * sizeof(float));
+    pnn->arOutputThreshold = (float *) (void *) (pch + off);
+    off += MappedSize(pnn->cOutput * sizeof(float));
+
+    pnn->fMapped = TRUE;
+    *poffset = off;
+
+    return 0;
+}
+
 
 #if defined(USE_SIMD_INSTRUCTIONS)
 
@@ -35,8 +35,12 @@ typedef struct {
     float *arOutputWeight;
     float *arHiddenThreshold;
     float *arOutputThreshold;
+    int fMapped;                /* arrays point into a mapped file */
 } neuralnet;
 
+/* alignment of the arrays in mapped weights files */
+#define NN_MAPPED_ALIGN 64
+
 typedef enum {
     NNEVAL_NONE,
     NNEVAL_SAVE,
@@ -67,6 +71,8 @@ extern int NeuralNetEvaluateSSE(const neuralnet * pnn, float arInput[], float ar
 extern int NeuralNetLoad(neuralnet * pnn, FILE * pf);
 extern int NeuralNetLoadBinary(neuralnet * pnn, FILE * pf);
 extern int NeuralNetSaveBinary(const neuralnet * pnn, FILE * pf);
+extern int NeuralNetSaveMapped(const neuralnet * pnn, FILE * pf);
+extern int NeuralNetMap(neuralnet * pnn, const char *pch, size_t cb, size_t * poffset);
 extern int SIMD_Supported(void);
 
 /* Try to determine whether we are 64-bit or 32-bit */
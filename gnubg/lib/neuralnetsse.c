@@ -263,16 +263,33 @@ sigmoid_ps(float_vector xin)
 
 #endif                          // USE_SSE2 or USE_AVX
 
+/* Complete unrolling of the loops over the hidden nodes. Only used in
+ * the kernels for the shapes of the shipped nets, where the trip counts
+ * are constants */
+#if defined(__clang__)
+#define UNROLL _Pragma("unroll")
+#elif defined(__GNUC__) && (__GNUC__ >= 8)
+#define UNROLL _Pragma("GCC unroll 32")
+#else
+#define UNROLL
+#endif
+
+#if defined(__GNUC__)
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE inline
+#endif
+
 #if defined(USE_SSE2)
 #define INPUT_ADD() \
-for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE) { \
+SHAPE_UNROLL for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE) { \
     vec0 = _mm_load_ps(pr); \
     vec1 = _mm_load_ps(prWeight); \
     sum = _mm_add_ps(vec0, vec1); \
     _mm_store_ps(pr, sum); \
 }
 #define INPUT_MULTADD() \
-for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE) { \
+SHAPE_UNROLL for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE) { \
     vec0 = _mm_load_ps(pr); \
     vec1 = _mm_load_ps(prWeight); \
     vec3 = _mm_mul_ps(vec1, scalevec); \
@@ -282,7 +299,7 @@ for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE
 #endif
 #if defined(USE_AVX)
 #define INPUT_ADD() \
-for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE) { \
+SHAPE_UNROLL for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE) { \
     vec0 = _mm256_load_ps(pr); \
     vec1 = _mm256_load_ps(prWeight); \
     sum = _mm256_add_ps(vec0, vec1); \
@@ -290,7 +307,7 @@ for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE
 }
 #if defined(USE_FMA3)
 #define INPUT_MULTADD() \
-for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE) { \
+SHAPE_UNROLL for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE) { \
     vec0 = _mm256_load_ps(pr); \
     vec1 = _mm256_load_ps(prWeight); \
     sum = _mm256_fmadd_ps(vec1, scalevec, vec0); \
@@ -298,7 +315,7 @@ for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE
 }
 #else
 #define INPUT_MULTADD() \
-for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE) { \
+SHAPE_UNROLL for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE) { \
     vec0 = _mm256_load_ps(pr); \
     vec1 = _mm256_load_ps(prWeight); \
     vec3 = _mm256_mul_ps(vec1, scalevec); \
@@ -309,14 +326,14 @@ for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE
 #endif
 #if defined(USE_NEON)
 #define INPUT_ADD() \
-for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE) { \
+SHAPE_UNROLL for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE) { \
     vec0 = vld1q_f32(pr); \
     vec1 = vld1q_f32(prWeight); \
     sum = vaddq_f32(vec0, vec1); \
     vst1q_f32(pr, sum); \
 }
 #define INPUT_MULTADD() \
-for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE) { \
+SHAPE_UNROLL for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE) { \
     vec0 = vld1q_f32(pr); \
     vec1 = vld1q_f32(prWeight); \
     vec3 = vmulq_f32(vec1, scalevec); \
@@ -325,246 +342,40 @@ for (j = (cHidden >> LOG2VEC_SIZE); j; j--, pr += VEC_SIZE, prWeight += VEC_SIZE
 }
 #endif
 
+/* Nets of any shape: the trip counts are only known at run time */
+#define EVALUATE_SHAPE_NAME EvaluateShape
+#define SHAPE_UNROLL
+#include "neuralnetsse_kernel.h"
+#undef SHAPE_UNROLL
+#undef EVALUATE_SHAPE_NAME
+
+/* Known shapes: the loops over the hidden nodes are unrolled completely */
+#define EVALUATE_SHAPE_NAME EvaluateShapeUnrolled
+#define SHAPE_UNROLL UNROLL
+#include "neuralnetsse_kernel.h"
+#undef SHAPE_UNROLL
+#undef EVALUATE_SHAPE_NAME
+
+/* Nets of any shape */
 static void
 EvaluateSSE(const neuralnet * restrict pnn, const float arInput[], float ar[], float arOutput[])
 {
-    const unsigned int cHidden = pnn->cHidden;
-    unsigned int i, j;
-    float *prWeight;
-#if defined(USE_SSE2) || defined(USE_AVX) || defined(USE_NEON)
-    float *par;
-#if defined(USE_FMA3)
-    float_vector vec0, vec1, scalevec, sum;
-#else
-    float_vector vec0, vec1, vec3, scalevec, sum;
-#endif
-#endif
-
-    /* Calculate activity at hidden nodes */
-    memcpy(ar, pnn->arHiddenThreshold, cHidden * sizeof(float));
-
-    prWeight = pnn->arHiddenWeight;
-
-    if (pnn->cInput != 214) {   /* everything but the racing net */
-        for (i = 0; i < 200;) { /* base inputs */
-            float ari = arInput[i++];
-
-            /* 3 binaries, 1 float */
-
-            if (likely(ari == 0.0f))
-                prWeight += cHidden;
-            else {
-                float *pr = ar;
-                INPUT_ADD();
-            }
-
-            ari = arInput[i++];
-
-            if (likely(ari == 0.0f))
-                prWeight += cHidden;
-            else {
-                float *pr = ar;
-                INPUT_ADD();
-            }
-
-            ari = arInput[i++];
-
-            if (likely(ari == 0.0f)) {
-                prWeight += cHidden;
-                /* If 3rd element is 0, so is 4th. Skip it */
-                prWeight += cHidden;
-                i++;
-                continue;
-            } else {
-                float *pr = ar;
-                INPUT_ADD();
-            }
-
-            ari = arInput[i++];
-
-            if (likely(ari == 0.0f))
-                prWeight += cHidden;
-            else {
-                float *pr = ar;
-
-#if defined(USE_FMA3)
-                scalevec = _mm256_set1_ps(ari);
-                INPUT_MULTADD();
-#elif defined(USE_NEON)
-                scalevec = vdupq_n_f32(ari);
-                INPUT_MULTADD();
-#else
-                if (unlikely(ari == 1.0f)) {
-                    INPUT_ADD();
-                } else {
-#if defined(USE_AVX)
-                    scalevec = _mm256_set1_ps(ari);
-#elif defined(HAVE_SSE)
-                    scalevec = _mm_set1_ps(ari);
-#endif
-                    INPUT_MULTADD();
-                }
-#endif
-            }                   /* base inputs are done */
-        }
-
-        if (pnn->cInput == 250) /* Pruning nets are over, contact/crashed still have 2 * 25 floats */
-            for (i = 200; i < 250; i++) {
-                float const ari = arInput[i];
-
-                if (unlikely(ari == 0.0f))
-                    prWeight += cHidden;
-                else {
-                    float *pr = ar;
-
-#if defined(USE_AVX)
-                    scalevec = _mm256_set1_ps(ari);
-#elif defined(HAVE_SSE)
-                    scalevec = _mm_set1_ps(ari);
-#else
-                    scalevec = vdupq_n_f32(ari);
-#endif
-                    INPUT_MULTADD();
-                }
-            }
-    }
-
-    else                        /* racing net */
-        for (i = 0; i < pnn->cInput; i++) {
-            float const ari = arInput[i];
-
-            if (likely(ari == 0.0f))
-                prWeight += cHidden;
-            else {
-                float *pr = ar;
-#if defined(USE_FMA3)
-                scalevec = _mm256_set1_ps(ari);
-                INPUT_MULTADD();
-#elif defined(USE_NEON)
-                scalevec = vdupq_n_f32(ari);
-                INPUT_MULTADD();
-#else
-                if (likely(ari == 1.0f)) {
-                    INPUT_ADD();
-                } else {
-#if defined(USE_AVX)
-                    scalevec = _mm256_set1_ps(ari);
-#elif defined(HAVE_SSE)
-                    scalevec = _mm_set1_ps(ari);
-#endif
-                    INPUT_MULTADD();
-                }
-#endif
-            }
-        }
-
-#if defined(USE_SSE2) || defined(USE_AVX) || defined(USE_NEON)
-#if defined(USE_AVX)
-    scalevec = _mm256_set1_ps(pnn->rBetaHidden);
-#elif defined(HAVE_SSE)
-    scalevec = _mm_set1_ps(pnn->rBetaHidden);
-#else
-    scalevec = vdupq_n_f32(pnn->rBetaHidden);
-#endif
-
-    for (par = ar, i = (cHidden >> LOG2VEC_SIZE); i; i--, par += VEC_SIZE) {
-#if defined(USE_AVX)
-        float_vector vec = _mm256_load_ps(par);
-        vec = _mm256_mul_ps(vec, scalevec);
-        vec = sigmoid_ps(vec);
-        _mm256_store_ps(par, vec);
-#elif defined(HAVE_SSE)
-        float_vector vec = _mm_load_ps(par);
-        vec = _mm_mul_ps(vec, scalevec);
-        vec = sigmoid_ps(vec);
-        _mm_store_ps(par, vec);
-#else
-        float_vector vec = vld1q_f32(par);
-        vec = vmulq_f32(vec, scalevec);
-        vec = sigmoid_ps(vec);
-        vst1q_f32(par, vec);
-#endif
-    }
-#else
-    for (i = 0; i < cHidden; i++)
-        ar[i] = sigmoid(-pnn->rBetaHidden * ar[i]);
-#endif
-
-    /* Calculate activity at output nodes */
-    prWeight = pnn->arOutputWeight;
-
-    for (i = 0; i < pnn->cOutput; i++) {
-
-#if defined(USE_AVX)
-        SSE_ALIGN(float r[8]);
-#else
-        float r;
-#endif
-        float *pr = ar;
-#if defined(USE_AVX)
-        sum = _mm256_setzero_ps();
-#elif defined(HAVE_SSE)
-        sum = _mm_setzero_ps();
-#else
-        sum = vdupq_n_f32(0.0f);
-#endif
-        for (j = (cHidden >> LOG2VEC_SIZE); j; j--, prWeight += VEC_SIZE, pr += VEC_SIZE) {
-#if defined(USE_AVX)
-            vec0 = _mm256_load_ps(pr);  /* Eight floats into vec0 */
-            vec1 = _mm256_load_ps(prWeight);    /* Eight weights into vec1 */
-#if defined(USE_FMA3)
-            sum = _mm256_fmadd_ps(vec0, vec1, sum);
-#else
-            vec3 = _mm256_mul_ps(vec0, vec1);   /* Multiply */
-            sum = _mm256_add_ps(sum, vec3);     /* Add */
-#endif
-#elif defined(HAVE_SSE)
-            vec0 = _mm_load_ps(pr);     /* Four floats into vec0 */
-            vec1 = _mm_load_ps(prWeight);       /* Four weights into vec1 */
-            vec3 = _mm_mul_ps(vec0, vec1);      /* Multiply */
-            sum = _mm_add_ps(sum, vec3);        /* Add */
-#else
-            vec0 = vld1q_f32(pr);     /* Four floats into vec0 */
-            vec1 = vld1q_f32(prWeight);       /* Four weights into vec1 */
-            vec3 = vmulq_f32(vec0, vec1);      /* Multiply */
-            sum = vaddq_f32(sum, vec3);        /* Add */
-#endif
-        }
-
-#if defined(USE_AVX)
-        vec0 = _mm256_hadd_ps(sum, sum);
-        vec1 = _mm256_hadd_ps(vec0, vec0);
-        _mm256_store_ps(r, vec1);
-
-        arOutput[i] = sigmoid(-pnn->rBetaOutput * (r[0] + r[4] + pnn->arOutputThreshold[i]));
-#elif defined(HAVE_SSE)
-        vec0 = _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1));
-        vec1 = _mm_add_ps(sum, vec0);
-        vec0 = _mm_shuffle_ps(vec1, vec1, _MM_SHUFFLE(1, 1, 3, 3));
-        sum = _mm_add_ps(vec1, vec0);
-        _mm_store_ss(&r, sum);
-
-        arOutput[i] = sigmoid(-pnn->rBetaOutput * (r + pnn->arOutputThreshold[i]));
-
-#else
-       {
-       float32x2_t vec0_h, vec0_l, vec1;
-
-       vec0_h = vget_high_f32(sum);
-       vec0_l = vget_low_f32(sum);
-       vec1 = vpadd_f32(vec0_h, vec0_l);
-       vec1 = vpadd_f32(vec1, vec1);
-       vst1_lane_f32(&r, vec1, 0);
+    EvaluateShape(pnn, arInput, ar, arOutput, pnn->cInput, pnn->cHidden, pnn->cOutput);
+}
 
-       arOutput[i] = sigmoid(-pnn->rBetaOutput * (r + pnn->arOutputThreshold[i]));
-       }
-#endif
-    }
-#if defined(USE_AVX)
-    _mm256_zeroupper();
-#endif
+/* The shapes of the nets in gnubg.weights */
+#define EVALUATE_SHAPE(in, hidden, out) \
+static void \
+EvaluateSSE_##in##_##hidden##_##out(const neuralnet * restrict pnn, const float arInput[], float ar[], float arOutput[]) \
+{ \
+    EvaluateShapeUnrolled(pnn, arInput, ar, arOutput, in, hidden, out); \
 }
 
+EVALUATE_SHAPE(250, 128, 5)     /* contact and crashed */
+EVALUATE_SHAPE(214, 128, 5)     /* race */
+EVALUATE_SHAPE(200, 16, 5)      /* contact and crashed pruning */
+EVALUATE_SHAPE(200, 8, 5)       /* race pruning */
+
 
 extern int
 NeuralNetEvaluateSSE(const neuralnet * restrict pnn, /*lint -e{818} */ float arInput[],
@@ -578,7 +389,17 @@ NeuralNetEvaluateSSE(const neuralnet * restrict pnn, /*lint -e{818} */ float arI
     g_assert(sse_aligned(arInput));
 #endif
 
-    EvaluateSSE(pnn, arInput, ar, arOutput);
+    if (pnn->cOutput == 5 && pnn->cHidden == 128 && pnn->cInput == 250)
+        EvaluateSSE_250_128_5(pnn, arInput, ar, arOutput);
+    else if (pnn->cOutput == 5 && pnn->cHidden == 128 && pnn->cInput == 214)
+        EvaluateSSE_214_128_5(pnn, arInput, ar, arOutput);
+    else if (pnn->cOutput == 5 && pnn->cHidden == 16 && pnn->cInput == 200)
+        EvaluateSSE_200_16_5(pnn, arInput, ar, arOutput);
+    else if (pnn->cOutput == 5 && pnn->cHidden == 8 && pnn->cInput == 200)
+        EvaluateSSE_200_8_5(pnn, arInput, ar, arOutput);
+    else
+        EvaluateSSE(pnn, arInput, ar, arOutput);
+
     return 0;
 }
 
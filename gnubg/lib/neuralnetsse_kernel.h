@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 2006-2009 Jon Kinsey <jonkinsey@gmail.com>
+ * Copyright (C) 2007-2021 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+/*
+ * The kernel proper, included twice by neuralnetsse.c: once as the
+ * kernel for nets of any shape and once as the kernel for the shapes
+ * known at compile time. EVALUATE_SHAPE_NAME names the function and
+ * SHAPE_UNROLL is the pragma put before the loops over the hidden nodes.
+ *
+ * cInput, cHidden and cOutput are passed separately from pnn so that the
+ * kernels for known shapes get them as constants, with the trip counts
+ * folded away.
+ */
+
+static ALWAYS_INLINE void
+EVALUATE_SHAPE_NAME(const neuralnet * restrict pnn, const float arInput[], float ar[], float arOutput[],
+                    const unsigned int cInput, const unsigned int cHidden, const unsigned int cOutput)
+{
+    unsigned int i, j;
+    float *prWeight;
+#if defined(USE_SSE2) || defined(USE_AVX) || defined(USE_NEON)
+    float *par;
+#if defined(USE_FMA3)
+    float_vector vec0, vec1, scalevec, sum;
+#else
+    float_vector vec0, vec1, vec3, scalevec, sum;
+#endif
+#endif
+
+    /* Calculate activity at hidden nodes */
+    memcpy(ar, pnn->arHiddenThreshold, cHidden * sizeof(float));
+
+    prWeight = pnn->arHiddenWeight;
+
+    if (cInput != 214) {        /* everything but the racing net */
+        for (i = 0; i < 200;) { /* base inputs */
+            float ari = arInput[i++];
+
+            /* 3 binaries, 1 float */
+
+            if (likely(ari == 0.0f))
+                prWeight += cHidden;
+            else {
+                float *pr = ar;
+                INPUT_ADD();
+            }
+
+            ari = arInput[i++];
+
+            if (likely(ari == 0.0f))
+                prWeight += cHidden;
+            else {
+                float *pr = ar;
+                INPUT_ADD();
+            }
+
+            ari = arInput[i++];
+
+            if (likely(ari == 0.0f)) {
+                prWeight += cHidden;
+                /* If 3rd element is 0, so is 4th. Skip it */
+                prWeight += cHidden;
+                i++;
+                continue;
+            } else {
+                float *pr = ar;
+                INPUT_ADD();
+            }
+
+            ari = arInput[i++];
+
+            if (likely(ari == 0.0f))
+                prWeight += cHidden;
+            else {
+                float *pr = ar;
+
+#if defined(USE_FMA3)
+                scalevec = _mm256_set1_ps(ari);
+                INPUT_MULTADD();
+#elif defined(USE_NEON)
+                scalevec = vdupq_n_f32(ari);
+                INPUT_MULTADD();
+#else
+                if (unlikely(ari == 1.0f)) {
+                    INPUT_ADD();
+                } else {
+#if defined(USE_AVX)
+                    scalevec = _mm256_set1_ps(ari);
+#elif defined(HAVE_SSE)
+                    scalevec = _mm_set1_ps(ari);
+#endif
+                    INPUT_MULTADD();
+                }
+#endif
+            }                   /* base inputs are done */
+        }
+
+        if (cInput == 250)      /* Pruning nets are over, contact/crashed still have 2 * 25 floats */
+            for (i = 200; i < 250; i++) {
+                float const ari = arInput[i];
+
+                if (unlikely(ari == 0.0f))
+                    prWeight += cHidden;
+                else {
+                    float *pr = ar;
+
+#if defined(USE_AVX)
+                    scalevec = _mm256_set1_ps(ari);
+#elif defined(HAVE_SSE)
+                    scalevec = _mm_set1_ps(ari);
+#else
+                    scalevec = vdupq_n_f32(ari);
+#endif
+                    INPUT_MULTADD();
+                }
+            }
+    }
+
+    else                        /* racing net */
+        for (i = 0; i < cInput; i++) {
+            float const ari = arInput[i];
+
+            if (likely(ari == 0.0f))
+                prWeight += cHidden;
+            else {
+                float *pr = ar;
+#if defined(USE_FMA3)
+                scalevec = _mm256_set1_ps(ari);
+                INPUT_MULTADD();
+#elif defined(USE_NEON)
+                scalevec = vdupq_n_f32(ari);
+                INPUT_MULTADD();
+#else
+                if (likely(ari == 1.0f)) {
+                    INPUT_ADD();
+                } else {
+#if defined(USE_AVX)
+                    scalevec = _mm256_set1_ps(ari);
+#elif defined(HAVE_SSE)
+                    scalevec = _mm_set1_ps(ari);
+#endif
+                    INPUT_MULTADD();
+                }
+#endif
+            }
+        }
+
+#if defined(USE_SSE2) || defined(USE_AVX) || defined(USE_NEON)
+#if defined(USE_AVX)
+    scalevec = _mm256_set1_ps(pnn->rBetaHidden);
+#elif defined(HAVE_SSE)
+    scalevec = _mm_set1_ps(pnn->rBetaHidden);
+#else
+    scalevec = vdupq_n_f32(pnn->rBetaHidden);
+#endif
+
+    SHAPE_UNROLL for (par = ar, i = (cHidden >> LOG2VEC_SIZE); i; i--, par += VEC_SIZE) {
+#if defined(USE_AVX)
+        float_vector vec = _mm256_load_ps(par);
+        vec = _mm256_mul_ps(vec, scalevec);
+        vec = sigmoid_ps(vec);
+        _mm256_store_ps(par, vec);
+#elif defined(HAVE_SSE)
+        float_vector vec = _mm_load_ps(par);
+        vec = _mm_mul_ps(vec, scalevec);
+        vec = sigmoid_ps(vec);
+        _mm_store_ps(par, vec);
+#else
+        float_vector vec = vld1q_f32(par);
+        vec = vmulq_f32(vec, scalevec);
+        vec = sigmoid_ps(vec);
+        vst1q_f32(par, vec);
+#endif
+    }
+#else
+    for (i = 0; i < cHidden; i++)
+        ar[i] = sigmoid(-pnn->rBetaHidden * ar[i]);
+#endif
+
+    /* Calculate activity at output nodes */
+    prWeight = pnn->arOutputWeight;
+
+    for (i = 0; i < cOutput; i++) {
+
+#if defined(USE_AVX)
+        SSE_ALIGN(float r[8]);
+#else
+        float r;
+#endif
+        float *pr = ar;
+#if defined(USE_AVX)
+        sum = _mm256_setzero_ps();
+#elif defined(HAVE_SSE)
+        sum = _mm_setzero_ps();
+#else
+        sum = vdupq_n_f32(0.0f);
+#endif
+        SHAPE_UNROLL for (j = (cHidden >> LOG2VEC_SIZE); j; j--, prWeight += VEC_SIZE, pr += VEC_SIZE) {
+#if defined(USE_AVX)
+            vec0 = _mm256_load_ps(pr);  /* Eight floats into vec0 */
+            vec1 = _mm256_load_ps(prWeight);    /* Eight weights into vec1 */
+#if defined(USE_FMA3)
+            sum = _mm256_fmadd_ps(vec0, vec1, sum);
+#else
+            vec3 = _mm256_mul_ps(vec0, vec1);   /* Multiply */
+            sum = _mm256_add_ps(sum, vec3);     /* Add */
+#endif
+#elif defined(HAVE_SSE)
+            vec0 = _mm_load_ps(pr);     /* Four floats into vec0 */
+            vec1 = _mm_load_ps(prWeight);       /* Four weights into vec1 */
+            vec3 = _mm_mul_ps(vec0, vec1);      /* Multiply */
+            sum = _mm_add_ps(sum, vec3);        /* Add */
+#else
+            vec0 = vld1q_f32(pr);     /* Four floats into vec0 */
+            vec1 = vld1q_f32(prWeight);       /* Four weights into vec1 */
+            vec3 = vmulq_f32(vec0, vec1);      /* Multiply */
+            sum = vaddq_f32(sum, vec3);        /* Add */
+#endif
+        }
+
+#if defined(USE_AVX)
+        vec0 = _mm256_hadd_ps(sum, sum);
+        vec1 = _mm256_hadd_ps(vec0, vec0);
+        _mm256_store_ps(r, vec1);
+
+        arOutput[i] = sigmoid(-pnn->rBetaOutput * (r[0] + r[4] + pnn->arOutputThreshold[i]));
+#elif defined(HAVE_SSE)
+        vec0 = _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1));
+        vec1 = _mm_add_ps(sum, vec0);
+        vec0 = _mm_shuffle_ps(vec1, vec1, _MM_SHUFFLE(1, 1, 3, 3));
+        sum = _mm_add_ps(vec1, vec0);
+        _mm_store_ss(&r, sum);
+
+        arOutput[i] = sigmoid(-pnn->rBetaOutput * (r + pnn->arOutputThreshold[i]));
+
+#else
+       {
+       float32x2_t vec0_h, vec0_l, vec1;
+
+       vec0_h = vget_high_f32(sum);
+       vec0_l = vget_low_f32(sum);
+       vec1 = vpadd_f32(vec0_h, vec0_l);
+       vec1 = vpadd_f32(vec1, vec1);
+       vst1_lane_f32(&r, vec1, 0);
+
+       arOutput[i] = sigmoid(-pnn->rBetaOutput * (r + pnn->arOutputThreshold[i]));
+       }
+#endif
+    }
+#if defined(USE_AVX)
+    _mm256_zeroupper();
+#endif
+}
@@ -32,7 +32,8 @@
 static void
 usage(char *prog)
 {
-    g_printerr(_("Usage: %s [[-f] outputfile [inputfile]]\n"
+    g_printerr(_("Usage: %s [-m] [[-f] outputfile [inputfile]]\n"
+            "  -m: Write weights that can be mapped into memory\n"
             "  outputfile: Output to file instead of stdout\n"
             "  inputfile: Input from file instead of stdin\n"), prog);
     exit(1);
@@ -43,8 +44,9 @@ main(int argc, /*lint -e{818} */ char *argv[])
 {
     neuralnet nn;
     char szFileVersion[16];
-    static float ar[2] = { WEIGHTS_MAGIC_BINARY, WEIGHTS_VERSION_BINARY };
-    int c;
+    static float ar[NN_MAPPED_ALIGN / sizeof(float)] = { WEIGHTS_MAGIC_BINARY, WEIGHTS_VERSION_BINARY };
+    int c, fMapped = FALSE;
+    size_t cHeader = 2;
     FILE *in = stdin, *out = stdout;
 
     if (!setlocale(LC_ALL, "C") || !bindtextdomain(PACKAGE, LOCALEDIR) || !textdomain(PACKAGE)) {
@@ -54,6 +56,16 @@ main(int argc, /*lint -e{818} */ char *argv[])
 
     g_set_printerr_handler(print_utf8_to_locale);
 
+    if (argc > 1 && !StrCaseCmp(argv[1], "-m")) {
+        /* header padded so that the nets are aligned */
+        fMapped = TRUE;
+        ar[0] = WEIGHTS_MAGIC_MAPPED;
+        cHeader = G_N_ELEMENTS(ar);
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+
     if (argc > 1) {
         int arg = 1;
         if (!StrCaseCmp(argv[1], "-f"))
@@ -91,7 +103,7 @@ main(int argc, /*lint -e{818} */ char *argv[])
         return EXIT_FAILURE;
     }
 
-    if (fwrite(ar, sizeof(ar[0]), 2, out) != 2) {
+    if (fwrite(ar, sizeof(ar[0]), cHeader, out) != cHeader) {
         g_printerr(_("Failed to write neural net!"));
         fclose(in);
         fclose(out);
@@ -105,7 +117,7 @@ main(int argc, /*lint -e{818} */ char *argv[])
             fclose(out);
             return EXIT_FAILURE;
         }
-        if (NeuralNetSaveBinary(&nn, out) == -1) {
+        if ((fMapped ? NeuralNetSaveMapped(&nn, out) : NeuralNetSaveBinary(&nn, out)) == -1) {
             g_printerr(_("Failed to save neural net!"));
             fclose(in);
             fclose(out);
@@ -375,6 +375,80 @@ initMETZadeh(float aafMET[MAXSCORE][MAXSCORE],
 
 }
 
+/*
+ * getMEMultiple() results at every score, Crawford flag and cube
+ * level, with the cube prime values GetPoints() uses. The first
+ * DTLB + 1 entries don't depend on the primes, so the Cl2CfMatch*()
+ * functions share them. The results only depend on the away scores,
+ * so one block per pair of away scores serves every match length.
+ *
+ * A block is built the first time its score is seen, by whichever
+ * thread needs it first, and published atomically. The blocks are
+ * dropped whenever the MET changes, which only happens from commands
+ * run while no evaluation is going on.
+ */
+
+typedef struct {
+    metresults aamr[2][MAXCUBELEVEL];
+} metmemo;
+
+static metmemo *aapMETMemo[MAXSCORE][MAXSCORE];
+
+unsigned int cMETChanges = 0;
+
+static void
+ClearMETMemo(void)
+{
+    int i, j;
+
+    cMETChanges++;
+
+    for (i = 0; i < MAXSCORE; i++)
+        for (j = 0; j < MAXSCORE; j++) {
+            g_free(aapMETMemo[i][j]);
+            aapMETMemo[i][j] = NULL;
+        }
+}
+
+extern const metresults *
+getMEMemo(const int nScore0, const int nScore1, const int nMatchTo,
+          const int nCube, const int fCrawford, metresults * pmrBuf)
+{
+    int i = nMatchTo - nScore0 - 1;
+    int j = nMatchTo - nScore1 - 1;
+    int n, k, f, nCubeValue;
+    metmemo *pmm;
+
+    for (n = 0; n < MAXCUBELEVEL && (1 << n) < nCube; n++);
+
+    if (i < 0 || j < 0 || i >= MAXSCORE || j >= MAXSCORE || n == MAXCUBELEVEL || (1 << n) != nCube) {
+        /* not worth keeping */
+        getMEMultiple(nScore0, nScore1, nMatchTo, nCube,
+                      GetCubePrimeValue(i, j, nCube), GetCubePrimeValue(j, i, nCube),
+                      fCrawford, aafMET, aafMETPostCrawford, pmrBuf->aar[0], pmrBuf->aar[1]);
+        return pmrBuf;
+    }
+
+    pmm = g_atomic_pointer_get((gpointer *) & aapMETMemo[i][j]);
+
+    if (!pmm) {
+        pmm = g_new(metmemo, 1);
+        for (f = 0; f < 2; f++)
+            for (k = 0, nCubeValue = 1; k < MAXCUBELEVEL; k++, nCubeValue *= 2)
+                getMEMultiple(nScore0, nScore1, nMatchTo, nCubeValue,
+                              GetCubePrimeValue(i, j, nCubeValue), GetCubePrimeValue(j, i, nCubeValue),
+                              f, aafMET, aafMETPostCrawford, pmm->aamr[f][k].aar[0], pmm->aamr[f][k].aar[1]);
+
+        if (!g_atomic_pointer_compare_and_exchange((gpointer *) & aapMETMemo[i][j], NULL, pmm)) {
+            /* another thread was faster */
+            g_free(pmm);
+            pmm = g_atomic_pointer_get((gpointer *) & aapMETMemo[i][j]);
+        }
+    }
+
+    return &pmm->aamr[fCrawford ? 1 : 0][n];
+}
+
 extern int
 GetPoints(float arOutput[5], const cubeinfo * pci, float arCP[2])
 {
@@ -413,7 +487,8 @@ GetPoints(float arOutput[5], const cubeinfo * pci, float arCP[2])
     int nDead, n, nMax, nCubeValue, k;
 
 
-    float aarMETResults[2][DTLBP1 + 1];
+    metresults mr;
+    const float (*aarMETResults)[DTLBP1 + 1];
 
     /* Gammon and backgammon ratio's. 
      * Avoid division by zero in extreme cases. */
@@ -481,9 +556,8 @@ GetPoints(float arOutput[5], const cubeinfo * pci, float arCP[2])
 
         /* Dead cube cash point for player 0 */
 
-        getMEMultiple(pci->anScore[0], pci->anScore[1], pci->nMatchTo, nCubeValue, GetCubePrimeValue(i, j, nCubeValue), /* 0 */
-                      GetCubePrimeValue(j, i, nCubeValue),      /* 1 */
-                      pci->fCrawford, aafMET, aafMETPostCrawford, aarMETResults[0], aarMETResults[1]);
+        aarMETResults = getMEMemo(pci->anScore[0], pci->anScore[1], pci->nMatchTo,
+                                  nCubeValue, pci->fCrawford, &mr)->aar;
 
         for (k = 0; k < 2; k++) {
 
@@ -1581,6 +1655,7 @@ InitMatchEquity(const char *szFileName)
     memcpy(&miCurrent, &md.mi, sizeof(metinfo));
 
     /* initialise gammon prices */
+    ClearMETMemo();
     calcGammonPrices(aafMET, aafMETPostCrawford, aaaafGammonPrices, aaaafGammonPricesPostCrawford);
 }
 
@@ -1711,6 +1786,7 @@ invertMET(void)
         }
     }
 
+    ClearMETMemo();
     calcGammonPrices(aafMET, aafMETPostCrawford, aaaafGammonPrices, aaaafGammonPricesPostCrawford);
 }
 
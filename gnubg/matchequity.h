@@ -111,4 +111,18 @@ getMEMultiple(const int nScore0, const int nScore1, const int nMatchTo,
               const int fCrawford,
               float aafMET[MAXSCORE][MAXSCORE], float aafMETPostCrawford[2][MAXSCORE], float *player0, float *player1);
 
+typedef struct {
+    float aar[2][DTLBP1 + 1];
+} metresults;
+
+/* getMEMultiple() for the current MET with the cube prime values of
+ * GetPoints(), looked up in a table built as scores are met. Returns
+ * pmrBuf, filled in, for scores or cubes outside the table. */
+extern const metresults *getMEMemo(const int nScore0, const int nScore1, const int nMatchTo,
+                                   const int nCube, const int fCrawford, metresults * pmrBuf);
+
+/* Counts the changes of the current MET, so that results computed with
+ * an earlier one can be recognised */
+extern unsigned int cMETChanges;
+
 #endif
@@ -57,6 +57,8 @@ MT_CreateThreadLocalData(int id)
 
     tld->aMoves = (move *) g_malloc(sizeof(move) * MAX_INCOMPLETE_MOVES);
     memset(tld->aMoves, 0, sizeof(move) * MAX_INCOMPLETE_MOVES);
+    tld->prm = NULL;
+    tld->cCommands = 0;
     return tld;
 }
 
@@ -72,9 +74,27 @@ static GMutex condMutex;        /* Extra mutex needed for waiting */
 static GMutex *condMutex = NULL;        /* Extra mutex needed for waiting */
 #endif
 
+static void
+FreeThreadLocalData(gpointer p)
+{
+    ThreadLocalData *pTLD = (ThreadLocalData *) p;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        g_free(pTLD->pnnState[i].savedBase);
+        g_free(pTLD->pnnState[i].savedIBase);
+    }
+    g_free(pTLD->pnnState);
+    g_free(pTLD->aMoves);
+    g_free(pTLD->prm);
+    g_free(pTLD);
+}
+
 #if GLIB_CHECK_VERSION (2,32,0)
 /* Dynamic allocation of GPrivate is deprecated */
 static GPrivate private_item = G_PRIVATE_INIT(free);
+static GPrivate attached_item = G_PRIVATE_INIT(FreeThreadLocalData);
+#define pAttachedItem (&attached_item)
 
 extern void
 TLSCreate(TLSItem * pItem)
@@ -82,6 +102,8 @@ TLSCreate(TLSItem * pItem)
     *pItem = &private_item;
 }
 #else
+static GPrivate *pAttachedItem = NULL;
+
 extern void
 TLSCreate(TLSItem * pItem)
 {
@@ -89,6 +111,23 @@ TLSCreate(TLSItem * pItem)
 }
 #endif
 
+/* Threads we didn't create, such as Python threads evaluating
+ * positions, get their own thread local data the first time they
+ * evaluate. It is freed when the thread exits. */
+
+extern void
+MT_AttachThread(void)
+{
+    ThreadLocalData *pTLD;
+
+    if (g_private_get(td.tlsItem))
+        return;
+
+    pTLD = MT_CreateThreadLocalData(-2);
+    g_private_set(pAttachedItem, pTLD);
+    TLSSetValue(td.tlsItem, (size_t) pTLD);
+}
+
 extern void
 TLSSetValue(TLSItem pItem, size_t value)
 {
@@ -263,6 +302,9 @@ MT_InitThreads(void)
     InitManualEvent(&td.activity);
     TLSCreate(&td.tlsItem);
     TLSSetValue(td.tlsItem, (size_t) MT_CreateThreadLocalData(-1));
+#if !GLIB_CHECK_VERSION (2,32,0)
+    pAttachedItem = g_private_new(FreeThreadLocalData);
+#endif
 
 #if defined(DEBUG_MULTITHREADED) && defined(WIN32)
     mainThreadID = GetCurrentThreadId();
@@ -289,6 +331,7 @@ CloseThread(void *UNUSED(unused))
     ThreadLocalData *pTLD = (ThreadLocalData *) TLSGet(td.tlsItem);
     if (pTLD->aMoves)
         free(pTLD->aMoves);
+    g_free(pTLD->prm);
 
     for (i = 0; i < 3; i++) {
         free(pnnState[i].savedBase);
@@ -396,6 +439,7 @@ MT_Close(void)
         return;
 
     g_free(td.tld->aMoves);
+    g_free(td.tld->prm);
     pnnState = td.tld->pnnState;
     for (i = 0; i < 3; i++) {
         g_free(pnnState[i].savedBase);
@@ -32,6 +32,7 @@
 #endif
 
 #include "multithread.h"
+#include "ponder.h"
 #include "rollout.h"
 #include "util.h"
 #include "lib/simd.h"
@@ -202,6 +203,7 @@ MT_SetNumThreads(unsigned int num)
         if (num == 1) {         /* No locking in evals */
             EvaluatePosition = EvaluatePositionNoLocking;
             GeneralCubeDecisionE = GeneralCubeDecisionENoLocking;
+            GeneralCubeDecisionsE = GeneralCubeDecisionsENoLocking;
             GeneralEvaluationE = GeneralEvaluationENoLocking;
             ScoreMove = ScoreMoveNoLocking;
             FindBestMove = FindBestMoveNoLocking;
@@ -210,6 +212,7 @@ MT_SetNumThreads(unsigned int num)
         } else {                /* Locking version of evals */
             EvaluatePosition = EvaluatePositionWithLocking;
             GeneralCubeDecisionE = GeneralCubeDecisionEWithLocking;
+            GeneralCubeDecisionsE = GeneralCubeDecisionsEWithLocking;
             GeneralEvaluationE = GeneralEvaluationEWithLocking;
             ScoreMove = ScoreMoveWithLocking;
             FindBestMove = FindBestMoveWithLocking;
@@ -258,6 +261,9 @@ extern void
 mt_add_tasks(unsigned int num_tasks, AsyncFun pFun, void *taskData, gpointer linked)
 {
     unsigned int i;
+
+    /* the threads are only lent to pondering while nothing else needs them */
+    PonderStop();
     {
 #if defined(DEBUG_MULTITHREADED)
         multi_debug("add %u task%s asks lock (queueLock)", num_tasks, (num_tasks > 1 ? "s" : ""));
@@ -443,8 +449,10 @@ MT_WaitForTasks(gboolean(*pCallback) (gpointer), int callbackTime, int autosave)
 
     multi_debug("waiting for all tasks");
 
-    pCallback(NULL);
-    cb_source = g_timeout_add(1000, pCallback, NULL);
+    if (pCallback) {
+        pCallback(NULL);
+        cb_source = g_timeout_add(1000, pCallback, NULL);
+    }
     if (autosave)
         as_source = g_timeout_add(nAutoSaveTime * 60000, save_autosave, NULL);
     for (member = g_list_first(td.tasks); member; member = member->next, MT_SafeInc(&td.doneTasks)) {
@@ -460,7 +468,8 @@ MT_WaitForTasks(gboolean(*pCallback) (gpointer), int callbackTime, int autosave)
         save_autosave(NULL);
     }
 
-    g_source_remove(cb_source);
+    if (cb_source)
+        g_source_remove(cb_source);
     td.tasks = NULL;
 
 #if defined(USE_GTK)
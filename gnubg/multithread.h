@@ -51,18 +51,23 @@ typedef struct Task {
     struct Task *pLinkedTask;
 } Task;
 
+typedef struct _moveluck moveluck;     /* see analysis.c */
+
 typedef struct {
     Task task;
     moverecord *pmr;
     listOLD *plGame;
     statcontext *psc;
     matchstate ms;
+    moveluck *pml;              /* the luck, if computed in a task of its own */
 } AnalyseMoveTask;
 
 typedef struct {
     int id;
     move *aMoves;
     NNState *pnnState;
+    struct _replymemo *prm;     /* FindnSaveBestMoves() replies, see eval.c */
+    int cCommands;              /* commands running on the thread, see gnubgmodule.c */
 } ThreadLocalData;
 
 typedef struct {
@@ -139,6 +144,7 @@ extern void FreeMutex(Mutex * mutex);
 extern void MT_Release(void);
 extern void MT_Exclusive(void);
 extern void MT_StartThreads(void);
+extern void MT_AttachThread(void);
 extern void MT_SetNumThreads(unsigned int num);
 extern void MT_SyncInit(void);
 extern void MT_SyncStart(void);
@@ -177,6 +183,7 @@ extern unsigned int MT_GetNumThreads(void);
 #endif
 extern int asyncRet;
 #define MT_Exclusive() {}
+#define MT_AttachThread() {}
 #define MT_Release() {}
 #define MT_GetNumThreads() 1
 #define MT_SetResultFailed() asyncRet = -1
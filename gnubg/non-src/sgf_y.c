@@ -92,6 +92,8 @@ extern char *stpcpy(char *s1, const char *s2);
 #endif
 
 static listOLD *plCollection;    
+static int ( *pfGameTree )( listOLD *, void * );
+static void *pvGameTree;
     
 extern int sgflex( void );
 
@@ -141,7 +143,7 @@ static char *Concatenate( listOLD *pl ) {
 }
 
 
-#line 145 "sgf_y.c"
+#line 147 "sgf_y.c"
 
 # ifndef YY_CAST
 #  ifdef __cplusplus
@@ -202,14 +204,14 @@ extern int sgfdebug;
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
 union YYSTYPE
 {
-#line 95 "sgf_y.y"
+#line 97 "sgf_y.y"
 
     char ach[ 2 ]; /* property identifier */
     char *pch; /* property value */
     property *pp; /* complete property */
     listOLD *pl; /* nodes, sequences, gametrees */
 
-#line 213 "sgf_y.c"
+#line 215 "sgf_y.c"
 
 };
 typedef union YYSTYPE YYSTYPE;
@@ -241,15 +243,16 @@ enum yysymbol_kind_t
   YYSYMBOL_9_ = 9,                         /* ']'  */
   YYSYMBOL_YYACCEPT = 10,                  /* $accept  */
   YYSYMBOL_Collection = 11,                /* Collection  */
-  YYSYMBOL_GameTreeSeq = 12,               /* GameTreeSeq  */
-  YYSYMBOL_GameTree = 13,                  /* GameTree  */
-  YYSYMBOL_Sequence = 14,                  /* Sequence  */
-  YYSYMBOL_Node = 15,                      /* Node  */
-  YYSYMBOL_PropertySeq = 16,               /* PropertySeq  */
-  YYSYMBOL_Property = 17,                  /* Property  */
-  YYSYMBOL_ValueSeq = 18,                  /* ValueSeq  */
-  YYSYMBOL_Value = 19,                     /* Value  */
-  YYSYMBOL_ValueCharSeq = 20               /* ValueCharSeq  */
+  YYSYMBOL_TopGameTreeSeq = 12,            /* TopGameTreeSeq  */
+  YYSYMBOL_GameTreeSeq = 13,               /* GameTreeSeq  */
+  YYSYMBOL_GameTree = 14,                  /* GameTree  */
+  YYSYMBOL_Sequence = 15,                  /* Sequence  */
+  YYSYMBOL_Node = 16,                      /* Node  */
+  YYSYMBOL_PropertySeq = 17,               /* PropertySeq  */
+  YYSYMBOL_Property = 18,                  /* Property  */
+  YYSYMBOL_ValueSeq = 19,                  /* ValueSeq  */
+  YYSYMBOL_Value = 20,                     /* Value  */
+  YYSYMBOL_ValueCharSeq = 21               /* ValueCharSeq  */
 };
 typedef enum yysymbol_kind_t yysymbol_kind_t;
 
@@ -577,16 +580,16 @@ union yyalloc
 /* YYFINAL -- State number of the termination state.  */
 #define YYFINAL  3
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   23
+#define YYLAST   26
 
 /* YYNTOKENS -- Number of terminals.  */
 #define YYNTOKENS  10
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  11
+#define YYNNTS  12
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  19
+#define YYNRULES  22
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  24
+#define YYNSTATES  26
 
 /* YYMAXUTOK -- Last valid token kind.  */
 #define YYMAXUTOK   259
@@ -635,8 +638,9 @@ static const yytype_int8 yytranslate[] =
 /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_uint8 yyrline[] =
 {
-       0,   112,   112,   117,   118,   120,   123,   127,   129,   131,
-     134,   139,   140,   144,   147,   156,   157,   161,   166,   167
+       0,   114,   114,   121,   122,   132,   136,   137,   139,   142,
+     146,   148,   150,   153,   158,   159,   163,   166,   175,   176,
+     180,   185,   186
 };
 #endif
 
@@ -654,8 +658,8 @@ static const char *const yytname[] =
 {
   "\"end of file\"", "error", "\"invalid token\"", "PROPERTY",
   "VALUETEXT", "'('", "')'", "';'", "'['", "']'", "$accept", "Collection",
-  "GameTreeSeq", "GameTree", "Sequence", "Node", "PropertySeq", "Property",
-  "ValueSeq", "Value", "ValueCharSeq", YY_NULLPTR
+  "TopGameTreeSeq", "GameTreeSeq", "GameTree", "Sequence", "Node",
+  "PropertySeq", "Property", "ValueSeq", "Value", "ValueCharSeq", YY_NULLPTR
 };
 
 static const char *
@@ -670,7 +674,7 @@ yysymbol_name (yysymbol_kind_t yysymbol)
 #define yypact_value_is_default(Yyn) \
   ((Yyn) == YYPACT_NINF)
 
-#define YYTABLE_NINF (-17)
+#define YYTABLE_NINF (-20)
 
 #define yytable_value_is_error(Yyn) \
   0
@@ -680,8 +684,8 @@ yysymbol_name (yysymbol_kind_t yysymbol)
 static const yytype_int8 yypact[] =
 {
       -2,     1,    10,    -2,    -2,     7,    -2,    -2,     2,    -2,
-      -1,    -2,    11,    -2,    -2,    -2,    -2,    -2,    12,    -2,
-      13,     9,    -2,    -2
+      -1,    -2,    11,    -2,    -2,    -2,    -2,    -2,    -2,    -2,
+      12,    -2,    13,     9,    -2,    -2
 };
 
 /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
@@ -689,23 +693,23 @@ static const yytype_int8 yypact[] =
    means the default is an error.  */
 static const yytype_int8 yydefact[] =
 {
-       3,     0,     0,     1,     5,     0,     4,    11,     0,     7,
-       0,     9,     0,     8,    13,    15,    12,     6,     0,    18,
-      14,     0,    19,    17
+       3,     0,     0,     1,     5,     0,     4,    14,     0,    10,
+       0,    12,     0,    11,    16,    18,    15,     8,     9,     7,
+       0,    21,    17,     0,    22,    20
 };
 
 /* YYPGOTO[NTERM-NUM].  */
 static const yytype_int8 yypgoto[] =
 {
-      -2,    -2,    14,    -2,    -2,    15,    -2,    -2,    -2,    -2,
-      -2
+      -2,    -2,    -2,    -2,    14,    -2,    15,    -2,    -2,    -2,
+      -2,    -2
 };
 
 /* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int8 yydefgoto[] =
 {
-       0,     1,     2,     6,     8,     9,    10,    16,    18,    20,
-      21
+       0,     1,     2,    12,     6,     8,     9,    10,    16,    20,
+      22,    23
 };
 
 /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
@@ -713,39 +717,41 @@ static const yytype_int8 yydefgoto[] =
    number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_int8 yytable[] =
 {
-      14,     3,    15,    11,   -10,   -10,   -10,    -3,    -3,     7,
-      -2,     4,     4,    22,     7,     5,     5,    17,    23,     0,
-      19,   -16,    12,    13
+      14,     3,    15,    11,   -13,   -13,   -13,    -6,    -6,     7,
+      -2,     4,    17,    24,     7,     5,     5,    18,    25,     0,
+      21,   -19,     0,    13,     0,     0,    19
 };
 
 static const yytype_int8 yycheck[] =
 {
        1,     0,     3,     1,     5,     6,     7,     5,     6,     7,
        0,     1,     1,     4,     7,     5,     5,     6,     9,    -1,
-       8,     8,     8,     8
+       8,     8,    -1,     8,    -1,    -1,    12
 };
 
 /* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
    state STATE-NUM.  */
 static const yytype_int8 yystos[] =
 {
-       0,    11,    12,     0,     1,     5,    13,     7,    14,    15,
-      16,     1,    12,    15,     1,     3,    17,     6,    18,     8,
-      19,    20,     4,     9
+       0,    11,    12,     0,     1,     5,    14,     7,    15,    16,
+      17,     1,    13,    16,     1,     3,    18,     1,     6,    14,
+      19,     8,    20,    21,     4,     9
 };
 
 /* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr1[] =
 {
-       0,    10,    11,    12,    12,    12,    13,    14,    14,    14,
-      15,    16,    16,    16,    17,    18,    18,    19,    20,    20
+       0,    10,    11,    12,    12,    12,    13,    13,    13,    14,
+      15,    15,    15,    16,    17,    17,    17,    18,    19,    19,
+      20,    21,    21
 };
 
 /* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr2[] =
 {
-       0,     2,     1,     0,     2,     2,     4,     1,     2,     2,
-       2,     0,     2,     2,     3,     0,     2,     3,     0,     2
+       0,     2,     1,     0,     2,     2,     0,     2,     2,     4,
+       1,     2,     2,     2,     0,     2,     2,     3,     0,     2,
+       3,     0,     2
 };
 
 
@@ -1208,102 +1214,122 @@ yyreduce:
   YY_REDUCE_PRINT (yyn);
   switch (yyn)
     {
-  case 2: /* Collection: GameTreeSeq  */
-#line 113 "sgf_y.y"
+  case 2: /* Collection: TopGameTreeSeq  */
+#line 115 "sgf_y.y"
                 { (yyval.pl) = plCollection = (yyvsp[0].pl); }
-#line 1215 "sgf_y.c"
+#line 1221 "sgf_y.c"
     break;
 
-  case 3: /* GameTreeSeq: %empty  */
-#line 117 "sgf_y.y"
+  case 3: /* TopGameTreeSeq: %empty  */
+#line 121 "sgf_y.y"
                 { (yyval.pl) = NewList(); }
-#line 1221 "sgf_y.c"
+#line 1227 "sgf_y.c"
+    break;
+
+  case 4: /* TopGameTreeSeq: TopGameTreeSeq GameTree  */
+#line 123 "sgf_y.y"
+                {
+		    if( !pfGameTree )
+			ListInsert( (yyvsp[-1].pl), (yyvsp[0].pl) );
+		    else if( !pfGameTree( (yyvsp[0].pl), pvGameTree ) ) {
+			g_free( (yyvsp[-1].pl) );
+			YYABORT;
+		    }
+		    (yyval.pl) = (yyvsp[-1].pl);
+		}
+#line 1241 "sgf_y.c"
     break;
 
-  case 4: /* GameTreeSeq: GameTreeSeq GameTree  */
-#line 119 "sgf_y.y"
+  case 6: /* GameTreeSeq: %empty  */
+#line 136 "sgf_y.y"
+                { (yyval.pl) = NewList(); }
+#line 1247 "sgf_y.c"
+    break;
+
+  case 7: /* GameTreeSeq: GameTreeSeq GameTree  */
+#line 138 "sgf_y.y"
                 { ListInsert( (yyvsp[-1].pl), (yyvsp[0].pl) ); (yyval.pl) = (yyvsp[-1].pl); }
-#line 1227 "sgf_y.c"
+#line 1253 "sgf_y.c"
     break;
 
-  case 6: /* GameTree: '(' Sequence GameTreeSeq ')'  */
-#line 124 "sgf_y.y"
+  case 9: /* GameTree: '(' Sequence GameTreeSeq ')'  */
+#line 143 "sgf_y.y"
                 { ListInsert( (yyvsp[-1].pl)->plNext, (yyvsp[-2].pl) ); (yyval.pl) = (yyvsp[-1].pl); }
-#line 1233 "sgf_y.c"
+#line 1259 "sgf_y.c"
     break;
 
-  case 7: /* Sequence: Node  */
-#line 128 "sgf_y.y"
+  case 10: /* Sequence: Node  */
+#line 147 "sgf_y.y"
                 { (yyval.pl) = NewList(); ListInsert( (yyval.pl), (yyvsp[0].pl) ); }
-#line 1239 "sgf_y.c"
+#line 1265 "sgf_y.c"
     break;
 
-  case 8: /* Sequence: Sequence Node  */
-#line 130 "sgf_y.y"
+  case 11: /* Sequence: Sequence Node  */
+#line 149 "sgf_y.y"
                 { ListInsert( (yyvsp[-1].pl), (yyvsp[0].pl) ); (yyval.pl) = (yyvsp[-1].pl); }
-#line 1245 "sgf_y.c"
+#line 1271 "sgf_y.c"
     break;
 
-  case 10: /* Node: ';' PropertySeq  */
-#line 135 "sgf_y.y"
+  case 13: /* Node: ';' PropertySeq  */
+#line 154 "sgf_y.y"
                 { (yyval.pl) = (yyvsp[0].pl); }
-#line 1251 "sgf_y.c"
+#line 1277 "sgf_y.c"
     break;
 
-  case 11: /* PropertySeq: %empty  */
-#line 139 "sgf_y.y"
+  case 14: /* PropertySeq: %empty  */
+#line 158 "sgf_y.y"
                 { (yyval.pl) = NewList(); }
-#line 1257 "sgf_y.c"
+#line 1283 "sgf_y.c"
     break;
 
-  case 12: /* PropertySeq: PropertySeq Property  */
-#line 141 "sgf_y.y"
+  case 15: /* PropertySeq: PropertySeq Property  */
+#line 160 "sgf_y.y"
                 { ListInsert( (yyvsp[-1].pl), (yyvsp[0].pp) ); (yyval.pl) = (yyvsp[-1].pl); }
-#line 1263 "sgf_y.c"
+#line 1289 "sgf_y.c"
     break;
 
-  case 14: /* Property: PROPERTY ValueSeq Value  */
-#line 148 "sgf_y.y"
+  case 17: /* Property: PROPERTY ValueSeq Value  */
+#line 167 "sgf_y.y"
                 { 
 		    ListInsert( (yyvsp[-1].pl), (yyvsp[0].pch) );
 		    (yyval.pp) = g_malloc( sizeof(property) ); (yyval.pp)->pl = (yyvsp[-1].pl);
 		    (yyval.pp)->ach[ 0 ] = (yyvsp[-2].ach)[ 0 ]; (yyval.pp)->ach[ 1 ] = (yyvsp[-2].ach)[ 1 ];
 		}
-#line 1273 "sgf_y.c"
+#line 1299 "sgf_y.c"
     break;
 
-  case 15: /* ValueSeq: %empty  */
-#line 156 "sgf_y.y"
+  case 18: /* ValueSeq: %empty  */
+#line 175 "sgf_y.y"
                 { (yyval.pl) = NewList(); }
-#line 1279 "sgf_y.c"
+#line 1305 "sgf_y.c"
     break;
 
-  case 16: /* ValueSeq: ValueSeq Value  */
-#line 158 "sgf_y.y"
+  case 19: /* ValueSeq: ValueSeq Value  */
+#line 177 "sgf_y.y"
                 { ListInsert( (yyvsp[-1].pl), (yyvsp[0].pch) ); (yyval.pl) = (yyvsp[-1].pl); }
-#line 1285 "sgf_y.c"
+#line 1311 "sgf_y.c"
     break;
 
-  case 17: /* Value: '[' ValueCharSeq ']'  */
-#line 162 "sgf_y.y"
+  case 20: /* Value: '[' ValueCharSeq ']'  */
+#line 181 "sgf_y.y"
                 { (yyval.pch) = Concatenate( (yyvsp[-1].pl) ); }
-#line 1291 "sgf_y.c"
+#line 1317 "sgf_y.c"
     break;
 
-  case 18: /* ValueCharSeq: %empty  */
-#line 166 "sgf_y.y"
+  case 21: /* ValueCharSeq: %empty  */
+#line 185 "sgf_y.y"
                 { (yyval.pl) = NewList(); }
-#line 1297 "sgf_y.c"
+#line 1323 "sgf_y.c"
     break;
 
-  case 19: /* ValueCharSeq: ValueCharSeq VALUETEXT  */
-#line 168 "sgf_y.y"
+  case 22: /* ValueCharSeq: ValueCharSeq VALUETEXT  */
+#line 187 "sgf_y.y"
                 { ListInsert( (yyvsp[-1].pl), (yyvsp[0].pch) ); (yyval.pl) = (yyvsp[-1].pl); }
-#line 1303 "sgf_y.c"
+#line 1329 "sgf_y.c"
     break;
 
 
-#line 1307 "sgf_y.c"
+#line 1333 "sgf_y.c"
 
       default: break;
     }
@@ -1496,20 +1522,45 @@ yyreturnlab:
   return yyresult;
 }
 
-#line 171 "sgf_y.y"
+#line 190 "sgf_y.y"
 
 
 extern FILE *sgfin;
+extern void sgfrestart( FILE *pf );
+
 extern listOLD *SGFParse( FILE *pf ) {
 
     
-    sgfin = pf;
+    sgfrestart( pf );
     plCollection = NULL;
+    pfGameTree = NULL;
 
     sgfparse();
 
     return plCollection;
 }
+
+extern int SGFParseStream( FILE *pf, int ( *pfCallback )( listOLD *, void * ),
+			   void *p ) {
+
+    int f;
+
+    /* a previous parse may have stopped part way through its file */
+    sgfrestart( pf );
+    plCollection = NULL;
+    pfGameTree = pfCallback;
+    pvGameTree = p;
+
+    f = !sgfparse() && plCollection;
+
+    if( plCollection )
+	g_free( plCollection ); /* empty, the trees went to the callback */
+
+    pfGameTree = NULL;
+    plCollection = NULL;
+
+    return f;
+}
 	
 #ifdef SGFTEST
 
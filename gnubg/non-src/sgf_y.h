@@ -71,7 +71,7 @@ extern int sgfdebug;
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
 union YYSTYPE
 {
-#line 95 "sgf_y.y"
+#line 97 "sgf_y.y"
 
     char ach[ 2 ]; /* property identifier */
     char *pch; /* property value */
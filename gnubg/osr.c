@@ -30,27 +30,76 @@
 
 #include "eval.h"
 #include "positionid.h"
-#include "mt19937ar.h"
 #include "osr.h"
+#if defined(USE_MULTITHREAD)
+#include "multithread.h"
+#endif
 
 #define MAX_PROBS        32
 #define MAX_GAMMON_PROBS 15
 
-static unsigned long mt[MT_ARRAY_N];
-static int mti = MT_ARRAY_N + 1;
+/* number of one sided rollouts advanced in lockstep */
+#define OSR_LANES        16
+
+/* don't bother starting a thread for fewer games than this */
+#define OSR_MIN_GAMES_PER_THREAD 512
+
+/*
+ * The dice are a pure function of (game, turn) rather than a draw from a
+ * shared random number generator.  This makes the result independent of
+ * the order in which the games are simulated, so the lockstep and the
+ * multithreaded code paths give identical results.
+ */
+
+static inline unsigned int
+OSRHash(unsigned int x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+/* Roll the dice of turn iTurn for the games iGame .. iGame + OSR_LANES - 1 */
 
 static void
-OSRQuasiRandomDice(const unsigned int iTurn, const unsigned int iGame, const unsigned int cGames, unsigned int anDice[2])
+OSRQuasiRandomDice(const unsigned int iTurn, const unsigned int iGame, const unsigned int cGames,
+                   unsigned int anDie0[OSR_LANES], unsigned int anDie1[OSR_LANES])
 {
+    unsigned int l;
+
     if (!iTurn && !(cGames % 36)) {
-        anDice[0] = (iGame % 6) + 1;
-        anDice[1] = ((iGame / 6) % 6) + 1;
+        for (l = 0; l < OSR_LANES; ++l) {
+            anDie0[l] = ((iGame + l) % 6) + 1;
+            anDie1[l] = (((iGame + l) / 6) % 6) + 1;
+        }
     } else if (iTurn == 1 && !(cGames % 1296)) {
-        anDice[0] = ((iGame / 36) % 6) + 1;
-        anDice[1] = ((iGame / 216) % 6) + 1;
+        for (l = 0; l < OSR_LANES; ++l) {
+            anDie0[l] = (((iGame + l) / 36) % 6) + 1;
+            anDie1[l] = (((iGame + l) / 216) % 6) + 1;
+        }
     } else {
-        anDice[0] = (unsigned int) (genrand_int32(&mti, mt) % 6) + 1;
-        anDice[1] = (unsigned int) (genrand_int32(&mti, mt) % 6) + 1;
+        const unsigned int nTurn = OSRHash(iTurn + 0x632be5abU);
+
+        for (l = 0; l < OSR_LANES; ++l) {
+            const unsigned int r = OSRHash((iGame + l) * 0x9e3779b9U ^ nTurn) % 36;
+
+            anDie0[l] = (r % 6) + 1;
+            anDie1[l] = (r / 6) + 1;
+        }
+    }
+
+    /* highest die first; no data dependent branches, so the loops above
+     * and this one are vectorised */
+
+    for (l = 0; l < OSR_LANES; ++l) {
+        const unsigned int d0 = anDie0[l];
+        const unsigned int d1 = anDie1[l];
+
+        anDie0[l] = MAX(d0, d1);
+        anDie1[l] = MIN(d0, d1);
     }
 }
 
@@ -541,119 +590,202 @@ FindBestMoveOSR(unsigned int anBoard[25], const unsigned int anDice[2], unsigned
         FindBestMoveOSR4(anBoard, anDice[0], pnOut);
 }
 
+/* One sided rollouts of the games iFirst .. iLast - 1 */
+
+typedef struct {
+    const unsigned int *anBoard;
+    unsigned int nOut;
+    unsigned int iFirst;
+    unsigned int iLast;
+    unsigned int nGames;
+    /* the sums are kept as integers so that the order in which the
+     * games are added up doesn't matter */
+    guint64 aulProbs[MAX_PROBS];
+    unsigned int anCounts[MAX_GAMMON_PROBS];
+} osrrange;
+
 /*
- * osr: one sided rollout.
+ * rollOSRLanes: perform up to OSR_LANES one sided rollouts in lockstep
  *
  * Input:
- *   anBoard: the board (reversed compared to normal convention)
- *   iGame: game#
- *   nGames: # of games.
- *   nOut: current number of chequers outside home quadrant.
+ *   por: the starting position and the accumulated results
+ *   iGame: game# of the first lane
+ *   cLanes: number of games to play
  *
- * Returns: number of rolls used to get all chequers inside home
- *          quadrant.
+ * The boards are stored one per lane, the per game state (dice,
+ * chequers outside home quadrant, turns used) as arrays over the lanes,
+ * so that the dice and the book keeping are done for all lanes at once.
+ * The move search, most of the work, is still done lane by lane.
  */
 
-static unsigned int
-osr(unsigned int anBoard[25], const unsigned int iGame, const unsigned int nGames, unsigned int nOut)
+static void
+rollOSRLanes(osrrange * por, const unsigned int iGame, const unsigned int cLanes)
 {
-    unsigned int iTurn = 0;
-    unsigned int anDice[2];
+    unsigned int aan[OSR_LANES][25];
+    unsigned int anOut[OSR_LANES];
+    unsigned int anTurns[OSR_LANES];
+    unsigned int anDie0[OSR_LANES], anDie1[OSR_LANES];
+    unsigned int cActive;
+    unsigned int iTurn;
+    unsigned int i, l;
+
+    for (l = 0; l < cLanes; ++l)
+        memcpy(aan[l], por->anBoard, sizeof(aan[l]));
+
+    for (l = 0; l < OSR_LANES; ++l) {
+        anOut[l] = l < cLanes ? por->nOut : 0;
+        anTurns[l] = 0;
+    }
 
-    /* loop until all chequers are in home quadrant */
+    /* loop until all chequers are in home quadrant in every lane */
 
-    while (nOut) {
-        /* roll dice */
-        OSRQuasiRandomDice(iTurn, iGame, nGames, anDice);
+    for (iTurn = 0, cActive = cLanes; cActive; ++iTurn) {
 
-        if (anDice[0] < anDice[1])
-            swap_us(anDice, anDice + 1);
+        OSRQuasiRandomDice(iTurn, iGame, por->nGames, anDie0, anDie1);
 
-        /* find and move best move */
-        FindBestMoveOSR(anBoard, anDice, &nOut);
+        for (l = 0; l < cLanes; ++l) {
+            unsigned int anDice[2];
 
-        iTurn++;
+            if (!anOut[l])
+                continue;
+
+            anDice[0] = anDie0[l];
+            anDice[1] = anDie1[l];
+
+            /* find and move best move */
+            FindBestMoveOSR(aan[l], anDice, &anOut[l]);
+
+            ++anTurns[l];
+        }
+
+        cActive = 0;
+        for (l = 0; l < OSR_LANES; ++l)
+            cActive += anOut[l] != 0;
     }
 
-    return iTurn;
+    for (l = 0; l < cLanes; ++l) {
+        unsigned short int anProb[32];
+        const unsigned int n = anTurns[l];
+        unsigned int m = 0;
+
+        /* number of chequers in home quadrant */
+
+        for (i = 0; i < 6; ++i)
+            m += aan[l][i];
+
+        /* update counts */
+
+        ++por->anCounts[MIN(m == 15 ? n + 1 : n, MAX_GAMMON_PROBS - 1)];
+
+        /* get prob. from bearoff1 */
+
+        getBearoffProbs(PositionBearoff(aan[l], pbc1->nPoints, pbc1->nChequers), anProb);
+
+        for (i = 0; i < 32; ++i)
+            por->aulProbs[MIN(n + i, MAX_PROBS - 1)] += anProb[i];
+    }
 }
 
+static void
+rollOSRRange(osrrange * por)
+{
+    unsigned int iGame;
+
+    for (iGame = por->iFirst; iGame < por->iLast; iGame += OSR_LANES)
+        rollOSRLanes(por, iGame, MIN(OSR_LANES, por->iLast - iGame));
+}
+
+#if defined(USE_MULTITHREAD)
+typedef struct {
+    osrrange *aor;
+    int iNext;
+} osrtasks;
+
+static void
+rollOSRTask(void *p)
+{
+    osrtasks *pot = (osrtasks *) p;
+
+    rollOSRRange(pot->aor + MT_SafeIncCheck(&pot->iNext));
+}
+#endif
 
 /*
  * RollOSR: perform onesided rollout
  *
  * Input:
  *   nGames: number of simulations
+ *   nThreads: maximum number of calculation threads to split the
+ *             simulations over
  *   anBoard: the board 
  *   nOut: number of chequers outside home quadrant
  *
  * Output:
- *   arProbs[ nMaxProbs ]: probabilities
- *   arGammonProbs[ nMaxGammonProbs ]: gammon probabilities
+ *   arProbs[ MAX_PROBS ]: probabilities
+ *   arGammonProbs[ MAX_GAMMON_PROBS ]: gammon probabilities
+ *
+ * The result doesn't depend on nThreads.
  *
  */
 
 static void
-rollOSR(const unsigned int nGames, const unsigned int anBoard[25], const unsigned int nOut,
-        float arProbs[], const unsigned int nMaxProbs, float arGammonProbs[], const unsigned int nMaxGammonProbs)
+rollOSR(const unsigned int nGames, const unsigned int nThreads, const unsigned int anBoard[25], const unsigned int nOut,
+        float arProbs[MAX_PROBS], float arGammonProbs[MAX_GAMMON_PROBS])
 {
-
-    unsigned int an[25];
-    unsigned short int anProb[32];
-    unsigned int i;
-    unsigned int iGame;
-
-    int *anCounts = (int *) g_alloca(nMaxGammonProbs * sizeof(int));
-
-    memset(anCounts, 0, sizeof(int) * nMaxGammonProbs);
-
-    for (i = 0; i < nMaxProbs; ++i)
-        arProbs[i] = 0.0f;
+    unsigned int cRanges = MAX(1, MIN(nThreads, nGames / OSR_MIN_GAMES_PER_THREAD));
+    osrrange *aor = g_new0(osrrange, cRanges);
+    guint64 aulProbs[MAX_PROBS];
+    unsigned int anCounts[MAX_GAMMON_PROBS];
+    unsigned int i, j;
+
+    for (j = 0; j < cRanges; ++j) {
+        aor[j].anBoard = anBoard;
+        aor[j].nOut = nOut;
+        aor[j].nGames = nGames;
+        aor[j].iFirst = (unsigned int) ((guint64) nGames * j / cRanges);
+        aor[j].iLast = (unsigned int) ((guint64) nGames * (j + 1) / cRanges);
+    }
 
     /* perform rollouts */
 
-    for (iGame = 0; iGame < nGames; ++iGame) {
-        unsigned int n, m;
-
-        memcpy(an, anBoard, sizeof(an));
-
-        /* do actual rollout */
-
-        n = osr(an, iGame, nGames, nOut);
-
-        /* number of chequers in home quadrant */
-
-        m = 0;
-        for (i = 0; i < 6; ++i)
-            m += an[i];
-
-        /* update counts */
-
-        ++anCounts[MIN(m == 15 ? n + 1 : n, nMaxGammonProbs - 1)];
-
-        /* get prob. from bearoff1 */
+#if defined(USE_MULTITHREAD)
+    /* only the main thread can hand out tasks, and only while the
+     * calculation threads have none; EPC gets here from the calculation
+     * threads too, and then plays the games itself */
+    if (cRanges > 1 && MT_GetThreadID() == -1 && !td.addedTasks) {
+        osrtasks ot;
+
+        ot.aor = aor;
+        ot.iNext = 0;
+        mt_add_tasks(cRanges, rollOSRTask, &ot, NULL);
+        MT_WaitForTasks(NULL, 10, FALSE);
+    } else
+#endif
+        for (j = 0; j < cRanges; ++j)
+            rollOSRRange(aor + j);
 
-        getBearoffProbs(PositionBearoff(an, pbc1->nPoints, pbc1->nChequers), anProb);
-
-        for (i = 0; i < 32; ++i)
-            arProbs[MIN(n + i, nMaxProbs - 1)] += anProb[i] / 65535.0f;
+    memset(aulProbs, 0, sizeof(aulProbs));
+    memset(anCounts, 0, sizeof(anCounts));
 
+    for (j = 0; j < cRanges; ++j) {
+        for (i = 0; i < MAX_PROBS; ++i)
+            aulProbs[i] += aor[j].aulProbs[i];
+        for (i = 0; i < MAX_GAMMON_PROBS; ++i)
+            anCounts[i] += aor[j].anCounts[i];
     }
 
+    g_free(aor);
+
     /* scale resulting probabilities */
 
-    for (i = 0; i < (unsigned int) nMaxProbs; ++i) {
-        arProbs[i] /= (float)nGames;
-        /* printf ( "arProbs[%d]=%f\n", i, arProbs[ i ] ); */
-    }
+    for (i = 0; i < MAX_PROBS; ++i)
+        arProbs[i] = (float) ((double) aulProbs[i] / (65535.0 * nGames));
 
     /* calculate gammon probs. 
      * (prob. of getting inside home quadrant in i rolls */
 
-    for (i = 0; i < nMaxGammonProbs; ++i) {
-        arGammonProbs[i] = (float)anCounts[i] / (float)nGames;
-        /* printf ( "arGammonProbs[%d]=%f\n", i, arGammonProbs[ i ] ); */
-    }
+    for (i = 0; i < MAX_GAMMON_PROBS; ++i)
+        arGammonProbs[i] = (float) anCounts[i] / (float) nGames;
 
 }
 
@@ -665,6 +797,7 @@ rollOSR(const unsigned int nGames, const unsigned int anBoard[25], const unsigne
  * Input:
  *   anBoard: one side of the board
  *   nGames: number of simulations
+ *   nThreads: number of threads for the simulations
  *   
  * Output:
  *   an: ???
@@ -675,7 +808,7 @@ rollOSR(const unsigned int nGames, const unsigned int anBoard[25], const unsigne
  */
 
 static unsigned int
-osp(const unsigned int anBoard[25], const unsigned int nGames,
+osp(const unsigned int anBoard[25], const unsigned int nGames, const unsigned int nThreads,
     unsigned int an[25], float arProbs[MAX_PROBS], float arGammonProbs[MAX_GAMMON_PROBS])
 {
 
@@ -699,7 +832,7 @@ osp(const unsigned int anBoard[25], const unsigned int nGames,
 
     if (nOut > 0)
         /* chequers outside home: do one sided rollout */
-        rollOSR(nGames, an, nOut, arProbs, MAX_PROBS, arGammonProbs, MAX_GAMMON_PROBS);
+        rollOSR(nGames, nThreads, an, nOut, arProbs, arGammonProbs);
     else {
         /* chequers inside home: use BEAROFF2 */
 
@@ -792,6 +925,140 @@ bgProb(const unsigned int anBoard[25],
 }
 
 
+/*
+ * Cache of one sided results.
+ *
+ * A one sided rollout depends only on the chequers of one player and on
+ * the number of games, and the same one sided position shows up in a
+ * large number of two sided race positions. The cache is a fixed size
+ * direct mapped table with a lock per entry, like the evaluation cache.
+ */
+
+#define OSR_CACHE_SIZE 4096     /* must be a power of 2 */
+
+typedef struct {
+    unsigned int anKey[4];    /* board, 4 bits per point */
+    unsigned int nGames;        /* 0: unused entry */
+    unsigned int nTotal;
+    float arProbs[MAX_PROBS];
+    float arGammonProbs[MAX_GAMMON_PROBS];
+#if defined(USE_MULTITHREAD)
+    int lock;
+#endif
+} osrcacheentry;
+
+static osrcacheentry aOSRCache[OSR_CACHE_SIZE];
+
+#if defined(USE_MULTITHREAD)
+static inline void
+osr_cache_lock(osrcacheentry * pe)
+{
+    if (MT_SafeIncCheck(&pe->lock))
+        do {
+            MT_SafeDec(&pe->lock);
+        } while (MT_SafeIncCheck(&pe->lock));
+}
+
+static inline void
+osr_cache_unlock(osrcacheentry * pe)
+{
+    MT_SafeDec(&pe->lock);
+}
+#else
+#define osr_cache_lock(pe)
+#define osr_cache_unlock(pe)
+#endif
+
+static unsigned int
+OSRCacheKey(const unsigned int anBoard[25], unsigned int anKey[4])
+{
+    unsigned int i, h = 0;
+
+    memset(anKey, 0, 4 * sizeof(unsigned int));
+
+    for (i = 0; i < 25; ++i)
+        anKey[i >> 3] |= anBoard[i] << ((i & 7) << 2);
+
+    for (i = 0; i < 4; ++i)
+        h = OSRHash(h ^ anKey[i]);
+
+    return h & (OSR_CACHE_SIZE - 1);
+}
+
+static int
+OSRCacheLookup(const unsigned int anKey[4], const unsigned int l, const unsigned int nGames,
+               unsigned int *pnTotal, float arProbs[MAX_PROBS], float arGammonProbs[MAX_GAMMON_PROBS])
+{
+    osrcacheentry *pe = aOSRCache + l;
+    int fHit;
+
+    osr_cache_lock(pe);
+
+    fHit = pe->nGames == nGames && !memcmp(pe->anKey, anKey, sizeof(pe->anKey));
+
+    if (fHit) {
+        *pnTotal = pe->nTotal;
+        memcpy(arProbs, pe->arProbs, sizeof(pe->arProbs));
+        memcpy(arGammonProbs, pe->arGammonProbs, sizeof(pe->arGammonProbs));
+    }
+
+    osr_cache_unlock(pe);
+
+    return fHit;
+}
+
+static void
+OSRCacheAdd(const unsigned int anKey[4], const unsigned int l, const unsigned int nGames,
+            const unsigned int nTotal, const float arProbs[MAX_PROBS], const float arGammonProbs[MAX_GAMMON_PROBS])
+{
+    osrcacheentry *pe = aOSRCache + l;
+
+    osr_cache_lock(pe);
+
+    memcpy(pe->anKey, anKey, sizeof(pe->anKey));
+    pe->nGames = nGames;
+    pe->nTotal = nTotal;
+    memcpy(pe->arProbs, arProbs, sizeof(pe->arProbs));
+    memcpy(pe->arGammonProbs, arGammonProbs, sizeof(pe->arGammonProbs));
+
+    osr_cache_unlock(pe);
+}
+
+/* osp() through the cache */
+
+static unsigned int
+ospCached(const unsigned int anBoard[25], const unsigned int nGames, const unsigned int nThreads,
+          unsigned int an[25], float arProbs[MAX_PROBS], float arGammonProbs[MAX_GAMMON_PROBS])
+{
+    unsigned int anKey[4];
+    unsigned int l = OSRCacheKey(anBoard, anKey);
+    unsigned int nTotal;
+
+    if (OSRCacheLookup(anKey, l, nGames, &nTotal, arProbs, arGammonProbs)) {
+        memcpy(an, anBoard, 25 * sizeof(int));
+        return nTotal;
+    }
+
+    nTotal = osp(anBoard, nGames, nThreads, an, arProbs, arGammonProbs);
+
+    OSRCacheAdd(anKey, l, nGames, nTotal, arProbs, arGammonProbs);
+
+    return nTotal;
+}
+
+extern void
+OSRCacheFlush(void)
+{
+    unsigned int l;
+
+    for (l = 0; l < OSR_CACHE_SIZE; ++l) {
+        osr_cache_lock(aOSRCache + l);
+        aOSRCache[l].nGames = 0;
+        osr_cache_unlock(aOSRCache + l);
+    }
+}
+
+
 /*
  * Calculate race probabilities using one sided rollouts.
  *
@@ -799,6 +1066,7 @@ bgProb(const unsigned int anBoard[25],
  *   anBoard: the current board 
  *            (assumed to be a race position without contact)
  *   nGames:  the number of simulations to perform
+ *   nThreads: the number of threads the simulations may be split over
  *
  * Output:
  *   arOutput: probabilities.
@@ -806,12 +1074,13 @@ bgProb(const unsigned int anBoard[25],
  */
 
 extern void
-raceProbs(const TanBoard anBoard, const unsigned int nGames, float arOutput[NUM_OUTPUTS], float arMu[2])
+raceProbsMT(const TanBoard anBoard, const unsigned int nGames, const unsigned int nThreads,
+            float arOutput[NUM_OUTPUTS], float arMu[2])
 {
 
     TanBoard an;
     float aarProbs[2][MAX_PROBS];
-    float aarGammonProbs[2][MAX_PROBS];
+    float aarGammonProbs[2][MAX_GAMMON_PROBS];
     float arG[2] = { 0.0f, 0.0f }, arBG[2] = { 0.0f, 0.0f };
 
     unsigned int anTotal[2];
@@ -820,15 +1089,11 @@ raceProbs(const TanBoard anBoard, const unsigned int nGames, float arOutput[NUM_
 
     float w, s;
 
-    /* Seed set to ensure that OSR are reproducible */
-
-    init_genrand(0, &mti, mt);
-
     for (i = 0; i < NUM_OUTPUTS; ++i)
         arOutput[i] = 0.0f;
 
     for (i = 0; i < 2; ++i)
-        anTotal[i] = osp(anBoard[i], nGames, an[i], aarProbs[i], aarGammonProbs[i]);
+        anTotal[i] = ospCached(anBoard[i], nGames, nThreads, an[i], aarProbs[i], aarGammonProbs[i]);
 
     /* calculate OUTPUT_WIN */
 
@@ -903,3 +1168,9 @@ raceProbs(const TanBoard anBoard, const unsigned int nGames, float arOutput[NUM_
     }
 
 }
+
+extern void
+raceProbs(const TanBoard anBoard, const unsigned int nGames, float arOutput[NUM_OUTPUTS], float arMu[2])
+{
+    raceProbsMT(anBoard, nGames, 1, arOutput, arMu);
+}
@@ -23,5 +23,12 @@
 extern void
  raceProbs(const TanBoard anBoard, const unsigned int nGames, float arOutput[NUM_OUTPUTS], float arMu[2]);
 
+extern void
+ raceProbsMT(const TanBoard anBoard, const unsigned int nGames, const unsigned int nThreads,
+             float arOutput[NUM_OUTPUTS], float arMu[2]);
+
+extern void
+ OSRCacheFlush(void);
+
 
 #endif                          /* OSR_H */
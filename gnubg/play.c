@@ -34,6 +34,7 @@
 #include "positionid.h"
 #include "matchid.h"
 #include "matchequity.h"
+#include "ponder.h"
 #include "sound.h"
 #include "renderprefs.h"
 #include "md5.h"
@@ -88,6 +89,7 @@ const char *aszLuckType[] = {
 const char *aszLuckTypeAbbr[] = { "--", "-", "", "+", "++" };
 
 listOLD lMatch, *plGame, *plLastMove;
+unsigned int nMatchGeneration = 0;
 statcontext scMatch;
 static int fComputerDecision = FALSE;
 static int fEndGame = FALSE;
@@ -426,6 +428,8 @@ FreeMoveRecord(moverecord * pmr)
     if (!pmr)
         return;
 
+    nMatchGeneration++;
+
     switch (pmr->mt) {
     case MOVE_NORMAL:
         if (pmr->ml.cMoves && pmr->ml.amMoves) {
@@ -1691,6 +1695,8 @@ NextTurn(int fPlayNext)
 
     g_assert(!fComputing);
 
+    PonderStop();
+
 #if defined (USE_GTK)
     if (fX) {
         if (nNextTurn) {
@@ -1855,6 +1861,7 @@ NextTurn(int fPlayNext)
             CommandRoll(NULL);
 
         fComputing = FALSE;
+        PonderSchedule();
         return -1;
     }
 #if defined (USE_GTK)
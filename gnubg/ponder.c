@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#if defined(USE_GTK)
+#include "gtkgame.h"
+#else
+#include "backgammon.h"
+#endif
+#include "multithread.h"
+#include "ponder.h"
+#include "positionid.h"
+
+int fPonder = FALSE;
+
+#if defined(USE_MULTITHREAD)
+
+#define PONDER_REPLIES 3        /* the opponent's best moves at 0-ply... */
+#define PONDER_WINDOW 0.1f      /* ...this close to the best one */
+
+typedef int (*cfunc) (const void *, const void *);
+
+/* One search: a move for one of our rolls, or the cube decision if
+ * anDice[0] is 0, in a position after a reply of the opponent */
+typedef struct {
+    TanBoard anBoard;
+    cubeinfo ci;
+    int anDice[2];
+    float rWeight;              /* how likely we are to need it */
+} ponderitem;
+
+static struct {
+    GArray *pa;
+    evalcontext ecChequer;
+    movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+    evalcontext ecCube;
+    int fCube;
+    int iNext;
+    int fActive;
+    int fStopping;
+    guint nIdle;
+} pd;
+
+static int
+CompareItems(const ponderitem * pi0, const ponderitem * pi1)
+{
+    return pi0->rWeight < pi1->rWeight ? 1 : (pi0->rWeight > pi1->rWeight ? -1 : 0);
+}
+
+static void
+PonderTask(void *UNUSED(p))
+{
+    const ponderitem *ppi = &g_array_index(pd.pa, ponderitem, MT_SafeIncCheck(&pd.iNext));
+
+    if (fInterrupt)
+        return;
+
+    /* the results only go to the evaluation cache; failures are
+     * interrupts, which aren't the task's to report */
+    if (!ppi->anDice[0]) {
+        float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
+        cubeinfo ci = ppi->ci;
+
+        (void) GeneralCubeDecisionE(aarOutput, (ConstTanBoard) ppi->anBoard, &ci, &pd.ecCube, NULL);
+    } else {
+        movelist ml;
+
+        if (FindnSaveBestMoves(&ml, ppi->anDice[0], ppi->anDice[1], (ConstTanBoard) ppi->anBoard, NULL, 0.0f,
+                               &ppi->ci, &pd.ecChequer, pd.aamf) == 0)
+            g_free(ml.amMoves);
+    }
+}
+
+/* Our searches after the opponent's likely replies to one roll */
+
+static void
+AddReplies(GArray * pa, const TanBoard anBoard, int n0, int n1, const cubeinfo * pci, float rRoll)
+{
+    movelist ml;
+    move am[PONDER_REPLIES];
+    evalcontext ec = pd.ecChequer;
+    cubeinfo ci = *pci;
+    unsigned int i, cReplies;
+    int d0, d1;
+    float rSum = 0.0f;
+
+    ec.nPlies = 0;
+    ci.fMove = !ci.fMove;
+
+    if (!GenerateMoves(&ml, anBoard, n0, n1, FALSE)) {
+        /* the opponent dances */
+        PositionKey(anBoard, &am[0].key);
+        cReplies = 1;
+    } else {
+        for (i = 0; i < ml.cMoves; i++)
+            if (ScoreMove(NULL, &ml.amMoves[i], pci, &ec, 0) < 0)
+                return;
+        qsort(ml.amMoves, ml.cMoves, sizeof(move), (cfunc) CompareMoves);
+
+        for (cReplies = 1; cReplies < MIN(ml.cMoves, PONDER_REPLIES); cReplies++)
+            if (ml.amMoves[cReplies].rScore < ml.amMoves[0].rScore - PONDER_WINDOW)
+                break;
+        memcpy(am, ml.amMoves, cReplies * sizeof(move));
+    }
+
+    /* the better replies are the likelier */
+    for (i = 0; i < cReplies; i++)
+        rSum += 1.0f / (i + 1);
+
+    for (i = 0; i < cReplies; i++) {
+        ponderitem pi;
+        float r = rRoll / (i + 1) / rSum;
+
+        PositionFromKeySwapped(pi.anBoard, &am[i].key);
+        pi.ci = ci;
+
+        if (pd.fCube && GetDPEq(NULL, NULL, &ci)) {
+            /* the cube decision comes first */
+            pi.anDice[0] = pi.anDice[1] = 0;
+            pi.rWeight = r;
+            g_array_append_val(pa, pi);
+        }
+
+        for (d0 = 1; d0 <= 6; d0++)
+            for (d1 = 1; d1 <= d0; d1++) {
+                pi.anDice[0] = d0;
+                pi.anDice[1] = d1;
+                pi.rWeight = r * (d0 == d1 ? 1.0f : 2.0f) / 36.0f;
+                g_array_append_val(pa, pi);
+            }
+    }
+}
+
+extern void
+PonderPosition(const TanBoard anBoard, const unsigned int anDice[2], const cubeinfo * pci,
+               const evalcontext * pecChequer, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES],
+               const evalcontext * pecCube)
+{
+    unsigned int i;
+    int d0, d1;
+
+    if (!fPonder || pd.fActive || pd.fStopping)
+        return;
+
+    /* the threads must be idle, or their tasks would be counted with
+     * ours */
+    if (td.addedTasks)
+        return;
+
+    pd.pa = g_array_new(FALSE, FALSE, sizeof(ponderitem));
+    pd.ecChequer = *pecChequer;
+    memcpy(pd.aamf, aamf, sizeof(pd.aamf));
+    pd.fCube = pecCube != NULL;
+    if (pecCube)
+        pd.ecCube = *pecCube;
+
+    if (anDice[0])
+        AddReplies(pd.pa, anBoard, (int) anDice[0], (int) anDice[1], pci, 1.0f);
+    else
+        for (d0 = 1; d0 <= 6; d0++)
+            for (d1 = 1; d1 <= d0; d1++)
+                AddReplies(pd.pa, anBoard, d0, d1, pci, (d0 == d1 ? 1.0f : 2.0f) / 36.0f);
+
+    /* the likeliest positions first, for when the opponent is quick */
+    g_array_sort(pd.pa, (GCompareFunc) CompareItems);
+
+    pd.iNext = 0;
+    pd.fActive = TRUE;
+
+    for (i = 0; i < pd.pa->len; i++) {
+        Task *pt = (Task *) g_malloc(sizeof(Task));
+
+        pt->fun = PonderTask;
+        pt->data = NULL;
+        pt->pLinkedTask = NULL;
+        MT_AddTask(pt, TRUE);
+    }
+}
+
+extern void
+PonderStart(void)
+{
+    cubeinfo ci;
+    const player *pp = &ap[!ms.fTurn];
+
+    if (!fPonder || !plGame || ms.gs != GAME_PLAYING || fComputing || fNextTurn)
+        return;
+
+    /* a human on roll against gnubg, with nothing else to decide first */
+    if (ap[ms.fTurn].pt != PLAYER_HUMAN || pp->pt != PLAYER_GNU || ms.fMove != ms.fTurn
+        || ms.fDoubled || ms.fResigned)
+        return;
+
+    GetMatchStateCubeInfo(&ci, &ms);
+
+    PonderPosition(msBoard(), ms.anDice, &ci, &pp->esChequer.ec, (movefilter(*)[MAX_FILTER_PLIES]) pp->aamf,
+                   pp->esCube.et == EVAL_EVAL ? &pp->esCube.ec : NULL);
+}
+
+#if defined(USE_GTK)
+static gboolean
+PonderIdle(gpointer UNUSED(p))
+{
+    pd.nIdle = 0;
+
+    if (!nNextTurn)
+        PonderStart();
+
+    return FALSE;
+}
+#endif
+
+extern void
+PonderSchedule(void)
+{
+#if defined(USE_GTK)
+    /* on the command line it starts before the next command is read */
+    if (fX && fPonder && !pd.nIdle)
+        pd.nIdle = g_idle_add_full(G_PRIORITY_LOW, PonderIdle, NULL, NULL);
+#endif
+}
+
+extern void
+PonderStop(void)
+{
+    int fInterruptSave;
+
+#if defined(USE_GTK)
+    if (pd.nIdle) {
+        g_source_remove(pd.nIdle);
+        pd.nIdle = 0;
+    }
+#endif
+
+    if (!pd.fActive || pd.fStopping)
+        return;
+
+    pd.fStopping = TRUE;
+
+    /* drop the searches not started, and cut short the others */
+    fInterruptSave = fInterrupt;
+    fInterrupt = TRUE;
+    MT_AbortTasks();
+    (void) MT_WaitForTasks(NULL, UI_UPDATETIME, FALSE);
+    fInterrupt = fInterruptSave;
+
+    g_array_free(pd.pa, TRUE);
+    pd.pa = NULL;
+    pd.fActive = FALSE;
+    pd.fStopping = FALSE;
+}
+
+#endif                          /* USE_MULTITHREAD */
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef PONDER_H
+#define PONDER_H
+
+#include "eval.h"
+
+/* Pondering: while the opponent of GNU Backgammon is to play, the
+ * calculation threads find our moves for the opponent's likely replies
+ * and all our rolls, so that the evaluation cache already holds them
+ * when it is our turn.
+ *
+ * The threads are only lent out while gnubg waits for input: pondering
+ * is stopped before any command is run, before the next turn is played
+ * and before any other tasks are queued, so nothing else ever runs at
+ * the same time. It needs a build with threads. */
+
+extern int fPonder;
+
+#if defined(USE_MULTITHREAD)
+
+/* Ponder on the current match if a human is on roll against gnubg */
+extern void PonderStart(void);
+/* PonderStart() once the GUI is idle; without a GUI it is started
+ * before each command is read */
+extern void PonderSchedule(void);
+/* Ponder on anBoard with the opponent on roll, pci from the opponent's
+ * side, for gnubg playing with pecChequer and aamf and deciding on the
+ * cube with pecCube (NULL for no cube decisions). anDice is the
+ * opponent's roll, or 0, 0 if not rolled yet. */
+extern void PonderPosition(const TanBoard anBoard, const unsigned int anDice[2], const cubeinfo * pci,
+                           const evalcontext * pecChequer, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES],
+                           const evalcontext * pecCube);
+/* Interrupt the pondering and wait for the threads to finish */
+extern void PonderStop(void);
+
+#else
+
+#define PonderStart()
+#define PonderSchedule()
+#define PonderStop()
+
+#endif
+
+#endif                          /* PONDER_H */
@@ -35,13 +35,14 @@
 #include "rollout.h"
 #include "analysis.h"
 #include "util.h"
+#include "file.h"
 #include <glib/gstdio.h>
 #include <glib.h>
 
 static int
-RelationalMatchExists(DBProvider * pdb)
+RelationalMatchExists(DBProvider * pdb, const char *szChecksum)
 {
-    char *buf = g_strdup_printf("session_id FROM session WHERE checksum = '%s'", GetMatchCheckSum());
+    char *buf = g_strdup_printf("session_id FROM session WHERE checksum = '%s'", szChecksum);
     int ret = RunQueryValue(pdb, buf);
     g_free(buf);
     return ret;
@@ -72,8 +73,9 @@ GameOver(void)
     return FALSE;
 }
 
+/* Reserve n consecutive ids in table, returning the first one (or -1) */
 static int
-GetNextId(DBProvider * pdb, const char *table)
+GetNextIds(DBProvider * pdb, const char *table, int n)
 {
     int next_id;
     /* fetch next_id from control table */
@@ -82,14 +84,14 @@ GetNextId(DBProvider * pdb, const char *table)
     g_free(buf);
 
     if (next_id != -1) {        /* update control data with new next id */
+        buf = g_strdup_printf("UPDATE control SET next_id = %d WHERE tablename = '%s'", next_id + n, table);
         next_id++;
-        buf = g_strdup_printf("UPDATE control SET next_id = %d WHERE tablename = '%s'", next_id, table);
         if (!pdb->UpdateCommand(buf))
             next_id = -1;
         g_free(buf);
     } else {                    /* insert new id */
         next_id = 1;
-        buf = g_strdup_printf("INSERT INTO control (tablename,next_id) VALUES ('%s',%d)", table, next_id);
+        buf = g_strdup_printf("INSERT INTO control (tablename,next_id) VALUES ('%s',%d)", table, n);
         if (!pdb->UpdateCommand(buf))
             next_id = -1;
         g_free(buf);
@@ -97,6 +99,12 @@ GetNextId(DBProvider * pdb, const char *table)
     return next_id;
 }
 
+static int
+GetNextId(DBProvider * pdb, const char *table)
+{
+    return GetNextIds(pdb, table, 1);
+}
+
 static int
 GetPlayerId(DBProvider * pdb, const char *player_name)
 {
@@ -146,28 +154,100 @@ Ratio(float a, int b)
 }
 
 #define NS(x) (x == NULL) ? "NULL" : x
-#define APPENDF(x,y) {g_string_append_printf(column, "%s, ", x); \
-	g_string_append_printf(value, "'%s', ", g_ascii_dtostr(tmpf, G_ASCII_DTOSTR_BUF_SIZE, y));}
-#define APPENDI(x,y) {g_string_append_printf(column, "%s, ", x); \
-	g_string_append_printf(value, "'%i', ", y);}
-#define APPENDU(x,y) {g_string_append_printf(column, "%s, ", x); \
-        g_string_append_printf(value, "'%u', ", y);}
 
+static DBValue *
+RowAppend(DBRow * prow, const char *szColumn, DBValueType t)
+{
+    DBValue *pv;
+
+    g_assert(prow->cValues < DB_MAX_COLUMNS);
+    pv = &prow->aValues[prow->cValues++];
+    pv->szColumn = szColumn;
+    pv->t = t;
+    return pv;
+}
+
+#define APPENDF(x,y) (RowAppend(prow, x, DB_FLOAT)->r = (double) (y))
+#define APPENDI(x,y) (RowAppend(prow, x, DB_INT)->n = (int) (y))
+#define APPENDU(x,y) APPENDI(x,y)
+#define APPENDS(x,y) (RowAppend(prow, x, DB_TEXT)->sz = g_string_chunk_insert(prm->pgsc, NS(y)))
+#define APPENDNOW(x) RowAppend(prow, x, DB_NOW)
+
+/* Insert a row, through a prepared statement if the provider has them */
 static int
-AddStats(DBProvider * pdb, int gm_id, int player_id, int player, const char *table, int nMatchTo, statcontext * sc)
+InsertRow(DBProvider * pdb, const char *table, const DBRow * prow)
 {
-    gchar *buf;
     GString *column, *value;
+    char tmpf[G_ASCII_DTOSTR_BUF_SIZE];
+    unsigned int i;
+    gchar *buf;
+    int ret;
+
+    if (pdb->Insert)
+        return pdb->Insert(table, prow);
+
+    column = g_string_new(NULL);
+    value = g_string_new(NULL);
+    for (i = 0; i < prow->cValues; i++) {
+        const DBValue *pv = &prow->aValues[i];
+
+        g_string_append_printf(column, "%s%s", i ? ", " : "", pv->szColumn);
+        if (i)
+            g_string_append(value, ", ");
+        switch (pv->t) {
+        case DB_INT:
+            g_string_append_printf(value, "'%i'", pv->n);
+            break;
+        case DB_FLOAT:
+            g_string_append_printf(value, "'%s'", g_ascii_dtostr(tmpf, G_ASCII_DTOSTR_BUF_SIZE, pv->r));
+            break;
+        case DB_TEXT:
+            g_string_append_printf(value, "'%s'", pv->sz);
+            break;
+        case DB_NOW:
+            g_string_append(value, "CURRENT_TIMESTAMP");
+            break;
+        }
+    }
+
+    buf = g_strdup_printf("INSERT INTO %s (%s) VALUES(%s)", table, column->str, value->str);
+    ret = pdb->UpdateCommand(buf);
+    g_free(buf);
+    g_string_free(column, TRUE);
+    g_string_free(value, TRUE);
+    return ret;
+}
+
+/* Insert a row after the ids, which are only known to the thread
+ * writing to the database */
+static int
+InsertRowIds(DBProvider * pdb, const char *table, const DBRow * prow, unsigned int cIds, const char **aszId,
+             const int *anId)
+{
+    DBRow row;
+    unsigned int i;
+
+    for (i = 0; i < cIds; i++) {
+        row.aValues[i].szColumn = aszId[i];
+        row.aValues[i].t = DB_INT;
+        row.aValues[i].n = anId[i];
+    }
+    g_assert(cIds + prow->cValues <= DB_MAX_COLUMNS);
+    memcpy(row.aValues + cIds, prow->aValues, prow->cValues * sizeof(DBValue));
+    row.cValues = cIds + prow->cValues;
+
+    return InsertRow(pdb, table, &row);
+}
+
+static void
+StatsRow(DBRow * prow, int player, int nMatchTo, statcontext * sc)
+{
     int totalmoves, unforced;
     float errorcost, errorskill;
     float aaaar[3][2][2][2];
     float r;
-    int ret;
-    char tmpf[G_ASCII_DTOSTR_BUF_SIZE];
 
-    int gms_id = GetNextId(pdb, table);
-    if (gms_id == -1)
-        return FALSE;
+    prow->cValues = 0;
 
     totalmoves = sc->anTotalMoves[player];
     unforced = sc->anUnforcedMoves[player];
@@ -176,19 +256,6 @@ AddStats(DBProvider * pdb, int gm_id, int player_id, int player, const char *tab
     errorskill = aaaar[CUBEDECISION][PERMOVE][player][NORMALISED];
     errorcost = aaaar[CUBEDECISION][PERMOVE][player][UNNORMALISED];
 
-    column = g_string_new(NULL);
-    value = g_string_new(NULL);
-
-
-    if (strcmp("matchstat", table) == 0) {
-        APPENDI("matchstat_id", gms_id);
-        APPENDI("session_id", gm_id);
-    } else {
-        APPENDI("gamestat_id", gms_id);
-        APPENDI("game_id", gm_id);
-    }
-
-    APPENDI("player_id", player_id);
     APPENDI("total_moves", totalmoves);
     APPENDI("unforced_moves", unforced);
     APPENDI("unmarked_moves", sc->anMoves[player][SKILL_NONE]);
@@ -287,15 +354,6 @@ AddStats(DBProvider * pdb, int gm_id, int player_id, int player, const char *tab
         APPENDF("luck_adjusted_advantage", scMatch.arLuckAdj[player] / (float) scMatch.nGames);
         APPENDF("luck_adjusted_advantage_ci", 1.95996f * sqrtf(scMatch.arVarianceLuckAdj[player] / (float) scMatch.nGames));
     }
-
-    g_string_truncate(column, column->len - 2);
-    g_string_truncate(value, value->len - 2);
-    buf = g_strdup_printf("INSERT INTO %s (%s) VALUES(%s)", table, column->str, value->str);
-    ret = pdb->UpdateCommand(buf);
-    g_free(buf);
-    g_string_free(column, TRUE);
-    g_string_free(value, TRUE);
-    return ret;
 }
 
 int
@@ -375,17 +433,73 @@ ConnectToDB(DBProviderType dbType)
     return NULL;
 }
 
-static void
-AddGames(DBProvider * pdb, int session_id, int player_id0, int player_id1)
+/* A match ready to be written to the database. The rows are built on
+ * the main thread from the current match; the ids are only filled in
+ * when the rows are written, so that may happen on another thread. */
+typedef struct {
+    gchar *szFile;              /* NULL for the end of a queue */
+    gchar *szChecksum;
+    gchar *aszPlayer[2];
+    DBRow rowSession;
+    DBRow arowMatchStat[2];
+    unsigned int cGames;
+    DBRow *arowGame;
+    DBRow *arowGameStat;        /* two per game */
+    GStringChunk *pgsc;         /* text values of the rows */
+    int fWritten;
+} relmatch;
+
+static relmatch *
+RelationalMatchNew(const char *szFile)
 {
-    int gamenum = 0;
-    listOLD *plg, *pl = lMatch.plNext;
-    while ((plg = pl->p) != NULL) {
-        int game_id = GetNextId(pdb, "game");
+    relmatch *prm = g_new0(relmatch, 1);
+    DBRow *prow = &prm->rowSession;
+    char *date;
+    listOLD *plg, *pl;
+    unsigned int i;
+
+    prm->pgsc = g_string_chunk_new(1024);
+    prm->szFile = g_strdup(szFile);
+    prm->szChecksum = g_strdup(GetMatchCheckSum());
+    prm->aszPlayer[0] = g_strdup(ap[0].szName);
+    prm->aszPlayer[1] = g_strdup(ap[1].szName);
+
+    if (mi.nYear)
+        date = g_strdup_printf("%04u-%02u-%02u", mi.nYear, mi.nMonth, mi.nDay);
+    else
+        date = NULL;
+
+    APPENDS("checksum", prm->szChecksum);
+    APPENDI("result", MatchResult(ms.nMatchTo));
+    APPENDI("length", ms.nMatchTo);
+    APPENDNOW("added");
+    APPENDS("rating0", mi.pchRating[0]);
+    APPENDS("rating1", mi.pchRating[1]);
+    APPENDS("event", mi.pchEvent);
+    APPENDS("round", mi.pchRound);
+    APPENDS("place", mi.pchPlace);
+    APPENDS("annotator", mi.pchAnnotator);
+    APPENDS("comment", mi.pchComment);
+    APPENDS("date", date);
+    g_free(date);
+
+    updateStatisticsMatch(&lMatch);
+
+    StatsRow(&prm->arowMatchStat[0], 0, ms.nMatchTo, &scMatch);
+    StatsRow(&prm->arowMatchStat[1], 1, ms.nMatchTo, &scMatch);
+
+    if (!storeGameStats)
+        return prm;
+
+    for (pl = lMatch.plNext; pl->p; pl = pl->plNext)
+        prm->cGames++;
+    prm->arowGame = g_new(DBRow, prm->cGames);
+    prm->arowGameStat = g_new(DBRow, 2 * prm->cGames);
+
+    for (i = 0, pl = lMatch.plNext; (plg = pl->p) != NULL; i++, pl = pl->plNext) {
         int result = 0;
         moverecord *pmr = plg->plNext->p;
         xmovegameinfo *pmgi = &pmr->g;
-        char *buf;
 
         switch(pmgi->fWinner) {
             case 0:
@@ -400,28 +514,154 @@ AddGames(DBProvider * pdb, int session_id, int player_id0, int player_id1)
                 g_assert_not_reached();
         }
 
-        buf = g_strdup_printf("INSERT INTO game(game_id, session_id, player_id0, player_id1, "
-                                    "score_0, score_1, result, added, game_number, crawford) "
-                                    "VALUES (%d, %d, %d, %d, %d, %d, %d, CURRENT_TIMESTAMP, %d, %d )",
-                                    game_id, session_id, player_id0, player_id1,
-                                    pmgi->anScore[0], pmgi->anScore[1], result, ++gamenum, pmr->g.fCrawfordGame);
+        prow = &prm->arowGame[i];
+        prow->cValues = 0;
+        APPENDI("score_0", pmgi->anScore[0]);
+        APPENDI("score_1", pmgi->anScore[1]);
+        APPENDI("result", result);
+        APPENDNOW("added");
+        APPENDI("game_number", i + 1);
+        APPENDI("crawford", pmr->g.fCrawfordGame);
+
+        StatsRow(&prm->arowGameStat[2 * i], 0, ms.nMatchTo, &pmgi->sc);
+        StatsRow(&prm->arowGameStat[2 * i + 1], 1, ms.nMatchTo, &pmgi->sc);
+    }
 
-        if (pdb->UpdateCommand(buf)) {
-            AddStats(pdb, game_id, player_id0, 0, "gamestat", ms.nMatchTo, &(pmgi->sc));
-            AddStats(pdb, game_id, player_id1, 1, "gamestat", ms.nMatchTo, &(pmgi->sc));
-        }
-        g_free(buf);
-        pl = pl->plNext;
+    return prm;
+}
+
+static void
+RelationalMatchFree(relmatch * prm)
+{
+    g_free(prm->szFile);
+    g_free(prm->szChecksum);
+    g_free(prm->aszPlayer[0]);
+    g_free(prm->aszPlayer[1]);
+    g_free(prm->arowGame);
+    g_free(prm->arowGameStat);
+    if (prm->pgsc)
+        g_string_chunk_free(prm->pgsc);
+    g_free(prm);
+}
+
+static int
+RelationalMatchDelete(DBProvider * pdb, int existing_id)
+{
+    char *buf, *buf2;
+    int ok;
+
+    /* Remove any game stats and games */
+    buf2 = g_strdup_printf("FROM game WHERE session_id = %d", existing_id);
+    buf = g_strdup_printf("DELETE FROM gamestat WHERE game_id in (SELECT game_id %s)", buf2);
+    ok = pdb->UpdateCommand(buf);
+    g_free(buf);
+    buf = g_strdup_printf("DELETE %s", buf2);
+    ok = ok && pdb->UpdateCommand(buf);
+    g_free(buf);
+    g_free(buf2);
+
+    /* Remove any match stats and session */
+    buf = g_strdup_printf("DELETE FROM matchstat WHERE session_id = %d", existing_id);
+    ok = ok && pdb->UpdateCommand(buf);
+    g_free(buf);
+    buf = g_strdup_printf("DELETE FROM session WHERE session_id = %d", existing_id);
+    ok = ok && pdb->UpdateCommand(buf);
+    g_free(buf);
+
+    return ok;
+}
+
+/* Write a match, replacing any earlier copy of it; the caller owns
+ * the transaction and must undo what was written if this fails */
+static int
+RelationalMatchWrite(DBProvider * pdb, const relmatch * prm)
+{
+    static const char *aszSession[] = { "session_id", "player_id0", "player_id1" };
+    static const char *aszMatchStat[] = { "matchstat_id", "session_id", "player_id" };
+    static const char *aszGame[] = { "game_id", "session_id", "player_id0", "player_id1" };
+    static const char *aszGameStat[] = { "gamestat_id", "game_id", "player_id" };
+    int anId[4];
+    int session_id, matchstat_id, game_id = 0, gamestat_id = 0, player_id0, player_id1, existing_id;
+    unsigned int i;
+
+    existing_id = RelationalMatchExists(pdb, prm->szChecksum);
+    if (existing_id != -1 && !RelationalMatchDelete(pdb, existing_id))
+        return FALSE;
+
+    /* reserve all the ids at once rather than two round trips per row */
+    session_id = GetNextId(pdb, "session");
+    matchstat_id = GetNextIds(pdb, "matchstat", 2);
+    if (prm->cGames) {
+        game_id = GetNextIds(pdb, "game", (int) prm->cGames);
+        gamestat_id = GetNextIds(pdb, "gamestat", 2 * (int) prm->cGames);
+    }
+    player_id0 = AddPlayer(pdb, prm->aszPlayer[0]);
+    player_id1 = AddPlayer(pdb, prm->aszPlayer[1]);
+    if (session_id == -1 || matchstat_id == -1 || game_id == -1 || gamestat_id == -1 || player_id0 == -1
+        || player_id1 == -1)
+        return FALSE;
+
+    anId[0] = session_id;
+    anId[1] = player_id0;
+    anId[2] = player_id1;
+    if (!InsertRowIds(pdb, "session", &prm->rowSession, 3, aszSession, anId))
+        return FALSE;
+
+    for (i = 0; i < 2; i++) {
+        anId[0] = matchstat_id + (int) i;
+        anId[1] = session_id;
+        anId[2] = i ? player_id1 : player_id0;
+        if (!InsertRowIds(pdb, "matchstat", &prm->arowMatchStat[i], 3, aszMatchStat, anId))
+            return FALSE;
+    }
+
+    for (i = 0; i < prm->cGames; i++, game_id++, gamestat_id += 2) {
+        anId[0] = game_id;
+        anId[1] = session_id;
+        anId[2] = player_id0;
+        anId[3] = player_id1;
+        if (!InsertRowIds(pdb, "game", &prm->arowGame[i], 4, aszGame, anId))
+            return FALSE;
+        anId[0] = gamestat_id;
+        anId[1] = game_id;
+        anId[2] = player_id0;
+        if (!InsertRowIds(pdb, "gamestat", &prm->arowGameStat[2 * i], 3, aszGameStat, anId))
+            return FALSE;
+        anId[0] = gamestat_id + 1;
+        anId[2] = player_id1;
+        if (!InsertRowIds(pdb, "gamestat", &prm->arowGameStat[2 * i + 1], 3, aszGameStat, anId))
+            return FALSE;
     }
+
+    return TRUE;
+}
+
+/* Write a match inside a savepoint, so that a failure halfway undoes
+ * the rows already written without losing the rest of the caller's
+ * transaction */
+static int
+RelationalMatchWriteSavepoint(DBProvider * pdb, const relmatch * prm)
+{
+    int fWritten;
+
+    if (!pdb->UpdateCommand("SAVEPOINT relmatch"))
+        return FALSE;
+
+    fWritten = RelationalMatchWrite(pdb, prm);
+
+    if (!fWritten)
+        pdb->UpdateCommand("ROLLBACK TO SAVEPOINT relmatch");
+    pdb->UpdateCommand("RELEASE SAVEPOINT relmatch");
+
+    return fWritten;
 }
 
 extern void
 CommandRelationalAddMatch(char *sz)
 {
     DBProvider *pdb;
-    char *buf, *date;
+    relmatch *prm;
     char warnings[1024] = "";
-    int session_id, existing_id, player_id0, player_id1;
     char *arg = NULL;
     gboolean quiet = FALSE;
 
@@ -450,66 +690,221 @@ CommandRelationalAddMatch(char *sz)
         outputerrf(_("Error opening database"));
         return;
     }
-    existing_id = RelationalMatchExists(pdb);
-    if (existing_id != -1) {
-        char *buf2;
 
-        if (!quiet && !GetInputYN(_("Match exists, overwrite?")))
+    prm = RelationalMatchNew(NULL);
+
+    if (quiet || RelationalMatchExists(pdb, prm->szChecksum) == -1
+        || GetInputYN(_("Match exists, overwrite?"))) {
+        /* Write the whole match in one transaction */
+        if (pdb->Begin)
+            pdb->Begin();
+        if (!RelationalMatchWriteSavepoint(pdb, prm))
+            outputl(_("Error adding match."));
+        /* after a failure nothing of the match is left to commit, but
+         * the transaction must still be ended */
+        pdb->Commit();
+    }
+
+    RelationalMatchFree(prm);
+    pdb->Disconnect();
+}
+
+/* Bulk import of a directory of matches. The reader thread of
+ * MatchDirOpen() detects the format of the files, the main thread
+ * imports each match and optionally analyses it with the calculation
+ * threads, and a writer thread stores the finished matches, many to a
+ * transaction. */
+
+#define RELIMPORT_BATCH 64      /* matches per transaction */
+#define RELIMPORT_PENDING 16    /* matches waiting for the writer */
+
+typedef struct {
+    GAsyncQueue *paqMatches;    /* main thread -> writer: relmatch */
+    GAsyncQueue *paqWritten;    /* writer -> main thread: relmatch */
+    DBProvider *pdb;
+} relimport;
+
+static void
+RelImportWrite(relimport * pri, relmatch * prm, int *pc)
+{
+    DBProvider *pdb = pri->pdb;
+
+    if (*pc == 0 && pdb->Begin)
+        pdb->Begin();
+
+    /* a match that fails is undone without losing the others of the
+     * transaction */
+    prm->fWritten = RelationalMatchWriteSavepoint(pdb, prm);
+
+    if (++*pc == RELIMPORT_BATCH) {
+        pri->pdb->Commit();
+        *pc = 0;
+    }
+}
+
+#if defined(USE_MULTITHREAD)
+static gpointer
+RelImportWriter(gpointer p)
+{
+    relimport *pri = p;
+    relmatch *prm;
+    int c = 0;
+
+    while ((prm = g_async_queue_pop(pri->paqMatches))->szFile) {
+        RelImportWrite(pri, prm, &c);
+        g_async_queue_push(pri->paqWritten, prm);
+    }
+    RelationalMatchFree(prm);
+
+    if (c)
+        pri->pdb->Commit();
+
+    return NULL;
+}
+#endif
+
+static void
+RelImportWritten(relmatch * prm, int *pnAdded)
+{
+    if (prm->fWritten)
+        ++*pnAdded;
+    else
+        outputf(_("Error adding match `%s'\n"), prm->szFile);
+    RelationalMatchFree(prm);
+}
+
+extern void
+CommandRelationalAddDirectory(char *sz)
+{
+    relimport ri;
+    matchdir *pmd;
+    relmatch *prm;
+    ImportType type;
+    GThread *ptWriter = NULL;
+    GTimer *timer;
+    int fAnalyse = FALSE, fConfirmNewOld = fConfirmNew, fAutoSaveConfirmDeleteOld = fAutoSaveConfirmDelete;
+#if defined(USE_MULTITHREAD)
+    int fWriterThread;
+#endif
+    int cPending = 0, nAdded = 0, nSkipped = 0, nDone = 0, cBatch = 0;
+    double rElapsed;
+    char *szDir, *szFile, *arg;
+
+    szDir = NextToken(&sz);
+    if (!szDir || !*szDir) {
+        outputl(_("You must specify a directory to import (see `help relational add directory')."));
+        return;
+    }
+    while ((arg = NextToken(&sz))) {
+        if (!StrNCaseCmp(arg, "analyse", strlen(arg)) || !StrNCaseCmp(arg, "analyze", strlen(arg)))
+            fAnalyse = TRUE;
+        else {
+            outputf(_("Unknown keyword `%s' (see `help relational add directory').\n"), arg);
             return;
+        }
+    }
 
-        /* Remove any game stats and games */
-        buf2 = g_strdup_printf("FROM game WHERE session_id = %d", existing_id);
-        buf = g_strdup_printf("DELETE FROM gamestat WHERE game_id in (SELECT game_id %s)", buf2);
-        pdb->UpdateCommand(buf);
-        g_free(buf);
-        buf = g_strdup_printf("DELETE %s", buf2);
-        pdb->UpdateCommand(buf);
-        g_free(buf);
-        g_free(buf2);
+    if (!(pmd = MatchDirOpen(szDir)))
+        return;
 
-        /* Remove any match stats and session */
-        buf = g_strdup_printf("DELETE FROM matchstat WHERE session_id = %d", existing_id);
-        pdb->UpdateCommand(buf);
-        g_free(buf);
-        buf = g_strdup_printf("DELETE FROM session WHERE session_id = %d", existing_id);
-        pdb->UpdateCommand(buf);
-        g_free(buf);
+    if (!get_input_discard()) {
+        MatchDirClose(pmd);
+        return;
     }
 
-    session_id = GetNextId(pdb, "session");
-    player_id0 = AddPlayer(pdb, ap[0].szName);
-    player_id1 = AddPlayer(pdb, ap[1].szName);
-    if (session_id == -1 || player_id0 == -1 || player_id1 == -1) {
-        outputl(_("Error adding match."));
+    if ((ri.pdb = ConnectToDB(dbProviderType)) == NULL) {
+        outputerrf(_("Error opening database"));
+        MatchDirClose(pmd);
         return;
     }
 
-    if (mi.nYear)
-        date = g_strdup_printf("%04u-%02u-%02u", mi.nYear, mi.nMonth, mi.nDay);
-    else
-        date = NULL;
+    ri.paqMatches = g_async_queue_new();
+    ri.paqWritten = g_async_queue_new();
+
+#if defined(USE_MULTITHREAD)
+    /* the Python providers must only be used from the main thread */
+    fWriterThread = ri.pdb->Insert != NULL;
+#if defined(USE_GTK)
+    /* and the providers report errors with outputerrf(), which must
+     * only reach the GUI from the main thread */
+    if (fX)
+        fWriterThread = FALSE;
+#endif
+    if (fWriterThread)
+#if GLIB_CHECK_VERSION (2,32,0)
+        ptWriter = g_thread_try_new(NULL, RelImportWriter, &ri, NULL);
+#else
+        ptWriter = g_thread_create(RelImportWriter, &ri, TRUE, NULL);
+#endif
+#endif
 
-    buf = g_strdup_printf("INSERT INTO session(session_id, checksum, player_id0, player_id1, "
-                          "result, length, added, rating0, rating1, event, round, place, annotator, comment, date) "
-                          "VALUES (%d, '%s', %d, %d, %d, %d, CURRENT_TIMESTAMP, '%s', '%s', '%s', '%s', '%s', '%s', '%s', '%s')",
-                          session_id, GetMatchCheckSum(), player_id0, player_id1,
-                          MatchResult(ms.nMatchTo), ms.nMatchTo, NS(mi.pchRating[0]), NS(mi.pchRating[1]),
-                          NS(mi.pchEvent), NS(mi.pchRound), NS(mi.pchPlace), NS(mi.pchAnnotator), NS(mi.pchComment),
-                          NS(date));
+    /* the current match is discarded; the imported ones replace each
+     * other without asking */
+    fConfirmNew = FALSE;
+    fAutoSaveConfirmDelete = FALSE;
 
-    updateStatisticsMatch(&lMatch);
+    timer = g_timer_new();
+    /* the analysis has a progress bar of its own */
+    if (!fAnalyse)
+        ProgressStartValue(_("Importing matches; file:"), (int) MatchDirSize(pmd));
 
-    if (pdb->UpdateCommand(buf)) {
-        if (AddStats(pdb, session_id, player_id0, 0, "matchstat", ms.nMatchTo, &scMatch) &&
-            AddStats(pdb, session_id, player_id1, 1, "matchstat", ms.nMatchTo, &scMatch)) {
-            if (storeGameStats)
-                AddGames(pdb, session_id, player_id0, player_id1);
-            pdb->Commit();
+    while (!fInterrupt && (szFile = MatchDirNext(pmd, &type))) {
+        if (fAnalyse)
+            outputf("(%d/%u) %s\n", ++nDone, MatchDirSize(pmd), szFile);
+        else
+            ProgressValue(++nDone);
+
+        if (!MatchDirLoad(szFile, type))
+            nSkipped++;
+        else {
+            if (fAnalyse)
+                CommandAnalyseMatch(NULL);
+
+            prm = RelationalMatchNew(szFile);
+            if (ptWriter) {
+                g_async_queue_push(ri.paqMatches, prm);
+                /* don't let the parsed matches pile up ahead of the writer */
+                if (++cPending > RELIMPORT_PENDING) {
+                    RelImportWritten(g_async_queue_pop(ri.paqWritten), &nAdded);
+                    cPending--;
+                }
+            } else {
+                RelImportWrite(&ri, prm, &cBatch);
+                RelImportWritten(prm, &nAdded);
+            }
         }
+
+        while (ptWriter && (prm = g_async_queue_try_pop(ri.paqWritten))) {
+            RelImportWritten(prm, &nAdded);
+            cPending--;
+        }
+
+        g_free(szFile);
     }
-    g_free(buf);
-    g_free(date);
-    pdb->Disconnect();
+
+    if (ptWriter) {
+        g_async_queue_push(ri.paqMatches, g_new0(relmatch, 1));
+        g_thread_join(ptWriter);
+        while ((prm = g_async_queue_try_pop(ri.paqWritten)))
+            RelImportWritten(prm, &nAdded);
+    } else if (cBatch)
+        ri.pdb->Commit();
+
+    if (!fAnalyse)
+        ProgressEnd();
+    rElapsed = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+
+    fConfirmNew = fConfirmNewOld;
+    fAutoSaveConfirmDelete = fAutoSaveConfirmDeleteOld;
+
+    ri.pdb->Disconnect();
+    g_async_queue_unref(ri.paqMatches);
+    g_async_queue_unref(ri.paqWritten);
+    MatchDirClose(pmd);
+
+    outputf(_("%d matches added to the database, %d files skipped, in %.1f seconds (%.1f matches/s)\n"),
+            nAdded, nSkipped, rElapsed, rElapsed > 0.0 ? nAdded / rElapsed : 0.0);
 }
 
 const char *
@@ -0,0 +1,344 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <glib.h>
+
+#include "backgammon.h"
+#include "scoremap.h"
+#include "format.h"
+#include "multithread.h"
+
+/* At 0-ply the cubeless evaluation doesn't depend on the score, so
+ * the cells share it, this many at a time */
+#define SCOREMAP_CHUNK 64
+
+typedef struct {
+    TanBoard anBoard;
+    int anDice[2];
+    evalcontext ec;
+    movefilter(*aamf)[MAX_FILTER_PLIES];
+    scoremapcell *asmc;
+    int iNext;
+} scoremapcalc;
+
+extern int
+ScoreMapCellCubeInfo(cubeinfo * pci, const matchstate * pms, int fCubeMap, int nMatchTo, int i, int j)
+{
+    matchstate ams = *pms;
+
+    /* the score is changed in the match state rather than in the
+     * cubeinfo, so that the gammon prices are right */
+    ams.nMatchTo = nMatchTo;
+
+    if (fCubeMap) {
+        ams.anScore[0] = nMatchTo - i - 2;
+        ams.anScore[1] = nMatchTo - j - 2;
+        ams.fCrawford = ams.fPostCrawford = FALSE;
+    } else {
+        /* one player in the Crawford game and the other after it */
+        if ((i == 0 && j == 1) || (i == 1 && j == 0) || (i == 1 && j == 1))
+            return FALSE;
+        /* no doubling in the Crawford game */
+        if (ams.nCube > 1 && (i == 1 || j == 1))
+            return FALSE;
+
+        ams.fCrawford = (i == 1 || j == 1);
+        ams.fPostCrawford = (i == 0 || j == 0);
+        ams.anScore[0] = nMatchTo - MAX(i, 1);
+        ams.anScore[1] = nMatchTo - MAX(j, 1);
+    }
+
+    GetMatchStateCubeInfo(pci, &ams);
+
+    return TRUE;
+}
+
+static float
+CellEquity(float r, const cubeinfo * pci)
+{
+    return pci->nMatchTo ? mwc2eq(r, pci) : r;
+}
+
+static void
+ScoreMapCubeTask(void *p)
+{
+    scoremapcalc *pcalc = (scoremapcalc *) p;
+    scoremapcell *psmc = &pcalc->asmc[MT_SafeIncCheck(&pcalc->iNext)];
+    float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
+
+    if (fInterrupt)
+        return;
+
+    if (GeneralCubeDecisionE(aarOutput, (ConstTanBoard) pcalc->anBoard, &psmc->ci, &pcalc->ec, NULL) < 0) {
+        MT_SetResultFailed();
+        return;
+    }
+
+    psmc->rNoDouble = CellEquity(aarOutput[0][OUTPUT_CUBEFUL_EQUITY], &psmc->ci);
+    psmc->rDoubleTake = CellEquity(aarOutput[1][OUTPUT_CUBEFUL_EQUITY], &psmc->ci);
+    MT_SafeSet(&psmc->fDone, TRUE);
+}
+
+static void
+ScoreMapMoveTask(void *p)
+{
+    scoremapcalc *pcalc = (scoremapcalc *) p;
+    scoremapcell *psmc = &pcalc->asmc[MT_SafeIncCheck(&pcalc->iNext)];
+
+    if (fInterrupt)
+        return;
+
+    if (FindnSaveBestMoves(&psmc->ml, pcalc->anDice[0], pcalc->anDice[1], (ConstTanBoard) pcalc->anBoard, NULL,
+                           arSkillLevel[SKILL_DOUBTFUL], &psmc->ci, &pcalc->ec, pcalc->aamf) < 0) {
+        MT_SetResultFailed();
+        return;
+    }
+
+    MT_SafeSet(&psmc->fDone, TRUE);
+}
+
+/* One task per cell, so that the cells are shared evenly between the
+ * threads and the callback sees them finish one by one */
+
+static int
+ScoreMapRun(AsyncFun fun, scoremapcalc * pcalc, unsigned int n, gboolean(*pCallback) (gpointer))
+{
+    unsigned int i;
+    int ret;
+
+    for (i = 0; i < n; i++)
+        pcalc->asmc[i].fDone = FALSE;
+    pcalc->iNext = 0;
+
+    if (!n)
+        return 0;
+
+    mt_add_tasks(n, fun, pcalc, NULL);
+    ret = MT_WaitForTasks(pCallback, UI_UPDATETIME, FALSE);
+
+    return (ret < 0 || fInterrupt) ? -1 : 0;
+}
+
+/* All the cells from one cubeful evaluation */
+
+static int
+ScoreMapCubeStatic(const TanBoard anBoard, const evalcontext * pec, scoremapcell asmc[], unsigned int n)
+{
+    cubeinfo aci[SCOREMAP_CHUNK];
+    float aarCubeful[SCOREMAP_CHUNK][2];
+    unsigned int i, iChunk, c;
+
+    for (iChunk = 0; iChunk < n; iChunk += c) {
+        c = MIN(n - iChunk, SCOREMAP_CHUNK);
+
+        for (i = 0; i < c; i++)
+            aci[i] = asmc[iChunk + i].ci;
+
+        if (GeneralCubeDecisionsE(aarCubeful, anBoard, aci, (int) c, pec) < 0)
+            return -1;
+
+        for (i = 0; i < c; i++) {
+            scoremapcell *psmc = &asmc[iChunk + i];
+
+            psmc->rNoDouble = CellEquity(aarCubeful[i][0], &psmc->ci);
+            psmc->rDoubleTake = CellEquity(aarCubeful[i][1], &psmc->ci);
+            psmc->fDone = TRUE;
+        }
+    }
+
+    return 0;
+}
+
+extern int
+ScoreMapCalcCube(const TanBoard anBoard, const evalcontext * pec,
+                 scoremapcell asmc[], unsigned int n, gboolean(*pCallback) (gpointer))
+{
+    scoremapcalc calc;
+
+    /* Beyond 0-ply the best moves in the search depend on the score,
+     * so each cell needs its own search */
+    if (pec->nPlies == 0)
+        return ScoreMapCubeStatic(anBoard, pec, asmc, n);
+
+    memcpy(calc.anBoard, anBoard, sizeof(TanBoard));
+    calc.ec = *pec;
+    calc.asmc = asmc;
+
+    return ScoreMapRun(ScoreMapCubeTask, &calc, n, pCallback);
+}
+
+extern int
+ScoreMapCalcMove(const TanBoard anBoard, const unsigned int anDice[2], const evalcontext * pec,
+                 movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES],
+                 scoremapcell asmc[], unsigned int n, gboolean(*pCallback) (gpointer))
+{
+    scoremapcalc calc;
+
+    memcpy(calc.anBoard, anBoard, sizeof(TanBoard));
+    calc.anDice[0] = (int) anDice[0];
+    calc.anDice[1] = (int) anDice[1];
+    calc.ec = *pec;
+    calc.aamf = aamf;
+    calc.asmc = asmc;
+
+    return ScoreMapRun(ScoreMapMoveTask, &calc, n, pCallback);
+}
+
+extern const char *
+ScoreMapCubeAction(float rNoDouble, float rDoubleTake)
+{
+    float rDouble = MIN(rDoubleTake, 1.0f);
+
+    if (rNoDouble < rDouble)
+        return rDoubleTake < 1.0f ? "D/T" : "D/P";
+    else
+        return rDoubleTake < 1.0f ? "ND" : "TGTD";
+}
+
+static void
+CellText(char *sz, const scoremapcell * psmc, int fCubeMap, const matchstate * pms)
+{
+    if (!psmc)
+        strcpy(sz, "-");
+    else if (fCubeMap)
+        strcpy(sz, ScoreMapCubeAction(psmc->rNoDouble, psmc->rDoubleTake));
+    else if (psmc->ml.cMoves)
+        FormatMove(sz, (ConstTanBoard) pms->anBoard, psmc->ml.amMoves[0].anMove);
+    else
+        strcpy(sz, _("no move"));
+}
+
+static const char *
+AwayText(char *sz, int fCubeMap, int i)
+{
+    if (fCubeMap)
+        sprintf(sz, _("%d-away"), i + 2);
+    else if (i == 0)
+        strcpy(sz, _("1-away PC"));
+    else if (i == 1)
+        strcpy(sz, _("1-away C"));
+    else
+        sprintf(sz, _("%d-away"), i);
+
+    return sz;
+}
+
+extern int
+ScoreMapTableCalc(scoremaptable * pst, const matchstate * pms, int fCubeMap, int nMatchTo)
+{
+    /* cube maps start at 2-away, move maps at 1-away post-Crawford */
+    unsigned int cSize = fCubeMap ? (unsigned int) nMatchTo - 1 : (unsigned int) nMatchTo + 1;
+    const evalsetup *pes = fCubeMap ? GetEvalCube() : GetEvalChequer();
+    unsigned int i, j, n = 0;
+    matchstate msMoney = *pms;
+    int ret;
+
+    pst->fCubeMap = fCubeMap;
+    pst->nMatchTo = nMatchTo;
+    pst->cSize = cSize;
+    pst->nPlies = pes->ec.nPlies;
+    pst->asmc = g_new0(scoremapcell, cSize * cSize + 1);
+    pst->apsmc = g_new0(scoremapcell *, cSize * cSize + 1);
+
+    for (i = 0; i < cSize; i++)
+        for (j = 0; j < cSize; j++)
+            if (ScoreMapCellCubeInfo(&pst->asmc[n].ci, pms, fCubeMap, nMatchTo, (int) i, (int) j)
+                && (!fCubeMap || GetDPEq(NULL, NULL, &pst->asmc[n].ci)))
+                pst->apsmc[i * cSize + j] = &pst->asmc[n++];
+
+    msMoney.nMatchTo = 0;
+    msMoney.fJacoby = fJacoby;
+    GetMatchStateCubeInfo(&pst->asmc[n].ci, &msMoney);
+    if (!fCubeMap || GetDPEq(NULL, NULL, &pst->asmc[n].ci))
+        pst->apsmc[cSize * cSize] = &pst->asmc[n++];
+    pst->n = n;
+
+    ProgressStartValue(_("Finding correct actions"), (int) n);
+    if (fCubeMap)
+        ret = ScoreMapCalcCube((ConstTanBoard) pms->anBoard, &pes->ec, pst->asmc, n, NULL);
+    else
+        ret = ScoreMapCalcMove((ConstTanBoard) pms->anBoard, pms->anDice, &pes->ec, aamfEval,
+                               pst->asmc, n, NULL);
+    ProgressEnd();
+
+    return ret;
+}
+
+extern void
+ScoreMapTableFree(scoremaptable * pst)
+{
+    unsigned int i;
+
+    for (i = 0; i < pst->n; i++)
+        g_free(pst->asmc[i].ml.amMoves);
+    g_free(pst->asmc);
+    g_free(pst->apsmc);
+}
+
+extern void
+ScoreMapOutput(const matchstate * pms, int fCubeMap, int nMatchTo)
+{
+    scoremaptable st;
+    unsigned int i, j, cSize;
+    char sz[FORMATEDMOVESIZE], szAway[32];
+
+    if (ScoreMapTableCalc(&st, pms, fCubeMap, nMatchTo) < 0) {
+        outputl(_("Interrupted."));
+        ScoreMapTableFree(&st);
+        return;
+    }
+    cSize = st.cSize;
+
+    outputf(fCubeMap ? _("Cube actions at each score of a %d point match (%u-ply)\n")
+            : _("Best moves at each score of a %d point match (%u-ply)\n"), nMatchTo, st.nPlies);
+    outputf(_("Rows are %s's away score, columns %s's.\n\n"), ap[0].szName, ap[1].szName);
+
+    if (fCubeMap) {
+        outputf("%-10s", "");
+        for (j = 0; j < cSize; j++)
+            outputf(" %-8s", AwayText(szAway, fCubeMap, (int) j));
+        outputc('\n');
+        for (i = 0; i < cSize; i++) {
+            outputf("%-10s", AwayText(szAway, fCubeMap, (int) i));
+            for (j = 0; j < cSize; j++) {
+                CellText(sz, st.apsmc[i * cSize + j], fCubeMap, pms);
+                outputf(" %-8s", sz);
+            }
+            outputc('\n');
+        }
+    } else {
+        /* the moves are too wide for a table */
+        for (i = 0; i < cSize; i++)
+            for (j = 0; j < cSize; j++) {
+                if (!st.apsmc[i * cSize + j])
+                    continue;
+                CellText(sz, st.apsmc[i * cSize + j], fCubeMap, pms);
+                outputf("%-10s ", AwayText(szAway, fCubeMap, (int) i));
+                outputf("%-10s %s\n", AwayText(szAway, fCubeMap, (int) j), sz);
+            }
+    }
+
+    CellText(sz, st.apsmc[cSize * cSize], fCubeMap, pms);
+    outputf(_("\nMoney: %s\n"), sz);
+
+    ScoreMapTableFree(&st);
+}
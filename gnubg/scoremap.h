@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef SCOREMAP_H
+#define SCOREMAP_H
+
+#include "eval.h"
+
+/* Score maps: the correct cube action or best move of a position at
+ * every score of a match. The cells are evaluated on the calculation
+ * threads; the GTK score map and "show scoremap" without a GUI are
+ * both built on this. */
+
+typedef struct {
+    cubeinfo ci;                /* the score and cube of the cell */
+    int fDone;                  /* set when the results are in */
+    float rNoDouble;            /* cube maps: equity after no double */
+    float rDoubleTake;          /* and after double, take */
+    movelist ml;                /* move maps: the best moves first */
+} scoremapcell;
+
+/* The cube and score of cell (i, j) of a map for a match to nMatchTo,
+ * with the cube of pms. In a cube map player 0 is i + 2 away and player
+ * 1 j + 2 away. In a move map i and j are the away scores, with 1 for
+ * the Crawford game and 0 for post-Crawford. Returns FALSE if the score
+ * can't occur. */
+extern int ScoreMapCellCubeInfo(cubeinfo * pci, const matchstate * pms, int fCubeMap, int nMatchTo, int i, int j);
+
+/* Evaluate the cube action in all the cells. pCallback is called
+ * regularly while waiting, and may look at the cells with fDone set.
+ * Returns -1 on error or interrupt. */
+extern int ScoreMapCalcCube(const TanBoard anBoard, const evalcontext * pec,
+                            scoremapcell asmc[], unsigned int n, gboolean(*pCallback) (gpointer));
+/* Find the best moves for anDice in all the cells; free the move lists
+ * with g_free(ml.amMoves). */
+extern int ScoreMapCalcMove(const TanBoard anBoard, const unsigned int anDice[2], const evalcontext * pec,
+                            movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES],
+                            scoremapcell asmc[], unsigned int n, gboolean(*pCallback) (gpointer));
+
+/* "ND", "D/T", "D/P" or "TGTD" */
+extern const char *ScoreMapCubeAction(float rNoDouble, float rDoubleTake);
+
+/* A whole map, as "show scoremap" and the Python gnubg.scoremap() see it */
+typedef struct {
+    int fCubeMap;
+    int nMatchTo;
+    unsigned int nPlies;
+    unsigned int cSize;         /* the map has cSize x cSize cells */
+    unsigned int n;
+    scoremapcell *asmc;
+    scoremapcell **apsmc;       /* cell (i, j) is apsmc[i * cSize + j], money
+                                 * is apsmc[cSize * cSize]; NULL where the
+                                 * score can't occur or the cube isn't
+                                 * available */
+} scoremaptable;
+
+/* Evaluate the map of the position in pms with the evaluation settings
+ * for cube or chequer play; free it with ScoreMapTableFree() even if
+ * interrupted (-1) */
+extern int ScoreMapTableCalc(scoremaptable * pst, const matchstate * pms, int fCubeMap, int nMatchTo);
+extern void ScoreMapTableFree(scoremaptable * pst);
+
+/* Print the score map of the position in pms */
+extern void ScoreMapOutput(const matchstate * pms, int fCubeMap, int nMatchTo);
+
+#endif                          /* SCOREMAP_H */
@@ -19,7 +19,7 @@
 #
 
 """
- db_import.py -- batch import of multiple sgf files into relational database
+ db_import.py -- batch import of a directory of matches into relational database
 
  by Jon Kinsey <Jon_Kinsey@hotmail.com>, 2004
 \n"""
@@ -34,7 +34,7 @@ if sys.version_info >= (3, 0):
     raw_input = python3_raw_input
 
 def GetFiles(dir):
-    "Look for gnubg import files in dir"
+    "Look for files in dir; gnubg skips those it can't import"
     try:
         files = os.listdir(dir)
     except:
@@ -42,38 +42,19 @@ def GetFiles(dir):
         return 0
 
     fileList = []
-    foundAnyFile = False
-    foundBGFile = False
     # Check each file in dir
     for file in files:
         # Check it's a file (not a directory)
         if os.path.isfile(dir + file):
-            foundAnyFile = True
-            # Check has supported extension
-            dot = file.rfind('.')
-            if dot != -1:
-                ext = file[dot + 1:].lower()
-                if ext == "sgf":
-                    foundBGFile = True
-                    fileList.append(file)
-
-    if foundBGFile:
+            fileList.append(file)
+
+    if fileList:
         return fileList
     else:
-        if not foundAnyFile:
-            print ("  ** No files in directory **")
-        else:
-            print ("  ** No sgf files found in directory **")
+        print ("  ** No files in directory **")
         return 0
 
 
-def ImportFile(prompt, file, dir):
-    "Run commands to import stats into gnubg"
-    print (prompt + " Importing " + file)
-    gnubg.command('load match "' + dir + file + '"')
-    gnubg.command('relational add match')
-
-
 def GetYN(prompt):
     confirm = ''
     while len(confirm) == 0 or (confirm[0] != 'y' and confirm[0] != 'n'):
@@ -91,7 +72,7 @@ def GetDir(prompt):
 
 
 def BatchImport():
-    "Import stats for all sgf files in a directory"
+    "Import stats for all the matches in a directory"
 
     inFiles = []
     while not inFiles:
@@ -107,18 +88,15 @@ def BatchImport():
     for file in inFiles:
         print ("    " + file)
 
-    print ("\n", len(inFiles), "files found\n")
+    print ("\n", len(inFiles), "files found; those that aren't matches will be skipped\n")
 
     # Check user wants to continue
     if GetYN("Continue") == 'n':
         return
 
-    # Get stats for each file
-    num = 0
-    for file in inFiles:
-        num = num + 1
-        prompt = "(%d/%d)" % (num, len(inFiles))
-        ImportFile(prompt, file, dir)
+    # Import the whole directory at once, so that reading the files,
+    # analysing and writing to the database overlap
+    gnubg.command('relational add directory "' + dir + '"')
 
     print ("\n** Finished **")
     return
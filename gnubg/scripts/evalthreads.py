@@ -0,0 +1,104 @@
+# Copyright (C) 2026 the AUTHORS
+
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#
+# $Id$
+#
+
+"""
+ evalthreads.py -- measure gnubg.evaluate() and gnubg.findbestmove()
+ called from several Python threads at once
+
+ Usage: gnubg -t -q -p evalthreads.py
+    or, to choose the number of positions and the plies, at the
+    gnubg Python prompt: from evalthreads import *; main(1000, 2)
+
+ Each run evaluates fresh random positions, so that the evaluation
+ cache doesn't flatter the later runs. With a multithreaded gnubg the
+ evaluations release the GIL and the throughput should grow nearly
+ linearly with the number of threads, up to the number of cores.
+\n"""
+
+import random
+import threading
+import time
+
+import gnubg
+
+try:
+    from multiprocessing import cpu_count
+except ImportError:
+    def cpu_count():
+        return 2
+
+
+def randomBoard(rng):
+    """Return a random legal board as the tuple gnubg.board() returns."""
+    while True:
+        board = [[0] * 25, [0] * 25]
+        for side in (0, 1):
+            for i in range(15):
+                board[side][rng.randint(0, 24)] += 1
+        # no point may be held by both sides
+        if all(board[0][i] == 0 or board[1][23 - i] == 0 for i in range(24)):
+            return (tuple(board[0]), tuple(board[1]))
+
+
+def worker(boards, cubeinfo, evalcontext, counts, i):
+    n = 0
+    for board in boards:
+        gnubg.evaluate(board, cubeinfo, evalcontext)
+        gnubg.findbestmove(board, cubeinfo, evalcontext, (3, 1))
+        n += 1
+    counts[i] = n
+
+
+def run(nThreads, nPositions, evalcontext, rng):
+    cubeinfo = gnubg.cubeinfo()
+    boards = [randomBoard(rng) for i in range(nPositions)]
+    counts = [0] * nThreads
+    threads = [threading.Thread(target=worker,
+                                args=(boards[i::nThreads], cubeinfo,
+                                      evalcontext, counts, i))
+               for i in range(nThreads)]
+
+    start = time.time()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.time() - start
+
+    return sum(counts) / elapsed
+
+
+def main(nPositions=400, nPlies=1):
+    evalcontext = {'cubeful': 0, 'plies': nPlies, 'deterministic': 1,
+                   'prune': 1, 'noise': 0.0}
+    rng = random.Random(1)
+
+    nThreads = 1
+    rBase = None
+    print("threads  positions/s  speedup")
+    while nThreads <= cpu_count():
+        r = run(nThreads, nPositions, evalcontext, rng)
+        if rBase is None:
+            rBase = r
+        print("%7d  %11.1f  %7.2f" % (nThreads, r, r / rBase))
+        nThreads *= 2
+
+
+if __name__ == "__main__":
+    main()
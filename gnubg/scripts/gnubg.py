@@ -263,8 +263,9 @@ def exportBad(baseName):
     """ For current analyzed match, export all moves/cube decisions marked
     doubtful or bad"""
 
-    # Get current match
-    m = gnubg.match()
+    # Get a lazy view of the current match; only the analysis of each
+    # record is looked at
+    m = gnubg.matchview(boards=0)
 
     # Go to match start
     gnubg.navigate()
@@ -275,8 +276,8 @@ def exportBad(baseName):
     # Exported position number, used in file name
     poscount = 0
 
-    for game in m["games"]:
-        for action in game["game"]:
+    for game in m:
+        for action in game:
 
             analysis = action.get("analysis", None)
             if analysis:
@@ -72,6 +72,7 @@
 #include "matchequity.h"
 #include "positionid.h"
 #include "matchid.h"
+#include "ponder.h"
 #include "renderprefs.h"
 #include "drawboard.h"
 #include "format.h"
@@ -3140,6 +3141,72 @@ CommandSetAnalysisMoveFilter(char *sz)
 
 }
 
+extern void
+CommandSetPonder(char *sz)
+{
+
+    SetToggle("ponder", &fPonder, sz,
+              _("GNU Backgammon will think ahead while the opponent is to play."),
+              _("GNU Backgammon will not think ahead while the opponent is to play."));
+
+#if !defined(USE_MULTITHREAD)
+    if (fPonder)
+        outputl(_("This installation of GNU Backgammon was compiled without thread support, "
+                  "and does not ponder."));
+#endif
+}
+
+extern void
+CommandSetAdaptiveFiltersConfidence(char *sz)
+{
+
+    float r = ParseReal(&sz);
+
+    if (r <= 0.0f) {
+        outputl(_("You must specify a positive number of standard deviations "
+                  "(see `help set adaptivefilters confidence')."));
+        return;
+    }
+
+    rFilterConfidence = r;
+
+    outputf(_("Adaptive move filters keep the moves within %.2f standard deviations of the best one.\n"), r);
+}
+
+extern void
+CommandSetAdaptiveFiltersEnable(char *sz)
+{
+
+    SetToggle("adaptivefilters enable", &fAdaptiveFilters, sz,
+              _("Moves will be filtered by their expected error."),
+              _("Moves will be filtered by the fixed thresholds."));
+}
+
+extern void
+CommandSetAdaptiveFiltersSigma(char *sz)
+{
+
+    int i = ParseNumber(&sz);
+    int j = ParseNumber(&sz);
+    float r = ParseReal(&sz);
+
+    if (i < 0 || i >= MAX_FILTER_PLIES || j <= i || j > MAX_FILTER_PLIES) {
+        outputf(_("You must specify two plies with 0 <= ply < next ply <= %d "
+                  "(see `help set adaptivefilters sigma').\n"), MAX_FILTER_PLIES);
+        return;
+    }
+
+    if (r < 0.0f) {
+        outputl(_("You must specify a semi-positive standard deviation "
+                  "(see `help set adaptivefilters sigma')."));
+        return;
+    }
+
+    aarFilterSigma[i][j] = r;
+
+    outputf(_("Standard deviation of the error of %d-ply relative to %d-ply set to %.4f.\n"), i, j, r);
+}
+
 
 
 
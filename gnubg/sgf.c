@@ -92,11 +92,27 @@ FreeGameTreeSeq(listOLD * pl)
     FreeList(pl, 0);
 }
 
+static int
+IsBackgammonGameTree(listOLD * plGameTree)
+{
+    listOLD *plRoot = ((listOLD *) plGameTree->plNext->p)->plNext->p;
+    listOLD *plProp;
+
+    for (plProp = plRoot->plNext; plProp != plRoot; plProp = plProp->plNext) {
+        property *pp = plProp->p;
+
+        if (pp->ach[0] == 'G' && pp->ach[1] == 'M' && pp->pl->plNext->p && atoi((char *) pp->pl->plNext->p) == 6)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
 static listOLD *
 LoadCollection(char *sz)
 {
 
-    listOLD *plCollection, *pl, *plRoot, *plProp;
+    listOLD *plCollection, *pl;
     FILE *pf;
 
     fError = FALSE;
@@ -123,19 +139,7 @@ LoadCollection(char *sz)
     if (plCollection) {
         pl = plCollection->plNext;
         while (pl != plCollection) {
-            int fBackgammon = FALSE;
-
-            plRoot = ((listOLD *) ((listOLD *) pl->p)->plNext->p)->plNext->p;
-
-            for (plProp = plRoot->plNext; plProp != plRoot; plProp = plProp->plNext) {
-                property *pp = plProp->p;
-
-                if (pp->ach[0] == 'G' && pp->ach[1] == 'M' && pp->pl->plNext->p && atoi((char *)
-                                                                                        pp->pl->plNext->p) == 6) {
-                    fBackgammon = TRUE;
-                    break;
-                }
-            }
+            int fBackgammon = IsBackgammonGameTree(pl->p);
 
             pl = pl->plNext;
 
@@ -1511,10 +1515,114 @@ CommandLoadPosition(char *sz)
 }
 
 
+typedef struct {
+    int (*pfGame) (listOLD * plGame, void *p);
+    void *p;
+    int nGames;
+    int fStopped;
+} sgfstream;
+
+static int
+StreamGameTree(listOLD * plGameTree, void *p)
+{
+    sgfstream *pss = p;
+
+    if (!IsBackgammonGameTree(plGameTree)) {
+        FreeList(plGameTree, 1);
+        return TRUE;
+    }
+
+    if (!pss->nGames && !pss->pfGame(NULL, pss->p)) {
+        FreeList(plGameTree, 1);
+        pss->fStopped = TRUE;
+        return FALSE;
+    }
+
+    RestoreGame(plGameTree);
+    FreeList(plGameTree, 1);
+    pss->nGames++;
+
+    if (!pss->pfGame(plGame, pss->p)) {
+        pss->fStopped = TRUE;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+extern int
+SGFLoadStream(char *sz, int (*pfGame) (listOLD * plGame, void *p), void *p)
+{
+    sgfstream ss;
+    FILE *pf;
+    int fParsed;
+
+    fError = FALSE;
+    SGFErrorHandler = ErrorHandler;
+
+    if (strcmp(sz, "-")) {
+        if (!(pf = g_fopen(sz, "r"))) {
+            outputerr(sz);
+            return -1;
+        }
+        szFile = sz;
+    } else {
+        pf = stdin;
+        szFile = "(stdin)";
+    }
+
+    ss.pfGame = pfGame;
+    ss.p = p;
+    ss.nGames = 0;
+    ss.fStopped = FALSE;
+
+    fParsed = SGFParseStream(pf, StreamGameTree, &ss);
+
+    if (pf != stdin)
+        fclose(pf);
+
+    if (!ss.nGames && !ss.fStopped) {
+        if (!fParsed)
+            return -1;
+        ErrorHandler(_("warning: no backgammon games in SGF file"), TRUE);
+    }
+
+    return ss.nGames;
+}
+
+static int
+LoadMatchGame(listOLD * plGame, void *p)
+{
+    int *pfStarted = p;
+
+    if (plGame)
+        return TRUE;
+
+    /* the first game is about to be restored; replace the current match */
+
+    /* FIXME make sure the root nodes have MI properties; if not,
+     * we're loading a session. */
+    if (!get_input_discard())
+        return FALSE;
+#if USE_GTK
+    if (fX) {                   /* Clear record to avoid ugly updates */
+        GTKClearMoveRecord();
+        GTKFreeze();
+    }
+#endif
+
+    FreeMatch();
+    ClearMatch();
+
+    *pfStarted = TRUE;
+    return TRUE;
+}
+
 extern void
 CommandLoadMatch(char *sz)
 {
     listOLD *pl;
+    int fStarted = FALSE, nGames, nMoves = 0;
 
     sz = NextToken(&sz);
 
@@ -1523,73 +1631,54 @@ CommandLoadMatch(char *sz)
         return;
     }
 
-    if ((pl = LoadCollection(sz))) {
-        int nGames = 0, nMoves = 0;
+    /* games are restored as they are parsed, so that a large collection
+     * never has to be held as a syntax tree all at once */
+    nGames = SGFLoadStream(sz, LoadMatchGame, &fStarted);
 
-        /* FIXME make sure the root nodes have MI properties; if not,
-         * we're loading a session. */
-        if (!get_input_discard())
-            return;
-#if USE_GTK
-        if (fX) {               /* Clear record to avoid ugly updates */
-            GTKClearMoveRecord();
-            GTKFreeze();
-        }
-#endif
-
-        FreeMatch();
-        ClearMatch();
-
-        for (pl = pl->plNext; pl->p; pl = pl->plNext) {
-            RestoreGame(pl->p);
-            nGames++;
-        }
-
-        FreeGameTreeSeq(pl);
+    if (!fStarted)
+        return;
 
-        UpdateSettings();
+    UpdateSettings();
 
 #if USE_GTK
-        if (fX) {
-            GTKThaw();
-            GTKSet(ap);
-        }
+    if (fX) {
+        GTKThaw();
+        GTKSet(ap);
+    }
 #endif
 
-        setDefaultFileName(sz);
+    setDefaultFileName(sz);
 
-        for (pl = plGame->plNext; pl != plGame; pl = pl->plNext) {
-            moverecord *pmr = pl->p;
+    for (pl = plGame->plNext; pl != plGame; pl = pl->plNext) {
+        moverecord *pmr = pl->p;
 
-            switch (pmr->mt) {
-            case MOVE_NORMAL:
-            case MOVE_DOUBLE:
-            case MOVE_TAKE:
-            case MOVE_DROP:
-                nMoves++;
-                break;
-            default:
-                /* do not count the other pseudo-moves */
-                break;
-            }
+        switch (pmr->mt) {
+        case MOVE_NORMAL:
+        case MOVE_DOUBLE:
+        case MOVE_TAKE:
+        case MOVE_DROP:
+            nMoves++;
+            break;
+        default:
+            /* do not count the other pseudo-moves */
+            break;
         }
+    }
 
-        if (nGames == 1 && nMoves == 1) {
-            moverecord *pmr;
+    if (nGames == 1 && nMoves == 1) {
+        moverecord *pmr;
 
-            CommandFirstMove(NULL);
-            pl = plGame->plNext;
+        CommandFirstMove(NULL);
+        pl = plGame->plNext;
+        pmr = pl->p;
+        while (pmr->mt != MOVE_NORMAL && pmr->mt != MOVE_DOUBLE) {
+            CommandNext(NULL);
+            pl = pl->plNext;
             pmr = pl->p;
-            while (pmr->mt != MOVE_NORMAL && pmr->mt != MOVE_DOUBLE) {
-                CommandNext(NULL);
-                pl = pl->plNext;
-                pmr = pl->p;
-            }
-            CommandPrevious(NULL);
-        } else if (fGotoFirstGame)
-            CommandFirstGame(NULL);
-
-    }
+        }
+        CommandPrevious(NULL);
+    } else if (fGotoFirstGame)
+        CommandFirstGame(NULL);
 }
 
 static void
@@ -43,6 +43,21 @@ extern void (*SGFErrorHandler) (const char *szMessage, int fParseError);
  * (if set), or complains to stderr (otherwise). */
 extern listOLD *SGFParse(FILE * pf);
 
+/* Parse an SGF file like SGFParse, but pass each top level game tree to
+ * pfCallback as soon as it has been read, so that only one game tree is
+ * in memory at a time.  The callback owns the tree and must free it;
+ * returning FALSE stops the parse.  Returns FALSE if the file couldn't
+ * be parsed or the callback stopped it. */
+extern int SGFParseStream(FILE * pf, int (*pfCallback) (listOLD * plGameTree, void *p), void *p);
+
+/* Load the backgammon games of an SGF file one at a time, restoring
+ * each into the current match and then calling pfGame with it.  pfGame
+ * is called with NULL before the first game is restored and can return
+ * FALSE to leave the current match alone; later it can return FALSE to
+ * stop loading, or remove the game again to keep memory bounded.
+ * Returns the number of games loaded, or -1 on errors. */
+extern int SGFLoadStream(char *sz, int (*pfGame) (listOLD * plGame, void *p), void *p);
+
 /* The following properties are defined for GNU Backgammon SGF files:
  * 
  * A  (M)  - analysis (gnubg private)
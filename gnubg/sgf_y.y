@@ -35,6 +35,8 @@ extern char *stpcpy(char *s1, const char *s2);
 #endif
 
 static listOLD *plCollection;    
+static int ( *pfGameTree )( listOLD *, void * );
+static void *pvGameTree;
     
 extern int sgflex( void );
 
@@ -103,16 +105,33 @@ static char *Concatenate( listOLD *pl ) {
 
 %type <pp> Property
 %type <pch> Value
-%type <pl> Collection GameTreeSeq GameTree Sequence Node PropertySeq ValueSeq
+%type <pl> Collection TopGameTreeSeq GameTreeSeq GameTree Sequence Node PropertySeq ValueSeq
 %type <pl> ValueCharSeq
 
 %%
 		/* The specification says empty collections are illegal, but
 		   we'll try to be accommodating. */
-Collection:	GameTreeSeq
+Collection:	TopGameTreeSeq
 		{ $$ = plCollection = $1; }
 	;
 
+		/* When streaming, each top level game tree is handed over
+		   as soon as it is complete instead of being collected. */
+TopGameTreeSeq:	/* empty */
+		{ $$ = NewList(); }
+	|	TopGameTreeSeq GameTree
+		{
+		    if( !pfGameTree )
+			ListInsert( $1, $2 );
+		    else if( !pfGameTree( $2, pvGameTree ) ) {
+			g_free( $1 );
+			YYABORT;
+		    }
+		    $$ = $1;
+		}
+	|	TopGameTreeSeq error
+	;
+
 GameTreeSeq:	/* empty */
 		{ $$ = NewList(); }
 	|	GameTreeSeq GameTree
@@ -171,16 +190,41 @@ ValueCharSeq:	/* empty */
 %%
 
 extern FILE *sgfin;
+extern void sgfrestart( FILE *pf );
+
 extern listOLD *SGFParse( FILE *pf ) {
 
     
-    sgfin = pf;
+    sgfrestart( pf );
     plCollection = NULL;
+    pfGameTree = NULL;
 
     sgfparse();
 
     return plCollection;
 }
+
+extern int SGFParseStream( FILE *pf, int ( *pfCallback )( listOLD *, void * ),
+			   void *p ) {
+
+    int f;
+
+    /* a previous parse may have stopped part way through its file */
+    sgfrestart( pf );
+    plCollection = NULL;
+    pfGameTree = pfCallback;
+    pvGameTree = p;
+
+    f = !sgfparse() && plCollection;
+
+    if( plCollection )
+	g_free( plCollection ); /* empty, the trees went to the callback */
+
+    pfGameTree = NULL;
+    plCollection = NULL;
+
+    return f;
+}
 	
 #ifdef SGFTEST
 
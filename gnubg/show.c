@@ -46,6 +46,8 @@
 #include "util.h"
 #include "openurl.h"
 #include "multithread.h"
+#include "scoremap.h"
+#include "tempmap.h"
 
 #if defined(USE_GTK)
 #include "gtkboard.h"
@@ -363,6 +365,32 @@ ShowPaged(char **ppch)
             outputl(*ppch++);
 }
 
+extern void
+CommandShowAdaptiveFilters(char *UNUSED(sz))
+{
+
+    int i, j;
+
+    outputl(fAdaptiveFilters ? _("Moves will be filtered by their expected error.") :
+            _("Moves will be filtered by the fixed thresholds."));
+    outputf(_("Moves within %.2f standard deviations of the best one are kept.\n"), rFilterConfidence);
+
+    outputl(_("\nStandard deviation of the error relative to the next ply evaluated:"));
+    output("       ");
+    for (j = 1; j <= MAX_FILTER_PLIES; j++)
+        outputf("  %d-ply ", j);
+    outputc('\n');
+    for (i = 0; i < MAX_FILTER_PLIES; i++) {
+        outputf("  %d-ply", i);
+        for (j = 1; j <= MAX_FILTER_PLIES; j++)
+            if (j > i)
+                outputf("  %.4f", aarFilterSigma[i][j]);
+            else
+                output("        ");
+        outputc('\n');
+    }
+}
+
 extern void
 CommandShowAnalysis(char *UNUSED(sz))
 {
@@ -1445,7 +1473,7 @@ CommandShowOneSidedRollout(char *sz)
 
     outputf(_("One sided rollout with %d trials (%s on roll):\n"), nTrials, ap[ms.fMove].szName);
 
-    raceProbs((ConstTanBoard) anBoard, nTrials, ar, arMu);
+    raceProbsMT((ConstTanBoard) anBoard, nTrials, MT_GetNumThreads(), ar, arMu);
     outputl(OutputPercents(ar, TRUE));
 
     PipCount((ConstTanBoard) anBoard, anPips);
@@ -2107,12 +2135,56 @@ CommandShowTemperatureMap(char *sz)
 
         return;
     }
-#else
-    (void) sz;                  /* suppress unused parameter compiler warning */
 #endif
 
-    CommandNotImplemented(NULL);
+    {
+        /* without the GUI: print the map, for the cube the maps
+         * after no double and after double, take */
+        evalcontext ec = { TRUE, 0, FALSE, TRUE, 0.0 };
+        matchstate ams[2];
+        gchar *asz[2] = { NULL, NULL };
+        cubeinfo ci;
+        int i, n = 1, nPlies = 0;
+        char *pch;
+
+        if (sz && *sz == '=') {
+            pch = NextToken(&sz);
+            if (!strcmp(pch, "=cube"))
+                n = 2;
+        }
+        if (sz && *sz && ((nPlies = ParseNumber(&sz)) < 0 || nPlies > 7)) {
+            outputl(_("Valid numbers of plies to look ahead are 0 to 7."));
+            return;
+        }
+        ec.nPlies = (unsigned int) nPlies;
+
+        if (n == 1) {
+            TempMapOutput(&ms, 1, NULL, &ec);
+            return;
+        }
+
+        GetMatchStateCubeInfo(&ci, &ms);
+        if (!GetDPEq(NULL, NULL, &ci)) {
+            outputl(_("Cube is not available."));
+            return;
+        }
+
+        for (i = 0; i < 2; ++i)
+            memcpy(&ams[i], &ms, sizeof(matchstate));
+        ams[1].nCube *= 2;
+        ams[1].fCubeOwner = !ams[1].fMove;
+
+        for (i = 0; i < 2; ++i) {
+            asz[i] = g_malloc(200);
+            GetMatchStateCubeInfo(&ci, &ams[i]);
+            FormatCubePosition(asz[i], &ci);
+        }
+
+        TempMapOutput(ams, 2, asz, &ec);
 
+        for (i = 0; i < 2; ++i)
+            g_free(asz[i]);
+    }
 }
 
 // defined in backgammon.h
@@ -2164,12 +2236,39 @@ CommandShowScoreMap(char *sz)
 
         return;
     }
-#else
-    (void) sz;                  /* suppress unused parameter compiler warning */
 #endif
 
-    CommandNotImplemented(NULL);
+    {
+        /* without the GUI: print the map */
+        int fCubeMap = TRUE, nMatchTo = 0;
+        char *pch;
+        cubeinfo ci;
+
+        if (sz && *sz == '=') {
+            pch = NextToken(&sz);
+            fCubeMap = strcmp(pch, "=move") != 0;
+        }
+        if (sz && *sz && ((nMatchTo = ParseNumber(&sz)) < 2 || nMatchTo > MAXSCORE)) {
+            outputf(_("The match length must be between 2 and %d.\n"), MAXSCORE);
+            return;
+        }
+        if (!nMatchTo)
+            /* as the GTK score map starts */
+            nMatchTo = ms.nMatchTo < 3 ? 3 : MIN(ms.nMatchTo, 9);
 
+        if (fCubeMap) {
+            GetMatchStateCubeInfo(&ci, &ms);
+            if (!GetDPEq(NULL, NULL, &ci)) {
+                outputl(_("Cube is not available."));
+                return;
+            }
+        } else if (!ms.anDice[0]) {
+            outputl(_("You must roll the dice first."));
+            return;
+        }
+
+        ScoreMapOutput(&ms, fCubeMap, nMatchTo);
+    }
 }
 
 extern void
@@ -2233,8 +2332,8 @@ show_bearoff(TanBoard an, char *szTemp)
     case VARIATION_HYPERGAMMON_2:
     case VARIATION_HYPERGAMMON_3:
 
-        if (isBearoff(apbcHyper[ms.bgv - VARIATION_HYPERGAMMON_1], (ConstTanBoard) an)) {
-            BearoffDump(apbcHyper[ms.bgv - VARIATION_HYPERGAMMON_1], (ConstTanBoard) an, szTemp);
+        if (isBearoff(GetHyperBearoff(ms.bgv - VARIATION_HYPERGAMMON_1), (ConstTanBoard) an)) {
+            BearoffDump(GetHyperBearoff(ms.bgv - VARIATION_HYPERGAMMON_1), (ConstTanBoard) an, szTemp);
             outputl(szTemp);
         }
 
@@ -25,15 +25,16 @@
 #else
 #include "backgammon.h"
 #endif
-#if defined(USE_MULTITHREAD)
 #include "multithread.h"
-#endif
 #ifndef WIN32
 #include <stdlib.h>
 #endif
+#include <math.h>
+#include <string.h>
 
 #include "lib/isaac.h"
 #include "lib/simd.h"
+#include "positionid.h"
 
 #define EVALS_PER_ITERATION 1024
 
@@ -90,6 +91,328 @@ RunEvals(void *UNUSED(notused))
 #endif
 }
 
+/* Calibration of the adaptive move filters. The chequer plays of the
+ * loaded match are shared out: the even ones measure how far the
+ * difference between two moves moves from one ply to a deeper one, the
+ * odd ones compare the fixed and adaptive filters on analysis. */
+
+#define CALIBRATE_MOVES 16      /* the best moves at 0-ply rescored */
+#define CALIBRATE_WINDOW 0.2f   /* moves this close to the best are sampled */
+#define CALIBRATE_SAMPLES 20    /* the fewest samples a sigma is set from */
+
+typedef int (*cfunc) (const void *, const void *);
+
+typedef struct {
+    TanBoard anBoard;
+    int anDice[2];
+    cubeinfo ci;
+    /* calibration: the scores of the moves at each ply */
+    unsigned int cMoves;
+    float aarScore[MAX_FILTER_PLIES + 1][CALIBRATE_MOVES];
+    /* benchmark: the move list with the fixed filters, the moves scored
+     * at the top ply by each filter and the equity lost by the adaptive
+     * one */
+    movelist ml;
+    unsigned int acTop[2];
+    int fAgree;
+    float rLoss;
+} filterposition;
+
+typedef struct {
+    filterposition *afp;
+    evalcontext ec;
+    unsigned int nPlies;
+    int fAdaptive;
+    int iNext;
+} filtercalc;
+
+static void
+FilterCalibrateTask(void *p)
+{
+    filtercalc *pfc = (filtercalc *) p;
+    filterposition *pfp = &pfc->afp[MT_SafeIncCheck(&pfc->iNext)];
+    move am[CALIBRATE_MOVES];
+    movelist ml;
+    unsigned int i, j;
+
+    if (fInterrupt)
+        return;
+
+    GenerateMoves(&ml, (ConstTanBoard) pfp->anBoard, pfp->anDice[0], pfp->anDice[1], FALSE);
+    for (i = 0; i < ml.cMoves; i++)
+        if (ScoreMove(NULL, &ml.amMoves[i], &pfp->ci, &pfc->ec, 0) < 0) {
+            MT_SetResultFailed();
+            return;
+        }
+    qsort(ml.amMoves, ml.cMoves, sizeof(move), (cfunc) CompareMoves);
+
+    /* the move list is overwritten by the deeper evaluations */
+    pfp->cMoves = MIN(ml.cMoves, CALIBRATE_MOVES);
+    memcpy(am, ml.amMoves, pfp->cMoves * sizeof(move));
+
+    for (j = 0; j <= pfc->nPlies; j++)
+        for (i = 0; i < pfp->cMoves; i++) {
+            if (j && ScoreMove(NULL, &am[i], &pfp->ci, &pfc->ec, (int) j) < 0) {
+                MT_SetResultFailed();
+                return;
+            }
+            pfp->aarScore[j][i] = am[i].rScore;
+        }
+}
+
+static void
+FilterBenchmarkTask(void *p)
+{
+    filtercalc *pfc = (filtercalc *) p;
+    filterposition *pfp = &pfc->afp[MT_SafeIncCheck(&pfc->iNext)];
+    movelist ml;
+    const move *pmBest;
+    unsigned int i;
+
+    if (fInterrupt)
+        return;
+
+    if (FindnSaveBestMoves(&ml, pfp->anDice[0], pfp->anDice[1], (ConstTanBoard) pfp->anBoard, NULL,
+                           arSkillLevel[SKILL_DOUBTFUL], &pfp->ci, &pfc->ec, aamfAnalysis) < 0) {
+        MT_SetResultFailed();
+        return;
+    }
+
+    pfp->acTop[pfc->fAdaptive] = 0;
+    for (i = 0; i < ml.cMoves; i++)
+        if (ml.amMoves[i].esMove.ec.nPlies == pfc->ec.nPlies)
+            pfp->acTop[pfc->fAdaptive]++;
+
+    if (!pfc->fAdaptive) {
+        pfp->ml = ml;
+        return;
+    }
+
+    pmBest = &pfp->ml.amMoves[0];
+    pfp->fAgree = EqualKeys(ml.amMoves[0].key, pmBest->key);
+    pfp->rLoss = 0.0f;
+
+    if (!pfp->fAgree) {
+        move m = ml.amMoves[0];
+
+        /* score the adaptive choice at the top ply unless the fixed
+         * filters already did */
+        for (i = 1; i < pfp->ml.cMoves; i++)
+            if (EqualKeys(pfp->ml.amMoves[i].key, m.key))
+                break;
+
+        if (i < pfp->ml.cMoves && pfp->ml.amMoves[i].esMove.ec.nPlies == pfc->ec.nPlies)
+            m = pfp->ml.amMoves[i];
+        else if (ScoreMove(NULL, &m, &pfp->ci, &pfc->ec, (int) pfc->ec.nPlies) < 0) {
+            MT_SetResultFailed();
+            g_free(ml.amMoves);
+            return;
+        }
+
+        pfp->rLoss = MAX(pmBest->rScore - m.rScore, 0.0f);
+    }
+
+    g_free(ml.amMoves);
+}
+
+static gboolean
+FilterProgress(gpointer UNUSED(unused))
+{
+    ProgressValue(MT_GetDoneTasks());
+    return TRUE;
+}
+
+static int
+FilterRun(AsyncFun fun, filtercalc * pfc, filterposition * afp, unsigned int n, char *szProgress)
+{
+    int ret;
+
+    pfc->afp = afp;
+    pfc->iNext = 0;
+
+    ProgressStartValue(szProgress, (int) n);
+    mt_add_tasks(n, fun, pfc, NULL);
+    ret = MT_WaitForTasks(FilterProgress, UI_UPDATETIME, FALSE);
+    ProgressEnd();
+
+    return (ret < 0 || fInterrupt) ? -1 : 0;
+}
+
+/* The chequer plays of the match with a choice of moves */
+
+static GArray *
+FilterPositions(void)
+{
+    GArray *pa = g_array_new(FALSE, TRUE, sizeof(filterposition));
+    listOLD *plGame, *pl;
+    matchstate msPos;
+    movelist ml;
+
+    for (plGame = lMatch.plNext; plGame != &lMatch; plGame = plGame->plNext)
+        for (pl = ((listOLD *) plGame->p)->plNext; pl != plGame->p; pl = pl->plNext) {
+            moverecord *pmr = pl->p;
+
+            FixMatchState(&msPos, pmr);
+            if (pmr->mt == MOVE_NORMAL) {
+                if (pmr->fPlayer != msPos.fMove)
+                    SwapSides(msPos.anBoard);
+                msPos.fTurn = msPos.fMove = pmr->fPlayer;
+
+                GenerateMoves(&ml, (ConstTanBoard) msPos.anBoard, pmr->anDice[0], pmr->anDice[1], FALSE);
+                if (ml.cMoves > 1) {
+                    filterposition fp;
+
+                    memset(&fp, 0, sizeof(fp));
+                    memcpy(fp.anBoard, msPos.anBoard, sizeof(TanBoard));
+                    fp.anDice[0] = (int) pmr->anDice[0];
+                    fp.anDice[1] = (int) pmr->anDice[1];
+                    GetMatchStateCubeInfo(&fp.ci, &msPos);
+                    g_array_append_val(pa, fp);
+                }
+            }
+            ApplyMoveRecord(&msPos, plGame->p, pmr);
+        }
+
+    return pa;
+}
+
+static void
+FilterSigmaUpdate(const filterposition * afp, unsigned int n, unsigned int nPlies)
+{
+    double aarSum[MAX_FILTER_PLIES][MAX_FILTER_PLIES + 1];
+    unsigned int aac[MAX_FILTER_PLIES][MAX_FILTER_PLIES + 1];
+    unsigned int i, j, k, m, iBest;
+
+    memset(aarSum, 0, sizeof(aarSum));
+    memset(aac, 0, sizeof(aac));
+
+    for (i = 0; i < n; i++)
+        for (k = 0; k < nPlies; k++) {
+            const float *ar = afp[i].aarScore[k];
+
+            for (iBest = 0, m = 1; m < afp[i].cMoves; m++)
+                if (ar[m] > ar[iBest])
+                    iBest = m;
+
+            /* how much the lead of the best move at ply k over a close
+             * one changes at each deeper ply */
+            for (m = 0; m < afp[i].cMoves; m++)
+                if (m != iBest && ar[iBest] - ar[m] <= CALIBRATE_WINDOW)
+                    for (j = k + 1; j <= nPlies; j++) {
+                        double r = (afp[i].aarScore[j][iBest] - afp[i].aarScore[j][m]) - (ar[iBest] - ar[m]);
+
+                        aarSum[k][j] += r * r;
+                        aac[k][j]++;
+                    }
+        }
+
+    outputl(_("Standard deviation of the error relative to a deeper ply:"));
+    for (k = 0; k < nPlies; k++)
+        for (j = k + 1; j <= nPlies; j++)
+            if (aac[k][j] >= CALIBRATE_SAMPLES) {
+                aarFilterSigma[k][j] = (float) sqrt(aarSum[k][j] / aac[k][j]);
+                outputf(_("  %u-ply to %u-ply: %.4f (%u samples)\n"), k, j, aarFilterSigma[k][j], aac[k][j]);
+            } else
+                outputf(_("  %u-ply to %u-ply: %.4f kept (only %u samples)\n"), k, j, aarFilterSigma[k][j],
+                        aac[k][j]);
+}
+
+static void
+FilterBenchmarkReport(const filterposition * afp, unsigned int n, const double at[2])
+{
+    unsigned int i, acTop[2] = { 0, 0 }, cAgree = 0;
+    float rLoss = 0.0f, rWorst = 0.0f;
+
+    for (i = 0; i < n; i++) {
+        acTop[0] += afp[i].acTop[0];
+        acTop[1] += afp[i].acTop[1];
+        cAgree += afp[i].fAgree ? 1 : 0;
+        rLoss += afp[i].rLoss;
+        rWorst = MAX(rWorst, afp[i].rLoss);
+    }
+
+    outputf(_("\nBenchmark on %u positions:\n"), n);
+    outputf(_("                       Fixed    Adaptive\n"));
+    outputf(_("  Time (seconds)     %8.2f    %8.2f\n"), at[0] / 1000.0, at[1] / 1000.0);
+    outputf(_("  Moves at top ply   %8.2f    %8.2f\n"), (float) acTop[0] / n, (float) acTop[1] / n);
+    outputf(_("  Same best move: %.1f%%; equity lost: %.4f per move, %.4f at worst\n"),
+            100.0f * cAgree / n, rLoss / n, rWorst);
+}
+
+static void
+CalibrateFilters(void)
+{
+    GArray *pa;
+    filterposition *afpCalibrate, *afpBenchmark;
+    filtercalc fc;
+    unsigned int i, n, nCalibrate;
+    double at[2];
+    int fAdaptiveSave = fAdaptiveFilters;
+    const evalbook *pevalbookSave = pevalbook;
+
+    if (!CheckGameExists())
+        return;
+
+    fc.ec = esAnalysisChequer.ec;
+    if (fc.ec.nPlies < 1) {
+        outputl(_("The analysis of chequer play must look at least one ply ahead to calibrate the move filters."));
+        return;
+    }
+    fc.nPlies = MIN(fc.ec.nPlies, MAX_FILTER_PLIES);
+
+    /* split the positions, so the benchmark isn't run on the
+     * positions the filters were calibrated on */
+    pa = FilterPositions();
+    n = pa->len / 2;
+    nCalibrate = pa->len - n;
+    if (!n) {
+        outputl(_("The match has too few chequer plays to calibrate the move filters."));
+        g_array_free(pa, TRUE);
+        return;
+    }
+    afpCalibrate = g_new(filterposition, nCalibrate);
+    afpBenchmark = g_new(filterposition, n);
+    for (i = 0; i < pa->len; i++)
+        if (i & 1)
+            afpBenchmark[i / 2] = g_array_index(pa, filterposition, i);
+        else
+            afpCalibrate[i / 2] = g_array_index(pa, filterposition, i);
+    g_array_free(pa, TRUE);
+
+    if (FilterRun(FilterCalibrateTask, &fc, afpCalibrate, nCalibrate, _("Calibrating move filters")) < 0)
+        goto finished;
+
+    FilterSigmaUpdate(afpCalibrate, nCalibrate, fc.nPlies);
+
+    /* time the searches, not the lookups of the opening book */
+    pevalbook = NULL;
+
+    for (fc.fAdaptive = 0; fc.fAdaptive < 2; fc.fAdaptive++) {
+        fAdaptiveFilters = fc.fAdaptive;
+        EvalCacheFlush();
+        at[fc.fAdaptive] = get_time();
+        if (FilterRun(FilterBenchmarkTask, &fc, afpBenchmark, n,
+                      fc.fAdaptive ? _("Benchmarking adaptive filters") : _("Benchmarking fixed filters")) < 0)
+            break;
+        at[fc.fAdaptive] = get_time() - at[fc.fAdaptive];
+    }
+
+    fAdaptiveFilters = fAdaptiveSave;
+    pevalbook = pevalbookSave;
+
+    if (fc.fAdaptive == 2)
+        FilterBenchmarkReport(afpBenchmark, n, at);
+    else
+        outputl(_("Benchmark interrupted."));
+
+  finished:
+    /* only the positions the fixed filters reached have a move list */
+    for (i = 0; i < n; i++)
+        g_free(afpBenchmark[i].ml.amMoves);
+    g_free(afpCalibrate);
+    g_free(afpBenchmark);
+}
+
 extern void
 CommandCalibrate(char *sz)
 {
@@ -99,6 +422,11 @@ CommandCalibrate(char *sz)
     void *pcc = NULL;
 #endif
 
+    if (sz && *sz && !StrNCaseCmp(sz, "filters", strlen(sz))) {
+        CalibrateFilters();
+        return;
+    }
+
     iCacheSize = GetEvalCacheEntries();
     EvalCacheResize(0);
 
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+/*
+ * Based on Sho Sengoku's Equity Temperature Map
+ * https://bkgm.com/articles/Sengoku/TemperatureMap/index.html 
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <glib.h>
+
+#include "backgammon.h"
+#include "tempmap.h"
+#include "format.h"
+#include "multithread.h"
+
+typedef struct {
+    const matchstate *ams;
+    const float *arFac;
+    int n;
+    evalcontext ec;
+    tempmapequities *atme;
+    int iNext;
+    int cDone;
+} tempmapcalc;
+
+/* for TempMapProgress() */
+static tempmapcalc *ptmcProgress;
+
+static int
+TempMapRoll(tempmapequities * ptme, const matchstate * pms, const float rFac, evalcontext * pec, int i, int j)
+{
+    float arOutput[NUM_ROLLOUT_OUTPUTS];
+    TanBoard anBoard;
+    cubeinfo ci;
+    cubeinfo cix;
+
+    GetMatchStateCubeInfo(&cix, pms);
+    memcpy(&ci, &cix, sizeof ci);
+
+    /* find best move */
+
+    memcpy(anBoard, pms->anBoard, sizeof(anBoard));
+
+    if (FindBestMove(ptme->aaanMove[i][j], i + 1, j + 1, anBoard, &ci, pec, defaultFilters) < 0)
+        return -1;
+
+    /* evaluate resulting position */
+
+    SwapSides(anBoard);
+    ci.fMove = !ci.fMove;
+
+    if (GeneralEvaluationE(arOutput, (ConstTanBoard) anBoard, &ci, pec) < 0)
+        return -1;
+
+    InvertEvaluationR(arOutput, &cix);
+
+    if (!cix.nMatchTo && rFac != 1.0f)
+        arOutput[OUTPUT_CUBEFUL_EQUITY] *= rFac;
+
+    ptme->aarEquity[i][j] = arOutput[OUTPUT_CUBEFUL_EQUITY];
+    ptme->aarEquity[j][i] = arOutput[OUTPUT_CUBEFUL_EQUITY];
+
+    if (i != j)
+        memcpy(ptme->aaanMove[j][i], ptme->aaanMove[i][j], sizeof ptme->aaanMove[0][0]);
+
+    return 0;
+}
+
+/* One task per roll, doing the roll for all the positions in turn.
+ * The positions compared are usually the same board with different
+ * cubes, so the later ones find most of the evaluations of the first in
+ * the cache; splitting them over threads would have them miss it
+ * together. */
+
+static void
+TempMapTask(void *p)
+{
+    tempmapcalc *ptmc = (tempmapcalc *) p;
+    int k = MT_SafeIncCheck(&ptmc->iNext);
+    int i, j, m;
+
+    /* the k-th of the 21 rolls, i >= j */
+    for (i = 0; k > i; ++i)
+        k -= i + 1;
+    j = k;
+
+    for (m = 0; m < ptmc->n; ++m) {
+        if (fInterrupt)
+            return;
+
+        if (TempMapRoll(&ptmc->atme[m], &ptmc->ams[m], ptmc->arFac ? ptmc->arFac[m] : 1.0f, &ptmc->ec, i, j) < 0) {
+            MT_SetResultFailed();
+            return;
+        }
+    }
+
+    MT_SafeInc(&ptmc->cDone);
+}
+
+static gboolean
+TempMapProgress(gpointer UNUSED(p))
+{
+    ProgressValue(MT_SafeGet(&ptmcProgress->cDone));
+    return TRUE;
+}
+
+extern int
+TempMapCalc(const matchstate ams[], const float arFac[], int n, const evalcontext * pec, tempmapequities atme[])
+{
+    tempmapcalc tmc;
+    int ret;
+
+    tmc.ams = ams;
+    tmc.arFac = arFac;
+    tmc.n = n;
+    tmc.ec = *pec;
+    tmc.atme = atme;
+    tmc.iNext = 0;
+    tmc.cDone = 0;
+    ptmcProgress = &tmc;
+
+    ProgressStartValue(_("Calculating equities"), 21);
+
+    mt_add_tasks(21, TempMapTask, &tmc, NULL);
+    ret = MT_WaitForTasks(TempMapProgress, UI_UPDATETIME, FALSE);
+
+    ProgressEnd();
+
+    return (ret < 0 || fInterrupt) ? -1 : 0;
+}
+
+extern void
+TempMapOutput(const matchstate ams[], int n, gchar * aszTitle[], const evalcontext * pec)
+{
+    tempmapequities *atme = g_new(tempmapequities, n);
+    float *arFac = g_new(float, n);
+    char szMove[FORMATEDMOVESIZE];
+    cubeinfo ci;
+    int i, j, m;
+
+    /* the money equities in units of the first cube */
+    for (m = 0; m < n; ++m)
+        arFac[m] = (float) ams[m].nCube / (float) ams[0].nCube;
+
+    if (TempMapCalc(ams, arFac, n, pec, atme) < 0) {
+        outputl(_("Interrupted."));
+        g_free(atme);
+        g_free(arFac);
+        return;
+    }
+
+    GetMatchStateCubeInfo(&ci, &ams[0]);
+
+    for (m = 0; m < n; ++m) {
+        float rAverage = 0.0f;
+
+        if (aszTitle && aszTitle[m])
+            outputf("%s\n", aszTitle[m]);
+        outputf(_("Equity after each roll (%u-ply)\n\n"), pec->nPlies);
+
+        outputf("%3s", "");
+        for (j = 0; j < 6; ++j)
+            outputf(" %*d", fOutputDigits + 3, j + 1);
+        outputc('\n');
+        for (i = 0; i < 6; ++i) {
+            outputf("%3d", i + 1);
+            for (j = 0; j < 6; ++j) {
+                outputf(" %s", OutputMWC(atme[m].aarEquity[i][j], &ci, TRUE));
+                rAverage += atme[m].aarEquity[i][j];
+            }
+            outputc('\n');
+        }
+        outputf(_("\nAverage: %s\n\n"), OutputMWC(rAverage / 36.0f, &ci, TRUE));
+
+        outputl(_("Best moves:"));
+        for (i = 5; i >= 0; --i)
+            for (j = i; j >= 0; --j)
+                outputf("  %d%d: %s\n", i + 1, j + 1,
+                        FormatMove(szMove, (ConstTanBoard) ams[m].anBoard, atme[m].aaanMove[i][j]));
+        if (m < n - 1)
+            outputc('\n');
+    }
+
+    g_free(atme);
+    g_free(arFac);
+}
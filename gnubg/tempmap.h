@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2026 the AUTHORS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * $Id$
+ */
+
+#ifndef TEMPMAP_H
+#define TEMPMAP_H
+
+#include "eval.h"
+
+/* Sho Sengoku's temperature map: the equity after the best move for
+ * each of the 36 rolls. The rolls of several positions are evaluated
+ * together on the calculation threads; the GTK temperature map and
+ * "show temperaturemap" without a GUI are both built on this. */
+
+typedef struct {
+    float aarEquity[6][6];      /* for the player on roll; [i][j] == [j][i] */
+    int aaanMove[6][6][8];      /* the best move for rolling i+1, j+1 */
+} tempmapequities;
+
+/* Fill atme[k] for the position in ams[k], with the money equities
+ * multiplied by arFac[k] (arFac may be NULL). Returns -1 on error or
+ * interrupt. */
+extern int TempMapCalc(const matchstate ams[], const float arFac[], int n, const evalcontext * pec,
+                       tempmapequities atme[]);
+
+/* Print the temperature maps of the positions in ams */
+extern void TempMapOutput(const matchstate ams[], int n, gchar * aszTitle[], const evalcontext * pec);
+
+#endif                          /* TEMPMAP_H */